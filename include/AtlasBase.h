@@ -3,6 +3,9 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "bus_recorder.h"
+#include "driver_stats.h"
+#include "system_clock.h"
 
 typedef enum
 {
@@ -41,12 +44,15 @@ public:
     void update();
     float getLastValue() const { return _lastValue; }
     unsigned long getAgeMs() const;
+    unsigned long getLastSampleTime() const { return _lastReadyTime; }
     eAtlasStatus getStatus() const { return _status; }
+    const DriverStats &getStats() const { return _stats; }
     virtual eAtlasStatus calibrateSinglePoint(eCalibrationValues value) = 0;
 
+    static float cleanString(const char *buf);
+
 protected:
-    virtual bool isValueFault(float v) const { return false; };
-    float cleanString(const char *buf);
+    virtual bool isValueFault(float) const { return false; };
     eAtlasStatus writeI2C(const char *payload, size_t len, bool nullTerminate = true);
     bool requestMeasurement();
     eAtlasStatus pollOnce();
@@ -65,11 +71,14 @@ protected:
     const uint8_t _i2cAddress;
 
     unsigned long _cmdSentAt = 0;
+    uint64_t _cmdSentAtUs = 0;
     unsigned long _lastReadyTime = 0;
-    unsigned long _nextPollDue = 0;
+    unsigned long _lastPollTime = 0; // Or the time of the request, the next poll is due _pollDelay after it
+    unsigned long _pollDelay = 0;
     unsigned long _lastCommTime = 0;
     float _lastValue = 0.0;
     eAtlasStatus _status = ATLAS_STATUS_NOT_INITIALISED;
+    DriverStats _stats;
 
     static constexpr uint8_t SUCCESS_STATUS_BYTE = 0x01;
     static constexpr uint8_t FAILED_STATUS_BYTE = 0x02;
@@ -3,6 +3,9 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "bus_recorder.h"
+#include "driver_stats.h"
+#include "system_clock.h"
 
 typedef enum
 {
@@ -33,7 +36,8 @@ public:
   bool calibration_20_9();
   bool calibration_99_5();
   bool clearCalibration();
-  eO2SensorStatus getStatus() { return status; }
+  eO2SensorStatus getStatus() const { return status; }
+  const DriverStats &getStats() const { return stats; }
 
 private:
   eO2SensorStatus readData(uint8_t reg, uint8_t *data, uint8_t len);
@@ -41,6 +45,7 @@ private:
 
   TwoWire *_pWire;
   eO2SensorStatus status;
+  DriverStats stats;
 
   static constexpr uint8_t CALIBRATION_20_9 = 0x01;
   static constexpr uint8_t CALIBRATION_99_5 = 0x02;
@@ -2,6 +2,9 @@
 #define SHT40_H
 
 #include <Wire.h>
+#include "bus_recorder.h"
+#include "driver_stats.h"
+#include "system_clock.h"
 
 typedef enum
 {
@@ -34,6 +37,7 @@ public:
     eSHT40Status fetchData();
     eSHT40Status getData(float *temperature, float *humidity);
     eSHT40Status getData(float *temperature);
+    const DriverStats &getStats() const { return this->stats; }
 
 private:
     static constexpr uint8_t SHT40_RSP_SIZE = 6;
@@ -55,6 +59,7 @@ private:
     float temperature;
     float humidity;
     TwoWire *i2cBus;
+    DriverStats stats;
 };
 
 #endif // SHT40_H
\ No newline at end of file
@@ -2,6 +2,8 @@
 #define BIOREACTOR_CONTROLLER_H
 
 #include "main.h"
+#include "recipe_engine.h"
+#include <initializer_list>
 
 /**
  * This file contains the functions that are called in the main loop to control the bioreactor.
@@ -12,15 +14,30 @@ void setFansState(bool heaterFanState, bool circulationFanState, bool rightFanSt
 void setValvesState(bool valveSupplyState, bool valveCirculationState, bool valveReturnState);
 void setPressureChamberValvesState(bool o2ValveState, bool co2ValveState, bool airValveState);
 void setPressureChamberState(bool state);
-void setPumpsSpeed(float approvPumpSpeed, float circulationPumpSpeed, float cultureChamberPump1Speed, float cultureChamberPump2Speed);
+void setPumpsSpeed(std::initializer_list<sPumpSpeed> speeds);
 void setHeatersState(bool heaterState);
 void updateTemperatureController();
 void updatePressureChamberController();
+void updatePhController();
+void updateDoController();
 void updateSensors();
 void printBioreactorStateToSerial();
 void updateLEDState();
 void setBioreactorState(uint8_t state);
 void receiveSerialCommand();
 void beginBioreactorPreferences();
+void restorePhaseProgress();
+void updatePhaseProgress();
+void startPhaseDosing(unsigned long elapsed);
+bool isPhaseDosingComplete();
+StepperMotor *getPump(uint8_t index);
+String getPumpCalibrationKey(uint8_t index);
+void checkPumpEvents();
+void updateSafetyInterlock();
+void updateRecipe();
+void startRecipeStep(const sRecipeInstruction &step, unsigned long elapsed);
+void applyRecipeStep(const sRecipeInstruction &step);
+bool isRecipeStepComplete(const sRecipeInstruction &step);
+void saveRecipePosition();
 
 #endif
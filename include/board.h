@@ -0,0 +1,83 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <Arduino.h>
+#include "pins.h"
+#include "stepper_motor.h"
+
+/**
+ * This file describes the pumps of the board and the drives they are wired to. The PumpRegistry builds the drives and
+ * the pumps from these tables, adding a drive or a pump is an entry in the tables (and in ePumpId for a pump).
+ */
+
+typedef enum
+{
+    PUMP_ID_APPROV = 0,
+    PUMP_ID_CIRCULATION,
+    PUMP_ID_CULTURE_CHAMBER_1,
+    PUMP_ID_CULTURE_CHAMBER_2,
+
+    PUMP_ID_MAX
+} ePumpId;
+
+/**
+ * @brief TMC5041 drive on the SPI bus.
+ */
+typedef struct
+{
+    const char *name; // Reported in the diagnostics
+    uint8_t csPin;
+} sDriveDescription;
+
+/**
+ * @brief Pump on one of the two motors of a drive.
+ */
+typedef struct
+{
+    uint8_t drive;      // Index in DRIVE_TABLE
+    eMotorName motor;
+    float acceleration; // ml/min per s
+    bool isCircuitPump; // Moves the culture between the bottles and the chambers, driven by the states of the bioreactor
+} sPumpDescription;
+
+static constexpr float PUMP_ACCELERATION = 50.0f;      // ml/min per s
+static constexpr float CELL_PUMP_ACCELERATION = 10.0f; // ml/min per s, gentler for the pumps moving the cells to limit the shear
+
+// SPI_CS_DRV_2_PIN has no drive fitted
+static constexpr sDriveDescription DRIVE_TABLE[] = {
+    {"DRV1", SPI_CS_DRV_1_PIN},
+    {"DRV3", SPI_CS_DRV_3_PIN},
+};
+
+// In the order of ePumpId. A dosing pump (ex: pH base) is an entry that is not a circuit pump, every motor is taken for now
+static constexpr sPumpDescription PUMP_TABLE[] = {
+    {0, MOTOR_1, PUMP_ACCELERATION, true},      // Approv
+    {1, MOTOR_2, CELL_PUMP_ACCELERATION, true}, // Circulation
+    {1, MOTOR_1, CELL_PUMP_ACCELERATION, true}, // Culture chamber 1
+    {0, MOTOR_2, CELL_PUMP_ACCELERATION, true}, // Culture chamber 2
+};
+
+static constexpr uint8_t DRIVE_COUNT = sizeof(DRIVE_TABLE) / sizeof(DRIVE_TABLE[0]);
+static constexpr uint8_t PUMP_COUNT = PUMP_ID_MAX;
+static_assert(sizeof(PUMP_TABLE) / sizeof(PUMP_TABLE[0]) == PUMP_ID_MAX, "One pump description per ePumpId");
+
+/**
+ * @brief Check that the pumps from index are on a drive of DRIVE_TABLE, at compile time.
+ */
+constexpr bool isPumpTableValid(uint8_t index = 0)
+{
+    return index >= PUMP_COUNT || (PUMP_TABLE[index].drive < DRIVE_COUNT && isPumpTableValid(index + 1));
+}
+static_assert(isPumpTableValid(), "A pump is on a drive missing from DRIVE_TABLE");
+
+/**
+ * @brief Check that a pump can dose an additive (ex: pH base). The circuit pumps are started and stopped by the states
+ * of the bioreactor, a dose would move the culture instead.
+ * @param index Index of the pump in PUMP_TABLE.
+ */
+constexpr bool isDosingPump(int index)
+{
+    return index >= 0 && index < PUMP_COUNT && !PUMP_TABLE[index].isCircuitPump;
+}
+
+#endif // BOARD_H
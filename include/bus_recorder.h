@@ -0,0 +1,99 @@
+#ifndef BUS_RECORDER_H
+#define BUS_RECORDER_H
+
+#include <Arduino.h>
+#include "system_clock.h"
+
+typedef enum
+{
+    BUS_CHANNEL_VISIFERM = 0, // Modbus frames of the VisiFerm, tag: Modbus address
+    BUS_CHANNEL_GMP251,       // ASCII replies of the GMP251
+    BUS_CHANNEL_ATLAS,        // Status byte and ASCII reply of the Atlas EZO circuits, tag: I2C address
+    BUS_CHANNEL_SHT40,        // Raw measurement of the SHT40
+    BUS_CHANNEL_O2_SENSOR,    // Registers of the O2 sensor, tag: first register read
+    BUS_CHANNEL_COMMAND,      // Commands received on the serial port
+
+    BUS_CHANNEL_MAX
+} eBusChannel;
+
+typedef enum
+{
+    BUS_RECORDER_IDLE = 0,
+    BUS_RECORDER_CAPTURING,
+    BUS_RECORDER_REPLAYING,
+
+    BUS_RECORDER_MODE_MAX
+} eBusRecorderMode;
+
+/**
+ * @class BusRecorder
+ * @brief Records the raw data received by the drivers and feeds it back to them to rerun an incident.
+ *
+ * Each driver gives the bytes it received to record() right where it reads its bus. In replay mode, the drivers take
+ * their bytes from replay() instead of the bus, so the parsing and the controllers run the same code as during the
+ * capture. A recorded exchange is only replayed once the same time has elapsed since the start of the replay.
+ *
+ * The records are kept in a ring buffer, the oldest ones are dropped when it is full. Record format:
+ * [timestamp (ms, 4 bytes LE)][channel][tag][length][data (length bytes)]
+ * The buffer is printed and loaded as one hexadecimal "REC=" line per record.
+ */
+class BusRecorder
+{
+public:
+    BusRecorder();
+
+    void startCapture();
+    bool startReplay();
+    void stop();
+    void clear();
+    void update();
+
+    void record(eBusChannel channel, uint8_t tag, const uint8_t *data, uint16_t length);
+    uint16_t replay(eBusChannel channel, uint8_t tag, uint8_t *data, uint16_t maxLength);
+
+    void dump(Print &output) const;
+    bool load(const String &line);
+
+    eBusRecorderMode getMode() const { return this->mode; }
+    bool isCapturing() const { return this->mode == BUS_RECORDER_CAPTURING; }
+    bool isReplaying() const { return this->mode == BUS_RECORDER_REPLAYING; }
+    uint16_t getRecordCount() const { return this->recordCount; }
+    uint32_t getDroppedCount() const { return this->droppedCount; }
+    uint16_t getReplayedCount() const;
+
+    static constexpr uint16_t MAX_DATA_LENGTH = 255;
+
+private:
+    static constexpr uint32_t BUFFER_SIZE = 16384; // Bytes kept in RAM, about 80 s of a running culture with every sensor
+
+    void appendRecord(uint32_t timestamp, uint8_t channel, uint8_t tag, const uint8_t *data, uint8_t length);
+    void dropOldestRecord();
+    uint8_t readByte(uint32_t offset) const { return this->buffer[(this->tail + offset) % BUFFER_SIZE]; }
+    uint32_t readTimestamp(uint32_t offset) const;
+    uint32_t getRecordSize(uint32_t offset) const { return HEADER_SIZE + readByte(offset + LENGTH_INDEX); }
+
+    eBusRecorderMode mode;
+    uint8_t buffer[BUFFER_SIZE];
+    uint32_t head;      // Next byte written, index in the buffer
+    uint32_t tail;      // Oldest record, index in the buffer
+    uint32_t usedBytes; // Bytes between tail and head
+    uint16_t recordCount;
+    uint32_t droppedCount;
+
+    // Replay state, offsets from the tail
+    unsigned long replayStartTime;
+    uint32_t firstTimestamp;
+    uint32_t lastTimestamp;
+    uint32_t firstPendingOffset; // All the records before this one were replayed
+
+    static constexpr uint8_t HEADER_SIZE = 7;
+    static constexpr uint8_t CHANNEL_INDEX = 4;
+    static constexpr uint8_t TAG_INDEX = 5;
+    static constexpr uint8_t LENGTH_INDEX = 6;
+    static constexpr uint8_t REPLAYED_FLAG = 0x80;            // Set on the channel of a record once replayed
+    static constexpr unsigned long REPLAY_END_TIMEOUT = 5000; // ms after the last record, for records no driver asked for
+};
+
+extern BusRecorder busRecorder;
+
+#endif // BUS_RECORDER_H
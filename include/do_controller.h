@@ -0,0 +1,51 @@
+#ifndef DO_CONTROLLER_H
+#define DO_CONTROLLER_H
+
+#include <Arduino.h>
+#include "system_clock.h"
+
+/**
+ * @class DoController
+ * @brief Outer loop of the dissolved oxygen, sets the O2 reference of the pressure chamber.
+ *
+ * A PI controller adds a correction to the nominal O2 level set by the user, the chamber controller then doses
+ * the O2 to reach it. The O2 reference is kept within configured limits, the integral term is only accumulated
+ * when the reference is not limited in the direction of the error, so it does not wind up while the chamber
+ * cannot follow (anti-windup by conditional integration).
+ *
+ * Only fresh DO samples are used, the same sample is not integrated twice.
+ */
+class DoController
+{
+public:
+    DoController();
+    bool update(float doLevel, unsigned long sampleAge);
+    bool update(float doLevel, unsigned long sampleAge, unsigned long currentTime);
+    void reset();
+    void setReferenceDo(float doRef) { this->doRef = doRef; }
+    void setNominalO2Level(float o2Level);
+    bool setO2Limits(float minLevel, float maxLevel);
+    float getO2Level() const { return this->o2Level; }
+
+private:
+    float doRef;           // %sat
+    float nominalO2Level;  // %, reference set by the user, the level after a reset
+    float o2Level;         // %, reference given to the pressure chamber
+    float minO2Level;      // %
+    float maxO2Level;      // %
+    float integralTerm;    // %, O2 added to the nominal level by the integral
+    unsigned long lastSampleTime;
+    unsigned long prevTime;
+    bool isStarted;        // prevTime is known
+
+    // Constants for the control loop.
+    static constexpr float KP = 0.5f;                     // % O2 per %sat
+    static constexpr float KI = 0.0003f;                  // % O2 per %sat.s, integral time of about 30 min
+    static constexpr float DO_DEAD_BAND = 1.0f;           // %sat, no integration within
+    static constexpr float MIN_O2_LEVEL = 21.0f;          // %, default limits, air
+    static constexpr float MAX_O2_LEVEL = 95.0f;          // %
+    static constexpr unsigned long MAX_SAMPLE_AGE = 2000; // ms, the VisiFerm is read every 500 ms
+    static constexpr float MILLIS_TO_SECONDS = 1000.0f;
+};
+
+#endif // DO_CONTROLLER_H
@@ -0,0 +1,60 @@
+#ifndef DRIVER_STATS_H
+#define DRIVER_STATS_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Cumulative counters of the exchanges of a driver with its device, since startup.
+ */
+typedef struct
+{
+    uint32_t requests;     // Measurements requested to the device
+    uint32_t successes;    // Valid measurements received
+    uint32_t timeouts;     // No response in time
+    uint32_t busErrors;    // Request not acknowledged or incomplete read (I2C NACK, short read, ADC read error)
+    uint32_t crcErrors;    // Response received with an invalid checksum
+    uint32_t parseErrors;  // Response received but malformed
+    uint32_t deviceErrors; // Valid response reporting an error or an out of range value
+    uint32_t retries;      // Extra polls or resynchronizations needed to get a response
+    uint32_t bytesSent;
+    uint32_t bytesReceived;
+    uint32_t minLatency; // µs, from the request to the valid response
+    uint32_t maxLatency; // µs
+    uint64_t totalLatency;
+    uint32_t latencyCount;
+} sDriverStats;
+
+/**
+ * @class DriverStats
+ * @brief Health and performance counters of a driver, kept by each driver and never overwritten.
+ *
+ * The status enums of the drivers only hold the result of the last exchange, these counters keep the history of
+ * the transient errors to size the polling rates and find the failing cables.
+ */
+class DriverStats
+{
+public:
+    DriverStats();
+    void reset();
+
+    void addRequest() { this->stats.requests++; }
+    void addSuccess() { this->stats.successes++; }
+    void addTimeout() { this->stats.timeouts++; }
+    void addBusError() { this->stats.busErrors++; }
+    void addCrcError() { this->stats.crcErrors++; }
+    void addParseError() { this->stats.parseErrors++; }
+    void addDeviceError() { this->stats.deviceErrors++; }
+    void addRetry() { this->stats.retries++; }
+    void addBytesSent(uint32_t count) { this->stats.bytesSent += count; }
+    void addBytesReceived(uint32_t count) { this->stats.bytesReceived += count; }
+    void addLatency(uint32_t latency);
+
+    const sDriverStats &get() const { return this->stats; }
+    uint32_t getAverageLatency() const;
+    void print(Print &output) const;
+
+private:
+    sDriverStats stats;
+};
+
+#endif // DRIVER_STATS_H
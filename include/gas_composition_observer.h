@@ -0,0 +1,69 @@
+#ifndef GAS_COMPOSITION_OBSERVER_H
+#define GAS_COMPOSITION_OBSERVER_H
+
+#include <Arduino.h>
+
+/**
+ * @brief State of the Kalman filter for one gas of the pressure chamber.
+ *
+ * The state holds the real concentration in the chamber and the concentration seen by the sensor,
+ * which lags behind the real one because of the sensor response time.
+ */
+typedef struct
+{
+    float chamberLevel; // Estimated concentration in the chamber
+    float sensorLevel;  // Estimated concentration seen by the sensor
+    float p[2][2];      // Covariance of the estimation error
+} sGasEstimate;
+
+/**
+ * @class GasCompositionObserver
+ * @brief Kalman filter estimating the O2 and CO2 concentration of the pressure chamber between sensor readings.
+ *
+ * The prediction step uses the gas volumes added by the valves (computed from the valve open times and the flow model
+ * of the PressureChamberController) and a first order model of the sensor response time. The correction step is done
+ * each time a new sensor sample is available.
+ *
+ * O2 is expressed in % and CO2 in ppm, like the sensors.
+ */
+class GasCompositionObserver
+{
+public:
+    GasCompositionObserver();
+    void predict(float dt, float addedO2Volume, float addedCo2Volume, float addedAirVolume);
+    void correctO2(float o2Concentration);
+    void correctCo2(float co2Concentration);
+    float getO2() const { return this->o2.chamberLevel; }
+    float getCo2() const { return this->co2.chamberLevel; }
+    bool isInitialized() const { return this->isO2Initialized && this->isCo2Initialized; }
+
+    // Composition of the gas supplies
+    static constexpr float O2_IN_AIR = 20.9f;           // % O2 in the air supply
+    static constexpr float CO2_IN_AIR = 400.0f;         // ppm CO2 in the air supply
+    static constexpr float O2_IN_O2_TANK = 100.0f;      // % O2 in the O2 tank
+    static constexpr float CO2_IN_CO2_TANK = 1000000.0; // ppm CO2 in the CO2 tank
+
+private:
+    static void predictGas(sGasEstimate &gas, float dt, float addedVolume, float addedGas, float sensorTimeConstant, float processNoise);
+    static void correctGas(sGasEstimate &gas, float measurement, float measurementNoise);
+    static void initGas(sGasEstimate &gas, float measurement, float measurementNoise);
+
+    sGasEstimate o2;
+    sGasEstimate co2;
+    bool isO2Initialized;
+    bool isCo2Initialized;
+
+    static constexpr float V = 1.296; // Volume of the pressure chamber (L)
+
+    // Sensor models (first order response, time constant = T63)
+    static constexpr float O2_SENSOR_TIME_CONSTANT = 6.0f;   // s, DFRobot O2 sensor T90 < 15 s
+    static constexpr float CO2_SENSOR_TIME_CONSTANT = 20.0f; // s, GMP251 with filtering enabled
+
+    // Noise parameters (to tune)
+    static constexpr float O2_PROCESS_NOISE = 0.01f;        // %^2/s, cells uptake and leaks not in the model
+    static constexpr float CO2_PROCESS_NOISE = 2500.0f;     // ppm^2/s, cells production and leaks not in the model
+    static constexpr float O2_MEASUREMENT_NOISE = 0.25f;    // %^2
+    static constexpr float CO2_MEASUREMENT_NOISE = 40000.0; // ppm^2
+};
+
+#endif // GAS_COMPOSITION_OBSERVER_H
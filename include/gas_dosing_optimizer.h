@@ -0,0 +1,62 @@
+#ifndef GAS_DOSING_OPTIMIZER_H
+#define GAS_DOSING_OPTIMIZER_H
+
+#include <Arduino.h>
+
+constexpr uint8_t DOSING_VALVE_COUNT = 3; // O2, CO2 and air valves, in the order of eValves
+constexpr uint8_t MIXTURE_GAS_COUNT = 2;  // O2 and CO2, in the order of eValves
+
+/**
+ * @brief Dosing problem to solve, levels are in % for O2 and in ppm for CO2.
+ */
+typedef struct
+{
+    float level[MIXTURE_GAS_COUNT];       // Current concentration in the chamber
+    float reference[MIXTURE_GAS_COUNT];   // Concentration to reach
+    float tolerance[MIXTURE_GAS_COUNT];   // Error considered as acceptable, used to weight the gases against each other
+    float maxVolume[DOSING_VALVE_COUNT];  // Maximum volume each valve can add in one dosing (L)
+    float volumeBudget;                   // Maximum total volume that can be added before reaching the pressure limit (L)
+} sGasDosingProblem;
+
+/**
+ * @class GasDosingOptimizer
+ * @brief Computes the gas volumes to add with the O2, CO2 and air valves together.
+ *
+ * Every gas added dilutes the others, so after adding the volumes v the chamber concentrations are
+ * c = (level * V + S * v) / (V + sum(v)) where S holds the composition of each gas supply.
+ * Reaching the reference is the linear equation (S - reference * 1^T) * v = (reference - level) * V,
+ * solved in the least-squares sense with 0 <= v <= maxVolume and sum(v) <= volumeBudget.
+ *
+ * The problem has 3 variables only, so it is solved exactly by enumerating the active constraints.
+ */
+class GasDosingOptimizer
+{
+public:
+    void solve(const sGasDosingProblem &problem, float volumes[DOSING_VALVE_COUNT]) const;
+
+private:
+    enum eBound : uint8_t
+    {
+        BOUND_FREE = 0,
+        BOUND_LOWER,
+        BOUND_UPPER,
+
+        eBound_MAX
+    };
+
+    bool solveActiveSet(const double a[MIXTURE_GAS_COUNT][DOSING_VALVE_COUNT], const double b[MIXTURE_GAS_COUNT],
+                        const sGasDosingProblem &problem, const eBound bounds[DOSING_VALVE_COUNT], bool isBudgetActive,
+                        double volumes[DOSING_VALVE_COUNT]) const;
+    double cost(const double a[MIXTURE_GAS_COUNT][DOSING_VALVE_COUNT], const double b[MIXTURE_GAS_COUNT],
+                const double volumes[DOSING_VALVE_COUNT]) const;
+    static bool solveLinearSystem(double m[][DOSING_VALVE_COUNT + 2], uint8_t n, double x[]);
+
+    static constexpr float V = 1.296; // Volume of the pressure chamber (L)
+
+    // Cost of each gas (per L^2), the air is cheap compared to the bottled gases
+    static constexpr double GAS_COST[DOSING_VALVE_COUNT] = {1.0, 1.0, 0.01};
+    static constexpr double FEASIBILITY_TOLERANCE = 1e-9; // L
+    static constexpr double PIVOT_TOLERANCE = 1e-12;
+};
+
+#endif // GAS_DOSING_OPTIMIZER_H
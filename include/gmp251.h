@@ -3,6 +3,9 @@
 
 #include <Arduino.h>
 #include <HardwareSerial.h>
+#include "bus_recorder.h"
+#include "driver_stats.h"
+#include "system_clock.h"
 
 typedef enum
 {
@@ -30,13 +33,18 @@ public:
     eGMP251Status begin();
     eGMP251Status update();
     float getCO2();
-    eGMP251Status getStatus() { return status; }
+    eGMP251Status getStatus() const { return status; }
+    unsigned long getLastSampleTime() const { return lastSampleTime; }
+    const DriverStats &getStats() const { return stats; }
     void calibrateCO2(uint32_t referencePpm);
     void calibrateTemperature(float temperature);
     void calibratePressure(float pressure);
     void calibrateOxygen(float oxygen);
+    void setPressureCompensation(float pressure);
     void setTemperatureCompensation(const String &mode);
 
+    static eGMP251Status parseResponse(const String &response, float &co2);
+
 private:
     eGMP251Status parseCO2();
     String readResponse();
@@ -44,18 +52,25 @@ private:
     void sendCarriageReturns();
     void sendCommand(const String &command);
     void clearBuffer();
+    void requestMeasurement();
 
     HardwareSerial _serial;
     uint8_t _rxPin, _txPin, _dePin;
-    uint32_t lastReadTime;
+    unsigned long lastReadTime;
+    unsigned long lastSampleTime;
     eGMP251Status status;
     float co2;
+    float compensationPressure;
+    bool isCompensationPending;
+    uint64_t requestTime; // µs, the response is read at the next update
+    DriverStats stats;
 
     // Constants
     static constexpr uint8_t NUM_CARRIAGE_RETURNS = 5;
     static constexpr uint32_t READ_INTERVAL_MS = 500;
     static constexpr uint32_t BAUD_RATE = 19200;
-    static constexpr uint8_t CO2_STRING_LENGTH = 4; // "CO2="
+    static constexpr uint8_t CO2_STRING_LENGTH = 4;                // "CO2="
+    static constexpr float COMPENSATION_PRESSURE_THRESHOLD = 5.0f; // hPa, smaller changes are not sent to the sensor
 };
 
 #endif // GMP251_H
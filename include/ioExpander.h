@@ -2,6 +2,8 @@
 #define io_EXPANDER_H
 #include <Arduino.h>
 #include <Wire.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 // Be careful to place the IO Expander initialization first in the logic
 // to ensure the loads are not activated unintentionally.
@@ -11,6 +13,9 @@
  * @brief Interface class for controlling eFuses and debug LEDs through
  *        the PI4IOE5V6524 I²C I/O Expander
  *
+ * setInhibited() latches a channel off, it can be called from another task (safety interlock): the output is cut at
+ * once and setEfuse() cannot turn it on again until the inhibit is released.
+ *
  * @see Datasheet: https://www.diodes.com/assets/Datasheets/PI4IOE5V6524.pdf
  */
 class IOExpander
@@ -21,6 +26,7 @@ public:
     bool begin();
 
     void setEfuse(uint8_t channel, bool outputState);
+    void setInhibited(uint8_t channel, bool isInhibited);
 
     // --- Constants ---
     static constexpr uint8_t OUTPUT_COUNT = 24;         ///< 20 eFuses + 4 debug LEDs
@@ -29,10 +35,12 @@ public:
 
 private:
     TwoWire *_pWire;
+    SemaphoreHandle_t _lock; ///< The outputs are also cut by the safety interlock task
 
     // --- Internal output registers mirror ---
     static constexpr uint8_t IOE_PORT_BYTES = 3;
     uint8_t _outputs[IOE_PORT_BYTES] = {REGISTER_OFF, REGISTER_OFF, REGISTER_OFF};
+    uint8_t _inhibited[IOE_PORT_BYTES] = {REGISTER_OFF, REGISTER_OFF, REGISTER_OFF}; ///< Channels latched off by setInhibited()
 
     // --- PI4IOE5V6524 register addresses ---
     static constexpr uint8_t IOE_I2C_ADDRESS = (0x46 >> 1); ///< 7-bit I²C address
@@ -3,8 +3,10 @@
 
 #include <Arduino.h>
 #include <Preferences.h>
+#include "system_clock.h"
 #include "SHT40.h"
 #include "stepper_motor.h"
+#include "pump_registry.h"
 #include "ssr_relay.h"
 #include "ioExpander.h"
 #include "pins.h"
@@ -20,6 +22,14 @@
 #include "AtlasTempSensor.h"
 #include "limitSwitch.h"
 #include "ledI2C.h"
+#include "pressure_sensor.h"
+#include "bus_recorder.h"
+#include "sensor_inputs.h"
+#include "sensor_manager.h"
+#include "safety_interlock.h"
+#include "recipe_engine.h"
+#include "ph_controller.h"
+#include "do_controller.h"
 
 enum class eBioreactorState
 {
@@ -40,18 +50,14 @@ enum class eBioreactorState
     OPEN_VALVES,
     SAMPLING,
     HEATING,
+    RECIPE,
 
     MAX_STATE
 };
 
 // Objects declaration (extern to be used both in main.cpp and bioreactor_controller.cpp)
 extern SHT40 sht40;
-extern DriveTmc5041 driveStepper1;
-extern DriveTmc5041 driveStepper3;
-extern StepperMotor approvPump;
-extern StepperMotor circulationPump;
-extern StepperMotor cultureChamberPump1;
-extern StepperMotor cultureChamberPump2;
+extern PumpRegistry pumpRegistry;
 extern SSR_Relay heater;
 extern IOExpander ioExpander;
 extern TemperatureController temperatureController;
@@ -63,6 +69,12 @@ extern LimitSwitch limitSwitch;
 extern LedI2C ledI2C;
 extern Preferences bioreactorParameter;
 extern PressureChamberController pressureChamber;
+extern PressureSensor pressureSensor;
+extern SensorManager sensorManager;
+extern SafetyInterlock safetyInterlock;
+extern RecipeEngine recipeEngine;
+extern PhController phController;
+extern DoController doController;
 
 // Global variables
 extern eBioreactorState bioreactorState;
@@ -70,6 +82,7 @@ extern unsigned long lastTemperatureControllerTime;
 extern unsigned long lastPrintTime;
 extern uint8_t testState;
 extern unsigned long stateTimer;
+extern int8_t phBasePumpIndex;
 
 // Global constants
 static constexpr bool OPEN = HIGH;
@@ -80,9 +93,23 @@ static constexpr uint8_t PUMP_MAX_SPEED = 255;
 static constexpr unsigned long TEMPERATURE_CONTROLLER_UPDATE_INTERVAL = 1000;
 static constexpr unsigned long MINUTE = 60000;
 static constexpr unsigned long PRINT_UPDATE_INTERVAL = 1000;
-static constexpr unsigned long PRESSURE_CHAMBER_CONTROLLER_UPDATE_INTERVAL = 60000; // Based on the GMP251 response time
-static constexpr unsigned long MOTOR_SET_SPEED_MSG_INTERVAL = 1250;
+static constexpr unsigned long PRESSURE_CHAMBER_CONTROLLER_UPDATE_INTERVAL = 10000; // The dosing uses the observer estimate so it does not wait for the GMP251 response time
+static constexpr unsigned long GAS_OBSERVER_UPDATE_INTERVAL = 1000;
+static constexpr unsigned long PH_CONTROLLER_UPDATE_INTERVAL = 60000; // The pH follows a CO2 change within minutes
+static constexpr float PH_BASE_PULSE_FLOW = 10.0f;                    // ml/min, slow so the base mixes in the circulation
+static constexpr unsigned long DO_CONTROLLER_UPDATE_INTERVAL = 60000; // Outer loop, slower than the pressure chamber controller
+static constexpr int8_t NO_PUMP = -1;
+static constexpr float PA_TO_HPA = 0.01f;
+static constexpr float APPROV_VOLUME = 230.0f;         // ml, supplied by the approv pump in APPROV, what 220 "ml/min" for 5 min moved with the shipped velocity scale (1100 / 4.79)
+static constexpr float APPROV_FLOW = 220.0f;           // ml/min
+static constexpr float SAMPLING_VOLUME = -12.5f;       // ml, drawn back by the approv pump in SAMPLING, what 80 "ml/min" for 45 s moved with the shipped velocity scale (60 / 4.79)
+static constexpr float SAMPLING_FLOW = 80.0f;          // ml/min
+static constexpr float DOSING_TIMEOUT_FACTOR = 2.0f;   // Phase ended after this many times the nominal dosing duration if the volume is not reached
+static constexpr float PUMP_CALIBRATION_RUN_TIME = 1.0f; // min, duration of a calibration run
+static constexpr float MEDIUM_DENSITY = 1.0f;          // g/ml, to convert the weighed mass of a calibration run
 static constexpr unsigned long LED_UPDATE_INTERVAL = 1000;
 static constexpr unsigned long SERIAL_BAUDRATE = 115200;
+static constexpr unsigned long CONTROLLER_HEARTBEAT_DEADLINE = 10000; // The controllers and the telemetry run every second
+static constexpr unsigned long PHASE_SAVE_INTERVAL = 60000;            // Saves of the elapsed time of the state to the flash, the RTC memory is updated every loop
 
 #endif
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef PH_CONTROLLER_H
+#define PH_CONTROLLER_H
+
+#include <Arduino.h>
+#include "system_clock.h"
+
+/**
+ * @class PhController
+ * @brief Holds the pH of the medium by trimming the CO2 reference of the pressure chamber, with base pulses as a
+ * last resort.
+ *
+ * The medium is buffered by bicarbonate, so at a constant bicarbonate level (Henderson-Hasselbalch):
+ * pH = pKa + log10([HCO3-] / (s * pCO2)), a pH error e is corrected by multiplying the CO2 level by 10^e.
+ * Each update applies a damped part of this correction, limited to MAX_CO2_RATIO_STEP and to the CO2 range of the
+ * chamber. When the pH stays too low with the CO2 at its minimum, a base pulse is requested, at most every
+ * BASE_PULSE_INTERVAL to let the medium mix.
+ *
+ * Only fresh pH samples are used, the same sample is not integrated twice.
+ */
+class PhController
+{
+public:
+    PhController();
+    bool update(float ph, unsigned long sampleAge);
+    bool update(float ph, unsigned long sampleAge, unsigned long currentTime);
+    void reset();
+    void setReferencePh(float phRef) { this->phRef = phRef; }
+    void setNominalCo2Level(float co2Level);
+    void setBaseEnabled(bool isEnabled) { this->isBaseEnabled = isEnabled; }
+    float getCo2Level() const { return this->co2Level; }
+    float getBasePulseVolume();
+
+private:
+    float phRef;
+    float nominalCo2Level; // ppm, reference set by the user, the level after a reset
+    float co2Level;        // ppm, trimmed reference given to the pressure chamber
+    bool isBaseEnabled;
+    float basePulseVolume; // ml, requested and not yet taken by getBasePulseVolume()
+    unsigned long lastSampleTime;
+    unsigned long lastBasePulseTime;
+    bool isBasePulseDone;
+
+    // Constants for the control loop.
+    static constexpr float PH_DEAD_BAND = 0.05f;                 // pH, no correction within
+    static constexpr float BASE_DEAD_BAND = 0.1f;                // pH below the reference before a base pulse
+    static constexpr float CO2_GAIN = 0.5f;                      // Part of the model correction applied by one update
+    static constexpr float MAX_CO2_RATIO_STEP = 1.2f;            // Change of the CO2 level by one update, up or down
+    static constexpr float MIN_CO2_LEVEL = 5000.0f;              // ppm
+    static constexpr float MAX_CO2_LEVEL = 150000.0f;            // ppm
+    static constexpr unsigned long MAX_SAMPLE_AGE = 5000;        // ms, a conversion of the EZO circuit takes up to 900 ms
+    static constexpr float BASE_PULSE_VOLUME = 1.0f;             // ml
+    static constexpr unsigned long BASE_PULSE_INTERVAL = 600000; // ms between two base pulses
+};
+
+#endif // PH_CONTROLLER_H
@@ -66,4 +66,7 @@ constexpr uint8_t HEATER_PIN = 4;
 // LIMIT SWITCH
 constexpr uint8_t LIMIT_SWITCH_PIN = 13;
 
+// PRESSURE SENSOR (must be an ADC1 pin, ADC1_CH0)
+constexpr uint8_t PRESSURE_SENSOR_PIN = 36;
+
 #endif // PINS_H
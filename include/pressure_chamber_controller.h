@@ -2,7 +2,12 @@
 #define PRESSURE_CHAMBER_CONTROLLER_H
 
 #include <Arduino.h>
+#include "system_clock.h"
 #include "gmp251.h"
+#include "gas_composition_observer.h"
+#include "gas_dosing_optimizer.h"
+
+static constexpr float ATMOSPHERIC_PRESSURE = 101325.0f; // Pa, to convert the gauge pressure to absolute
 
 typedef enum
 {
@@ -24,21 +29,38 @@ class PressureChamberController
 public:
     PressureChamberController();
     void update(float o2Concentration, float co2Concentration, float pressure);
+    void update(float o2Concentration, float co2Concentration, float pressure, unsigned long currentTime);
     void updateO2(float o2Concentration, float co2Concentration, float pressure);
     void updateCo2(float o2Concentration, float co2Concentration, float pressure);
     void updatePressure(float o2Concentration, float co2Concentration, float pressure);
     bool getValveState(eValves Valve) const;
+    bool getValveState(eValves Valve, unsigned long currentTime) const;
     void setReferenceLevel(eValves Valve, float ReferenceLevel);
     void setPressureChamberState(bool state) { this->pressureChamberState = state; }
+    bool getPressureChamberState() const { return this->pressureChamberState; }
+    void updateObserver(float o2Concentration, bool isO2New, float co2Concentration, bool isCo2New);
+    void updateObserver(float o2Concentration, bool isO2New, float co2Concentration, bool isCo2New, unsigned long currentTime);
+    float getEstimatedLevel(eValves Valve) const;
+    bool isEstimationReady() const { return this->observer.isInitialized(); }
 
 private:
-    float calculateTimeBeforeClosingValve(eValves Valve, float error);
+    float getValveFlowRate(eValves Valve) const;
+    float getEffectiveFlowRate(eValves Valve) const;
+    unsigned long getValveOpenTime(eValves Valve, unsigned long from, unsigned long to) const;
 
     // Control loop parameters.
     bool pressureChamberState;
     unsigned long timeBeforeClosingO2Valve;
     unsigned long timeBeforeClosingCO2Valve;
     unsigned long timeBeforeClosingAirValve;
+    unsigned long valveOpeningTime;
+
+    // Estimation of the chamber composition between sensor readings.
+    GasCompositionObserver observer;
+    unsigned long lastObserverUpdateTime;
+
+    // Computes the O2, CO2 and air valves together.
+    GasDosingOptimizer dosingOptimizer;
 
     // Reference values.
     float o2MinRef;
@@ -63,26 +85,21 @@ private:
     static constexpr float P_APPROV = 30 * 6895;                 // Pressure of the O2 and CO2 tanks (Pa)
     static constexpr float P_CHAMBER = 25 * 6895;                // Pressure of the pressure chamber (Pa)
     static constexpr float P_CHAMBER_MIN = P_CHAMBER - 2 * 6895; // Minimum pressure in the chamber (Pa) is 2 psi less than the setpoint
+    static constexpr float P_CHAMBER_MAX = P_CHAMBER + 2 * 6895; // Maximum pressure reached when adding gas (Pa) is 2 psi more than the setpoint
     static constexpr float V = 1.296;                            // Volume of the pressure chamber (L)
 
     // Constants for the control loop.
     static constexpr float O2_REF = 85.0f;
-    static constexpr float CO2_REF = 50000.0f;                      // ppm
-    static constexpr float CO2_DEAD_ZONE = 100.0f;                  // ppm
-    static constexpr float O2_DEAD_ZONE = 0.1f;                     // % O2
-    static constexpr float PERCENT_TO_LITERS = 0.01 * V;            // Convert percentage to liters
-    static constexpr float PPM_TO_LITERS = 0.000001 * V;            // Convert ppm to liters
-    static constexpr float SECONDS_TO_MILLIS = 1000.0f;             // Convert seconds to milliseconds
-    static constexpr float CO2_DISPLACEMENT_RATIO = 0.2f;           // Empirical factor to tune
-    static constexpr float AIR_VALVE_OPEN_TIME = 1000.0f;           // Time to open the air valve (ms)
-    static constexpr float CORRECTION_FACTOR_O2 = 2.0f;             // Correction factor for O2
-    static constexpr float CORRECTION_FACTOR_O2_REDUCTION = 40.0f;  // Correction factor for O2 reduction
-    static constexpr float CORRECTION_FACTOR_CO2 = 1.0f;            // Correction factor for CO2
-    static constexpr float CORRECTION_FACTOR_CO2_REDUCTION = 30.0f; // Correction factor for CO2 reduction
-    static constexpr float CORRECTION_FACTOR_O2_SMALL = CORRECTION_FACTOR_O2 * 3.0f;
-    static constexpr float CORRECTION_FACTOR_CO2_SMALL = CORRECTION_FACTOR_CO2 * 4.0f;
-    static constexpr float SMALL_O2_ERROR_THRESHOLD = 10.0f;     // 5% O2
-    static constexpr float SMALL_CO2_ERROR_THRESHOLD = 15000.0f; // 5000 ppm CO2
+    static constexpr float CO2_REF = 50000.0f;            // ppm
+    static constexpr float CO2_DEAD_ZONE = 100.0f;        // ppm
+    static constexpr float O2_DEAD_ZONE = 0.1f;           // % O2
+    static constexpr float SECONDS_TO_MILLIS = 1000.0f;   // Convert seconds to milliseconds
+    static constexpr float CO2_DISPLACEMENT_RATIO = 0.2f; // Empirical factor to tune
+    static constexpr float AIR_VALVE_OPEN_TIME = 1000.0f; // Time to open the air valve when the pressure is low (ms)
+    static constexpr float MAX_VALVE_OPEN_TIME = 5000.0f; // Maximum time a valve is opened by one update (ms)
+    static constexpr float CORRECTION_FACTOR_O2 = 2.0f;   // Ratio between the modeled and the real O2 flow, empirical factor to tune
+    static constexpr float CORRECTION_FACTOR_CO2 = 1.0f;  // Ratio between the modeled and the real CO2 flow, empirical factor to tune
+    static constexpr float CORRECTION_FACTOR_AIR = 30.0f; // Ratio between the modeled and the real air flow, empirical factor to tune
 };
 
 #endif // PRESSURE_CHAMBER_CONTROLLER_H
@@ -0,0 +1,98 @@
+#ifndef PRESSURE_SENSOR_H
+#define PRESSURE_SENSOR_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+#include "driver_stats.h"
+#include "system_clock.h"
+
+typedef enum
+{
+    PRESSURE_SENSOR_STATUS_OK = 0,
+    PRESSURE_SENSOR_STATUS_NOT_INITIALISED,
+    PRESSURE_SENSOR_STATUS_INVALID_PIN,
+    PRESSURE_SENSOR_STATUS_ADC_INIT_FAILED,
+    PRESSURE_SENSOR_STATUS_TASK_CREATION_FAILED,
+    PRESSURE_SENSOR_STATUS_OUT_OF_RANGE,
+
+    PRESSURE_SENSOR_STATUS_MAX
+} ePressureSensorStatus;
+
+/**
+ * @brief Point of the calibration curve of the pressure transducer.
+ */
+typedef struct
+{
+    float voltage;  // Voltage at the ADC pin (mV)
+    float pressure; // Gauge pressure (Pa)
+} sPressureCalibrationPoint;
+
+/**
+ * @brief Analog pressure transducer of the pressure chamber, sampled with the continuous (DMA) mode of the ESP32 ADC.
+ *
+ * The ADC runs in the background at ADC_SAMPLE_FREQUENCY. A low priority task oversamples and decimates the DMA
+ * frames, applies the calibration curve and a low-pass filter, then publishes the pressure with its timestamp.
+ * Reading the pressure from the main loop only copies the cached value.
+ *
+ * The transducer is a ratiometric 0.5-4.5 V, 0-50 psi gauge sensor connected to the ADC through a 2/3 voltage divider.
+ *
+ * @warning The continuous mode takes over ADC1, analogRead() must not be used on ADC1 pins when this driver is running.
+ */
+class PressureSensor
+{
+public:
+    PressureSensor(uint8_t pin);
+
+    ePressureSensorStatus begin();
+    float getPressure() const;
+    unsigned long getAgeMs() const;
+    unsigned long getLastSampleTime() const;
+    ePressureSensorStatus getStatus() const { return _status; }
+    const DriverStats &getStats() const { return _stats; }
+
+private:
+    static void taskEntry(void *pvParameters);
+    void run();
+    void publish(float averageRaw);
+    float voltageToPressure(float voltage) const;
+
+    uint8_t _pin;
+    uint8_t _channel;
+    ePressureSensorStatus _status;
+    esp_adc_cal_characteristics_t _adcCharacteristics;
+    TaskHandle_t _taskHandle;
+    DriverStats _stats; // Written by the task only, a DMA read is a request and a published value a success
+
+    // Decimation state (only used by the task)
+    uint32_t _rawSum;
+    uint32_t _rawCount;
+    float _filteredPressure;
+    bool _isFilterInitialized;
+
+    // Published values, protected by _lock
+    mutable portMUX_TYPE _lock;
+    float _pressure;
+    unsigned long _lastSampleTime;
+
+    static const sPressureCalibrationPoint CALIBRATION_CURVE[];
+    static const uint8_t CALIBRATION_POINT_COUNT;
+
+    static constexpr uint32_t ADC_SAMPLE_FREQUENCY = 20000;                     // Hz, lowest frequency of the continuous mode
+    static constexpr uint32_t OVERSAMPLING_COUNT = 2000;                        // Samples averaged for each published value (10 Hz)
+    static constexpr uint32_t ADC_FRAME_SIZE = 256 * SOC_ADC_DIGI_RESULT_BYTES; // Bytes read from the DMA at once
+    static constexpr uint32_t ADC_BUFFER_SIZE = 4 * ADC_FRAME_SIZE;             // Bytes stored by the driver between two reads
+    static constexpr uint32_t ADC_CONVERSION_LIMIT = 250;                       // Required by the ESP32 continuous mode
+    static constexpr uint32_t ADC_DEFAULT_VREF = 1100;                          // mV, used when the eFuse vref is not burned
+    static constexpr uint32_t ADC_READ_TIMEOUT_MS = 100;
+    static constexpr uint8_t ADC1_CHANNEL_COUNT = 8;
+    static constexpr float FILTER_ALPHA = 0.2f;                                 // Low-pass filter on the decimated values
+    static constexpr float OUT_OF_RANGE_MARGIN = 100.0f;                        // mV outside of the calibration curve
+    static constexpr uint32_t TASK_STACK_SIZE = 3072;
+    static constexpr UBaseType_t TASK_PRIORITY = 1;
+    static constexpr BaseType_t TASK_CORE = 0;                                  // The Arduino loop runs on core 1
+};
+
+#endif // PRESSURE_SENSOR_H
@@ -0,0 +1,67 @@
+#ifndef PUMP_CALIBRATION_H
+#define PUMP_CALIBRATION_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+constexpr uint8_t PUMP_CALIBRATION_MAX_POINTS = 8; // Per direction
+
+typedef enum
+{
+    PUMP_DIRECTION_FORWARD = 0, // + flow
+    PUMP_DIRECTION_REVERSE,     // - flow
+
+    PUMP_DIRECTION_MAX
+} ePumpDirection;
+
+/**
+ * @brief Flow measured when running the pump at a commanded flow, both positive.
+ */
+typedef struct
+{
+    float commanded; // ml/min
+    float measured;  // ml/min
+} sPumpCalibrationPoint;
+
+/**
+ * @brief Calibration points of a pump as saved in the preferences, sorted by commanded flow.
+ */
+typedef struct
+{
+    uint8_t pointCounts[PUMP_DIRECTION_MAX];
+    sPumpCalibrationPoint points[PUMP_DIRECTION_MAX][PUMP_CALIBRATION_MAX_POINTS];
+} sPumpCalibrationTable;
+
+/**
+ * @class PumpCalibration
+ * @brief Flow correction of a peristaltic pump, from a piecewise linear table of commanded vs measured flow.
+ *
+ * The table is inverted into a lookup table of the flow to command for each wanted flow, rebuilt when a point
+ * changes, so a speed change only costs one interpolation between two entries. Without points the flow is not
+ * corrected, with one point the correction is proportional.
+ */
+class PumpCalibration
+{
+public:
+    PumpCalibration();
+
+    bool addPoint(float commandedFlow, float measuredFlow);
+    void clear();
+    float getCommandedFlow(float flow) const;
+
+    bool load(Preferences &preferences, const char *key);
+    void save(Preferences &preferences, const char *key) const;
+    void print(Print &output) const;
+
+private:
+    void buildLut(ePumpDirection direction);
+    float invert(ePumpDirection direction, float flow) const;
+
+    sPumpCalibrationTable table;
+
+    static constexpr uint8_t LUT_SIZE = 51;
+    static constexpr float LUT_STEP = 10.0; // ml/min between two entries, extrapolated above (LUT_SIZE - 1) * LUT_STEP
+    float lut[PUMP_DIRECTION_MAX][LUT_SIZE];
+};
+
+#endif // PUMP_CALIBRATION_H
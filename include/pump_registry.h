@@ -0,0 +1,48 @@
+#ifndef PUMP_REGISTRY_H
+#define PUMP_REGISTRY_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "board.h"
+
+/**
+ * @brief Speed of one pump, to set the pumps by ID.
+ */
+typedef struct
+{
+    ePumpId id;
+    float speed; // ml/min
+} sPumpSpeed;
+
+/**
+ * @class PumpRegistry
+ * @brief Builds the drives and the pumps from DRIVE_TABLE and PUMP_TABLE, and sets the speeds of all the pumps.
+ *
+ * setSpeeds() only writes the pumps whose speed changed, plus every REFRESH_INTERVAL the pumps that still need a
+ * write at the same speed (current release, load sample, end of a volume). The datagrams of the pumps of a drive
+ * are sent in one SPI transaction, so the cost of an update grows with the pumps written, not with the pumps fitted.
+ */
+class PumpRegistry
+{
+public:
+    PumpRegistry(SPIClass *spi);
+
+    void begin();
+    StepperMotor *getPump(uint8_t id);
+    StepperMotor *const *getPumps() const { return this->pumpHandles; }
+    const DriveTmc5041 &getDrive(uint8_t index) const { return this->drives[index]; }
+    void setSpeeds(const float *speeds, unsigned long currentTime);
+    uint8_t getLastWriteCount() const { return this->lastWriteCount; }
+
+private:
+    DriveTmc5041 drives[DRIVE_COUNT];
+    StepperMotor pumps[PUMP_COUNT];
+    StepperMotor *pumpHandles[PUMP_COUNT];
+    unsigned long lastRefreshTime;
+    uint8_t lastWriteCount; // Pumps written by the last setSpeeds()
+
+    static constexpr unsigned long REFRESH_INTERVAL = 1250; // ms between two writes of a pump at the same speed
+    static constexpr uint8_t MAX_DRIVE_DATAGRAMS = MOTOR_NAME_MAX * StepperMotor::MAX_SPEED_DATAGRAMS;
+};
+
+#endif // PUMP_REGISTRY_H
@@ -0,0 +1,131 @@
+#ifndef RECIPE_ENGINE_H
+#define RECIPE_ENGINE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "sensor_manager.h"
+
+constexpr uint8_t RECIPE_MAX_INSTRUCTIONS = 32;
+constexpr uint8_t RECIPE_INSTRUCTION_SIZE = 20; // Bytes of an encoded instruction
+constexpr uint8_t RECIPE_PUMP_COUNT = 4;        // The first pumps of ePumpId: approv, circulation, culture chamber 1 and 2
+constexpr int16_t RECIPE_MAX_FLOW = 300;        // ml/min, pump speed limit of a step
+
+typedef enum
+{
+    RECIPE_OP_STEP = 0, // Set the actuators until the exit condition
+    RECIPE_OP_LOOP,     // Go back to a previous instruction a number of times
+    RECIPE_OP_END,      // End of the recipe, also ends after the last instruction
+
+    RECIPE_OP_MAX
+} eRecipeOpcode;
+
+typedef enum
+{
+    RECIPE_EXIT_TIME = 0,     // After the duration
+    RECIPE_EXIT_VOLUME,       // Once a pump moved the threshold volume (ml), at the speed of the step
+    RECIPE_EXIT_SENSOR_ABOVE, // Once a sensor value is above the threshold
+    RECIPE_EXIT_SENSOR_BELOW, // Once a sensor value is below the threshold
+
+    RECIPE_EXIT_MAX
+} eRecipeExit;
+
+typedef enum
+{
+    RECIPE_OUTPUT_HEATER_FAN = 0,
+    RECIPE_OUTPUT_CIRCULATION_FAN,
+    RECIPE_OUTPUT_RIGHT_FAN,
+    RECIPE_OUTPUT_LEFT_FAN,
+    RECIPE_OUTPUT_PCB_FAN,
+    RECIPE_OUTPUT_LOW_VOLT_FAN,
+    RECIPE_OUTPUT_HIGH_VOLT_FAN,
+    RECIPE_OUTPUT_SUPPLY_VALVE,
+    RECIPE_OUTPUT_CIRCULATION_VALVE,
+    RECIPE_OUTPUT_RETURN_VALVE,
+    RECIPE_OUTPUT_HEATER,
+    RECIPE_OUTPUT_PRESSURE_CHAMBER,
+
+    RECIPE_OUTPUT_MAX
+} eRecipeOutput;
+
+/**
+ * @brief Decoded instruction of a recipe, the fields not used by its opcode are zero.
+ */
+typedef struct
+{
+    uint8_t opcode;                        // eRecipeOpcode
+    uint16_t outputs;                      // STEP: bit (1 << eRecipeOutput) set for ON/OPEN
+    uint8_t exit;                          // STEP: eRecipeExit
+    uint8_t exitSource;                    // STEP: pump index of a volume exit, eSensorId of a sensor exit
+    uint8_t exitIndex;                     // STEP: value index of the sensor
+    uint16_t duration;                     // STEP: s, duration of a timed step, timeout of the others
+    int16_t pumpSpeeds[RECIPE_PUMP_COUNT]; // STEP: ml/min
+    float threshold;                       // STEP: ml for a volume exit (sign for the direction), unit of the sensor value for a sensor exit
+    uint8_t loopTarget;                    // LOOP: index of the first instruction repeated
+    uint8_t loopCount;                     // LOOP: repetitions after the first pass
+} sRecipeInstruction;
+
+/**
+ * @brief Where the interpreter is in the recipe, saved to resume after a reset.
+ */
+typedef struct
+{
+    uint8_t programCounter;
+    uint8_t loopCounts[RECIPE_MAX_INSTRUCTIONS]; // Repetitions done by each LOOP instruction
+} sRecipePosition;
+
+/**
+ * @class RecipeEngine
+ * @brief Interpreter of user-defined process sequences, uploaded over serial and kept in the flash.
+ *
+ * A recipe is a list of fixed size little endian instructions:
+ * - STEP: [0][outputs (2)][exit][exit source][exit index][duration (2)][pump speeds (4 x 2)][threshold (float)]
+ * - LOOP: [1][target][count] then zeros
+ * - END:  [2] then zeros
+ *
+ * The instructions are uploaded one hexadecimal line at a time and only replace the recipe once the whole recipe
+ * is valid: known opcodes and exits, speeds within RECIPE_MAX_FLOW, a duration for every step and only backward
+ * loops to a step. So every recipe ends, each step being bounded by its duration.
+ *
+ * The interpreter only points at the current instruction, the caller applies the step and checks its exit
+ * condition, then calls next(). An instruction costs the same whatever the length of the recipe.
+ */
+class RecipeEngine
+{
+public:
+    RecipeEngine();
+
+    void beginUpload();
+    bool addInstruction(const String &line);
+    bool commitUpload(uint8_t &invalidIndex);
+    uint8_t getInstructionCount() const { return this->instructionCount; }
+
+    bool load(Preferences &preferences, const char *key);
+    void save(Preferences &preferences, const char *key) const;
+    void print(Print &output) const;
+
+    void start();
+    const sRecipeInstruction *getInstruction() const;
+    void next();
+    const sRecipePosition &getPosition() const { return this->position; }
+    bool restore(const sRecipePosition &position);
+
+    /**
+     * @brief Check if a step turns an output ON/OPEN.
+     */
+    static bool isOutputOn(const sRecipeInstruction &step, eRecipeOutput output) { return (step.outputs >> output) & 1; }
+
+private:
+    static void decode(const uint8_t *bytes, sRecipeInstruction &instruction);
+    static bool validate(const uint8_t *program, uint8_t count, uint8_t &invalidIndex);
+    static bool isValidInstruction(const sRecipeInstruction *instructions, uint8_t index);
+
+    uint8_t program[RECIPE_MAX_INSTRUCTIONS * RECIPE_INSTRUCTION_SIZE]; // Encoded, as saved and printed
+    sRecipeInstruction instructions[RECIPE_MAX_INSTRUCTIONS];
+    uint8_t instructionCount;
+    sRecipePosition position;
+
+    uint8_t upload[RECIPE_MAX_INSTRUCTIONS * RECIPE_INSTRUCTION_SIZE];
+    uint8_t uploadCount;
+};
+
+#endif // RECIPE_ENGINE_H
@@ -0,0 +1,104 @@
+#ifndef SAFETY_INTERLOCK_H
+#define SAFETY_INTERLOCK_H
+
+#include <Arduino.h>
+#include "system_clock.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "stepper_motor.h"
+#include "ssr_relay.h"
+#include "ioExpander.h"
+#include "pressure_sensor.h"
+#include "pins.h"
+
+typedef enum
+{
+    INTERLOCK_DOOR_OPEN = 0,    // Pumps stopped
+    INTERLOCK_OVER_TEMPERATURE, // Heater off
+    INTERLOCK_OVER_PRESSURE,    // Gas valves closed
+
+    INTERLOCK_MAX
+} eInterlock;
+
+/**
+ * @brief Trips of an interlock since startup.
+ */
+typedef struct
+{
+    uint32_t tripCount;
+    uint32_t lastLatency; // µs, from the detection to the end of the cutoff
+    uint32_t maxLatency;  // µs
+} sInterlockStats;
+
+/**
+ * @class SafetyInterlock
+ * @brief Cuts the actuators when a safety limit is crossed, from a task that does not wait for the main loop.
+ *
+ * The rules run in a high priority task on core 0, every CHECK_INTERVAL and at once when the door switch
+ * interrupt fires. A trip cuts its actuator directly, without waiting for the main loop:
+ * - door open: the pumps are halted (no current, no speed) under the lock of their drive, the main loop resumes
+ *   them once the trip is cleared,
+ * - water or air over temperature: the heater relay is inhibited until the trip is cleared,
+ * - pressure above the limit: the gas valves are inhibited in the IO expander until the trip is cleared.
+ *
+ * The door trips as soon as it is confirmed open and clears once closed for DOOR_DEBOUNCE_TIME. The temperatures
+ * are given by the main loop at the rate of their sensors, the pressure is read from its acquisition task.
+ */
+class SafetyInterlock
+{
+public:
+    SafetyInterlock(uint8_t doorPin, StepperMotor *const *pumps, uint8_t pumpCount, SSR_Relay &heater,
+                    IOExpander &ioExpander, PressureSensor &pressureSensor);
+
+    bool begin();
+    void setTemperatures(float waterTemperature, float airTemperature);
+
+    bool isTripped(eInterlock interlock) const { return (this->trips & (1 << interlock)) != 0; }
+    uint8_t getTrips() const { return this->trips; }
+    sInterlockStats getStats(eInterlock interlock) const;
+
+    static constexpr float MAX_WATER_TEMPERATURE = 40.0f;  // °C, the culture setpoint is 37 °C
+    static constexpr float MAX_AIR_TEMPERATURE = 55.0f;    // °C
+    static constexpr float TEMPERATURE_HYSTERESIS = 1.0f;  // °C below the limit to clear the trip
+    static constexpr float MAX_PRESSURE = 29 * 6895;       // Pa, 2 psi above the highest pressure reached by the dosing
+    static constexpr float PRESSURE_HYSTERESIS = 1 * 6895; // Pa
+
+private:
+    static void taskEntry(void *pvParameters);
+    static void IRAM_ATTR doorInterrupt();
+    void run();
+    void update(eInterlock interlock, bool isTripCondition, bool isClearCondition, uint32_t detectionTime);
+    void cutoff(eInterlock interlock);
+    void setGasValvesInhibited(bool isInhibited);
+
+    static SafetyInterlock *instance; // For the door interrupt
+
+    uint8_t doorPin;
+    StepperMotor *const *pumps;
+    uint8_t pumpCount;
+    SSR_Relay &heater;
+    IOExpander &ioExpander;
+    PressureSensor &pressureSensor;
+    TaskHandle_t taskHandle;
+
+    volatile uint8_t trips; // Bit per eInterlock, written by the task only
+    unsigned long lastDoorOpenTime;
+
+    // Shared with the interrupt and the main loop, protected by lock
+    mutable portMUX_TYPE lock;
+    bool isDoorEdgePending;
+    uint32_t doorEdgeTime; // micros() of the last door interrupt
+    float waterTemperature;
+    float airTemperature;
+    sInterlockStats stats[INTERLOCK_MAX];
+
+    static constexpr unsigned long CHECK_INTERVAL = 10;      // ms between two evaluations of the rules
+    static constexpr uint32_t DOOR_CONFIRM_TIME = 200;       // µs between the two reads confirming an open door
+    static constexpr unsigned long DOOR_DEBOUNCE_TIME = 500; // ms closed before the door trip clears
+    static constexpr unsigned long PRESSURE_MAX_AGE = 1000;  // ms, older pressures are not evaluated
+    static constexpr uint32_t TASK_STACK_SIZE = 3072;
+    static constexpr UBaseType_t TASK_PRIORITY = 10;         // Above the pressure acquisition and the Arduino loop
+    static constexpr BaseType_t TASK_CORE = 0;               // Not delayed by the blocking calls of the loop on core 1
+};
+
+#endif // SAFETY_INTERLOCK_H
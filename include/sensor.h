@@ -0,0 +1,94 @@
+#ifndef SENSOR_H
+#define SENSOR_H
+
+#include <Arduino.h>
+#include "driver_stats.h"
+
+typedef enum
+{
+    SENSOR_QUALITY_OK = 0,
+    SENSOR_QUALITY_NO_DATA,    // No sample received since startup
+    SENSOR_QUALITY_STALE,      // The last sample is older than the maximum age of the sensor
+    SENSOR_QUALITY_COMM_ERROR, // The sensor does not answer (request failed, timeout, bad frame)
+    SENSOR_QUALITY_DATA_ERROR, // The sensor answers with an invalid value or reports an error
+
+    SENSOR_QUALITY_MAX
+} eSensorQuality;
+
+typedef enum
+{
+    SENSOR_BUS_I2C = 0,
+    SENSOR_BUS_RS485_1, // Serial1, GMP251
+    SENSOR_BUS_RS485_2, // Serial2, VisiFerm
+    SENSOR_BUS_ADC,
+
+    SENSOR_BUS_MAX
+} eSensorBus;
+
+static constexpr uint8_t SENSOR_MAX_VALUES = 2;
+
+/**
+ * @brief Measurement of a sensor.
+ */
+typedef struct
+{
+    float values[SENSOR_MAX_VALUES]; // Unit and order defined by each sensor
+    uint8_t valueCount;
+    unsigned long timestamp; // ms, SystemClock::getMillis() of the measurement
+    eSensorQuality quality;
+} sSensorSample;
+
+/**
+ * @class Sensor
+ * @brief Common non-blocking interface of the sensors, scheduled by the SensorManager.
+ *
+ * poll() advances the driver of the sensor and keeps its latest sample. The drivers keep their own status enums,
+ * each implementation maps them to an eSensorQuality. The manager polls each sensor at its period, so the drivers that
+ * block on their bus (O2 sensor, SHT40) are called at a known rate instead of by each consumer.
+ */
+class Sensor
+{
+public:
+    Sensor(const char *name, eSensorBus bus, unsigned long period, unsigned long maxAge);
+    virtual ~Sensor() {}
+
+    bool poll(unsigned long currentTime);
+    bool hasNewSample() const { return this->isNewSample; }
+    sSensorSample readSample(unsigned long currentTime);
+    sSensorSample getSample(unsigned long currentTime) const;
+    float getValue(uint8_t index = 0) const;
+    unsigned long getTimestamp() const { return this->sample.timestamp; }
+    unsigned long getAgeMs(unsigned long currentTime) const;
+    eSensorQuality getQuality(unsigned long currentTime) const;
+
+    const char *getName() const { return this->name; }
+    eSensorBus getBus() const { return this->bus; }
+    unsigned long getPeriod() const { return this->period; }
+    virtual uint8_t getDriverStatus() const = 0;
+    virtual const DriverStats &getDriverStats() const = 0;
+
+    /**
+     * @brief Map the status of the driver to a quality, SENSOR_QUALITY_OK if the driver has no error.
+     */
+    virtual eSensorQuality getDriverQuality() const = 0;
+
+protected:
+    /**
+     * @brief Advance the driver and get its latest measurement.
+     * @param currentTime Time of the poll (ms).
+     * @param newSample Output measurement, only used if true is returned. The timestamp is set by the driver if it
+     * keeps one, otherwise it is the time of the poll.
+     * @return True if the driver has a measurement that was not returned before.
+     */
+    virtual bool pollDriver(unsigned long currentTime, sSensorSample &newSample) = 0;
+
+private:
+    const char *name;
+    eSensorBus bus;
+    unsigned long period; // Time between two polls (ms)
+    unsigned long maxAge; // Older samples are stale (ms)
+    sSensorSample sample;
+    bool isNewSample;
+};
+
+#endif // SENSOR_H
@@ -0,0 +1,155 @@
+#ifndef SENSOR_INPUTS_H
+#define SENSOR_INPUTS_H
+
+#include <Arduino.h>
+#include "sensor.h"
+#include "AtlasBase.h"
+#include "visiferm_RS485.h"
+#include "gmp251.h"
+#include "O2Sensor.h"
+#include "SHT40.h"
+#include "pressure_sensor.h"
+
+/**
+ * This file contains the Sensor implementations of the drivers. They only wrap the drivers, which stay usable for
+ * the calibration and the configuration commands.
+ */
+
+/**
+ * @brief Atlas EZO circuit (pH or RTD). Values: [pH or °C]
+ */
+class AtlasSensorInput : public Sensor
+{
+public:
+    AtlasSensorInput(const char *name, AtlasBase &atlas)
+        : Sensor(name, SENSOR_BUS_I2C, PERIOD, MAX_AGE), atlas(atlas), lastSampleTime(0) {}
+    uint8_t getDriverStatus() const { return this->atlas.getStatus(); }
+    const DriverStats &getDriverStats() const { return this->atlas.getStats(); }
+    eSensorQuality getDriverQuality() const;
+
+protected:
+    bool pollDriver(unsigned long currentTime, sSensorSample &newSample);
+
+private:
+    AtlasBase &atlas;
+    unsigned long lastSampleTime;
+
+    static constexpr unsigned long PERIOD = 50;    // Poll interval of the EZO response
+    static constexpr unsigned long MAX_AGE = 3000; // A conversion takes up to 900 ms
+};
+
+/**
+ * @brief Hamilton VisiFerm dissolved oxygen sensor. Values: [DO (%sat), temperature (°C)]
+ */
+class VisiFermSensorInput : public Sensor
+{
+public:
+    VisiFermSensorInput(const char *name, VisiFermRS485 &visiFerm)
+        : Sensor(name, SENSOR_BUS_RS485_2, PERIOD, MAX_AGE), visiFerm(visiFerm), lastSampleTime(0) {}
+    uint8_t getDriverStatus() const { return this->visiFerm.getStatus(); }
+    const DriverStats &getDriverStats() const { return this->visiFerm.getStats(); }
+    eSensorQuality getDriverQuality() const;
+
+protected:
+    bool pollDriver(unsigned long currentTime, sSensorSample &newSample);
+
+private:
+    VisiFermRS485 &visiFerm;
+    unsigned long lastSampleTime;
+
+    static constexpr unsigned long PERIOD = 10;    // Collects the Modbus frame bytes as they arrive
+    static constexpr unsigned long MAX_AGE = 2000; // The driver reads the sensor every 500 ms
+};
+
+/**
+ * @brief Vaisala GMP251 CO2 sensor. Values: [CO2 (ppm)]
+ */
+class Gmp251SensorInput : public Sensor
+{
+public:
+    Gmp251SensorInput(const char *name, GMP251 &gmp251)
+        : Sensor(name, SENSOR_BUS_RS485_1, PERIOD, MAX_AGE), gmp251(gmp251), lastSampleTime(0) {}
+    uint8_t getDriverStatus() const { return this->gmp251.getStatus(); }
+    const DriverStats &getDriverStats() const { return this->gmp251.getStats(); }
+    eSensorQuality getDriverQuality() const;
+
+protected:
+    bool pollDriver(unsigned long currentTime, sSensorSample &newSample);
+
+private:
+    GMP251 &gmp251;
+    unsigned long lastSampleTime;
+
+    static constexpr unsigned long PERIOD = 100;   // The driver sends a request every 500 ms
+    static constexpr unsigned long MAX_AGE = 5000;
+};
+
+/**
+ * @brief DFRobot O2 sensor, blocking I2C read. Values: [O2 (%)]
+ */
+class O2SensorInput : public Sensor
+{
+public:
+    O2SensorInput(const char *name, O2Sensor &o2Sensor)
+        : Sensor(name, SENSOR_BUS_I2C, PERIOD, MAX_AGE), o2Sensor(o2Sensor) {}
+    uint8_t getDriverStatus() const { return this->o2Sensor.getStatus(); }
+    const DriverStats &getDriverStats() const { return this->o2Sensor.getStats(); }
+    eSensorQuality getDriverQuality() const;
+
+protected:
+    bool pollDriver(unsigned long currentTime, sSensorSample &newSample);
+
+private:
+    O2Sensor &o2Sensor;
+
+    static constexpr unsigned long PERIOD = 1000; // Rate of the gas composition observer
+    static constexpr unsigned long MAX_AGE = 3000;
+};
+
+/**
+ * @brief Sensirion SHT40 air sensor, blocks 10 ms per read. Values: [temperature (°C), humidity (%RH)]
+ */
+class Sht40SensorInput : public Sensor
+{
+public:
+    Sht40SensorInput(const char *name, SHT40 &sht40)
+        : Sensor(name, SENSOR_BUS_I2C, PERIOD, MAX_AGE), sht40(sht40), status(SHT40_STATUS_NOT_INITIALISED) {}
+    uint8_t getDriverStatus() const { return this->status; }
+    const DriverStats &getDriverStats() const { return this->sht40.getStats(); }
+    eSensorQuality getDriverQuality() const;
+
+protected:
+    bool pollDriver(unsigned long currentTime, sSensorSample &newSample);
+
+private:
+    SHT40 &sht40;
+    eSHT40Status status; // The driver does not keep the status of the last read
+
+    static constexpr unsigned long PERIOD = 1000; // Rate of the temperature controller
+    static constexpr unsigned long MAX_AGE = 3000;
+};
+
+/**
+ * @brief Pressure transducer of the pressure chamber, sampled in the background. Values: [gauge pressure (Pa)]
+ */
+class PressureSensorInput : public Sensor
+{
+public:
+    PressureSensorInput(const char *name, PressureSensor &pressureSensor)
+        : Sensor(name, SENSOR_BUS_ADC, PERIOD, MAX_AGE), pressureSensor(pressureSensor), lastSampleTime(0) {}
+    uint8_t getDriverStatus() const { return this->pressureSensor.getStatus(); }
+    const DriverStats &getDriverStats() const { return this->pressureSensor.getStats(); }
+    eSensorQuality getDriverQuality() const;
+
+protected:
+    bool pollDriver(unsigned long currentTime, sSensorSample &newSample);
+
+private:
+    PressureSensor &pressureSensor;
+    unsigned long lastSampleTime;
+
+    static constexpr unsigned long PERIOD = 100;   // The acquisition task publishes at 10 Hz
+    static constexpr unsigned long MAX_AGE = 1000; // Older pressure values are considered as unavailable
+};
+
+#endif // SENSOR_INPUTS_H
@@ -0,0 +1,67 @@
+#ifndef SENSOR_MANAGER_H
+#define SENSOR_MANAGER_H
+
+#include <Arduino.h>
+#include "sensor.h"
+#include "watchdog.h"
+
+typedef enum
+{
+    SENSOR_ID_DISSOLVED_OXYGEN = 0, // [DO (%sat), temperature (°C)]
+    SENSOR_ID_PH,                   // [pH]
+    SENSOR_ID_WATER_TEMPERATURE,    // [°C]
+    SENSOR_ID_AIR,                  // [temperature (°C), humidity (%RH)]
+    SENSOR_ID_CO2,                  // [CO2 (ppm)]
+    SENSOR_ID_O2,                   // [O2 (%)]
+    SENSOR_ID_PRESSURE,             // [gauge pressure (Pa)]
+
+    SENSOR_ID_MAX
+} eSensorId;
+
+/**
+ * @brief Samples of all the sensors at a given time.
+ */
+typedef struct
+{
+    sSensorSample samples[SENSOR_ID_MAX];
+    unsigned long time;
+} sSensorSnapshot;
+
+/**
+ * @class SensorManager
+ * @brief Polls every sensor at its period and gives a consistent view of their latest samples.
+ *
+ * At most one sensor per bus is polled at each update, the most late one first, so the blocking reads of the I2C
+ * sensors are spread over several loops instead of adding up. The first polls of the sensors sharing a bus are
+ * staggered by STAGGER_INTERVAL for the same reason.
+ *
+ * Each sensor has a watchdog heartbeat, fed when it gives a sample or when its driver reports an error. A sensor
+ * whose driver claims to be fine but gives no sample, or that is never polled, stalls its heartbeat.
+ */
+class SensorManager
+{
+public:
+    SensorManager();
+
+    bool addSensor(eSensorId id, Sensor *sensor);
+    void begin(unsigned long currentTime);
+    void update(unsigned long currentTime);
+
+    Sensor *getSensor(eSensorId id) const;
+    bool hasNewSample(eSensorId id) const;
+    sSensorSample readSample(eSensorId id, unsigned long currentTime);
+    float getValue(eSensorId id, uint8_t index = 0) const;
+    eSensorQuality getQuality(eSensorId id, unsigned long currentTime) const;
+    void getSnapshot(sSensorSnapshot &snapshot, unsigned long currentTime) const;
+    void printDiagnostics(Print &output, unsigned long currentTime) const;
+
+private:
+    Sensor *sensors[SENSOR_ID_MAX];
+    unsigned long nextPollTimes[SENSOR_ID_MAX];
+    int8_t heartbeats[SENSOR_ID_MAX];
+
+    static constexpr unsigned long STAGGER_INTERVAL = 20;       // ms between the first polls of the sensors of a bus
+    static constexpr unsigned long HEARTBEAT_DEADLINE = 30000; // ms without sample nor error before a sensor is stalled
+};
+
+#endif // SENSOR_MANAGER_H
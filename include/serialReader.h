@@ -3,6 +3,7 @@
 
 #include "main.h"
 #include "bioreactor_controller.h"
+#include "bus_recorder.h"
 
 void receiveSerialCommand();
 
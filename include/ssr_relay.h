@@ -2,12 +2,17 @@
 #define SSR_RELAY_H
 
 #include <Arduino.h>
+#include "system_clock.h"
+#include <freertos/FreeRTOS.h>
 
 /**
  * @class SSR_Relay
  * @brief Controls a solid-state relay using a PWM signal.
  *
  * This class allows setting the relay output with a PWM value between 0 and 100.
+ *
+ * setInhibited() latches the output off whatever the level, it can be called from another task (safety interlock):
+ * the output is cut at once and update() cannot drive it again until the inhibit is released.
  */
 class SSR_Relay
 {
@@ -16,7 +21,13 @@ public:
     void begin();
     void setLevel(uint8_t level);
     void update();
+    void update(unsigned long currentTime);
     void off();
+    void setInhibited(bool isInhibited);
+    bool getInhibited() const { return this->isInhibited; }
+    bool getOutputState() const { return this->isOutputOn; }
+
+    static constexpr uint8_t NO_PIN = 0xFF; // Use as pin to run the relay logic without driving an output (simulation)
 
 private:
     static constexpr unsigned long CHECK_INTERVAL = 10;
@@ -25,6 +36,9 @@ private:
     uint8_t levelPWM;
     uint8_t pin;
     uint8_t currentPWMIndex;
+    bool isOutputOn;
+    volatile bool isInhibited;
+    portMUX_TYPE lock; // The output pin is also cut by the safety interlock task
 };
 
 #endif
@@ -2,7 +2,9 @@
 #define STEPPER_MOTOR_H
 
 #include <Arduino.h>
+#include "system_clock.h"
 #include "tmc5041.h"
+#include "pump_calibration.h"
 
 typedef enum
 {
@@ -12,6 +14,15 @@ typedef enum
     MOTOR_NAME_MAX
 } eMotorName;
 
+typedef enum
+{
+    PUMP_EVENT_NONE = 0,
+    PUMP_EVENT_OCCLUSION, // Load above the baseline or stall, pinched or clamped tube
+    PUMP_EVENT_DRY_RUN,   // Load below the baseline, empty supply
+
+    PUMP_EVENT_MAX
+} ePumpEvent;
+
 /**
  * @brief Class to control the individual motors from a TMC5041 drive using a DriveTmc5041 object
  * that needs to be previously created and passed to the StepperMotor controller
@@ -22,36 +33,108 @@ typedef enum
 class StepperMotor
 {
 public:
+    StepperMotor();
     StepperMotor(DriveTmc5041 *drive_handle, eMotorName motorName);
 
     eMotorStatus begin();
 
     eMotorStatus setSpeed(float speed);
+    eMotorStatus prepareSpeed(float speed, sTmcDatagram *datagrams, uint8_t &count);
+    void completeSpeed(const sTmcDatagram *datagrams, uint8_t count);
+    bool isRefreshNeeded() const;
+    float getSpeed() const { return _speed; }
+    eMotorStatus setAcceleration(float acceleration);
     eMotorStatus stop();
+    eMotorStatus getActualSpeed(float &speed);
+    eMotorStatus dispense(float volume, float flow, bool isCalibrated = true);
+    bool isDispensing() const { return _isDispensing; }
+    bool isDispenseComplete();
+    eMotorStatus getDispensedVolume(float &volume);
+    bool hasDriverError() const;
+    bool isVelocityReached() const;
+    PumpCalibration &getCalibration() { return _calibration; }
+    void halt();
+    eMotorStatus resume();
+    bool isHalted() const { return _isHalted; }
+    ePumpEvent getEvent() const { return _event; }
+    void clearEvent();
+    uint16_t getLoad() const { return _load; }
+
+    static constexpr uint8_t MAX_SPEED_DATAGRAMS = 6; // Datagrams of prepareSpeed(), the speed and a load sample
 
 private:
     static constexpr uint8_t CONFIG_MSG_SIZE = 7;
+    static constexpr uint8_t SET_SPEED_MSG_SIZE = 4;
+    static constexpr uint8_t DISPENSE_MSG_SIZE = 12;
 
     static constexpr uint32_t RUNNING_TORQUE = 0x8F82; // Torque of the motor while running (half of the default torque)
+    static constexpr uint32_t DEFAULT_AMAX = 0x1388;   // Acceleration of the ramp generator until setAcceleration() is called
+    static constexpr uint32_t MAX_AMAX = 0xFFFF;       // AMAX is a 16 bit register
+    static constexpr uint32_t POSITION_VSTOP = 10;     // Minimum stop velocity recommended in positioning mode
+    static constexpr uint32_t SG_RESULT_MASK = 0x3FF;  // DRV_STATUS, StallGuard load measurement, lower with more load
+    static constexpr uint32_t STALL_GUARD_BIT = 1UL << 24;
+
+    static constexpr unsigned long LOAD_SAMPLE_INTERVAL = 1000; // ms, DRV_STATUS read with the next exchange after this delay
+    static constexpr uint8_t BASELINE_SAMPLES = 8;              // Load samples at constant speed averaged into the baseline
+    static constexpr uint8_t EVENT_SAMPLES = 3;                 // Consecutive abnormal samples before an event
+    static constexpr float OCCLUSION_LOAD_RATIO = 0.5;          // SG_RESULT below this ratio of the baseline
+    static constexpr float DRY_RUN_LOAD_RATIO = 1.3;            // SG_RESULT above this ratio of the baseline
+    static constexpr float MIN_BASELINE = 10.0;                 // StallGuard not usable at this speed below
 
     static const uint8_t MOTOR_DRV_IHOLD_IRUN_ADDR[MOTOR_NAME_MAX];
     static const uint8_t MOTOR_DRV_AMAX_ADDR[MOTOR_NAME_MAX];
     static const uint8_t MOTOR_DRV_VMAX_ADDR[MOTOR_NAME_MAX];
     static const uint8_t MOTOR_DRV_SET_SPEED_ADDR[MOTOR_NAME_MAX];
     static const uint8_t MOTOR_DRV_SET_MODE_ADDR[MOTOR_NAME_MAX];
+    static const uint8_t MOTOR_DRV_VACTUAL_ADDR[MOTOR_NAME_MAX];
+    static const uint8_t MOTOR_DRV_XACTUAL_ADDR[MOTOR_NAME_MAX];
+    static const uint8_t MOTOR_DRV_XTARGET_ADDR[MOTOR_NAME_MAX];
+    static const uint8_t MOTOR_DRV_VSTART_ADDR[MOTOR_NAME_MAX];
+    static const uint8_t MOTOR_DRV_A1_ADDR[MOTOR_NAME_MAX];
+    static const uint8_t MOTOR_DRV_V1_ADDR[MOTOR_NAME_MAX];
+    static const uint8_t MOTOR_DRV_DMAX_ADDR[MOTOR_NAME_MAX];
+    static const uint8_t MOTOR_DRV_D1_ADDR[MOTOR_NAME_MAX];
+    static const uint8_t MOTOR_DRV_VSTOP_ADDR[MOTOR_NAME_MAX];
+    static const uint8_t MOTOR_DRV_DRV_STATUS_ADDR[MOTOR_NAME_MAX];
     static const uint8_t SET_SPEED_CONFIG_MSG_ADDR_LIST[MOTOR_NAME_MAX][CONFIG_MSG_SIZE];
     static const uint32_t SET_SPEED_CONFIG_MSG_DATA_LIST[CONFIG_MSG_SIZE];
 
-    static constexpr float FREQ_CLOCK = 13.3 * (10 ^ 6);                                                                                                     // Hz
-    static constexpr float DEFREE_PER_STEP = 1.8;                                                                                                            // datasheet kamoer
-    static constexpr float ML_PER_RPM = 0.1388;                                                                                                              // gros approx datasheet kamoer
-    static constexpr uint16_t MICRO_STEP_PER_STEP = 256;                                                                                                     // datasheet p.30
-    static constexpr float REG_TO_ML_PER_MIN = (FREQ_CLOCK / 2 / (2 ^ 23) / MICRO_STEP_PER_STEP / (360 / DEFREE_PER_STEP)) /*rotation/s*/ * 60 * ML_PER_RPM; // conversion formula p. 52
+    static constexpr float FREQ_CLOCK = 13.3e6;                                                                                                                 // Hz
+    static constexpr float DEFREE_PER_STEP = 1.8;                                                                                                               // datasheet kamoer
+    static constexpr float ML_PER_RPM = 0.1388;                                                                                                                 // gros approx datasheet kamoer
+    static constexpr uint16_t MICRO_STEP_PER_STEP = 256;                                                                                                        // datasheet p.30
+    static constexpr float REG_TO_ML_PER_MIN = (FREQ_CLOCK / 2 / (1UL << 23) / MICRO_STEP_PER_STEP / (360 / DEFREE_PER_STEP)) /*rotation/s*/ * 60 * ML_PER_RPM; // conversion formula p. 52
     static constexpr float ML_PER_MIN_TO_REG = 1 / REG_TO_ML_PER_MIN;
+    static constexpr float ML_TO_MICROSTEP = MICRO_STEP_PER_STEP * (360 / DEFREE_PER_STEP) / ML_PER_RPM;
+    static constexpr float ML_PER_MIN_PER_S_TO_AMAX = ML_PER_MIN_TO_REG * 512 * 256 / FREQ_CLOCK;                                                               // conversion formula p. 52, a = AMAX * fCLK^2 / (512 * 256) / 2^24
 
     DriveTmc5041 *_drive_handle;
     eMotorName _motorName;
     bool _isInit;
+    uint32_t _amax;
+    float _speed; // ml/min, last speed set
+    bool _isDispensing;
+    int32_t _dispenseTarget; // µsteps, XTARGET of the volume in progress
+    float _dispenseRatio;    // Commanded volume per ml of the last dispense()
+    uint32_t _dispenseVmax;  // VMAX of the volume in progress, restored by resume()
+    volatile bool _isHalted; // Set by the safety interlock task, under the drive lock
+    bool _isTorqueHeld;      // Current written to the motor, released once stopped
+    PumpCalibration _calibration;
+
+    void writeHalt();
+    void lockDrive();
+    void unlockDrive();
+    bool isLoadSampleDue() const;
+    void resetLoadBaseline();
+    void updateLoad(uint32_t drvStatus);
+
+    unsigned long _lastLoadSampleTime;
+    uint16_t _load;             // SG_RESULT of the last sample
+    float _loadBaseline;        // Average SG_RESULT at the current speed
+    uint8_t _baselineCount;     // Samples in the baseline
+    uint8_t _abnormalCount;     // Consecutive samples outside of the baseline
+    ePumpEvent _abnormalEvent;  // Event of these samples
+    ePumpEvent _event;          // Latched until clearEvent()
 };
 
 #endif // STEPPER_MOTOR_H
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef SYSTEM_CLOCK_H
+#define SYSTEM_CLOCK_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+/**
+ * @class SystemClock
+ * @brief Monotonic time of the firmware, 64-bit microseconds since the boot, sampled once per loop.
+ *
+ * The loop calls tick() first, then the drivers and the controllers read getTime() or getMillis(): all the decisions
+ * of a loop see the same time and millis() is not read again and again. The 64-bit time does not wrap, getMillis()
+ * is truncated to an unsigned long like millis() for the millisecond timestamps, which wrap after 49 days on the
+ * ESP32 and must only be compared by subtraction (now - then >= interval), never as absolute values.
+ *
+ * readTime() and readMillis() read the source at once, for the durations inside a loop (latencies, blocking waits)
+ * and for the FreeRTOS tasks, which do not run at the pace of the loop.
+ *
+ * The source is esp_timer_get_time(), the simulated time of the NativeBoard in the native build. setSource() swaps
+ * it, for a virtual clock stepped by a harness.
+ */
+class SystemClock
+{
+public:
+    typedef uint64_t (*TimeSource)(); // µs, monotonic
+
+    constexpr SystemClock() : source(readEspTimer), time(0) {}
+
+    void setSource(TimeSource source);
+    void tick();
+
+    uint64_t getTime() const { return this->time; }                                  // µs, at the last tick
+    unsigned long getMillis() const { return (unsigned long)(this->time / 1000); }   // ms, at the last tick
+    uint64_t readTime() const { return this->source(); }                             // µs, now
+    unsigned long readMillis() const { return (unsigned long)(readTime() / 1000); } // ms, now
+
+private:
+    static uint64_t readEspTimer() { return (uint64_t)esp_timer_get_time(); }
+
+    TimeSource source;
+    uint64_t time; // µs
+};
+
+extern SystemClock systemClock;
+
+#endif // SYSTEM_CLOCK_H
@@ -2,6 +2,7 @@
 #define TEMPERATURE_CONTROLLER_H
 
 #include <Arduino.h>
+#include "system_clock.h"
 
 /**
  * @class TemperatureController
@@ -16,6 +17,7 @@ class TemperatureController
 public:
     TemperatureController();
     void update(float waterTemp, float airTemp);
+    void update(float waterTemp, float airTemp, unsigned long currentTime);
     float getHeaterPower() const;
     void setReferenceTemperature(float tempRef);
 
@@ -27,6 +29,7 @@ private:
     float integralError;
     float prevError;
     unsigned long prevTime;
+    bool isStarted; // prevTime and prevError are known
     float integralErrorAir;
 
     // Control outputs.
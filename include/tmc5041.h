@@ -3,6 +3,11 @@
 
 #include <Arduino.h>
 #include <SPI.h>
+#include <soc/gpio_struct.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "driver_stats.h"
+#include "system_clock.h"
 
 typedef enum
 {
@@ -10,6 +15,7 @@ typedef enum
     MOTOR_STATUS_NOT_INITIALISED,
     MOTOR_STATUS_INCORRECT_VARIABLE,
     MOTOR_STATUS_NULL_VARIABLE,
+    MOTOR_STATUS_BUSY,
 
     MOTOR_STATUS_MAX
 } eMotorStatus;
@@ -24,6 +30,28 @@ typedef enum
     MOTOR_MODE_MAX
 } eMotorMode;
 
+/**
+ * @brief Status bits returned in the first byte of every SPI datagram
+ */
+typedef enum
+{
+    TMC_SPI_STATUS_RESET_FLAG = 0x01,
+    TMC_SPI_STATUS_DRIVER_ERROR_1 = 0x02,
+    TMC_SPI_STATUS_DRIVER_ERROR_2 = 0x04,
+    TMC_SPI_STATUS_VELOCITY_REACHED_1 = 0x08,
+    TMC_SPI_STATUS_VELOCITY_REACHED_2 = 0x10,
+} eTmcSpiStatus;
+
+/**
+ * @brief 40 bit SPI datagram, the data and the status are replaced by the response of the driver
+ */
+typedef struct
+{
+    uint8_t address; // Register address, with TMC_WRITE_BIT for a write
+    uint32_t data;
+    uint8_t status; // eTmcSpiStatus bits
+} sTmcDatagram;
+
 /**
  * @brief Low level class for the TMC5041 driver
  *
@@ -33,17 +61,40 @@ typedef enum
 class DriveTmc5041
 {
 public:
+    DriveTmc5041();
     DriveTmc5041(SPIClass *spi_handle, uint8_t cs);
 
     eMotorStatus begin();
 
     void tmc_write(uint8_t address, uint32_t data);
     uint32_t tmc_read(uint8_t address);
+    eMotorStatus writeRegisters(const uint8_t *addresses, const uint32_t *data, uint8_t count);
+    eMotorStatus readRegisters(const uint8_t *addresses, uint32_t *data, uint8_t count);
+    void transfer(sTmcDatagram *datagrams, uint8_t count);
+    void lock();
+    void unlock();
+
+    uint8_t getSpiStatus() const { return _spiStatus; }
+    const DriverStats &getStats() const { return _stats; }
+
+    static constexpr uint8_t MAX_BATCH_SIZE = 16; // Datagrams per call of writeRegisters() and readRegisters()
+    static constexpr uint8_t TMC_WRITE_BIT = 0x80;
 
 private:
+    void csLow();
+    void csHigh();
+
     SPIClass *_spi;
     uint8_t _cs;
+    uint32_t _csMask; // Bit of the CS pin in the GPIO set/clear registers
     bool _isInit;
+    uint8_t _spiStatus; // Status bits of the last datagram
+    DriverStats _stats; // One request per SPI transaction, latency is the duration of the transaction
+    SemaphoreHandle_t _lock; // Recursive, the pumps are also halted by the safety interlock task
+
+    static constexpr uint8_t DATAGRAM_SIZE = 5;    // Bytes, address or status then 32 bits of data
+    static constexpr uint32_t SPI_CLOCK = 4000000; // Hz, max 4 MHz with the internal clock
+    static constexpr uint32_t CS_HIGH_TIME = 1;    // µs, CS must rise between two datagrams for the driver to latch them
 };
 
 #endif // MOTOR_DRIVE_TMC_H
\ No newline at end of file
@@ -3,6 +3,9 @@
 
 #include <Arduino.h>
 #include <HardwareSerial.h>
+#include "bus_recorder.h"
+#include "driver_stats.h"
+#include "system_clock.h"
 
 typedef enum
 {
@@ -53,7 +56,7 @@ public:
      * @brief Get the timestamp of the last successful read.
      * @return Milliseconds since startup.
      */
-    uint32_t getLastReadMs() const { return _lastReadTime; }
+    unsigned long getLastReadMs() const { return _lastReadTime; }
 
     /**
      * @brief Get the current status of the sensor/driver.
@@ -61,6 +64,16 @@ public:
      */
     eVisiFermStatus getStatus() const { return _status; }
 
+    /**
+     * @brief Get the cumulative counters of the Modbus exchanges.
+     */
+    const DriverStats &getStats() const { return _stats; }
+
+    static void encodeReadRegisters(uint8_t deviceAddress, uint16_t reg, uint16_t count, uint8_t *frame);
+    static eVisiFermStatus decodeFrame(const uint8_t *frame, uint16_t len, float &outValue);
+
+    static constexpr uint8_t MODBUS_READ_REGISTER_MSG_LEN = 8;
+
 private:
     // polling state
     enum PollState
@@ -74,7 +87,6 @@ private:
     void sendReadTemp();
     void sendReadRegisters(uint16_t reg, uint16_t count);
     bool tryReadFrame();
-    bool parseData(const uint8_t *frame, uint16_t len, float &outValue);
     void cleanSerialBuffer();
 
     static uint16_t modbusCRC(const uint8_t *buf, uint16_t len);
@@ -97,7 +109,6 @@ private:
     static constexpr uint32_t READ_INTERVAL_MS = 500;
     static constexpr uint32_t RESPONSE_TIMEOUT_MS = 200;
     static constexpr uint16_t MODBUS_FUNC_READ_HOLDING = 0x03;
-    static constexpr uint8_t MODBUS_READ_REGISTER_MSG_LEN = 8;
     static constexpr uint8_t CRC_LEN = 2;
     static constexpr uint8_t MIN_MSG_LEN = 5; // addr(1) + func(1) + byteCount(1) + CRC(2)
     static constexpr uint8_t DATA_LEN = 20;   // 10 registers * 2 bytes each
@@ -106,8 +117,10 @@ private:
     // receive buffer
     uint8_t _rxBuf[MAX_BUF_SIZE];
     uint16_t _rxLen;
-    uint32_t _waitStartMs;
-    uint32_t _lastReadTime;
+    unsigned long _waitStartMs;
+    uint64_t _requestStartUs;
+    unsigned long _lastReadTime;
+    DriverStats _stats;
 
     // VisiFerm registers (manual uses 1-based, Modbus uses 0-based)
     static constexpr uint16_t REG_PMC1 = 2090;    // Primary Measurement Channel 1 (DO), len 10
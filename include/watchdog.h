@@ -3,10 +3,55 @@
 
 #include <Arduino.h>
 #include <esp_task_wdt.h>
+#include <esp_system.h>
+#include <esp_attr.h>
+#include "system_clock.h"
 
 constexpr uint8_t WATCHDOG_TIMER = 60;
+constexpr uint8_t MAX_HEARTBEATS = 16;
+constexpr uint8_t HEARTBEAT_NAME_SIZE = 16;
+constexpr int8_t NO_HEARTBEAT = -1;
+
+/**
+ * @brief Stages of the main loop, the stage in progress is kept across a reset.
+ */
+typedef enum
+{
+    LOOP_STAGE_STATE_MACHINE = 0,
+    LOOP_STAGE_SENSORS,
+    LOOP_STAGE_TELEMETRY,
+    LOOP_STAGE_TEMPERATURE,
+    LOOP_STAGE_GAS,
+    LOOP_STAGE_LED,
+    LOOP_STAGE_COMMANDS,
+    LOOP_STAGE_RECORDER,
+
+    LOOP_STAGE_MAX // No stage in progress
+} eLoopStage;
+
+/**
+ * @brief What the supervisor knows when the board resets, kept in the RTC memory that is not cleared by a reset.
+ */
+typedef struct
+{
+    uint32_t magic;                              // RECORD_MAGIC when the record was written by this firmware
+    uint32_t uptime;                             // ms, at the last supervisor update
+    int8_t stalledHeartbeat;                     // NO_HEARTBEAT if all the heartbeats were healthy
+    char stalledName[HEARTBEAT_NAME_SIZE];       // Name of the stalled heartbeat
+    uint32_t stalledFor;                         // ms since the last beat of the stalled heartbeat
+    uint8_t currentStage;                        // eLoopStage in progress
+    uint32_t lastStageDurations[LOOP_STAGE_MAX]; // µs
+    uint32_t maxStageDurations[LOOP_STAGE_MAX];  // µs
+} sWatchdogRecord;
 
 void initWatchDog();
 void kickWatchDog();
+void updateWatchDog();
+int8_t registerHeartbeat(const char *name, unsigned long deadline);
+void feedHeartbeat(int8_t heartbeat);
+void beginLoopStage(eLoopStage stage);
+void endLoopStage();
+void setLoopStageHook(void (*hook)(eLoopStage stage));
+void reportLastReset(Print &output);
 
-#endif // WATCHDOG_H
\ No newline at end of file
+#endif // WATCHDOG_H
@@ -0,0 +1,124 @@
+/*
+ * Reruns an incident on the host: loads a bus capture (the REC= lines printed by REC-DUMP) and feeds it back through
+ * the drivers, the sensor manager and the controllers of the firmware on the simulated board, then prints as JSON how
+ * many records were replayed and the loop rate of the rerun.
+ *
+ * No peripheral is attached, the drivers take their bytes from the BusRecorder and the recorded commands drive the
+ * bioreactor from IDLE like REC-REPLAY. The time is virtual, so two runs of the same capture execute the same code on
+ * the same data: the console output of the firmware (-o) can be compared between two builds to bisect a change.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include "bus_recorder.h"
+#include "main.h"
+#include "native_board.h"
+
+typedef std::chrono::steady_clock HostClock;
+
+/**
+ * @brief Load the records of a capture, the other lines of a console log are ignored.
+ * @return False if the file cannot be read.
+ */
+static bool loadCapture(const char *path, uint32_t &invalidCount)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+
+    std::string line;
+    invalidCount = 0;
+    for (uint32_t lineNumber = 1; std::getline(file, line); lineNumber++)
+    {
+        if (line.compare(0, 4, "REC=") != 0)
+            continue;
+        if (!busRecorder.load(String(line.substr(4).c_str())))
+        {
+            fprintf(stderr, "%s:%u: malformed record skipped\n", path, lineNumber);
+            invalidCount++;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *capturePath = nullptr;
+    const char *outputPath = nullptr;
+    uint64_t step = 500;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "-r" && i + 1 < argc)
+            capturePath = argv[++i];
+        else if (argument == "-o" && i + 1 < argc)
+            outputPath = argv[++i];
+        else if (argument == "-s" && i + 1 < argc)
+            step = strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            capturePath = nullptr;
+            break;
+        }
+    }
+    if (capturePath == nullptr)
+    {
+        fprintf(stderr, "Usage: %s -r capture [-o console_output] [-s step_us]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    uint32_t invalidCount = 0;
+    if (!loadCapture(capturePath, invalidCount))
+        return EXIT_FAILURE;
+
+    FILE *output = nullptr;
+    if (outputPath != nullptr)
+    {
+        output = fopen(outputPath, "w");
+        if (output == nullptr)
+        {
+            fprintf(stderr, "Cannot open %s\n", outputPath);
+            return EXIT_FAILURE;
+        }
+    }
+
+    NativeBoard &board = getNativeBoard();
+    board.setConsoleOutput(false, true);
+    board.advanceTime(1000000); // The time is not 0 after the boot of the ESP32
+    setup();
+    if (!busRecorder.startReplay())
+    {
+        fprintf(stderr, "No bus records in %s\n", capturePath);
+        return EXIT_FAILURE;
+    }
+
+    uint64_t boardStart = board.getTime();
+    HostClock::time_point hostStart = HostClock::now();
+    uint32_t loopCount = 0;
+    while (busRecorder.isReplaying())
+    {
+        loop();
+        board.advanceTime(step);
+        loopCount++;
+
+        std::string console = board.takeConsoleOutput();
+        if (output != nullptr)
+            fwrite(console.data(), 1, console.size(), output);
+    }
+    double hostTime = std::chrono::duration<double>(HostClock::now() - hostStart).count();
+    double boardTime = (board.getTime() - boardStart) / 1e6;
+    if (output != nullptr)
+        fclose(output);
+
+    printf("{\"capture\": \"%s\", \"records\": %u, \"replayed\": %u, \"invalid\": %u, \"step_us\": %llu,\n", capturePath,
+           busRecorder.getRecordCount(), busRecorder.getReplayedCount(), invalidCount, (unsigned long long)step);
+    printf(" \"loops\": %u, \"host_s\": %.6f, \"simulated_s\": %.3f, \"loops_per_host_s\": %.0f}\n", loopCount, hostTime,
+           boardTime, hostTime > 0.0 ? loopCount / hostTime : 0.0);
+    return EXIT_SUCCESS;
+}
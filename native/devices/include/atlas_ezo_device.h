@@ -0,0 +1,50 @@
+#ifndef ATLAS_EZO_DEVICE_H
+#define ATLAS_EZO_DEVICE_H
+
+#include <string>
+
+#include "emulated_device.h"
+#include "native_board.h"
+
+/**
+ * @class AtlasEzoDevice
+ * @brief Atlas Scientific EZO circuit (pH, RTD) in I2C mode: a command is processed for its processing time, the
+ * reads answer 0xFE until then, then 0x01 and the ASCII reply.
+ *
+ * Faults: the latency lengthens the processing time, a dropout NACKs the command, an error fails it (0x02).
+ */
+class AtlasEzoDevice : public I2cDevice, public FaultInjector
+{
+public:
+    AtlasEzoDevice(float value, uint8_t decimals, uint32_t readingTime, uint32_t seed);
+
+    void setValue(float value) { this->value = value; }
+    const std::string &getLastCalibration() const { return this->lastCalibration; }
+    uint32_t getReadingCount() const { return this->readingCount; }
+
+    bool write(const uint8_t *data, size_t length, uint64_t time) override;
+    size_t read(uint8_t *data, size_t length, uint64_t time) override;
+
+    static constexpr uint32_t PH_READING_TIME = 900000;  // us
+    static constexpr uint32_t RTD_READING_TIME = 600000; // us
+    static constexpr uint32_t COMMAND_TIME = 300000;     // us, other commands
+
+    static constexpr uint8_t STATUS_SUCCESS = 0x01;
+    static constexpr uint8_t STATUS_FAILED = 0x02; // Syntax error or failed command
+    static constexpr uint8_t STATUS_PENDING = 0xFE;
+    static constexpr uint8_t STATUS_NO_DATA = 0xFF;
+
+private:
+    float value;
+    uint8_t decimals;
+    uint32_t readingTime; // us
+    uint8_t status;       // STATUS_NO_DATA when there is no command
+    uint64_t readyTime;   // us, end of the processing of the last command
+    std::string reply;    // ASCII reply of the last command
+    std::string lastCalibration;
+    uint32_t readingCount;
+
+    static constexpr size_t MAX_COMMAND_LENGTH = 40;
+};
+
+#endif // ATLAS_EZO_DEVICE_H
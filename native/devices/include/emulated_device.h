@@ -0,0 +1,72 @@
+#ifndef EMULATED_DEVICE_H
+#define EMULATED_DEVICE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+/**
+ * @brief Faults injected by an emulated device, none by default.
+ */
+typedef struct
+{
+    uint32_t latency;  // us added to the response time of the device
+    float noise;       // Standard deviation of the gaussian noise added to the measurements, in their unit
+    float dropoutRate; // Probability that a request is not answered (NACK on I2C, silence on the UARTs)
+    float errorRate;   // Probability that a response is wrong (bad CRC, error status, depending on the device)
+} sDeviceFaults;
+
+/**
+ * @class FaultInjector
+ * @brief Draws the faults of an emulated device from a seeded generator, a run gives the same faults every time.
+ */
+class FaultInjector
+{
+public:
+    explicit FaultInjector(uint32_t seed);
+
+    void setFaults(const sDeviceFaults &faults) { this->faults = faults; }
+    const sDeviceFaults &getFaults() const { return this->faults; }
+    void setSeed(uint32_t seed);
+
+    uint32_t getDropoutCount() const { return this->dropoutCount; }
+    uint32_t getErrorCount() const { return this->errorCount; }
+
+protected:
+    bool isDropped();
+    bool isWrong();
+    float addNoise(float value);
+    uint32_t getLatency() const { return this->faults.latency; }
+    uint32_t getRandom();
+    float getUniform();
+
+private:
+    sDeviceFaults faults;
+    uint32_t state; // xorshift32, never 0
+    uint32_t dropoutCount;
+    uint32_t errorCount;
+};
+
+/**
+ * @class UartTransmitter
+ * @brief Bytes sent by a UART device, each one is received after the time of its character at the baud rate.
+ */
+class UartTransmitter
+{
+public:
+    UartTransmitter(uint32_t baudRate, uint8_t bitsPerCharacter);
+
+    void send(const uint8_t *data, size_t length, uint64_t startTime);
+    size_t take(uint8_t *data, size_t maxLength, uint64_t time);
+    uint64_t getCharacterTime(size_t count) const;
+    bool isIdle(uint64_t time) const { return this->bytes.empty() || this->lastByteTime <= time; }
+    void clear() { this->bytes.clear(); }
+
+private:
+    uint32_t baudRate;
+    uint8_t bitsPerCharacter; // Start, data, parity and stop bits
+    std::deque<std::pair<uint64_t, uint8_t>> bytes; // Time the byte is received by the ESP32 (us), byte
+    uint64_t lastByteTime;
+};
+
+#endif // EMULATED_DEVICE_H
@@ -0,0 +1,42 @@
+#ifndef EMULATED_PERIPHERALS_H
+#define EMULATED_PERIPHERALS_H
+
+#include "atlas_ezo_device.h"
+#include "board.h"
+#include "gmp251_device.h"
+#include "io_expander_device.h"
+#include "native_board.h"
+#include "o2_sensor_device.h"
+#include "sht40_device.h"
+#include "tmc5041_device.h"
+#include "visiferm_device.h"
+
+/**
+ * @class EmulatedPeripherals
+ * @brief The peripherals of the bioreactor, at the addresses, UARTs and chip selects the firmware uses. The LED
+ * driver and the pressure sensor (ADC) are not emulated.
+ */
+class EmulatedPeripherals
+{
+public:
+    EmulatedPeripherals();
+
+    void attach(NativeBoard &board);
+    void setFaults(const sDeviceFaults &faults);
+
+    VisiFermDevice dissolvedOxygen;
+    Gmp251Device co2;
+    AtlasEzoDevice ph;
+    AtlasEzoDevice waterTemperature;
+    Sht40Device air;
+    O2SensorDevice o2;
+    IOExpanderDevice ioExpander;
+    Tmc5041Device drives[DRIVE_COUNT]; // In the order of DRIVE_TABLE
+
+    static constexpr uint8_t GMP251_UART = 1;   // Serial1
+    static constexpr uint8_t VISIFERM_UART = 2; // Serial2
+    static constexpr uint8_t PH_ADDRESS = 0x63;
+    static constexpr uint8_t RTD_ADDRESS = 0x66;
+};
+
+#endif // EMULATED_PERIPHERALS_H
@@ -0,0 +1,52 @@
+#ifndef GMP251_DEVICE_H
+#define GMP251_DEVICE_H
+
+#include <string>
+
+#include "emulated_device.h"
+#include "native_board.h"
+
+/**
+ * @class Gmp251Device
+ * @brief Vaisala GMP251 on a UART, in the polled mode of the Vaisala Industrial Protocol: answers "send" with the CO2
+ * concentration and acknowledges the compensation and calibration commands of the firmware.
+ *
+ * Faults: the latency delays the response, a dropout leaves the command unanswered, an error answers "send" with the
+ * stars the probe prints when it has no valid measurement.
+ */
+class Gmp251Device : public UartDevice, public FaultInjector
+{
+public:
+    explicit Gmp251Device(uint32_t seed = 2);
+
+    void setCo2(float co2) { this->co2 = co2; }
+    float getPressure() const { return this->pressure; }
+    float getTemperature() const { return this->temperature; }
+    float getOxygen() const { return this->oxygen; }
+    float getCalibrationReference() const { return this->calibrationReference; }
+    uint32_t getMeasurementCount() const { return this->measurementCount; }
+
+    void receive(const uint8_t *data, size_t length, uint64_t time) override;
+    size_t transmit(uint8_t *data, size_t maxLength, uint64_t time) override;
+
+    static constexpr uint32_t BAUD_RATE = 19200;
+    static constexpr uint8_t BITS_PER_CHARACTER = 10; // 8N1
+    static constexpr uint32_t RESPONSE_TIME = 10000;  // us, from the carriage return to the first byte
+
+private:
+    void answer(const std::string &command, uint64_t time);
+    void send(const std::string &text, uint64_t time);
+
+    float co2;                  // ppm
+    float pressure;             // hPa, "env xpres"
+    float temperature;          // °C, "env xtemp"
+    float oxygen;               // %, "env xoxy"
+    float calibrationReference; // ppm, last "cco2 -hi"
+    uint32_t measurementCount;
+    std::string line; // Received, not ended by a carriage return yet
+    UartTransmitter transmitter;
+
+    static constexpr size_t MAX_LINE_LENGTH = 80;
+};
+
+#endif // GMP251_DEVICE_H
@@ -0,0 +1,49 @@
+#ifndef IO_EXPANDER_DEVICE_H
+#define IO_EXPANDER_DEVICE_H
+
+#include "emulated_device.h"
+#include "native_board.h"
+
+/**
+ * @class IOExpanderDevice
+ * @brief Diodes PI4IOE5V6524 I/O expander, 24 pins in 3 ports: a write selects a register then writes the registers
+ * from it, the address rolls over within the bank of 3 ports (input, output, polarity, configuration).
+ *
+ * Faults: a dropout NACKs the transaction, an error NACKs a write after its first port, the others are left unchanged.
+ */
+class IOExpanderDevice : public I2cDevice, public FaultInjector
+{
+public:
+    explicit IOExpanderDevice(uint32_t seed = 5);
+
+    bool isOutput(uint8_t pin) const;
+    bool getLevel(uint8_t pin) const;
+    void setInput(uint8_t pin, bool level);
+    uint32_t getWriteCount() const { return this->writeCount; }
+
+    bool write(const uint8_t *data, size_t length, uint64_t time) override;
+    size_t read(uint8_t *data, size_t length, uint64_t time) override;
+
+    static constexpr uint8_t DEFAULT_ADDRESS = 0x23;
+    static constexpr uint8_t PORT_COUNT = 3;
+    static constexpr uint8_t PIN_COUNT = PORT_COUNT * 8;
+
+private:
+    uint8_t *getRegister(uint8_t address);
+    static uint8_t getNextAddress(uint8_t address);
+
+    uint8_t inputs[PORT_COUNT];   // Levels applied on the input pins
+    uint8_t outputs[PORT_COUNT];  // Output register
+    uint8_t polarity[PORT_COUNT]; // Inverts the input register
+    uint8_t config[PORT_COUNT];   // 1: input, 0: output
+    uint8_t registerAddress;
+    uint32_t writeCount;
+
+    static constexpr uint8_t REG_INPUT = 0x00;
+    static constexpr uint8_t REG_OUTPUT = 0x04;
+    static constexpr uint8_t REG_POLARITY = 0x08;
+    static constexpr uint8_t REG_CONFIG = 0x0C;
+    static constexpr uint8_t BANK_SIZE = 4; // Addresses of a bank, the last one is not a port
+};
+
+#endif // IO_EXPANDER_DEVICE_H
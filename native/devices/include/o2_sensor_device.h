@@ -0,0 +1,45 @@
+#ifndef O2_SENSOR_DEVICE_H
+#define O2_SENSOR_DEVICE_H
+
+#include "emulated_device.h"
+#include "native_board.h"
+
+/**
+ * @class O2SensorDevice
+ * @brief DFRobot Gravity I2C oxygen sensor (SEN0322): a write selects a register, a read gives the registers from it.
+ * The concentration is three bytes (units, tenths, hundredths of % Vol), the calibration commands complete after the
+ * calibration time.
+ *
+ * Faults: the latency lengthens the calibration, a dropout NACKs the transaction, an error garbles the concentration.
+ */
+class O2SensorDevice : public I2cDevice, public FaultInjector
+{
+public:
+    explicit O2SensorDevice(uint32_t seed = 4);
+
+    void setOxygen(float oxygen) { this->oxygen = oxygen; }
+
+    bool write(const uint8_t *data, size_t length, uint64_t time) override;
+    size_t read(uint8_t *data, size_t length, uint64_t time) override;
+
+    static constexpr uint8_t DEFAULT_ADDRESS = 0x70;
+    static constexpr uint32_t CALIBRATION_TIME = 1000000; // us
+
+private:
+    uint8_t getCalibrationState(uint64_t time) const;
+
+    float oxygen; // % Vol
+    uint8_t registerAddress;
+    uint8_t calibrationState;   // Bit 0: 20.9 %, bit 1: 99.5 %
+    uint8_t pendingCalibration; // Command of the calibration in progress, 0 if none
+    uint64_t calibrationEnd;    // us
+
+    static constexpr uint8_t REG_OXYGEN_DATA = 0x10;
+    static constexpr uint8_t REG_CALIBRATION_STATE = 0x13;
+    static constexpr uint8_t REG_CALIBRATION = 0x18;
+    static constexpr uint8_t CALIBRATION_20_9 = 0x01;
+    static constexpr uint8_t CALIBRATION_99_5 = 0x02;
+    static constexpr uint8_t CALIBRATION_CLEAR = 0x03;
+};
+
+#endif // O2_SENSOR_DEVICE_H
@@ -0,0 +1,53 @@
+#ifndef SHT40_DEVICE_H
+#define SHT40_DEVICE_H
+
+#include "emulated_device.h"
+#include "native_board.h"
+
+/**
+ * @class Sht40Device
+ * @brief Sensirion SHT40 temperature and humidity sensor: a measurement command, then a read of the two words with
+ * their CRC once the measurement time has elapsed. A read before it is NACKed, like the sensor.
+ *
+ * Faults: the latency lengthens the measurement, a dropout NACKs the command, an error corrupts a CRC.
+ */
+class Sht40Device : public I2cDevice, public FaultInjector
+{
+public:
+    explicit Sht40Device(uint32_t seed = 3);
+
+    void setTemperature(float temperature) { this->temperature = temperature; }
+    void setHumidity(float humidity) { this->humidity = humidity; }
+    uint32_t getMeasurementCount() const { return this->measurementCount; }
+
+    bool write(const uint8_t *data, size_t length, uint64_t time) override;
+    size_t read(uint8_t *data, size_t length, uint64_t time) override;
+
+    static constexpr uint8_t DEFAULT_ADDRESS = 0x44;
+    static constexpr size_t RESPONSE_SIZE = 6; // Two words, each followed by its CRC
+
+private:
+    void setWords(uint16_t first, uint16_t second);
+    static uint8_t getCrc(const uint8_t *data, size_t length);
+
+    float temperature; // °C
+    float humidity;    // %RH
+    uint8_t response[RESPONSE_SIZE];
+    bool isResponseReady; // Until it is read
+    uint64_t readyTime;   // us
+    uint32_t measurementCount;
+
+    static constexpr uint8_t CMD_MEASURE_HIGH_PRECISION = 0xFD;
+    static constexpr uint8_t CMD_MEASURE_MEDIUM_PRECISION = 0xF6;
+    static constexpr uint8_t CMD_MEASURE_LOW_PRECISION = 0xE0;
+    static constexpr uint8_t CMD_READ_SERIAL = 0x89;
+    static constexpr uint8_t CMD_SOFT_RESET = 0x94;
+
+    static constexpr uint32_t HIGH_PRECISION_TIME = 8300;   // us, maximum of the datasheet
+    static constexpr uint32_t MEDIUM_PRECISION_TIME = 4500; // us
+    static constexpr uint32_t LOW_PRECISION_TIME = 1700;    // us
+    static constexpr uint32_t COMMAND_TIME = 1000;          // us, serial number and soft reset
+    static constexpr uint32_t SERIAL_NUMBER = 0x0EA5F00D;
+};
+
+#endif // SHT40_DEVICE_H
@@ -0,0 +1,96 @@
+#ifndef TMC5041_DEVICE_H
+#define TMC5041_DEVICE_H
+
+#include "emulated_device.h"
+#include "native_board.h"
+
+/**
+ * @brief State of the ramp generator of a motor.
+ */
+typedef struct
+{
+    double position; // usteps, XACTUAL
+    double velocity; // usteps/s, VACTUAL
+} sRampState;
+
+/**
+ * @class Tmc5041Device
+ * @brief Trinamic TMC5041 dual stepper drive on SPI: 40-bit datagrams (address, 32-bit data), a register file and the
+ * ramp generators of the two motors in velocity and positioning modes, run on the time of the NativeBoard.
+ *
+ * Each response holds the SPI status (reset, driver errors, velocity reached) and the register read by the previous
+ * datagram, or the data written by it. DRV_STATUS gives the load set by setLoad() while the motor turns.
+ *
+ * Faults: the latency is not used (the drive answers in the datagram), a dropout leaves MISO low for a whole
+ * selection, an error flips a bit of the response. setDriverError() sets the driver error bit of a motor.
+ */
+class Tmc5041Device : public SpiDevice, public FaultInjector
+{
+public:
+    explicit Tmc5041Device(uint32_t seed = 6);
+
+    void setLoad(uint8_t motor, uint16_t load);
+    void setDriverError(uint8_t motor, bool isError);
+    int32_t getPosition(uint8_t motor);
+    float getVelocity(uint8_t motor);
+    uint32_t getRegister(uint8_t address) const { return this->registers[address & ADDRESS_MASK]; }
+    uint32_t getDatagramCount() const { return this->datagramCount; }
+
+    void select(bool isSelected) override;
+    uint8_t transfer(uint8_t data) override;
+
+    static constexpr uint8_t MOTOR_COUNT = 2;
+    static constexpr float CLOCK_FREQUENCY = 13.3e6f; // Hz, clock of the drives of the board
+
+private:
+    void runRamps(uint64_t time);
+    void runRamp(uint8_t motor, double duration);
+    bool isVelocityReached(uint8_t motor) const;
+    void executeDatagram();
+    uint32_t readRegister(uint8_t address);
+    uint8_t getStatus() const;
+
+    static constexpr uint8_t DATAGRAM_SIZE = 5;
+    static constexpr uint8_t WRITE_BIT = 0x80;
+    static constexpr uint8_t ADDRESS_MASK = 0x7F;
+    static constexpr uint32_t RAMP_STEP = 1000; // us, longest integration step
+
+    // Registers of motor 1, those of motor 2 are at + MOTOR_OFFSET (+ DRIVER_OFFSET for the driver registers)
+    static constexpr uint8_t REG_GSTAT = 0x01;
+    static constexpr uint8_t REG_RAMPMODE = 0x20;
+    static constexpr uint8_t REG_XACTUAL = 0x21;
+    static constexpr uint8_t REG_VACTUAL = 0x22;
+    static constexpr uint8_t REG_AMAX = 0x26;
+    static constexpr uint8_t REG_VMAX = 0x27;
+    static constexpr uint8_t REG_DMAX = 0x28;
+    static constexpr uint8_t REG_XTARGET = 0x2D;
+    static constexpr uint8_t REG_IHOLD_IRUN = 0x30;
+    static constexpr uint8_t REG_DRV_STATUS = 0x6F;
+    static constexpr uint8_t MOTOR_OFFSET = 0x20;
+    static constexpr uint8_t DRIVER_OFFSET = 0x10;
+
+    static constexpr uint8_t RAMPMODE_POSITION = 0;
+    static constexpr uint8_t RAMPMODE_VELOCITY_POSITIVE = 1;
+    static constexpr uint8_t RAMPMODE_VELOCITY_NEGATIVE = 2;
+    static constexpr uint8_t RAMPMODE_HOLD = 3;
+
+    static constexpr uint8_t STATUS_RESET = 0x01;
+    static constexpr uint8_t STATUS_DRIVER_ERROR_1 = 0x02;
+    static constexpr uint8_t STATUS_VELOCITY_REACHED_1 = 0x08; // Bits of motor 2 are the next ones
+    static constexpr uint32_t DRV_STATUS_STANDSTILL = 1UL << 31;
+    static constexpr uint32_t SG_RESULT_MASK = 0x3FF;
+
+    uint32_t registers[128];
+    sRampState ramps[MOTOR_COUNT];
+    uint16_t loads[MOTOR_COUNT];     // SG_RESULT while turning
+    bool driverErrors[MOTOR_COUNT];
+    uint64_t rampTime;               // us, time the ramps were run to
+    bool isSilent;                   // Dropout of the current selection
+    uint8_t datagram[DATAGRAM_SIZE]; // Received since the selection
+    uint8_t response[DATAGRAM_SIZE]; // Sent during the selection
+    uint8_t byteIndex;
+    uint32_t nextData;               // Sent back by the next datagram
+    uint32_t datagramCount;
+};
+
+#endif // TMC5041_DEVICE_H
@@ -0,0 +1,58 @@
+#ifndef VISIFERM_DEVICE_H
+#define VISIFERM_DEVICE_H
+
+#include <vector>
+
+#include "emulated_device.h"
+#include "native_board.h"
+
+/**
+ * @class VisiFermDevice
+ * @brief Hamilton VisiFerm RS485 on a UART: Modbus RTU slave answering the reads of the primary measurement channels
+ * PMC1 (dissolved oxygen) and PMC6 (temperature).
+ *
+ * Faults: the latency delays the response, a dropout leaves the request unanswered, an error corrupts a byte of the
+ * response (CRC error on the ESP32). setMeasurementStatus() reports a sensor error in the measurement status.
+ */
+class VisiFermDevice : public UartDevice, public FaultInjector
+{
+public:
+    explicit VisiFermDevice(uint8_t address = DEFAULT_ADDRESS, uint32_t seed = 1);
+
+    void setOxygen(float oxygen) { this->oxygen = oxygen; }
+    void setTemperature(float temperature) { this->temperature = temperature; }
+    void setMeasurementStatus(uint32_t status) { this->measurementStatus = status; }
+    uint32_t getRequestCount() const { return this->requestCount; }
+
+    void receive(const uint8_t *data, size_t length, uint64_t time) override;
+    size_t transmit(uint8_t *data, size_t maxLength, uint64_t time) override;
+
+    static constexpr uint8_t DEFAULT_ADDRESS = 1;
+    static constexpr uint32_t BAUD_RATE = 19200;
+    static constexpr uint8_t BITS_PER_CHARACTER = 11; // 8N2
+    static constexpr uint32_t RESPONSE_TIME = 5000;   // us, from the end of the request to the first byte
+    static constexpr uint16_t REG_PMC1 = 2089;        // Modbus address (manual address - 1), dissolved oxygen
+    static constexpr uint16_t REG_PMC6 = 2409;        // Temperature
+    static constexpr uint16_t PMC_LENGTH = 10;        // Registers
+
+private:
+    void answer(const uint8_t *request, uint64_t time);
+    void sendException(uint8_t function, uint8_t exception, uint64_t time);
+    void sendFrame(uint8_t *frame, size_t length, uint64_t time);
+    static uint16_t getCrc(const uint8_t *data, size_t length);
+
+    uint8_t address;
+    float oxygen;               // %sat
+    float temperature;          // °C
+    uint32_t measurementStatus; // 0 when the measurement is valid
+    uint32_t requestCount;
+    std::vector<uint8_t> request; // Received, not answered yet
+    UartTransmitter transmitter;
+
+    static constexpr uint8_t FUNCTION_READ_HOLDING = 0x03;
+    static constexpr uint8_t EXCEPTION_ILLEGAL_FUNCTION = 0x01;
+    static constexpr uint8_t EXCEPTION_ILLEGAL_ADDRESS = 0x02;
+    static constexpr size_t REQUEST_LENGTH = 8; // Address, function, start, count, CRC
+};
+
+#endif // VISIFERM_DEVICE_H
@@ -0,0 +1,90 @@
+#include "atlas_ezo_device.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+
+/**
+ * @brief Constructor.
+ * @param value Initial measurement.
+ * @param decimals Decimals of the replies.
+ * @param readingTime Processing time of "R" (us), PH_READING_TIME or RTD_READING_TIME.
+ * @param seed Seed of the faults and noise.
+ */
+AtlasEzoDevice::AtlasEzoDevice(float value, uint8_t decimals, uint32_t readingTime, uint32_t seed)
+    : FaultInjector(seed),
+      value(value),
+      decimals(decimals),
+      readingTime(readingTime),
+      status(STATUS_NO_DATA),
+      readyTime(0),
+      readingCount(0)
+{
+}
+
+/**
+ * @brief Receive a command, ASCII ended by a null character.
+ */
+bool AtlasEzoDevice::write(const uint8_t *data, size_t length, uint64_t time)
+{
+    if (isDropped())
+        return false;
+    if (length == 0)
+        return true; // Address probe
+
+    std::string command((const char *)data, strnlen((const char *)data, std::min(length, MAX_COMMAND_LENGTH)));
+    uint32_t processingTime = COMMAND_TIME;
+    this->reply.clear();
+    if (strcasecmp(command.c_str(), "R") == 0)
+    {
+        char text[24];
+        snprintf(text, sizeof(text), "%.*f", this->decimals, addNoise(this->value));
+        this->reply = text;
+        this->readingCount++;
+        processingTime = this->readingTime;
+    }
+    else if (strncasecmp(command.c_str(), "Cal,", 4) == 0)
+    {
+        this->lastCalibration = command;
+        processingTime = this->readingTime;
+    }
+    else if (strncasecmp(command.c_str(), "T,", 2) != 0)
+    {
+        // Syntax error, known at once
+        this->status = STATUS_FAILED;
+        this->readyTime = time;
+        return true;
+    }
+
+    this->status = isWrong() ? STATUS_FAILED : STATUS_SUCCESS;
+    this->readyTime = time + processingTime + getLatency();
+    return true;
+}
+
+/**
+ * @brief Answer the status of the last command, then its reply and a null character once it is processed.
+ */
+size_t AtlasEzoDevice::read(uint8_t *data, size_t length, uint64_t time)
+{
+    if (length == 0)
+        return 0;
+    if (this->status != STATUS_NO_DATA && time < this->readyTime)
+    {
+        data[0] = STATUS_PENDING;
+        return 1;
+    }
+
+    data[0] = this->status;
+    if (this->status != STATUS_SUCCESS)
+        return 1;
+
+    // The reply is given once, like the circuit
+    size_t replyLength = std::min(this->reply.size(), length - 1);
+    memcpy(data + 1, this->reply.data(), replyLength);
+    size_t count = 1 + replyLength;
+    if (count < length)
+        data[count++] = '\0';
+    this->status = STATUS_NO_DATA;
+    return count;
+}
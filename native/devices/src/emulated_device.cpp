@@ -0,0 +1,126 @@
+#include "emulated_device.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Constructor without faults.
+ * @param seed Seed of the generator, each device of a run should have its own.
+ */
+FaultInjector::FaultInjector(uint32_t seed)
+    : faults({0, 0, 0, 0}),
+      state(1),
+      dropoutCount(0),
+      errorCount(0)
+{
+    setSeed(seed);
+}
+
+/**
+ * @brief Restart the sequence of faults and noise.
+ */
+void FaultInjector::setSeed(uint32_t seed)
+{
+    this->state = seed != 0 ? seed : 0x9E3779B9;
+}
+
+/**
+ * @brief Draw whether the current request is dropped, counted in getDropoutCount().
+ */
+bool FaultInjector::isDropped()
+{
+    if (this->faults.dropoutRate <= 0 || getUniform() >= this->faults.dropoutRate)
+        return false;
+    this->dropoutCount++;
+    return true;
+}
+
+/**
+ * @brief Draw whether the current response is wrong, counted in getErrorCount().
+ */
+bool FaultInjector::isWrong()
+{
+    if (this->faults.errorRate <= 0 || getUniform() >= this->faults.errorRate)
+        return false;
+    this->errorCount++;
+    return true;
+}
+
+/**
+ * @brief Add the gaussian noise to a measurement (Box-Muller).
+ */
+float FaultInjector::addNoise(float value)
+{
+    if (this->faults.noise <= 0)
+        return value;
+    float u1 = std::max(getUniform(), 1e-7f);
+    float u2 = getUniform();
+    return value + this->faults.noise * sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float)M_PI * u2);
+}
+
+/**
+ * @brief Next value of the generator (xorshift32).
+ */
+uint32_t FaultInjector::getRandom()
+{
+    this->state ^= this->state << 13;
+    this->state ^= this->state >> 17;
+    this->state ^= this->state << 5;
+    return this->state;
+}
+
+/**
+ * @brief Uniform value in [0, 1).
+ */
+float FaultInjector::getUniform()
+{
+    return (getRandom() >> 8) * (1.0f / 16777216.0f);
+}
+
+/**
+ * @brief Constructor.
+ * @param baudRate Baud rate of the UART.
+ * @param bitsPerCharacter Bits per character, 10 for 8N1, 11 for 8N2.
+ */
+UartTransmitter::UartTransmitter(uint32_t baudRate, uint8_t bitsPerCharacter)
+    : baudRate(baudRate),
+      bitsPerCharacter(bitsPerCharacter),
+      lastByteTime(0)
+{
+}
+
+/**
+ * @brief Queue bytes, sent one after the other from a time or after the bytes still queued.
+ * @param startTime Time the first character starts (us).
+ */
+void UartTransmitter::send(const uint8_t *data, size_t length, uint64_t startTime)
+{
+    uint64_t start = this->bytes.empty() ? startTime : std::max(startTime, this->lastByteTime);
+    for (size_t i = 0; i < length; i++)
+        this->bytes.push_back(std::make_pair(start + getCharacterTime(i + 1), data[i]));
+    if (length > 0)
+        this->lastByteTime = this->bytes.back().first;
+}
+
+/**
+ * @brief Take the bytes fully received by a time.
+ * @return Bytes given, at most maxLength.
+ */
+size_t UartTransmitter::take(uint8_t *data, size_t maxLength, uint64_t time)
+{
+    size_t length = 0;
+    while (length < maxLength && !this->bytes.empty() && this->bytes.front().first <= time)
+    {
+        data[length++] = this->bytes.front().second;
+        this->bytes.pop_front();
+    }
+    return length;
+}
+
+/**
+ * @brief Time to send characters at the baud rate (us).
+ */
+uint64_t UartTransmitter::getCharacterTime(size_t count) const
+{
+    return ((uint64_t)count * this->bitsPerCharacter * 1000000 + this->baudRate - 1) / this->baudRate;
+}
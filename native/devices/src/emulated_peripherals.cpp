@@ -0,0 +1,49 @@
+#include "emulated_peripherals.h"
+
+/**
+ * @brief Constructor, a culture at rest: pH 7.2 and 37 °C in the medium, each device with its own seed.
+ */
+EmulatedPeripherals::EmulatedPeripherals()
+    : dissolvedOxygen(VisiFermDevice::DEFAULT_ADDRESS, 1),
+      co2(2),
+      ph(7.2f, 3, AtlasEzoDevice::PH_READING_TIME, 3),
+      waterTemperature(37.0f, 3, AtlasEzoDevice::RTD_READING_TIME, 4),
+      air(5),
+      o2(6),
+      ioExpander(7)
+{
+    for (uint8_t i = 0; i < DRIVE_COUNT; i++)
+        this->drives[i].setSeed(8 + i);
+}
+
+/**
+ * @brief Plug all the peripherals on the board.
+ */
+void EmulatedPeripherals::attach(NativeBoard &board)
+{
+    board.attachUartDevice(VISIFERM_UART, &this->dissolvedOxygen);
+    board.attachUartDevice(GMP251_UART, &this->co2);
+    board.attachI2cDevice(PH_ADDRESS, &this->ph);
+    board.attachI2cDevice(RTD_ADDRESS, &this->waterTemperature);
+    board.attachI2cDevice(Sht40Device::DEFAULT_ADDRESS, &this->air);
+    board.attachI2cDevice(O2SensorDevice::DEFAULT_ADDRESS, &this->o2);
+    board.attachI2cDevice(IOExpanderDevice::DEFAULT_ADDRESS, &this->ioExpander);
+    for (uint8_t i = 0; i < DRIVE_COUNT; i++)
+        board.attachSpiDevice(DRIVE_TABLE[i].csPin, &this->drives[i]);
+}
+
+/**
+ * @brief Inject the same faults in all the peripherals.
+ */
+void EmulatedPeripherals::setFaults(const sDeviceFaults &faults)
+{
+    this->dissolvedOxygen.setFaults(faults);
+    this->co2.setFaults(faults);
+    this->ph.setFaults(faults);
+    this->waterTemperature.setFaults(faults);
+    this->air.setFaults(faults);
+    this->o2.setFaults(faults);
+    this->ioExpander.setFaults(faults);
+    for (uint8_t i = 0; i < DRIVE_COUNT; i++)
+        this->drives[i].setFaults(faults);
+}
@@ -0,0 +1,112 @@
+#include "gmp251_device.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * @brief Constructor, the probe measures 400 ppm with the factory compensations.
+ * @param seed Seed of the faults and noise.
+ */
+Gmp251Device::Gmp251Device(uint32_t seed)
+    : FaultInjector(seed),
+      co2(400.0f),
+      pressure(1013.25f),
+      temperature(25.0f),
+      oxygen(20.9f),
+      calibrationReference(0.0f),
+      measurementCount(0),
+      transmitter(BAUD_RATE, BITS_PER_CHARACTER)
+{
+}
+
+/**
+ * @brief Receive characters, each line ended by a carriage return is a command.
+ */
+void Gmp251Device::receive(const uint8_t *data, size_t length, uint64_t time)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        char c = data[i];
+        if (c == '\r')
+        {
+            answer(this->line, time + this->transmitter.getCharacterTime(i + 1));
+            this->line.clear();
+        }
+        else if (c != '\n' && this->line.size() < MAX_LINE_LENGTH)
+            this->line += c;
+    }
+}
+
+/**
+ * @brief Give the bytes of the responses received by the ESP32 by the given time.
+ */
+size_t Gmp251Device::transmit(uint8_t *data, size_t maxLength, uint64_t time)
+{
+    return this->transmitter.take(data, maxLength, time);
+}
+
+/**
+ * @brief Execute a command.
+ * @param time End of the command (us).
+ */
+void Gmp251Device::answer(const std::string &command, uint64_t time)
+{
+    if (isDropped())
+        return;
+
+    char text[MAX_LINE_LENGTH];
+    if (command.empty())
+    {
+        send(">", time); // Prompt
+    }
+    else if (command == "send")
+    {
+        this->measurementCount++;
+        if (isWrong())
+            send("CO2=  *****.* ppm\r\n", time);
+        else
+        {
+            snprintf(text, sizeof(text), "CO2=%9.1f ppm\r\n", addNoise(this->co2));
+            send(text, time);
+        }
+    }
+    else if (command.compare(0, 10, "env xpres ") == 0)
+    {
+        this->pressure = strtof(command.c_str() + 10, nullptr);
+        snprintf(text, sizeof(text), "xpres : %.2f hPa\r\n", this->pressure);
+        send(text, time);
+    }
+    else if (command.compare(0, 10, "env xtemp ") == 0)
+    {
+        this->temperature = strtof(command.c_str() + 10, nullptr);
+        snprintf(text, sizeof(text), "xtemp : %.2f 'C\r\n", this->temperature);
+        send(text, time);
+    }
+    else if (command.compare(0, 9, "env xoxy ") == 0)
+    {
+        this->oxygen = strtof(command.c_str() + 9, nullptr);
+        snprintf(text, sizeof(text), "xoxy : %.2f %%\r\n", this->oxygen);
+        send(text, time);
+    }
+    else if (command.compare(0, 9, "cco2 -hi ") == 0)
+    {
+        this->calibrationReference = strtof(command.c_str() + 9, nullptr);
+        send("OK\r\n", time);
+    }
+    else if (command == "cco2 -save" || command.compare(0, 7, "tcmode ") == 0)
+    {
+        send("OK\r\n", time);
+    }
+    else
+    {
+        send("Unknown command\r\n", time);
+    }
+}
+
+/**
+ * @brief Send a response after the response time.
+ */
+void Gmp251Device::send(const std::string &text, uint64_t time)
+{
+    this->transmitter.send((const uint8_t *)text.data(), text.size(), time + RESPONSE_TIME + getLatency());
+}
@@ -0,0 +1,134 @@
+#include "io_expander_device.h"
+
+#include <cstring>
+
+/**
+ * @brief Constructor, with the state at power on: all pins inputs, output register high.
+ * @param seed Seed of the faults.
+ */
+IOExpanderDevice::IOExpanderDevice(uint32_t seed)
+    : FaultInjector(seed),
+      registerAddress(REG_INPUT),
+      writeCount(0)
+{
+    memset(this->inputs, 0, sizeof(this->inputs));
+    memset(this->outputs, 0xFF, sizeof(this->outputs));
+    memset(this->polarity, 0, sizeof(this->polarity));
+    memset(this->config, 0xFF, sizeof(this->config));
+}
+
+/**
+ * @brief Check whether a pin is configured as an output.
+ */
+bool IOExpanderDevice::isOutput(uint8_t pin) const
+{
+    return pin < PIN_COUNT && !(this->config[pin / 8] & (1 << (pin % 8)));
+}
+
+/**
+ * @brief Get the level of a pin: driven by the output register for an output, applied by setInput() otherwise.
+ */
+bool IOExpanderDevice::getLevel(uint8_t pin) const
+{
+    if (pin >= PIN_COUNT)
+        return false;
+    const uint8_t *levels = isOutput(pin) ? this->outputs : this->inputs;
+    return levels[pin / 8] & (1 << (pin % 8));
+}
+
+/**
+ * @brief Apply a level on a pin, read when the pin is an input.
+ */
+void IOExpanderDevice::setInput(uint8_t pin, bool level)
+{
+    if (pin >= PIN_COUNT)
+        return;
+    if (level)
+        this->inputs[pin / 8] |= 1 << (pin % 8);
+    else
+        this->inputs[pin / 8] &= ~(1 << (pin % 8));
+}
+
+/**
+ * @brief Select a register with the first byte, then write the registers from it.
+ */
+bool IOExpanderDevice::write(const uint8_t *data, size_t length, uint64_t time)
+{
+    (void)time;
+    if (isDropped())
+        return false;
+    if (length == 0)
+        return true; // Address probe
+
+    this->registerAddress = data[0];
+    bool isCut = length > 2 && isWrong();
+    for (size_t i = 1; i < length; i++)
+    {
+        if (isCut && i > 1)
+            return false;
+        uint8_t *reg = getRegister(this->registerAddress);
+        if (reg != nullptr && this->registerAddress / BANK_SIZE != REG_INPUT / BANK_SIZE)
+            *reg = data[i];
+        this->registerAddress = getNextAddress(this->registerAddress);
+    }
+    if (length > 1)
+        this->writeCount++;
+    return true;
+}
+
+/**
+ * @brief Give the registers from the selected one. The input register reads the level of every pin.
+ */
+size_t IOExpanderDevice::read(uint8_t *data, size_t length, uint64_t time)
+{
+    (void)time;
+    if (isDropped())
+        return 0;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        uint8_t address = this->registerAddress;
+        uint8_t *reg = getRegister(address);
+        if (address / BANK_SIZE == REG_INPUT / BANK_SIZE && reg != nullptr)
+        {
+            uint8_t port = address % BANK_SIZE;
+            data[i] = ((this->outputs[port] & ~this->config[port]) | (this->inputs[port] & this->config[port])) ^ this->polarity[port];
+        }
+        else
+            data[i] = reg != nullptr ? *reg : 0;
+        this->registerAddress = getNextAddress(address);
+    }
+    return length;
+}
+
+/**
+ * @brief Get a port register, nullptr for an address without register.
+ */
+uint8_t *IOExpanderDevice::getRegister(uint8_t address)
+{
+    uint8_t port = address % BANK_SIZE;
+    if (port >= PORT_COUNT)
+        return nullptr;
+    switch (address - port)
+    {
+    case REG_INPUT:
+        return &this->inputs[port];
+    case REG_OUTPUT:
+        return &this->outputs[port];
+    case REG_POLARITY:
+        return &this->polarity[port];
+    case REG_CONFIG:
+        return &this->config[port];
+    default:
+        return nullptr;
+    }
+}
+
+/**
+ * @brief Next address of the auto-increment, rolls over to the first port of the bank.
+ */
+uint8_t IOExpanderDevice::getNextAddress(uint8_t address)
+{
+    uint8_t port = address % BANK_SIZE;
+    return address - port + (port + 1 < PORT_COUNT ? port + 1 : 0);
+}
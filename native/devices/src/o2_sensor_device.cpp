@@ -0,0 +1,83 @@
+#include "o2_sensor_device.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Constructor, the sensor measures the ambient air and is not calibrated.
+ * @param seed Seed of the faults and noise.
+ */
+O2SensorDevice::O2SensorDevice(uint32_t seed)
+    : FaultInjector(seed),
+      oxygen(20.9f),
+      registerAddress(REG_OXYGEN_DATA),
+      calibrationState(0),
+      pendingCalibration(0),
+      calibrationEnd(0)
+{
+}
+
+/**
+ * @brief Select a register, then write it when data follows.
+ */
+bool O2SensorDevice::write(const uint8_t *data, size_t length, uint64_t time)
+{
+    if (isDropped())
+        return false;
+    if (length == 0)
+        return true; // Address probe
+
+    this->calibrationState = getCalibrationState(time);
+    if (time >= this->calibrationEnd)
+        this->pendingCalibration = 0;
+    this->registerAddress = data[0];
+    if (this->registerAddress == REG_CALIBRATION && length > 1)
+    {
+        if (data[1] == CALIBRATION_20_9 || data[1] == CALIBRATION_99_5 || data[1] == CALIBRATION_CLEAR)
+        {
+            // A failed calibration leaves the state unchanged
+            this->pendingCalibration = isWrong() ? 0 : data[1];
+            this->calibrationEnd = time + CALIBRATION_TIME + getLatency();
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Give the registers from the selected one.
+ */
+size_t O2SensorDevice::read(uint8_t *data, size_t length, uint64_t time)
+{
+    if (isDropped())
+        return 0;
+
+    if (this->registerAddress == REG_OXYGEN_DATA)
+    {
+        uint16_t hundredths = (uint16_t)lroundf(std::min(std::max(addNoise(this->oxygen), 0.0f), 100.0f) * 100.0f);
+        uint8_t registers[3] = {(uint8_t)(hundredths / 100), (uint8_t)(hundredths / 10 % 10), (uint8_t)(hundredths % 10)};
+        if (isWrong())
+            registers[getRandom() % 3] = 0xFF;
+        size_t count = std::min(length, sizeof(registers));
+        std::copy(registers, registers + count, data);
+        return count;
+    }
+    if (this->registerAddress == REG_CALIBRATION_STATE)
+    {
+        data[0] = getCalibrationState(time);
+        return 1;
+    }
+    std::fill(data, data + length, 0);
+    return length;
+}
+
+/**
+ * @brief Get the calibration state, with the calibration in progress once it is complete.
+ */
+uint8_t O2SensorDevice::getCalibrationState(uint64_t time) const
+{
+    if (this->pendingCalibration == 0 || time < this->calibrationEnd)
+        return this->calibrationState;
+    if (this->pendingCalibration == CALIBRATION_CLEAR)
+        return 0;
+    return this->calibrationState | this->pendingCalibration;
+}
@@ -0,0 +1,106 @@
+#include "sht40_device.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/**
+ * @brief Constructor, the sensor measures 25 °C and 50 %RH.
+ * @param seed Seed of the faults and noise.
+ */
+Sht40Device::Sht40Device(uint32_t seed)
+    : FaultInjector(seed),
+      temperature(25.0f),
+      humidity(50.0f),
+      isResponseReady(false),
+      readyTime(0),
+      measurementCount(0)
+{
+    memset(this->response, 0, sizeof(this->response));
+}
+
+/**
+ * @brief Receive a command, the words are computed at once and given after the command time.
+ */
+bool Sht40Device::write(const uint8_t *data, size_t length, uint64_t time)
+{
+    if (isDropped())
+        return false;
+    if (length == 0)
+        return true; // Address probe
+
+    uint32_t commandTime;
+    switch (data[0])
+    {
+    case CMD_MEASURE_HIGH_PRECISION:
+    case CMD_MEASURE_MEDIUM_PRECISION:
+    case CMD_MEASURE_LOW_PRECISION:
+    {
+        commandTime = data[0] == CMD_MEASURE_HIGH_PRECISION     ? HIGH_PRECISION_TIME
+                      : data[0] == CMD_MEASURE_MEDIUM_PRECISION ? MEDIUM_PRECISION_TIME
+                                                                : LOW_PRECISION_TIME;
+        float rawTemperature = (addNoise(this->temperature) + 45.0f) * 65535.0f / 175.0f;
+        float rawHumidity = (addNoise(this->humidity) + 6.0f) * 65535.0f / 125.0f;
+        setWords((uint16_t)lroundf(std::min(std::max(rawTemperature, 0.0f), 65535.0f)),
+                 (uint16_t)lroundf(std::min(std::max(rawHumidity, 0.0f), 65535.0f)));
+        this->measurementCount++;
+        break;
+    }
+    case CMD_READ_SERIAL:
+        commandTime = COMMAND_TIME;
+        setWords(SERIAL_NUMBER >> 16, SERIAL_NUMBER & 0xFFFF);
+        break;
+    case CMD_SOFT_RESET:
+        this->isResponseReady = false;
+        return true;
+    default:
+        return false;
+    }
+
+    if (isWrong())
+        this->response[2] ^= 0x01;
+    this->isResponseReady = true;
+    this->readyTime = time + commandTime + getLatency();
+    return true;
+}
+
+/**
+ * @brief Give the words of the last command, NACK while it is processed or when they were already read.
+ */
+size_t Sht40Device::read(uint8_t *data, size_t length, uint64_t time)
+{
+    if (!this->isResponseReady || time < this->readyTime)
+        return 0;
+    size_t count = std::min(length, RESPONSE_SIZE);
+    memcpy(data, this->response, count);
+    this->isResponseReady = false;
+    return count;
+}
+
+/**
+ * @brief Fill the response with two words and their CRC.
+ */
+void Sht40Device::setWords(uint16_t first, uint16_t second)
+{
+    this->response[0] = first >> 8;
+    this->response[1] = first & 0xFF;
+    this->response[2] = getCrc(&this->response[0], 2);
+    this->response[3] = second >> 8;
+    this->response[4] = second & 0xFF;
+    this->response[5] = getCrc(&this->response[3], 2);
+}
+
+/**
+ * @brief CRC-8 of the Sensirion sensors (polynomial 0x31, initial value 0xFF).
+ */
+uint8_t Sht40Device::getCrc(const uint8_t *data, size_t length)
+{
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+    }
+    return crc;
+}
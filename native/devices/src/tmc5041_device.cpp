@@ -0,0 +1,241 @@
+#include "tmc5041_device.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static constexpr double VELOCITY_UNIT = Tmc5041Device::CLOCK_FREQUENCY / 16777216.0; // usteps/s, fCLK / 2^24
+static constexpr double ACCELERATION_UNIT =
+    (double)Tmc5041Device::CLOCK_FREQUENCY * Tmc5041Device::CLOCK_FREQUENCY / 2199023255552.0; // usteps/s², fCLK^2 / 2^41
+
+/**
+ * @brief Constructor, as after power on: registers at 0, motors at rest, reset flag set.
+ * @param seed Seed of the faults and noise.
+ */
+Tmc5041Device::Tmc5041Device(uint32_t seed)
+    : FaultInjector(seed),
+      rampTime(getNativeBoard().getTime()),
+      isSilent(false),
+      byteIndex(0),
+      nextData(0),
+      datagramCount(0)
+{
+    memset(this->registers, 0, sizeof(this->registers));
+    memset(this->datagram, 0, sizeof(this->datagram));
+    memset(this->response, 0, sizeof(this->response));
+    this->registers[REG_GSTAT] = STATUS_RESET;
+    for (uint8_t motor = 0; motor < MOTOR_COUNT; motor++)
+    {
+        this->ramps[motor] = {0, 0};
+        this->loads[motor] = 500;
+        this->driverErrors[motor] = false;
+    }
+}
+
+/**
+ * @brief Set the StallGuard value of a motor while it turns, lower with more load (0 to 1023).
+ */
+void Tmc5041Device::setLoad(uint8_t motor, uint16_t load)
+{
+    if (motor < MOTOR_COUNT)
+        this->loads[motor] = std::min<uint16_t>(load, SG_RESULT_MASK);
+}
+
+/**
+ * @brief Set or clear the driver error of a motor (overtemperature, short), reported in every SPI status.
+ */
+void Tmc5041Device::setDriverError(uint8_t motor, bool isError)
+{
+    if (motor < MOTOR_COUNT)
+        this->driverErrors[motor] = isError;
+}
+
+/**
+ * @brief Get the position of a motor now (usteps, XACTUAL).
+ */
+int32_t Tmc5041Device::getPosition(uint8_t motor)
+{
+    runRamps(getNativeBoard().getTime());
+    return motor < MOTOR_COUNT ? (int32_t)(uint32_t)llround(this->ramps[motor].position) : 0;
+}
+
+/**
+ * @brief Get the velocity of a motor now (usteps/s, + in the positive velocity mode).
+ */
+float Tmc5041Device::getVelocity(uint8_t motor)
+{
+    runRamps(getNativeBoard().getTime());
+    return motor < MOTOR_COUNT ? this->ramps[motor].velocity : 0.0f;
+}
+
+/**
+ * @brief Start or end a datagram, a complete one is executed when the chip select rises.
+ */
+void Tmc5041Device::select(bool isSelected)
+{
+    if (isSelected)
+    {
+        runRamps(getNativeBoard().getTime());
+        this->byteIndex = 0;
+        this->isSilent = isDropped();
+        this->response[0] = getStatus();
+        for (uint8_t i = 0; i < 4; i++)
+            this->response[1 + i] = this->nextData >> (24 - 8 * i);
+        if (isWrong())
+            this->response[1 + getRandom() % 4] ^= 1 << (getRandom() % 8);
+    }
+    else if (this->byteIndex == DATAGRAM_SIZE && !this->isSilent)
+    {
+        executeDatagram();
+    }
+}
+
+/**
+ * @brief Exchange a byte of the datagram, MSB first.
+ */
+uint8_t Tmc5041Device::transfer(uint8_t data)
+{
+    if (this->byteIndex >= DATAGRAM_SIZE)
+        return 0;
+    uint8_t response = this->response[this->byteIndex];
+    this->datagram[this->byteIndex++] = data;
+    return this->isSilent ? 0 : response;
+}
+
+/**
+ * @brief Run the ramp generators up to a time, by steps of RAMP_STEP at most.
+ */
+void Tmc5041Device::runRamps(uint64_t time)
+{
+    while (this->rampTime < time)
+    {
+        uint64_t duration = std::min<uint64_t>(time - this->rampTime, RAMP_STEP);
+        for (uint8_t motor = 0; motor < MOTOR_COUNT; motor++)
+            runRamp(motor, duration * 1e-6);
+        this->rampTime += duration;
+    }
+}
+
+/**
+ * @brief Run the ramp generator of a motor for a duration (s).
+ *
+ * The velocity modes accelerate toward +VMAX or -VMAX with AMAX. The positioning mode accelerates toward the target
+ * with AMAX and decelerates with DMAX so that it stops on it. The hold mode keeps the velocity.
+ */
+void Tmc5041Device::runRamp(uint8_t motor, double duration)
+{
+    uint8_t offset = motor * MOTOR_OFFSET;
+    sRampState &ramp = this->ramps[motor];
+    uint8_t mode = this->registers[REG_RAMPMODE + offset] & 0x03;
+    double vmax = (this->registers[REG_VMAX + offset] & 0x7FFFFF) * VELOCITY_UNIT;
+    double amax = (this->registers[REG_AMAX + offset] & 0xFFFF) * ACCELERATION_UNIT;
+    double dmax = (this->registers[REG_DMAX + offset] & 0xFFFF) * ACCELERATION_UNIT;
+    double target = (int32_t)this->registers[REG_XTARGET + offset];
+
+    double targetVelocity = ramp.velocity;
+    if (mode == RAMPMODE_VELOCITY_POSITIVE)
+        targetVelocity = vmax;
+    else if (mode == RAMPMODE_VELOCITY_NEGATIVE)
+        targetVelocity = -vmax;
+    else if (mode == RAMPMODE_POSITION)
+    {
+        double remaining = target - ramp.position;
+        double direction = remaining >= 0 ? 1.0 : -1.0;
+        double stopDistance = dmax > 0 ? ramp.velocity * ramp.velocity / (2 * dmax) : 0;
+        targetVelocity = (ramp.velocity * direction < 0 || fabs(remaining) <= stopDistance) ? 0 : direction * vmax;
+    }
+
+    double rate = (mode == RAMPMODE_POSITION && fabs(targetVelocity) < fabs(ramp.velocity) && dmax > 0) ? dmax : amax;
+    double maxChange = rate * duration;
+    double velocity = ramp.velocity + std::min(std::max(targetVelocity - ramp.velocity, -maxChange), maxChange);
+    double previousRemaining = target - ramp.position;
+    ramp.position += (ramp.velocity + velocity) / 2 * duration;
+    ramp.velocity = velocity;
+
+    if (mode == RAMPMODE_POSITION)
+    {
+        // Stops on the target when it is crossed or reached at a velocity that stops within a step
+        double remaining = target - ramp.position;
+        if ((previousRemaining != 0 && remaining * previousRemaining <= 0) || (fabs(remaining) < 1 && fabs(velocity) <= maxChange))
+            ramp = {target, 0};
+    }
+}
+
+/**
+ * @brief Check whether the velocity of a motor is VMAX, its velocity reached flag.
+ */
+bool Tmc5041Device::isVelocityReached(uint8_t motor) const
+{
+    double vmax = (this->registers[REG_VMAX + motor * MOTOR_OFFSET] & 0x7FFFFF) * VELOCITY_UNIT;
+    return fabs(fabs(this->ramps[motor].velocity) - vmax) < VELOCITY_UNIT / 2;
+}
+
+/**
+ * @brief Execute the datagram received, the data to send back with the next one is latched.
+ */
+void Tmc5041Device::executeDatagram()
+{
+    uint8_t address = this->datagram[0] & ADDRESS_MASK;
+    uint32_t data = (uint32_t)this->datagram[1] << 24 | (uint32_t)this->datagram[2] << 16 | (uint32_t)this->datagram[3] << 8 | this->datagram[4];
+    this->datagramCount++;
+    if (!(this->datagram[0] & WRITE_BIT))
+    {
+        this->nextData = readRegister(address);
+        return;
+    }
+
+    if (address == REG_GSTAT)
+        this->registers[address] &= ~data; // Cleared by writing 1
+    else
+        this->registers[address] = data;
+    for (uint8_t motor = 0; motor < MOTOR_COUNT; motor++)
+    {
+        if (address == REG_XACTUAL + motor * MOTOR_OFFSET)
+            this->ramps[motor].position = (int32_t)data;
+    }
+    this->nextData = data;
+}
+
+/**
+ * @brief Read a register, the ramp and driver status registers are computed.
+ */
+uint32_t Tmc5041Device::readRegister(uint8_t address)
+{
+    for (uint8_t motor = 0; motor < MOTOR_COUNT; motor++)
+    {
+        const sRampState &ramp = this->ramps[motor];
+        if (address == REG_XACTUAL + motor * MOTOR_OFFSET)
+            return (uint32_t)llround(ramp.position);
+        if (address == REG_VACTUAL + motor * MOTOR_OFFSET)
+            return (uint32_t)lround(ramp.velocity / VELOCITY_UNIT) & 0xFFFFFF;
+        if (address == REG_DRV_STATUS + motor * DRIVER_OFFSET)
+        {
+            bool isTurning = ramp.velocity != 0;
+            bool isPowered = (this->registers[REG_IHOLD_IRUN + motor * MOTOR_OFFSET] >> 8) & 0x1F;
+            if (!isTurning)
+                return DRV_STATUS_STANDSTILL;
+            return isPowered ? (uint32_t)std::min(std::max(lroundf(addNoise(this->loads[motor])), 0L), (long)SG_RESULT_MASK) : 0;
+        }
+    }
+
+    uint32_t value = this->registers[address];
+    if (address == REG_GSTAT)
+        this->registers[address] = 0; // Cleared by the read
+    return value;
+}
+
+/**
+ * @brief SPI status sent with the first byte of every response.
+ */
+uint8_t Tmc5041Device::getStatus() const
+{
+    uint8_t status = this->registers[REG_GSTAT] & STATUS_RESET;
+    for (uint8_t motor = 0; motor < MOTOR_COUNT; motor++)
+    {
+        if (this->driverErrors[motor])
+            status |= STATUS_DRIVER_ERROR_1 << motor;
+        if (isVelocityReached(motor))
+            status |= STATUS_VELOCITY_REACHED_1 << motor;
+    }
+    return status;
+}
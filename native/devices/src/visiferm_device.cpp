@@ -0,0 +1,153 @@
+#include "visiferm_device.h"
+
+#include <cstring>
+
+/**
+ * @brief Constructor, the sensor measures 100 %sat at 37 °C.
+ * @param address Modbus address.
+ * @param seed Seed of the faults and noise.
+ */
+VisiFermDevice::VisiFermDevice(uint8_t address, uint32_t seed)
+    : FaultInjector(seed),
+      address(address),
+      oxygen(100.0f),
+      temperature(37.0f),
+      measurementStatus(0),
+      requestCount(0),
+      transmitter(BAUD_RATE, BITS_PER_CHARACTER)
+{
+}
+
+/**
+ * @brief Receive a request, answered once it is complete. Bytes that do not start a valid frame are dropped, as
+ * after a collision on the bus.
+ */
+void VisiFermDevice::receive(const uint8_t *data, size_t length, uint64_t time)
+{
+    this->request.insert(this->request.end(), data, data + length);
+    uint64_t endTime = time + this->transmitter.getCharacterTime(length);
+    while (this->request.size() >= REQUEST_LENGTH)
+    {
+        uint16_t crc = this->request[6] | (uint16_t)this->request[7] << 8;
+        if (crc != getCrc(this->request.data(), REQUEST_LENGTH - 2))
+        {
+            this->request.erase(this->request.begin());
+            continue;
+        }
+        if (this->request[0] == this->address)
+            answer(this->request.data(), endTime);
+        this->request.erase(this->request.begin(), this->request.begin() + REQUEST_LENGTH);
+    }
+}
+
+/**
+ * @brief Give the bytes of the responses received by the ESP32 by the given time.
+ */
+size_t VisiFermDevice::transmit(uint8_t *data, size_t maxLength, uint64_t time)
+{
+    return this->transmitter.take(data, maxLength, time);
+}
+
+/**
+ * @brief Answer a valid request for this device.
+ * @param time End of the request (us).
+ */
+void VisiFermDevice::answer(const uint8_t *request, uint64_t time)
+{
+    this->requestCount++;
+    if (isDropped())
+        return;
+
+    uint8_t function = request[1];
+    uint16_t start = (uint16_t)request[2] << 8 | request[3];
+    uint16_t count = (uint16_t)request[4] << 8 | request[5];
+    if (function != FUNCTION_READ_HOLDING)
+    {
+        sendException(function, EXCEPTION_ILLEGAL_FUNCTION, time);
+        return;
+    }
+
+    uint16_t block;
+    float value;
+    if (count == 0)
+    {
+        sendException(function, EXCEPTION_ILLEGAL_ADDRESS, time);
+        return;
+    }
+    else if (start >= REG_PMC1 && start + count <= REG_PMC1 + PMC_LENGTH)
+    {
+        block = REG_PMC1;
+        value = this->oxygen;
+    }
+    else if (start >= REG_PMC6 && start + count <= REG_PMC6 + PMC_LENGTH)
+    {
+        block = REG_PMC6;
+        value = this->temperature;
+    }
+    else
+    {
+        sendException(function, EXCEPTION_ILLEGAL_ADDRESS, time);
+        return;
+    }
+    // PMC block: unit (2 registers), value (float, LSW first), measurement status, then the range, not read by the
+    // firmware and left at 0. Each register is big endian.
+    uint16_t registers[PMC_LENGTH] = {};
+    uint32_t bits;
+    value = addNoise(value);
+    memcpy(&bits, &value, sizeof(bits));
+    registers[2] = bits & 0xFFFF;
+    registers[3] = bits >> 16;
+    registers[4] = this->measurementStatus & 0xFFFF;
+    registers[5] = this->measurementStatus >> 16;
+
+    uint8_t frame[3 + 2 * PMC_LENGTH + 2];
+    frame[0] = this->address;
+    frame[1] = function;
+    frame[2] = count * 2;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        frame[3 + 2 * i] = registers[start - block + i] >> 8;
+        frame[4 + 2 * i] = registers[start - block + i] & 0xFF;
+    }
+    sendFrame(frame, 3 + 2 * count, time);
+}
+
+/**
+ * @brief Answer with a Modbus exception.
+ */
+void VisiFermDevice::sendException(uint8_t function, uint8_t exception, uint64_t time)
+{
+    uint8_t frame[5] = {this->address, (uint8_t)(function | 0x80), exception};
+    sendFrame(frame, 3, time);
+}
+
+/**
+ * @brief Add the CRC to a frame and send it after the response time.
+ * @param frame Frame with room for the 2 bytes of CRC.
+ * @param length Length without the CRC.
+ * @param time End of the request (us).
+ */
+void VisiFermDevice::sendFrame(uint8_t *frame, size_t length, uint64_t time)
+{
+    uint16_t crc = getCrc(frame, length);
+    frame[length] = crc & 0xFF;
+    frame[length + 1] = crc >> 8;
+    if (isWrong())
+        frame[getRandom() % (length + 2)] ^= 1 << (getRandom() % 8);
+    this->transmitter.send(frame, length + 2, time + RESPONSE_TIME + getLatency());
+}
+
+/**
+ * @brief Modbus CRC16 (polynomial 0xA001, initial value 0xFFFF).
+ */
+uint16_t VisiFermDevice::getCrc(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+    return crc;
+}
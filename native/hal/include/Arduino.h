@@ -0,0 +1,224 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+/**
+ * Host implementation of the Arduino API used by the firmware, for the native build. The time is the simulated time
+ * of the NativeBoard and the buses go to the devices attached to it, see native_board.h.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using std::isfinite;
+using std::isinf;
+using std::isnan;
+using std::max;
+using std::min;
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+#define degrees(rad) ((rad) * RAD_TO_DEG)
+#define radians(deg) ((deg) * DEG_TO_RAD)
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define PULLUP 0x04
+#define INPUT_PULLUP 0x05
+#define PULLDOWN 0x08
+#define INPUT_PULLDOWN 0x09
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define SERIAL_8N1 0x800001c
+#define SERIAL_8N2 0x800003c
+
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#ifndef RTC_NOINIT_ATTR
+#define RTC_NOINIT_ATTR
+#endif
+#define F(string) (string)
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint16_t word;
+
+// Sketch, called by the native harness instead of the ESP32 core
+void setup();
+void loop();
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+int8_t digitalPinToAnalogChannel(uint8_t pin);
+inline int digitalPinToInterrupt(int pin) { return pin; }
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t pin);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v'; }
+inline bool isAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+
+/**
+ * @class String
+ * @brief Arduino String on a std::string, with the same number formatting.
+ */
+class String
+{
+public:
+    String(const char *text = "") : text(text != nullptr ? text : "") {}
+    String(const std::string &text) : text(text) {}
+    explicit String(char c) : text(1, c) {}
+    String(unsigned char value, unsigned char base = DEC);
+    String(int value, unsigned char base = DEC);
+    String(unsigned int value, unsigned char base = DEC);
+    String(long value, unsigned char base = DEC);
+    String(unsigned long value, unsigned char base = DEC);
+    String(long long value, unsigned char base = DEC);
+    String(unsigned long long value, unsigned char base = DEC);
+    String(float value, unsigned int decimals = 2);
+    String(double value, unsigned int decimals = 2);
+
+    unsigned int length() const { return this->text.size(); }
+    bool isEmpty() const { return this->text.empty(); }
+    const char *c_str() const { return this->text.c_str(); }
+    char charAt(unsigned int index) const { return index < this->text.size() ? this->text[index] : '\0'; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char &operator[](unsigned int index) { return this->text[index]; }
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String &pattern, unsigned int from = 0) const;
+    int lastIndexOf(char c) const;
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    bool startsWith(const String &prefix) const { return this->text.compare(0, prefix.text.size(), prefix.text) == 0; }
+    bool endsWith(const String &suffix) const;
+    bool equals(const String &other) const { return this->text == other.text; }
+    bool equalsIgnoreCase(const String &other) const;
+
+    long toInt() const { return atol(this->text.c_str()); }
+    float toFloat() const { return atof(this->text.c_str()); }
+    double toDouble() const { return atof(this->text.c_str()); }
+
+    void trim();
+    void toUpperCase();
+    void toLowerCase();
+    void replace(const String &find, const String &replacement);
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1);
+    bool reserve(unsigned int size);
+    bool concat(const String &other);
+    void toCharArray(char *buffer, unsigned int size, unsigned int from = 0) const;
+    void getBytes(unsigned char *buffer, unsigned int size, unsigned int from = 0) const;
+
+    String &operator+=(const String &other);
+    String &operator+=(const char *other);
+    String &operator+=(char c);
+    bool operator==(const String &other) const { return this->text == other.text; }
+    bool operator==(const char *other) const { return this->text == (other != nullptr ? other : ""); }
+    bool operator!=(const String &other) const { return this->text != other.text; }
+    bool operator!=(const char *other) const { return !(*this == other); }
+    bool operator<(const String &other) const { return this->text < other.text; }
+
+private:
+    std::string text;
+};
+
+String operator+(const String &left, const String &right);
+String operator+(const String &left, const char *right);
+String operator+(const char *left, const String &right);
+String operator+(const String &left, char right);
+String operator+(const String &left, int right);
+String operator+(const String &left, unsigned int right);
+String operator+(const String &left, long right);
+String operator+(const String &left, unsigned long right);
+String operator+(const String &left, float right);
+String operator+(const String &left, double right);
+
+/**
+ * @class Print
+ * @brief Arduino Print, the derived classes only write bytes.
+ */
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *text) { return text != nullptr ? write((const uint8_t *)text, strlen(text)) : 0; }
+    size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+    virtual void flush() {}
+
+    size_t print(const String &text) { return write(text.c_str(), text.length()); }
+    size_t print(const char *text) { return write(text); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = DEC) { return print(String(value, base)); }
+    size_t print(int value, int base = DEC) { return print(String(value, base)); }
+    size_t print(unsigned int value, int base = DEC) { return print(String(value, base)); }
+    size_t print(long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(unsigned long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(long long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(unsigned long long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(double value, int digits = 2) { return print(String(value, digits)); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T &value) { return print(value) + println(); }
+    template <typename T>
+    size_t println(const T &value, int format) { return print(value, format) + println(); }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+/**
+ * @class Stream
+ * @brief Arduino Stream. The reads do not wait: the simulated time only runs between two loops.
+ */
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) { this->timeout = timeout; }
+    size_t readBytes(uint8_t *buffer, size_t length);
+    size_t readBytes(char *buffer, size_t length) { return readBytes((uint8_t *)buffer, length); }
+    size_t readBytesUntil(char terminator, char *buffer, size_t length);
+    String readString();
+    String readStringUntil(char terminator);
+
+protected:
+    unsigned long timeout = 1000; // ms, kept for the API
+};
+
+#include "HardwareSerial.h"
+
+#endif // ARDUINO_H
@@ -0,0 +1,38 @@
+#ifndef HARDWARE_SERIAL_H
+#define HARDWARE_SERIAL_H
+
+#include "Arduino.h"
+
+/**
+ * @class HardwareSerial
+ * @brief UART of the NativeBoard. The object only holds the UART number, so a copy uses the same port like on the
+ * ESP32. UART 0 is the console, the others go to the UartDevice attached to them.
+ */
+class HardwareSerial : public Stream
+{
+public:
+    constexpr HardwareSerial(uint8_t uartNumber) : uartNumber(uartNumber) {}
+
+    void begin(unsigned long baudrate, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1,
+               bool invert = false, unsigned long timeout = 20000UL);
+    void end() {}
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override {}
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    int availableForWrite() { return 128; }
+    void setRxBufferSize(size_t) {}
+    operator bool() const { return true; }
+
+private:
+    uint8_t uartNumber;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+
+#endif // HARDWARE_SERIAL_H
@@ -0,0 +1,66 @@
+#ifndef PREFERENCES_H
+#define PREFERENCES_H
+
+#include "Arduino.h"
+
+/**
+ * @class Preferences
+ * @brief NVS of the NativeBoard, kept in memory until NativeBoard::clearPreferences().
+ */
+class Preferences
+{
+public:
+    Preferences() : isOpen(false), isReadOnly(false) {}
+
+    bool begin(const char *name, bool readOnly = false, const char *partition = nullptr);
+    void end() { this->isOpen = false; }
+    bool clear();
+    bool remove(const char *key);
+    bool isKey(const char *key);
+
+    size_t putChar(const char *key, int8_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putUChar(const char *key, uint8_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putShort(const char *key, int16_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putUShort(const char *key, uint16_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putInt(const char *key, int32_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putUInt(const char *key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putLong(const char *key, int32_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putULong(const char *key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putULong64(const char *key, uint64_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putFloat(const char *key, float value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putBool(const char *key, bool value) { return putUChar(key, value); }
+    size_t putBytes(const char *key, const void *value, size_t length);
+
+    int8_t getChar(const char *key, int8_t defaultValue = 0) { return getValue(key, defaultValue); }
+    uint8_t getUChar(const char *key, uint8_t defaultValue = 0) { return getValue(key, defaultValue); }
+    int16_t getShort(const char *key, int16_t defaultValue = 0) { return getValue(key, defaultValue); }
+    uint16_t getUShort(const char *key, uint16_t defaultValue = 0) { return getValue(key, defaultValue); }
+    int32_t getInt(const char *key, int32_t defaultValue = 0) { return getValue(key, defaultValue); }
+    uint32_t getUInt(const char *key, uint32_t defaultValue = 0) { return getValue(key, defaultValue); }
+    int32_t getLong(const char *key, int32_t defaultValue = 0) { return getValue(key, defaultValue); }
+    uint32_t getULong(const char *key, uint32_t defaultValue = 0) { return getValue(key, defaultValue); }
+    uint64_t getULong64(const char *key, uint64_t defaultValue = 0) { return getValue(key, defaultValue); }
+    float getFloat(const char *key, float defaultValue = NAN) { return getValue(key, defaultValue); }
+    bool getBool(const char *key, bool defaultValue = false) { return getUChar(key, defaultValue) != 0; }
+    size_t getBytesLength(const char *key);
+    size_t getBytes(const char *key, void *buffer, size_t maxLength);
+
+private:
+    /**
+     * @brief Read a value saved with the same size, the default value otherwise.
+     */
+    template <typename T>
+    T getValue(const char *key, T defaultValue)
+    {
+        T value;
+        if (getBytesLength(key) != sizeof(T) || getBytes(key, &value, sizeof(T)) != sizeof(T))
+            return defaultValue;
+        return value;
+    }
+
+    std::string name;
+    bool isOpen;
+    bool isReadOnly;
+};
+
+#endif // PREFERENCES_H
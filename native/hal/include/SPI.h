@@ -0,0 +1,47 @@
+#ifndef SPI_H
+#define SPI_H
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+class SPISettings
+{
+public:
+    SPISettings(uint32_t clock = 1000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0)
+        : clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+    uint32_t clock;
+    uint8_t bitOrder;
+    uint8_t dataMode;
+};
+
+/**
+ * @class SPIClass
+ * @brief SPI master of the NativeBoard, the bytes go to the SpiDevice whose chip select pin is low.
+ */
+class SPIClass
+{
+public:
+    SPIClass(uint8_t busNumber = 0) : clock(1000000) { (void)busNumber; }
+
+    void begin(int8_t = -1, int8_t = -1, int8_t = -1, int8_t = -1) {}
+    void end() {}
+    void beginTransaction(SPISettings settings);
+    void endTransaction() {}
+    uint8_t transfer(uint8_t data);
+    void transfer(void *data, uint32_t size);
+    void transferBytes(const uint8_t *data, uint8_t *out, uint32_t size);
+    void writeBytes(const uint8_t *data, uint32_t size) { transferBytes(data, nullptr, size); }
+
+private:
+    uint32_t clock; // Hz, sets the time of a transfer
+};
+
+extern SPIClass SPI;
+
+#endif // SPI_H
@@ -0,0 +1,47 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include "Arduino.h"
+
+/**
+ * @class TwoWire
+ * @brief I2C master of the NativeBoard, the transactions go to the I2cDevice attached at their address.
+ */
+class TwoWire : public Stream
+{
+public:
+    TwoWire(uint8_t busNumber = 0);
+
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+    bool setClock(uint32_t frequency);
+    void setTimeOut(uint16_t) {}
+
+    void beginTransmission(uint8_t address);
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+    size_t requestFrom(uint8_t address, size_t quantity, bool sendStop = true);
+    uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity); }
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    int available() override { return this->rxLength - this->rxIndex; }
+    int read() override { return this->rxIndex < this->rxLength ? this->rxBuffer[this->rxIndex++] : -1; }
+    int peek() override { return this->rxIndex < this->rxLength ? this->rxBuffer[this->rxIndex] : -1; }
+
+    static constexpr size_t BUFFER_SIZE = 128; // I2C_BUFFER_LENGTH of the ESP32 core
+
+private:
+    uint32_t frequency; // Hz, sets the time of a transaction
+    uint8_t txAddress;
+    uint8_t txBuffer[BUFFER_SIZE];
+    size_t txLength;
+    bool isTransmitting;
+    uint8_t rxBuffer[BUFFER_SIZE];
+    size_t rxLength;
+    size_t rxIndex;
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_H
@@ -0,0 +1,20 @@
+#ifndef ESP_ADC_CAL_H
+#define ESP_ADC_CAL_H
+
+#include "driver/adc.h"
+
+typedef struct
+{
+    uint32_t vref; // mV
+} esp_adc_cal_characteristics_t;
+
+typedef enum
+{
+    ESP_ADC_CAL_VAL_EFUSE_VREF
+} esp_adc_cal_value_t;
+
+esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t unit, adc_atten_t attenuation, adc_bits_width_t width,
+                                             uint32_t defaultVref, esp_adc_cal_characteristics_t *characteristics);
+uint32_t esp_adc_cal_raw_to_voltage(uint32_t raw, const esp_adc_cal_characteristics_t *characteristics);
+
+#endif // ESP_ADC_CAL_H
@@ -0,0 +1,15 @@
+#ifndef ESP_ERR_H
+#define ESP_ERR_H
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_TIMEOUT 0x107
+
+#ifndef BIT
+#define BIT(n) (1UL << (n))
+#endif
+
+#endif // ESP_ERR_H
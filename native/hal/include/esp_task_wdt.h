@@ -0,0 +1,12 @@
+#ifndef ESP_TASK_WDT_H
+#define ESP_TASK_WDT_H
+
+#include <cstdint>
+#include "esp_err.h"
+
+// The task watchdog never fires on the host, a stalled loop is seen by the caller of loop()
+esp_err_t esp_task_wdt_init(uint32_t timeout, bool isPanic);
+esp_err_t esp_task_wdt_add(void *task);
+esp_err_t esp_task_wdt_reset();
+
+#endif // ESP_TASK_WDT_H
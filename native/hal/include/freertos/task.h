@@ -0,0 +1,24 @@
+#ifndef FREERTOS_TASK_H
+#define FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+/*
+ * The tasks are created but never run: the main loop is simulated on a single thread and the tasks loop forever.
+ * Their work (ADC sampling, interlock checks) is outside of the loop budget on the ESP32 as well.
+ */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stackSize, void *parameter,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *previousWakeTime, TickType_t increment);
+TickType_t xTaskGetTickCount();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *isHigherPriorityTaskWoken);
+uint32_t ulTaskNotifyTake(BaseType_t isClearOnExit, TickType_t ticks);
+
+#endif // FREERTOS_TASK_H
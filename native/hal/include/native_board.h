@@ -0,0 +1,152 @@
+#ifndef NATIVE_BOARD_H
+#define NATIVE_BOARD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+typedef enum
+{
+    NATIVE_BUS_I2C = 0,
+    NATIVE_BUS_SPI,
+    NATIVE_BUS_UART_1,  // RS485 of the GMP251
+    NATIVE_BUS_UART_2,  // RS485 of the VisiFerm
+    NATIVE_BUS_CONSOLE, // Serial, telemetry and commands
+
+    NATIVE_BUS_MAX
+} eNativeBus;
+
+/**
+ * @brief Traffic of a bus since the last NativeBoard::resetBusCounters().
+ */
+typedef struct
+{
+    uint32_t transactions; // I2C write or read, SPI transaction, UART write
+    uint32_t bytesSent;    // From the ESP32
+    uint32_t bytesReceived;
+    uint64_t busTime;      // us the ESP32 waited for the bus (I2C and SPI, the UARTs are buffered)
+} sBusCounters;
+
+/**
+ * @brief Device on the I2C bus.
+ */
+class I2cDevice
+{
+public:
+    virtual ~I2cDevice() {}
+
+    /**
+     * @brief Receive a write transaction.
+     * @return False to NACK it.
+     */
+    virtual bool write(const uint8_t *data, size_t length, uint64_t time) = 0;
+
+    /**
+     * @brief Answer a read transaction.
+     * @return Bytes given, the master reads 0xFF after them. 0 to NACK the address (ex: measurement in progress).
+     */
+    virtual size_t read(uint8_t *data, size_t length, uint64_t time) = 0;
+};
+
+/**
+ * @brief Device on a UART.
+ */
+class UartDevice
+{
+public:
+    virtual ~UartDevice() {}
+
+    /**
+     * @brief Receive the bytes written by the ESP32.
+     */
+    virtual void receive(const uint8_t *data, size_t length, uint64_t time) = 0;
+
+    /**
+     * @brief Give the bytes the device has sent by the given time.
+     * @return Bytes given, at most maxLength.
+     */
+    virtual size_t transmit(uint8_t *data, size_t maxLength, uint64_t time) = 0;
+};
+
+/**
+ * @brief Device on the SPI bus, selected by its chip select pin.
+ */
+class SpiDevice
+{
+public:
+    virtual ~SpiDevice() {}
+    virtual void select(bool isSelected) { (void)isSelected; }
+    virtual uint8_t transfer(uint8_t data) = 0;
+};
+
+/**
+ * @class NativeBoard
+ * @brief The simulated ESP32 board of the native build: time, pins, devices on the buses and NVS.
+ *
+ * The time only runs when the caller advances it or when the firmware waits (delay(), I2C and SPI transfers), so a
+ * run does not depend on the speed of the host and hours of culture run in seconds. A bus without a device behaves
+ * like an absent device: NACK on I2C, silence on the UARTs, zeros on SPI.
+ *
+ * The board is created at its first use by getNativeBoard(), the firmware objects may use it from their constructors.
+ */
+class NativeBoard
+{
+public:
+    NativeBoard();
+
+    uint64_t getTime() const { return this->time; }
+    void advanceTime(uint64_t duration) { this->time += duration; }
+
+    void attachI2cDevice(uint8_t address, I2cDevice *device);
+    void attachUartDevice(uint8_t uartNumber, UartDevice *device);
+    void attachSpiDevice(uint8_t csPin, SpiDevice *device);
+    void detachDevices();
+
+    void setPin(uint8_t pin, bool level);
+    bool getPin(uint8_t pin) const { return pin < PIN_COUNT && this->pins[pin]; }
+    void setAnalogValue(uint8_t pin, uint16_t raw);
+    uint16_t getAnalogValue(uint8_t pin) const { return pin < PIN_COUNT ? this->analogValues[pin] : 0; }
+
+    void writeConsoleInput(const std::string &text);
+    void setConsoleOutput(bool isEchoed, bool isCaptured);
+    std::string takeConsoleOutput();
+
+    const sBusCounters &getBusCounters(eNativeBus bus) const { return this->busCounters[bus]; }
+    void resetBusCounters();
+    void clearPreferences() { this->preferences.clear(); }
+
+    // Used by the HAL
+    void addTransaction(eNativeBus bus, size_t bytesSent, size_t bytesReceived, uint64_t busTime);
+    I2cDevice *getI2cDevice(uint8_t address) const;
+    SpiDevice *getSelectedSpiDevice() const;
+    int uartAvailable(uint8_t uartNumber);
+    int uartRead(uint8_t uartNumber, bool isRemoved);
+    size_t uartWrite(uint8_t uartNumber, const uint8_t *data, size_t length);
+    std::map<std::string, std::vector<uint8_t>> &getPreferences() { return this->preferences; }
+
+    static constexpr uint8_t PIN_COUNT = 40;
+    static constexpr uint8_t UART_COUNT = 3;
+
+private:
+    uint64_t time; // us
+    bool pins[PIN_COUNT];
+    uint16_t analogValues[PIN_COUNT];
+    I2cDevice *i2cDevices[128];
+    std::map<uint8_t, SpiDevice *> spiDevices; // By chip select pin
+    UartDevice *uartDevices[UART_COUNT];
+    std::deque<uint8_t> uartRx[UART_COUNT];    // Received by the ESP32, not read yet
+    std::string consoleOutput;                 // Captured, not taken yet
+    bool isConsoleEchoed;                      // Printed on the standard output
+    bool isConsoleCaptured;
+    sBusCounters busCounters[NATIVE_BUS_MAX];
+    std::map<std::string, std::vector<uint8_t>> preferences; // "namespace/key"
+
+    static constexpr size_t UART_RX_BUFFER_SIZE = 256; // Bytes, rx buffer of the ESP32 core
+};
+
+NativeBoard &getNativeBoard();
+
+#endif // NATIVE_BOARD_H
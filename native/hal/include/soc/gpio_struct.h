@@ -0,0 +1,35 @@
+#ifndef SOC_GPIO_STRUCT_H
+#define SOC_GPIO_STRUCT_H
+
+#include <cstdint>
+
+/**
+ * @brief Write-only set or clear register of the GPIO, a write changes the pins of the NativeBoard.
+ */
+class GpioWriteRegister
+{
+public:
+    constexpr GpioWriteRegister(uint8_t firstPin, bool level) : firstPin(firstPin), level(level) {}
+    void operator=(uint32_t mask);
+
+private:
+    uint8_t firstPin; // Pin of bit 0
+    bool level;       // Written to the pins of the mask
+};
+
+/**
+ * @brief The output registers of the ESP32 GPIO used by the drivers.
+ */
+typedef struct
+{
+    GpioWriteRegister out_w1ts;
+    GpioWriteRegister out_w1tc;
+    struct
+    {
+        GpioWriteRegister val;
+    } out1_w1ts, out1_w1tc;
+} gpio_dev_t;
+
+extern gpio_dev_t GPIO;
+
+#endif // SOC_GPIO_STRUCT_H
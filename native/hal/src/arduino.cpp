@@ -0,0 +1,375 @@
+#include <Arduino.h>
+#include <cctype>
+#include <cstdarg>
+#include "native_board.h"
+
+static const int8_t ANALOG_CHANNELS[NativeBoard::PIN_COUNT] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, // ADC2 pins, unused by the firmware
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 4, 5, 6, 7, 0, 1, 2, 3};        // ADC1 on GPIO 32 to 39
+
+static void (*interruptHandlers[NativeBoard::PIN_COUNT])(void) = {};
+static unsigned long randomState = 1;
+
+unsigned long millis()
+{
+    return (unsigned long)(uint32_t)(getNativeBoard().getTime() / 1000);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)(uint32_t)getNativeBoard().getTime();
+}
+
+void delay(uint32_t ms)
+{
+    getNativeBoard().advanceTime((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    getNativeBoard().advanceTime(us);
+}
+
+void yield()
+{
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    // A pull-up reads high until a device drives the pin
+    if (mode == INPUT_PULLUP)
+        getNativeBoard().setPin(pin, HIGH);
+}
+
+void digitalWrite(uint8_t pin, uint8_t level)
+{
+    getNativeBoard().setPin(pin, level != LOW);
+}
+
+int digitalRead(uint8_t pin)
+{
+    return getNativeBoard().getPin(pin) ? HIGH : LOW;
+}
+
+uint16_t analogRead(uint8_t pin)
+{
+    return getNativeBoard().getAnalogValue(pin);
+}
+
+int8_t digitalPinToAnalogChannel(uint8_t pin)
+{
+    return pin < NativeBoard::PIN_COUNT ? ANALOG_CHANNELS[pin] : -1;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode)
+{
+    (void)mode;
+    if (pin < NativeBoard::PIN_COUNT)
+        interruptHandlers[pin] = handler;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    if (pin < NativeBoard::PIN_COUNT)
+        interruptHandlers[pin] = nullptr;
+}
+
+long random(long max)
+{
+    return max > 0 ? random(0, max) : 0;
+}
+
+long random(long min, long max)
+{
+    // Same sequence on every run, the benchmarks stay reproducible
+    if (max <= min)
+        return min;
+    randomState = randomState * 1103515245UL + 12345UL;
+    return min + (long)((randomState >> 16) % (unsigned long)(max - min));
+}
+
+void randomSeed(unsigned long seed)
+{
+    randomState = seed;
+}
+
+/**
+ * @brief Format an integer like the Arduino core.
+ */
+static std::string formatInteger(unsigned long long value, bool isNegative, unsigned char base)
+{
+    if (base < 2 || base > 36)
+        base = DEC;
+    char digits[72];
+    size_t length = 0;
+    do
+    {
+        uint8_t digit = value % base;
+        digits[length++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    } while (value > 0);
+    if (isNegative)
+        digits[length++] = '-';
+    std::reverse(digits, digits + length);
+    return std::string(digits, length);
+}
+
+/**
+ * @brief Format a float like the Arduino core (dtostrf).
+ */
+static std::string formatFloat(double value, unsigned int decimals)
+{
+    if (isnan(value))
+        return "nan";
+    if (isinf(value))
+        return value > 0 ? "inf" : "-inf";
+    char text[64];
+    snprintf(text, sizeof(text), "%.*f", (int)decimals, value);
+    return text;
+}
+
+String::String(unsigned char value, unsigned char base) : text(formatInteger(value, false, base)) {}
+String::String(int value, unsigned char base)
+    : text(base == DEC ? formatInteger(value < 0 ? -(long long)value : value, value < 0, base) : formatInteger((unsigned int)value, false, base)) {}
+String::String(unsigned int value, unsigned char base) : text(formatInteger(value, false, base)) {}
+String::String(long value, unsigned char base)
+    : text(base == DEC ? formatInteger(value < 0 ? -(long long)value : value, value < 0, base) : formatInteger((unsigned long)value, false, base)) {}
+String::String(unsigned long value, unsigned char base) : text(formatInteger(value, false, base)) {}
+String::String(long long value, unsigned char base)
+    : text(formatInteger(value < 0 ? 0ULL - (unsigned long long)value : value, value < 0, base)) {}
+String::String(unsigned long long value, unsigned char base) : text(formatInteger(value, false, base)) {}
+String::String(float value, unsigned int decimals) : text(formatFloat(value, decimals)) {}
+String::String(double value, unsigned int decimals) : text(formatFloat(value, decimals)) {}
+
+int String::indexOf(char c, unsigned int from) const
+{
+    size_t index = this->text.find(c, from);
+    return index == std::string::npos ? -1 : (int)index;
+}
+
+int String::indexOf(const String &pattern, unsigned int from) const
+{
+    size_t index = this->text.find(pattern.text, from);
+    return index == std::string::npos ? -1 : (int)index;
+}
+
+int String::lastIndexOf(char c) const
+{
+    size_t index = this->text.rfind(c);
+    return index == std::string::npos ? -1 : (int)index;
+}
+
+String String::substring(unsigned int from) const
+{
+    return from < this->text.size() ? String(this->text.substr(from)) : String();
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+    if (from > to)
+        std::swap(from, to);
+    if (from >= this->text.size())
+        return String();
+    return String(this->text.substr(from, to - from));
+}
+
+bool String::endsWith(const String &suffix) const
+{
+    return this->text.size() >= suffix.text.size() &&
+           this->text.compare(this->text.size() - suffix.text.size(), suffix.text.size(), suffix.text) == 0;
+}
+
+bool String::equalsIgnoreCase(const String &other) const
+{
+    if (this->text.size() != other.text.size())
+        return false;
+    for (size_t i = 0; i < this->text.size(); i++)
+    {
+        if (tolower((unsigned char)this->text[i]) != tolower((unsigned char)other.text[i]))
+            return false;
+    }
+    return true;
+}
+
+void String::trim()
+{
+    size_t first = 0;
+    while (first < this->text.size() && isSpace(this->text[first]))
+        first++;
+    size_t last = this->text.size();
+    while (last > first && isSpace(this->text[last - 1]))
+        last--;
+    this->text = this->text.substr(first, last - first);
+}
+
+void String::toUpperCase()
+{
+    for (char &c : this->text)
+        c = toupper((unsigned char)c);
+}
+
+void String::toLowerCase()
+{
+    for (char &c : this->text)
+        c = tolower((unsigned char)c);
+}
+
+void String::replace(const String &find, const String &replacement)
+{
+    if (find.text.empty())
+        return;
+    size_t index = 0;
+    while ((index = this->text.find(find.text, index)) != std::string::npos)
+    {
+        this->text.replace(index, find.text.size(), replacement.text);
+        index += replacement.text.size();
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count)
+{
+    if (index < this->text.size())
+        this->text.erase(index, count);
+}
+
+bool String::reserve(unsigned int size)
+{
+    this->text.reserve(size);
+    return true;
+}
+
+bool String::concat(const String &other)
+{
+    this->text += other.text;
+    return true;
+}
+
+void String::toCharArray(char *buffer, unsigned int size, unsigned int from) const
+{
+    getBytes((unsigned char *)buffer, size, from);
+}
+
+void String::getBytes(unsigned char *buffer, unsigned int size, unsigned int from) const
+{
+    if (size == 0)
+        return;
+    size_t length = from < this->text.size() ? std::min<size_t>(size - 1, this->text.size() - from) : 0;
+    memcpy(buffer, this->text.data() + from, length);
+    buffer[length] = '\0';
+}
+
+String &String::operator+=(const String &other)
+{
+    this->text += other.text;
+    return *this;
+}
+
+String &String::operator+=(const char *other)
+{
+    if (other != nullptr)
+        this->text += other;
+    return *this;
+}
+
+String &String::operator+=(char c)
+{
+    this->text += c;
+    return *this;
+}
+
+String operator+(const String &left, const String &right)
+{
+    String sum(left);
+    sum += right;
+    return sum;
+}
+
+String operator+(const String &left, const char *right)
+{
+    String sum(left);
+    sum += right;
+    return sum;
+}
+
+String operator+(const char *left, const String &right)
+{
+    String sum(left);
+    sum += right;
+    return sum;
+}
+
+String operator+(const String &left, char right)
+{
+    String sum(left);
+    sum += right;
+    return sum;
+}
+
+String operator+(const String &left, int right) { return left + String(right); }
+String operator+(const String &left, unsigned int right) { return left + String(right); }
+String operator+(const String &left, long right) { return left + String(right); }
+String operator+(const String &left, unsigned long right) { return left + String(right); }
+String operator+(const String &left, float right) { return left + String(right); }
+String operator+(const String &left, double right) { return left + String(right); }
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t count = 0;
+    while (count < size && write(buffer[count]) == 1)
+        count++;
+    return count;
+}
+
+size_t Print::printf(const char *format, ...)
+{
+    char text[256];
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vsnprintf(text, sizeof(text), format, arguments);
+    va_end(arguments);
+    if (length < 0)
+        return 0;
+    return write(text, std::min<size_t>(length, sizeof(text) - 1));
+}
+
+size_t Stream::readBytes(uint8_t *buffer, size_t length)
+{
+    size_t count = 0;
+    while (count < length && available() > 0)
+        buffer[count++] = read();
+    return count;
+}
+
+size_t Stream::readBytesUntil(char terminator, char *buffer, size_t length)
+{
+    size_t count = 0;
+    while (count < length && available() > 0)
+    {
+        int c = read();
+        if (c == terminator)
+            break;
+        buffer[count++] = c;
+    }
+    return count;
+}
+
+String Stream::readString()
+{
+    String text;
+    while (available() > 0)
+        text += (char)read();
+    return text;
+}
+
+String Stream::readStringUntil(char terminator)
+{
+    String text;
+    while (available() > 0)
+    {
+        int c = read();
+        if (c == terminator)
+            break;
+        text += (char)c;
+    }
+    return text;
+}
@@ -0,0 +1,223 @@
+#include <Arduino.h>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+#include <esp_system.h>
+#include <esp_task_wdt.h>
+#include <esp_timer.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <soc/gpio_struct.h>
+#include "native_board.h"
+
+static constexpr uint32_t ADC_MAX_RAW = 4095;
+static constexpr uint32_t ADC_FULL_SCALE = 3100; // mV at 11 dB
+
+// The handles only need to be different from nullptr
+static uint8_t taskHandles[8];
+static uint8_t taskCount = 0;
+static uint8_t semaphoreHandle;
+
+gpio_dev_t GPIO = {GpioWriteRegister(0, HIGH), GpioWriteRegister(0, LOW), {GpioWriteRegister(32, HIGH)}, {GpioWriteRegister(32, LOW)}};
+
+void GpioWriteRegister::operator=(uint32_t mask)
+{
+    for (uint8_t bit = 0; bit < 32; bit++)
+    {
+        if (mask & (1UL << bit))
+            getNativeBoard().setPin(this->firstPin + bit, this->level);
+    }
+}
+
+esp_reset_reason_t esp_reset_reason()
+{
+    return ESP_RST_POWERON;
+}
+
+void esp_restart()
+{
+    fprintf(stderr, "esp_restart() called at %lu ms\n", millis());
+    exit(EXIT_FAILURE);
+}
+
+int64_t esp_timer_get_time()
+{
+    return (int64_t)getNativeBoard().getTime();
+}
+
+esp_err_t esp_task_wdt_init(uint32_t timeout, bool isPanic)
+{
+    (void)timeout;
+    (void)isPanic;
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_add(void *task)
+{
+    (void)task;
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_reset()
+{
+    return ESP_OK;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stackSize, void *parameter,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core)
+{
+    (void)function;
+    (void)name;
+    (void)stackSize;
+    (void)parameter;
+    (void)priority;
+    (void)core;
+    if (handle != nullptr)
+        *handle = &taskHandles[taskCount++ % sizeof(taskHandles)];
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    (void)task;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    delay(ticks * portTICK_PERIOD_MS);
+}
+
+void vTaskDelayUntil(TickType_t *previousWakeTime, TickType_t increment)
+{
+    *previousWakeTime += increment;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(*previousWakeTime - now) > 0)
+        vTaskDelay(*previousWakeTime - now);
+}
+
+TickType_t xTaskGetTickCount()
+{
+    return millis() / portTICK_PERIOD_MS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return &taskHandles[0];
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    (void)task;
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *isHigherPriorityTaskWoken)
+{
+    (void)task;
+    if (isHigherPriorityTaskWoken != nullptr)
+        *isHigherPriorityTaskWoken = pdFALSE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t isClearOnExit, TickType_t ticks)
+{
+    (void)isClearOnExit;
+    (void)ticks;
+    return 0;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return &semaphoreHandle;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return &semaphoreHandle;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex()
+{
+    return &semaphoreHandle;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+    (void)semaphore;
+    (void)ticks;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    (void)semaphore;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+    return xSemaphoreTake(semaphore, ticks);
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore)
+{
+    return xSemaphoreGive(semaphore);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t *isHigherPriorityTaskWoken)
+{
+    (void)semaphore;
+    if (isHigherPriorityTaskWoken != nullptr)
+        *isHigherPriorityTaskWoken = pdFALSE;
+    return pdTRUE;
+}
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t *config)
+{
+    (void)config;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_deinitialize()
+{
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t *config)
+{
+    (void)config;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_start()
+{
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_stop()
+{
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_read_bytes(uint8_t *buffer, uint32_t length, uint32_t *readLength, uint32_t timeout)
+{
+    (void)buffer;
+    (void)length;
+    (void)timeout;
+    *readLength = 0;
+    return ESP_ERR_TIMEOUT;
+}
+
+esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t unit, adc_atten_t attenuation, adc_bits_width_t width,
+                                             uint32_t defaultVref, esp_adc_cal_characteristics_t *characteristics)
+{
+    (void)unit;
+    (void)attenuation;
+    (void)width;
+    characteristics->vref = defaultVref;
+    return ESP_ADC_CAL_VAL_EFUSE_VREF;
+}
+
+uint32_t esp_adc_cal_raw_to_voltage(uint32_t raw, const esp_adc_cal_characteristics_t *characteristics)
+{
+    (void)characteristics;
+    return raw * ADC_FULL_SCALE / ADC_MAX_RAW;
+}
@@ -0,0 +1,37 @@
+#include <HardwareSerial.h>
+#include "native_board.h"
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+HardwareSerial Serial2(2);
+
+void HardwareSerial::begin(unsigned long baudrate, uint32_t config, int8_t rxPin, int8_t txPin, bool invert, unsigned long timeout)
+{
+    // The bytes reach the devices at once, the baudrate and the pins do not matter
+    (void)baudrate;
+    (void)config;
+    (void)rxPin;
+    (void)txPin;
+    (void)invert;
+    (void)timeout;
+}
+
+int HardwareSerial::available()
+{
+    return getNativeBoard().uartAvailable(this->uartNumber);
+}
+
+int HardwareSerial::read()
+{
+    return getNativeBoard().uartRead(this->uartNumber, true);
+}
+
+int HardwareSerial::peek()
+{
+    return getNativeBoard().uartRead(this->uartNumber, false);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    return getNativeBoard().uartWrite(this->uartNumber, buffer, size);
+}
@@ -0,0 +1,244 @@
+#include "native_board.h"
+
+#include <cstdio>
+#include <cstring>
+
+/**
+ * @brief Get the board, created at the first call.
+ */
+NativeBoard &getNativeBoard()
+{
+    static NativeBoard board;
+    return board;
+}
+
+/**
+ * @brief Constructor of a board at time 0, all pins low and no device.
+ */
+NativeBoard::NativeBoard()
+    : time(0),
+      isConsoleEchoed(false),
+      isConsoleCaptured(false)
+{
+    memset(this->pins, 0, sizeof(this->pins));
+    memset(this->analogValues, 0, sizeof(this->analogValues));
+    memset(this->i2cDevices, 0, sizeof(this->i2cDevices));
+    memset(this->uartDevices, 0, sizeof(this->uartDevices));
+    resetBusCounters();
+}
+
+/**
+ * @brief Put a device on the I2C bus.
+ * @param address 7-bit address of the device.
+ * @param device The device, nullptr to remove the device at this address.
+ */
+void NativeBoard::attachI2cDevice(uint8_t address, I2cDevice *device)
+{
+    if (address < 128)
+        this->i2cDevices[address] = device;
+}
+
+/**
+ * @brief Connect a device to a UART.
+ * @param uartNumber 1 or 2 (Serial1, Serial2), the console cannot have a device.
+ * @param device The device, nullptr to disconnect the UART.
+ */
+void NativeBoard::attachUartDevice(uint8_t uartNumber, UartDevice *device)
+{
+    if (uartNumber > 0 && uartNumber < UART_COUNT)
+        this->uartDevices[uartNumber] = device;
+}
+
+/**
+ * @brief Put a device on the SPI bus.
+ * @param csPin Chip select pin of the device, active low.
+ * @param device The device, nullptr to remove it.
+ */
+void NativeBoard::attachSpiDevice(uint8_t csPin, SpiDevice *device)
+{
+    if (device == nullptr)
+        this->spiDevices.erase(csPin);
+    else
+        this->spiDevices[csPin] = device;
+}
+
+/**
+ * @brief Remove all the devices, the buses then behave as if nothing was connected.
+ */
+void NativeBoard::detachDevices()
+{
+    memset(this->i2cDevices, 0, sizeof(this->i2cDevices));
+    memset(this->uartDevices, 0, sizeof(this->uartDevices));
+    this->spiDevices.clear();
+}
+
+/**
+ * @brief Set the level of a pin, written by the firmware or driven by a device. The SPI device of a chip select pin
+ * is told when it is selected.
+ */
+void NativeBoard::setPin(uint8_t pin, bool level)
+{
+    if (pin >= PIN_COUNT || this->pins[pin] == level)
+        return;
+    this->pins[pin] = level;
+
+    std::map<uint8_t, SpiDevice *>::iterator device = this->spiDevices.find(pin);
+    if (device != this->spiDevices.end())
+        device->second->select(!level);
+}
+
+/**
+ * @brief Set the raw value read by analogRead() on a pin.
+ * @param pin Analog pin.
+ * @param raw 12-bit value.
+ */
+void NativeBoard::setAnalogValue(uint8_t pin, uint16_t raw)
+{
+    if (pin < PIN_COUNT)
+        this->analogValues[pin] = raw;
+}
+
+/**
+ * @brief Send text to the console of the firmware, as typed in the serial monitor.
+ */
+void NativeBoard::writeConsoleInput(const std::string &text)
+{
+    this->uartRx[0].insert(this->uartRx[0].end(), text.begin(), text.end());
+}
+
+/**
+ * @brief Choose what happens to the text printed by the firmware, it is dropped by default.
+ * @param isEchoed Print it on the standard output.
+ * @param isCaptured Keep it for takeConsoleOutput().
+ */
+void NativeBoard::setConsoleOutput(bool isEchoed, bool isCaptured)
+{
+    this->isConsoleEchoed = isEchoed;
+    this->isConsoleCaptured = isCaptured;
+    if (!isCaptured)
+        this->consoleOutput.clear();
+}
+
+/**
+ * @brief Get the text printed by the firmware since the last call, when it is captured.
+ */
+std::string NativeBoard::takeConsoleOutput()
+{
+    std::string output;
+    output.swap(this->consoleOutput);
+    return output;
+}
+
+/**
+ * @brief Reset the traffic counters of all the buses.
+ */
+void NativeBoard::resetBusCounters()
+{
+    memset(this->busCounters, 0, sizeof(this->busCounters));
+}
+
+/**
+ * @brief Count a transaction and wait for the bus.
+ * @param bus Bus of the transaction.
+ * @param bytesSent Bytes written by the ESP32.
+ * @param bytesReceived Bytes read by the ESP32.
+ * @param busTime Time the ESP32 is blocked by the transaction (us), added to the time of the board.
+ */
+void NativeBoard::addTransaction(eNativeBus bus, size_t bytesSent, size_t bytesReceived, uint64_t busTime)
+{
+    sBusCounters &counters = this->busCounters[bus];
+    counters.transactions++;
+    counters.bytesSent += bytesSent;
+    counters.bytesReceived += bytesReceived;
+    counters.busTime += busTime;
+    this->time += busTime;
+}
+
+/**
+ * @brief Get the device at an I2C address.
+ * @return The device, nullptr if there is none.
+ */
+I2cDevice *NativeBoard::getI2cDevice(uint8_t address) const
+{
+    return address < 128 ? this->i2cDevices[address] : nullptr;
+}
+
+/**
+ * @brief Get the SPI device whose chip select pin is low.
+ * @return The device, nullptr if none is selected.
+ */
+SpiDevice *NativeBoard::getSelectedSpiDevice() const
+{
+    for (std::map<uint8_t, SpiDevice *>::const_iterator device = this->spiDevices.begin(); device != this->spiDevices.end(); device++)
+    {
+        if (!getPin(device->first))
+            return device->second;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Get the number of bytes received by a UART, the device is asked for the bytes sent by now.
+ */
+int NativeBoard::uartAvailable(uint8_t uartNumber)
+{
+    if (uartNumber >= UART_COUNT)
+        return 0;
+
+    std::deque<uint8_t> &rx = this->uartRx[uartNumber];
+    UartDevice *device = this->uartDevices[uartNumber];
+    if (device != nullptr && rx.size() < UART_RX_BUFFER_SIZE)
+    {
+        uint8_t data[UART_RX_BUFFER_SIZE];
+        size_t length = device->transmit(data, UART_RX_BUFFER_SIZE - rx.size(), this->time);
+        rx.insert(rx.end(), data, data + length);
+        if (length > 0)
+            this->busCounters[uartNumber == 1 ? NATIVE_BUS_UART_1 : NATIVE_BUS_UART_2].bytesReceived += length;
+    }
+    return rx.size();
+}
+
+/**
+ * @brief Read or peek the next byte received by a UART.
+ * @param uartNumber UART to read.
+ * @param isRemoved False to peek.
+ * @return The byte, -1 if there is none.
+ */
+int NativeBoard::uartRead(uint8_t uartNumber, bool isRemoved)
+{
+    if (uartAvailable(uartNumber) == 0)
+        return -1;
+
+    std::deque<uint8_t> &rx = this->uartRx[uartNumber];
+    int data = rx.front();
+    if (isRemoved)
+        rx.pop_front();
+    if (isRemoved && uartNumber == 0)
+        this->busCounters[NATIVE_BUS_CONSOLE].bytesReceived++;
+    return data;
+}
+
+/**
+ * @brief Write bytes on a UART, they reach the device (or the console) at once.
+ * @return Bytes written.
+ */
+size_t NativeBoard::uartWrite(uint8_t uartNumber, const uint8_t *data, size_t length)
+{
+    if (uartNumber >= UART_COUNT)
+        return 0;
+
+    if (uartNumber == 0)
+    {
+        if (this->isConsoleEchoed)
+            fwrite(data, 1, length, stdout);
+        if (this->isConsoleCaptured)
+            this->consoleOutput.append((const char *)data, length);
+        addTransaction(NATIVE_BUS_CONSOLE, length, 0, 0);
+        return length;
+    }
+
+    if (this->uartDevices[uartNumber] != nullptr)
+        this->uartDevices[uartNumber]->receive(data, length, this->time);
+    addTransaction(uartNumber == 1 ? NATIVE_BUS_UART_1 : NATIVE_BUS_UART_2, length, 0, 0);
+    return length;
+}
@@ -0,0 +1,66 @@
+#include <Preferences.h>
+#include "native_board.h"
+
+bool Preferences::begin(const char *name, bool readOnly, const char *partition)
+{
+    (void)partition;
+    this->name = name;
+    this->isReadOnly = readOnly;
+    this->isOpen = true;
+    return true;
+}
+
+bool Preferences::clear()
+{
+    if (!this->isOpen || this->isReadOnly)
+        return false;
+    std::map<std::string, std::vector<uint8_t>> &preferences = getNativeBoard().getPreferences();
+    std::string prefix = this->name + "/";
+    for (std::map<std::string, std::vector<uint8_t>>::iterator i = preferences.begin(); i != preferences.end();)
+    {
+        if (i->first.compare(0, prefix.size(), prefix) == 0)
+            i = preferences.erase(i);
+        else
+            i++;
+    }
+    return true;
+}
+
+bool Preferences::remove(const char *key)
+{
+    if (!this->isOpen || this->isReadOnly)
+        return false;
+    return getNativeBoard().getPreferences().erase(this->name + "/" + key) > 0;
+}
+
+bool Preferences::isKey(const char *key)
+{
+    return this->isOpen && getNativeBoard().getPreferences().count(this->name + "/" + key) > 0;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t length)
+{
+    if (!this->isOpen || this->isReadOnly || key == nullptr)
+        return 0;
+    const uint8_t *bytes = (const uint8_t *)value;
+    getNativeBoard().getPreferences()[this->name + "/" + key] = std::vector<uint8_t>(bytes, bytes + length);
+    return length;
+}
+
+size_t Preferences::getBytesLength(const char *key)
+{
+    if (!this->isOpen || key == nullptr)
+        return 0;
+    std::map<std::string, std::vector<uint8_t>> &preferences = getNativeBoard().getPreferences();
+    std::map<std::string, std::vector<uint8_t>>::const_iterator value = preferences.find(this->name + "/" + key);
+    return value != preferences.end() ? value->second.size() : 0;
+}
+
+size_t Preferences::getBytes(const char *key, void *buffer, size_t maxLength)
+{
+    size_t length = getBytesLength(key);
+    if (length == 0 || length > maxLength)
+        return 0;
+    memcpy(buffer, getNativeBoard().getPreferences()[this->name + "/" + key].data(), length);
+    return length;
+}
@@ -0,0 +1,41 @@
+#include <SPI.h>
+#include "native_board.h"
+
+SPIClass SPI(0);
+
+void SPIClass::beginTransaction(SPISettings settings)
+{
+    if (settings.clock != 0)
+        this->clock = settings.clock;
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+    uint8_t received = 0;
+    transferBytes(&data, &received, 1);
+    return received;
+}
+
+void SPIClass::transfer(void *data, uint32_t size)
+{
+    transferBytes((const uint8_t *)data, (uint8_t *)data, size);
+}
+
+/**
+ * @brief Exchange bytes with the selected device, a transfer counts as one transaction.
+ * @param data Bytes sent, nullptr to send zeros.
+ * @param out Bytes received, nullptr to drop them.
+ * @param size Number of bytes.
+ */
+void SPIClass::transferBytes(const uint8_t *data, uint8_t *out, uint32_t size)
+{
+    NativeBoard &board = getNativeBoard();
+    SpiDevice *device = board.getSelectedSpiDevice();
+    for (uint32_t i = 0; i < size; i++)
+    {
+        uint8_t received = device != nullptr ? device->transfer(data != nullptr ? data[i] : 0) : 0;
+        if (out != nullptr)
+            out[i] = received;
+    }
+    board.addTransaction(NATIVE_BUS_SPI, size, size, ((uint64_t)size * 8 * 1000000 + this->clock - 1) / this->clock);
+}
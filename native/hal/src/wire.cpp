@@ -0,0 +1,113 @@
+#include <Wire.h>
+#include "native_board.h"
+
+static constexpr uint32_t DEFAULT_FREQUENCY = 100000; // Hz, default of the ESP32 core
+static constexpr uint32_t BITS_PER_BYTE = 9;           // 8 bits and the acknowledge
+static constexpr uint32_t START_STOP_BITS = 2;
+
+TwoWire Wire(0);
+
+/**
+ * @brief Get the time the ESP32 is blocked by a transaction.
+ * @param dataLength Bytes after the address byte.
+ * @param frequency Clock of the bus (Hz).
+ * @return Duration (us).
+ */
+static uint64_t getTransactionTime(size_t dataLength, uint32_t frequency)
+{
+    uint64_t bits = (1 + dataLength) * BITS_PER_BYTE + START_STOP_BITS;
+    return (bits * 1000000 + frequency - 1) / frequency;
+}
+
+TwoWire::TwoWire(uint8_t busNumber)
+    : frequency(DEFAULT_FREQUENCY), txAddress(0), txLength(0), isTransmitting(false), rxLength(0), rxIndex(0)
+{
+    (void)busNumber;
+}
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency)
+{
+    (void)sda;
+    (void)scl;
+    if (frequency != 0)
+        this->frequency = frequency;
+    return true;
+}
+
+bool TwoWire::setClock(uint32_t frequency)
+{
+    if (frequency == 0)
+        return false;
+    this->frequency = frequency;
+    return true;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    this->txAddress = address;
+    this->txLength = 0;
+    this->isTransmitting = true;
+}
+
+/**
+ * @brief Send the bytes written since beginTransmission().
+ * @return 0 on success, 2 if the address is not acknowledged, like the ESP32 core.
+ */
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    (void)sendStop;
+    this->isTransmitting = false;
+    NativeBoard &board = getNativeBoard();
+    I2cDevice *device = board.getI2cDevice(this->txAddress);
+    bool isAcknowledged = device != nullptr && device->write(this->txBuffer, this->txLength, board.getTime());
+
+    // The bytes are only clocked out once the address is acknowledged
+    size_t sentLength = isAcknowledged ? this->txLength : 0;
+    board.addTransaction(NATIVE_BUS_I2C, 1 + sentLength, 0, getTransactionTime(sentLength, this->frequency));
+    return isAcknowledged ? 0 : 2;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool sendStop)
+{
+    return requestFrom(address, (size_t)quantity, sendStop);
+}
+
+/**
+ * @brief Read bytes from a device, they are then taken with read().
+ * @return Bytes received, 0 if the address is not acknowledged.
+ */
+size_t TwoWire::requestFrom(uint8_t address, size_t quantity, bool sendStop)
+{
+    (void)sendStop;
+    NativeBoard &board = getNativeBoard();
+    I2cDevice *device = board.getI2cDevice(address);
+    quantity = std::min(quantity, BUFFER_SIZE);
+    this->rxIndex = 0;
+    this->rxLength = 0;
+
+    if (device != nullptr)
+    {
+        // The master clocks all the bytes, a device that gives less leaves the bus high
+        memset(this->rxBuffer, 0xFF, quantity);
+        if (device->read(this->rxBuffer, quantity, board.getTime()) > 0)
+            this->rxLength = quantity;
+    }
+    board.addTransaction(NATIVE_BUS_I2C, 1, this->rxLength, getTransactionTime(this->rxLength, this->frequency));
+    return this->rxLength;
+}
+
+size_t TwoWire::write(uint8_t c)
+{
+    if (!this->isTransmitting || this->txLength >= BUFFER_SIZE)
+        return 0;
+    this->txBuffer[this->txLength++] = c;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *buffer, size_t size)
+{
+    size_t count = 0;
+    while (count < size && write(buffer[count]) == 1)
+        count++;
+    return count;
+}
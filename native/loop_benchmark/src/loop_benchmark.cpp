@@ -0,0 +1,167 @@
+/*
+ * Runs the firmware main loop on the host, with the emulated peripherals of native/devices, in every state of the
+ * bioreactor, and prints for each state as JSON:
+ * - the loop rate on the host and the time of each stage, host and simulated,
+ * - the traffic of each bus per simulated second.
+ *
+ * The simulated time advances by a fixed step after each loop (the time the ESP32 would be idle or busy elsewhere)
+ * plus the time the firmware waits for the I2C and SPI transfers, so the controllers and the telemetry run at their
+ * real period.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "emulated_peripherals.h"
+#include "main.h"
+#include "native_board.h"
+
+typedef std::chrono::steady_clock HostClock;
+
+static const char *const LOOP_STAGE_KEYS[LOOP_STAGE_MAX] = {"state_machine", "sensors", "telemetry", "temperature", "gas", "led", "commands", "recorder"};
+static const char *const BUS_KEYS[NATIVE_BUS_MAX] = {"i2c", "spi", "uart1", "uart2", "console"};
+static const char *const STATE_KEYS[(uint8_t)eBioreactorState::MAX_STATE] = {
+    "IDLE", "APPROV", "PREPARE", "RUN", "CELL_RETURN", "CLEANING_APPROV", "CLEANING_CIRCULATION", "CLEANING_RETURN",
+    "RINSING_APPROV", "RINSING_CIRCULATION", "RINSING_RETURN", "REDUCE_OVERFLOW", "RETURN_START", "TEST",
+    "OPEN_VALVES", "SAMPLING", "HEATING", "RECIPE"};
+
+/**
+ * @brief Time spent in each stage since the last reset().
+ */
+typedef struct
+{
+    double hostTime[LOOP_STAGE_MAX];    // ns
+    uint64_t boardTime[LOOP_STAGE_MAX]; // us, simulated
+} sStageTimes;
+
+static EmulatedPeripherals peripherals;
+static sStageTimes stageTimes;
+static uint8_t currentStage = LOOP_STAGE_MAX;
+static HostClock::time_point stageHostStart;
+static uint64_t stageBoardStart = 0;
+
+/**
+ * @brief Called by the watchdog at each stage change of the main loop.
+ */
+static void onLoopStage(eLoopStage stage)
+{
+    HostClock::time_point now = HostClock::now();
+    uint64_t boardNow = getNativeBoard().getTime();
+    if (currentStage < LOOP_STAGE_MAX)
+    {
+        stageTimes.hostTime[currentStage] += std::chrono::duration<double, std::nano>(now - stageHostStart).count();
+        stageTimes.boardTime[currentStage] += boardNow - stageBoardStart;
+    }
+    currentStage = stage;
+    stageHostStart = now;
+    stageBoardStart = boardNow;
+}
+
+/**
+ * @brief Run the loop a number of times.
+ * @param iterations Number of loops.
+ * @param step Simulated time added after each loop (us).
+ */
+static void runLoop(uint32_t iterations, uint64_t step)
+{
+    NativeBoard &board = getNativeBoard();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        loop();
+        board.advanceTime(step);
+    }
+}
+
+/**
+ * @brief Run the loop in a state and print its figures as a JSON object.
+ */
+static void benchmarkState(uint8_t state, uint32_t warmup, uint32_t iterations, uint64_t step, bool isLast)
+{
+    NativeBoard &board = getNativeBoard();
+    setBioreactorState(state);
+    runLoop(warmup, step);
+
+    board.resetBusCounters();
+    stageTimes = sStageTimes();
+    uint64_t boardStart = board.getTime();
+    HostClock::time_point hostStart = HostClock::now();
+    runLoop(iterations, step);
+    double hostTime = std::chrono::duration<double>(HostClock::now() - hostStart).count();
+    double boardTime = (board.getTime() - boardStart) * 1e-6;
+
+    printf("    {\"state\": \"%s\", \"final_state\": \"%s\", \"iterations\": %u,\n", STATE_KEYS[state],
+           STATE_KEYS[(uint8_t)bioreactorState], iterations);
+    printf("     \"host_s\": %.6f, \"simulated_s\": %.3f, \"loops_per_host_s\": %.0f,\n", hostTime, boardTime,
+           iterations / hostTime);
+
+    printf("     \"stages\": {");
+    for (uint8_t i = 0; i < LOOP_STAGE_MAX; i++)
+    {
+        printf("%s\"%s\": {\"host_ns_per_loop\": %.0f, \"simulated_us_per_loop\": %.1f}", i > 0 ? ", " : "",
+               LOOP_STAGE_KEYS[i], stageTimes.hostTime[i] / iterations, (double)stageTimes.boardTime[i] / iterations);
+    }
+    printf("},\n");
+
+    // Per simulated second, the rates of the ESP32 whatever the step
+    printf("     \"buses\": {");
+    for (uint8_t i = 0; i < NATIVE_BUS_MAX; i++)
+    {
+        const sBusCounters &counters = board.getBusCounters((eNativeBus)i);
+        printf("%s\"%s\": {\"transactions_per_s\": %.1f, \"bytes_sent_per_s\": %.1f, \"bytes_received_per_s\": %.1f, \"busy_us_per_s\": %.1f}",
+               i > 0 ? ", " : "", BUS_KEYS[i], counters.transactions / boardTime, counters.bytesSent / boardTime,
+               counters.bytesReceived / boardTime, counters.busTime / boardTime);
+    }
+    printf("}}%s\n", isLast ? "" : ",");
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = 20000;
+    uint32_t warmup = 2000;
+    uint64_t step = 500;
+    bool isEmpty = false;
+    sDeviceFaults faults = {0, 0, 0, 0};
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "-n" && i + 1 < argc)
+            iterations = strtoul(argv[++i], nullptr, 10);
+        else if (argument == "-w" && i + 1 < argc)
+            warmup = strtoul(argv[++i], nullptr, 10);
+        else if (argument == "-s" && i + 1 < argc)
+            step = strtoull(argv[++i], nullptr, 10);
+        else if (argument == "-a")
+            isEmpty = true;
+        else if (argument == "-d" && i + 1 < argc)
+            faults.dropoutRate = strtof(argv[++i], nullptr);
+        else if (argument == "-e" && i + 1 < argc)
+            faults.errorRate = strtof(argv[++i], nullptr);
+        else
+        {
+            fprintf(stderr, "Usage: %s [-n iterations] [-w warmup_iterations] [-s step_us] [-a] [-d dropout_rate] [-e error_rate]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (iterations == 0)
+        iterations = 1;
+
+    // The telemetry is counted on the console bus but not printed, stdout holds the JSON only
+    NativeBoard &board = getNativeBoard();
+    board.setConsoleOutput(false, false);
+    board.advanceTime(1000000); // The time is not 0 after the boot of the ESP32
+    if (!isEmpty)
+    {
+        peripherals.setFaults(faults);
+        peripherals.attach(board);
+    }
+    setup();
+    setLoopStageHook(onLoopStage);
+
+    printf("{\"iterations\": %u, \"warmup\": %u, \"step_us\": %llu, \"devices\": %s, \"dropout_rate\": %g, \"error_rate\": %g, \"states\": [\n",
+           iterations, warmup, (unsigned long long)step, isEmpty ? "false" : "true", faults.dropoutRate, faults.errorRate);
+    for (uint8_t state = 0; state < (uint8_t)eBioreactorState::MAX_STATE; state++)
+        benchmarkState(state, warmup, iterations, step, state + 1 == (uint8_t)eBioreactorState::MAX_STATE);
+    printf("]}\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,610 @@
+/*
+ * Times the protocol parsers and encoders of the drivers on the frames of a corpus and checks their results.
+ *
+ * For each frame: ns per frame (mean of the repetitions) and heap allocations per frame. The frames with an
+ * expected result are a regression set: a parser change that alters a result makes the run fail.
+ *
+ * The console commands go through the simulated Serial and run the firmware handler, their figures include reading
+ * the line and executing the command.
+ */
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "main.h"
+#include "native_board.h"
+#include "serialReader.h"
+
+typedef std::chrono::steady_clock HostClock;
+
+typedef enum
+{
+    PARSER_VISIFERM = 0,
+    PARSER_VISIFERM_REQUEST,
+    PARSER_GMP251,
+    PARSER_ATLAS,
+    PARSER_COMMAND,
+
+    PARSER_MAX
+} eParser;
+
+static const char *const PARSER_NAMES[PARSER_MAX] = {"visiferm", "visiferm_request", "gmp251", "atlas", "command"};
+static const char *const VISIFERM_STATUS_NAMES[VISIFERM_STATUS_MAX] = {
+    "OK", "NOT_INITIALISED", "WAITING_RESPONSE", "TIMEOUT", "CRC_ERROR", "BAD_FRAME", "SENSOR_STATUS_ERROR"};
+static const char *const GMP251_STATUS_NAMES[GMP_251_STATUS_MAX] = {
+    "OK", "INITIALIZED", "NOT_INITIALISED", "FAILED_TO_SEND_REQUEST", "PARSING_FAILED", "PARSING_NOT_A_NUMBER"};
+
+static constexpr float VALUE_TOLERANCE = 1e-5f; // Relative
+static constexpr uint8_t ATLAS_SUCCESS_STATUS_BYTE = 0x01;
+
+/**
+ * @brief Frame of the corpus.
+ */
+typedef struct
+{
+    uint32_t line; // In the corpus file
+    eParser parser;
+    std::string input;
+    std::vector<std::string> expected; // Empty if the frame is only timed
+} sCorpusEntry;
+
+/**
+ * @brief Figures of one frame.
+ */
+typedef struct
+{
+    double time;        // ns per frame
+    double allocations; // per frame
+    std::vector<std::string> result;
+} sMeasurement;
+
+static uint64_t allocationCount = 0;
+
+void *operator new(size_t size)
+{
+    allocationCount++;
+    void *pointer = malloc(size != 0 ? size : 1);
+    if (pointer == nullptr)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+    free(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept
+{
+    free(pointer);
+}
+
+/**
+ * @brief Time and count the allocations of a number of repetitions.
+ */
+class Stopwatch
+{
+public:
+    Stopwatch() : start(HostClock::now()), startAllocations(allocationCount) {}
+
+    void stop(uint32_t repetitions, sMeasurement &measurement) const
+    {
+        measurement.time = std::chrono::duration<double, std::nano>(HostClock::now() - this->start).count() / repetitions;
+        measurement.allocations = (double)(allocationCount - this->startAllocations) / repetitions;
+    }
+
+private:
+    HostClock::time_point start;
+    uint64_t startAllocations;
+};
+
+static std::string formatValue(float value)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%.6g", value);
+    return text;
+}
+
+static std::string formatHex(const uint8_t *data, size_t length)
+{
+    std::string text;
+    char hex[3];
+    for (size_t i = 0; i < length; i++)
+    {
+        snprintf(hex, sizeof(hex), "%02X", data[i]);
+        text += hex;
+    }
+    return text;
+}
+
+/**
+ * @brief Decode hexadecimal bytes.
+ * @return False if the text is not an even number of hexadecimal digits.
+ */
+static bool parseHex(const std::string &text, std::string &bytes)
+{
+    if (text.size() % 2 != 0)
+        return false;
+    bytes.clear();
+    for (size_t i = 0; i < text.size(); i += 2)
+    {
+        char *end = nullptr;
+        std::string digits = text.substr(i, 2);
+        long value = strtol(digits.c_str(), &end, 16);
+        if (*end != '\0')
+            return false;
+        bytes += (char)value;
+    }
+    return true;
+}
+
+static void runVisiFerm(const std::string &input, uint32_t repetitions, sMeasurement &measurement)
+{
+    const uint8_t *frame = (const uint8_t *)input.data();
+    float value = 0;
+    eVisiFermStatus status = VISIFERM_STATUS_MAX;
+
+    Stopwatch stopwatch;
+    for (uint32_t i = 0; i < repetitions; i++)
+        status = VisiFermRS485::decodeFrame(frame, input.size(), value);
+    stopwatch.stop(repetitions, measurement);
+
+    measurement.result.push_back(VISIFERM_STATUS_NAMES[status]);
+    if (status == VISIFERM_STATUS_OK)
+        measurement.result.push_back(formatValue(value));
+}
+
+static void runVisiFermRequest(const std::string &input, uint32_t repetitions, sMeasurement &measurement)
+{
+    unsigned int address = 0;
+    unsigned int reg = 0;
+    unsigned int count = 0;
+    if (sscanf(input.c_str(), "%u %u %u", &address, &reg, &count) != 3)
+    {
+        measurement.result.push_back("BAD_INPUT");
+        return;
+    }
+
+    uint8_t frame[VisiFermRS485::MODBUS_READ_REGISTER_MSG_LEN];
+    Stopwatch stopwatch;
+    for (uint32_t i = 0; i < repetitions; i++)
+        VisiFermRS485::encodeReadRegisters(address, reg, count, frame);
+    stopwatch.stop(repetitions, measurement);
+
+    measurement.result.push_back(formatHex(frame, sizeof(frame)));
+}
+
+static void runGmp251(const std::string &input, uint32_t repetitions, sMeasurement &measurement)
+{
+    // Built like GMP251::readResponse(), one character at a time
+    String response;
+    for (char c : input)
+        response += c;
+    float co2 = 0;
+    eGMP251Status status = GMP_251_STATUS_MAX;
+
+    Stopwatch stopwatch;
+    for (uint32_t i = 0; i < repetitions; i++)
+        status = GMP251::parseResponse(response, co2);
+    stopwatch.stop(repetitions, measurement);
+
+    measurement.result.push_back(GMP251_STATUS_NAMES[status]);
+    if (status == GMP_251_STATUS_OK)
+        measurement.result.push_back(formatValue(co2));
+}
+
+static void runAtlas(const std::string &input, uint32_t repetitions, sMeasurement &measurement)
+{
+    // NUL terminated like the reply in AtlasBase::pollOnce()
+    const char *reply = input.c_str();
+    float value = 0;
+
+    Stopwatch stopwatch;
+    for (uint32_t i = 0; i < repetitions; i++)
+        value = AtlasBase::cleanString(reply);
+    stopwatch.stop(repetitions, measurement);
+
+    measurement.result.push_back(formatValue(value));
+}
+
+static void runCommand(const std::string &input, uint32_t repetitions, sMeasurement &measurement)
+{
+    NativeBoard &board = getNativeBoard();
+    std::string line = input + "\n";
+
+    board.setConsoleOutput(false, false);
+    Stopwatch stopwatch;
+    for (uint32_t i = 0; i < repetitions; i++)
+    {
+        board.writeConsoleInput(line);
+        receiveSerialCommand();
+    }
+    stopwatch.stop(repetitions, measurement);
+
+    // Once more to get what the command prints
+    board.setConsoleOutput(false, true);
+    board.writeConsoleInput(line);
+    receiveSerialCommand();
+    measurement.result.push_back(board.takeConsoleOutput());
+    board.setConsoleOutput(false, false);
+}
+
+static void runEntry(const sCorpusEntry &entry, uint32_t repetitions, sMeasurement &measurement)
+{
+    switch (entry.parser)
+    {
+    case PARSER_VISIFERM:
+        runVisiFerm(entry.input, repetitions, measurement);
+        break;
+    case PARSER_VISIFERM_REQUEST:
+        runVisiFermRequest(entry.input, repetitions, measurement);
+        break;
+    case PARSER_GMP251:
+        runGmp251(entry.input, repetitions, measurement);
+        break;
+    case PARSER_ATLAS:
+        runAtlas(entry.input, repetitions, measurement);
+        break;
+    case PARSER_COMMAND:
+        runCommand(entry.input, repetitions, measurement);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Compare a result token to the expected one, the numbers with a tolerance.
+ */
+static bool isTokenMatching(const std::string &result, const std::string &expected)
+{
+    if (result == expected)
+        return true;
+
+    char *resultEnd = nullptr;
+    char *expectedEnd = nullptr;
+    float resultValue = strtof(result.c_str(), &resultEnd);
+    float expectedValue = strtof(expected.c_str(), &expectedEnd);
+    if (result.empty() || expected.empty() || *resultEnd != '\0' || *expectedEnd != '\0')
+        return false;
+    if (std::isnan(resultValue) || std::isnan(expectedValue))
+        return std::isnan(resultValue) && std::isnan(expectedValue);
+    return fabsf(resultValue - expectedValue) <= VALUE_TOLERANCE * std::max(1.0f, fabsf(expectedValue));
+}
+
+static bool isResultMatching(const std::vector<std::string> &result, const std::vector<std::string> &expected)
+{
+    if (result.size() != expected.size())
+        return false;
+    for (size_t i = 0; i < result.size(); i++)
+    {
+        if (!isTokenMatching(result[i], expected[i]))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Split a corpus line in tokens: words or quoted strings with C escapes.
+ * @return False on an unterminated string or a bad escape.
+ */
+static bool splitTokens(const std::string &line, std::vector<std::string> &tokens)
+{
+    size_t i = 0;
+    while (i < line.size())
+    {
+        if (isSpace(line[i]))
+        {
+            i++;
+            continue;
+        }
+
+        std::string token;
+        if (line[i] != '"')
+        {
+            while (i < line.size() && !isSpace(line[i]))
+                token += line[i++];
+            tokens.push_back(token);
+            continue;
+        }
+
+        for (i++; i < line.size() && line[i] != '"'; i++)
+        {
+            if (line[i] != '\\')
+            {
+                token += line[i];
+                continue;
+            }
+            if (++i >= line.size())
+                return false;
+            switch (line[i])
+            {
+            case 'r':
+                token += '\r';
+                break;
+            case 'n':
+                token += '\n';
+                break;
+            case 't':
+                token += '\t';
+                break;
+            case 'x':
+            {
+                std::string byte;
+                if (i + 2 >= line.size() || !parseHex(line.substr(i + 1, 2), byte))
+                    return false;
+                token += byte;
+                i += 2;
+                break;
+            }
+            default:
+                token += line[i];
+                break;
+            }
+        }
+        if (i >= line.size())
+            return false;
+        i++; // Closing quote
+        tokens.push_back(token);
+    }
+    return true;
+}
+
+/**
+ * @brief Quote a token if it cannot be written as a word.
+ */
+static std::string quoteToken(const std::string &token, bool isQuoted)
+{
+    for (char c : token)
+        isQuoted = isQuoted || isSpace(c) || c == '"' || c == '\\' || !isprint((unsigned char)c);
+    if (!isQuoted && !token.empty())
+        return token;
+
+    std::string text = "\"";
+    char hex[5];
+    for (char c : token)
+    {
+        if (c == '\r')
+            text += "\\r";
+        else if (c == '\n')
+            text += "\\n";
+        else if (c == '\t')
+            text += "\\t";
+        else if (c == '"' || c == '\\')
+            text += std::string("\\") + c;
+        else if (!isprint((unsigned char)c))
+        {
+            snprintf(hex, sizeof(hex), "\\x%02X", (uint8_t)c);
+            text += hex;
+        }
+        else
+            text += c;
+    }
+    return text + "\"";
+}
+
+/**
+ * @brief Convert a record printed by BusRecorder::dump() to a corpus entry.
+ * @return False if the record is malformed or its channel has no parser here.
+ */
+static bool parseRecord(const std::string &hex, sCorpusEntry &entry)
+{
+    // [timestamp (4 bytes)][channel][tag][length][data]
+    std::string record;
+    if (!parseHex(hex, record) || record.size() < 7 || record.size() != 7u + (uint8_t)record[6])
+        return false;
+
+    std::string data = record.substr(7);
+    switch ((uint8_t)record[4])
+    {
+    case BUS_CHANNEL_VISIFERM:
+        entry.parser = PARSER_VISIFERM;
+        entry.input = data;
+        return true;
+    case BUS_CHANNEL_GMP251:
+        entry.parser = PARSER_GMP251;
+        entry.input = data;
+        return true;
+    case BUS_CHANNEL_ATLAS:
+        // Only the replies with a value are parsed, the status byte is removed like in AtlasBase::pollOnce()
+        if (data.empty() || (uint8_t)data[0] != ATLAS_SUCCESS_STATUS_BYTE)
+            return false;
+        entry.parser = PARSER_ATLAS;
+        entry.input = std::string(data.c_str() + 1);
+        return true;
+    case BUS_CHANNEL_COMMAND:
+        entry.parser = PARSER_COMMAND;
+        entry.input = data;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Read the corpus file.
+ * @return False if the file cannot be read or has a malformed line.
+ */
+static bool loadCorpus(const char *path, std::vector<sCorpusEntry> &corpus)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+
+    std::string line;
+    for (uint32_t lineNumber = 1; std::getline(file, line); lineNumber++)
+    {
+        std::vector<std::string> tokens;
+        if (!splitTokens(line, tokens))
+        {
+            fprintf(stderr, "%s:%u: malformed string\n", path, lineNumber);
+            return false;
+        }
+        if (tokens.empty() || tokens[0][0] == '#')
+            continue;
+
+        sCorpusEntry entry;
+        entry.line = lineNumber;
+        size_t expectedStart = 2;
+        if (tokens[0].compare(0, 4, "REC=") == 0)
+        {
+            if (!parseRecord(tokens[0].substr(4), entry))
+            {
+                fprintf(stderr, "%s:%u: record skipped, malformed or without parser\n", path, lineNumber);
+                continue;
+            }
+            expectedStart = 1;
+        }
+        else
+        {
+            entry.parser = PARSER_MAX;
+            for (uint8_t i = 0; i < PARSER_MAX; i++)
+            {
+                if (tokens[0] == PARSER_NAMES[i])
+                    entry.parser = (eParser)i;
+            }
+            if (entry.parser == PARSER_MAX || tokens.size() < 2)
+            {
+                fprintf(stderr, "%s:%u: unknown parser or no input\n", path, lineNumber);
+                return false;
+            }
+            entry.input = tokens[1];
+            if (entry.parser == PARSER_VISIFERM && !parseHex(tokens[1], entry.input))
+            {
+                fprintf(stderr, "%s:%u: malformed hexadecimal frame\n", path, lineNumber);
+                return false;
+            }
+        }
+        entry.expected.assign(tokens.begin() + std::min(expectedStart, tokens.size()), tokens.end());
+        corpus.push_back(entry);
+    }
+    return true;
+}
+
+/**
+ * @brief Print an entry and its result in the corpus format, to review and add the result of a new frame.
+ */
+static void printCorpusLine(const sCorpusEntry &entry, const sMeasurement &measurement)
+{
+    std::string line = PARSER_NAMES[entry.parser];
+    if (entry.parser == PARSER_VISIFERM)
+        line += " " + formatHex((const uint8_t *)entry.input.data(), entry.input.size());
+    else
+        line += " " + quoteToken(entry.input, true);
+    for (const std::string &token : measurement.result)
+        line += " " + quoteToken(token, entry.parser == PARSER_COMMAND);
+    printf("%s\n", line.c_str());
+}
+
+int main(int argc, char **argv)
+{
+    const char *corpusPath = "native/parser_benchmark/corpus.txt";
+    uint32_t repetitions = 10000;
+    bool isCorpusPrinted = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "-c" && i + 1 < argc)
+            corpusPath = argv[++i];
+        else if (argument == "-r" && i + 1 < argc)
+            repetitions = strtoul(argv[++i], nullptr, 10);
+        else if (argument == "-p")
+            isCorpusPrinted = true;
+        else
+        {
+            fprintf(stderr, "Usage: %s [-c corpus] [-r repetitions] [-p]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (repetitions == 0)
+        repetitions = 1;
+
+    std::vector<sCorpusEntry> corpus;
+    if (!loadCorpus(corpusPath, corpus))
+        return EXIT_FAILURE;
+
+    // The commands save their parameters like on the reactor
+    bioreactorParameter.begin("bioreactor");
+
+    double parserTimes[PARSER_MAX] = {};
+    double parserAllocations[PARSER_MAX] = {};
+    uint32_t parserFrames[PARSER_MAX] = {};
+    uint32_t failureCount = 0;
+    if (!isCorpusPrinted)
+        printf("{\"corpus\": \"%s\", \"repetitions\": %u, \"frames\": [\n", corpusPath, repetitions);
+
+    for (size_t i = 0; i < corpus.size(); i++)
+    {
+        const sCorpusEntry &entry = corpus[i];
+        sMeasurement measurement;
+        runEntry(entry, repetitions, measurement);
+        parserTimes[entry.parser] += measurement.time;
+        parserAllocations[entry.parser] += measurement.allocations;
+        parserFrames[entry.parser]++;
+
+        if (isCorpusPrinted)
+        {
+            printCorpusLine(entry, measurement);
+            continue;
+        }
+
+        bool isChecked = !entry.expected.empty();
+        bool isPassed = !isChecked || isResultMatching(measurement.result, entry.expected);
+        if (!isPassed)
+        {
+            failureCount++;
+            std::string result;
+            std::string expected;
+            for (const std::string &token : measurement.result)
+                result += " " + quoteToken(token, false);
+            for (const std::string &token : entry.expected)
+                expected += " " + quoteToken(token, false);
+            fprintf(stderr, "%s:%u: %s, expected%s, got%s\n", corpusPath, entry.line, PARSER_NAMES[entry.parser],
+                    expected.c_str(), result.c_str());
+        }
+        printf("    {\"line\": %u, \"parser\": \"%s\", \"ns_per_frame\": %.1f, \"allocations_per_frame\": %.2f, \"checked\": %s, \"passed\": %s}%s\n",
+               entry.line, PARSER_NAMES[entry.parser], measurement.time, measurement.allocations,
+               isChecked ? "true" : "false", isPassed ? "true" : "false", i + 1 < corpus.size() ? "," : "");
+    }
+
+    if (isCorpusPrinted)
+        return EXIT_SUCCESS;
+
+    printf("], \"parsers\": {");
+    bool isFirst = true;
+    for (uint8_t i = 0; i < PARSER_MAX; i++)
+    {
+        if (parserFrames[i] == 0)
+            continue;
+        printf("%s\"%s\": {\"frames\": %u, \"ns_per_frame\": %.1f, \"allocations_per_frame\": %.2f}", isFirst ? "" : ", ",
+               PARSER_NAMES[i], parserFrames[i], parserTimes[i] / parserFrames[i], parserAllocations[i] / parserFrames[i]);
+        isFirst = false;
+    }
+    printf("}, \"failures\": %u}\n", failureCount);
+    return failureCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
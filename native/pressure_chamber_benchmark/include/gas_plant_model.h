@@ -0,0 +1,79 @@
+#ifndef GAS_PLANT_MODEL_H
+#define GAS_PLANT_MODEL_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Parameters of the gas model of the pressure chamber.
+ */
+typedef struct
+{
+    float o2Flow;                // O2 valve flow at the chamber setpoint (L/s)
+    float co2Flow;               // CO2 valve flow at the chamber setpoint (L/s)
+    float airFlow;               // Air valve flow at the chamber setpoint (L/s)
+    float leakRate;              // Gas lost by the chamber at its setpoint (L/s)
+    float o2Uptake;              // O2 consumed by the cells (L/s)
+    float co2Production;         // CO2 produced by the cells (L/s)
+    float o2SensorTimeConstant;  // Response time of the O2 sensor (s)
+    float o2SensorDelay;         // Transport delay of the gas to the O2 sensor (s)
+    float co2SensorTimeConstant; // Response time of the GMP251 (s)
+    float co2SensorDelay;        // Transport delay of the gas to the GMP251 (s)
+} sGasPlantParameters;
+
+/**
+ * @class GasPlantModel
+ * @brief Model of the gas in the pressure chamber: valve flows, leakage, gas exchange with the cells and sensor responses.
+ *
+ * The gas is counted in liters at the setpoint pressure of the chamber, like the PressureChamberController does.
+ * The valve flows depend on the pressure difference with the supply, so they drop when the chamber pressure rises,
+ * which is one of the simplifications compensated by the correction factors of the controller.
+ * The sensor delay is approximated by a first order lag in series with the sensor response.
+ */
+class GasPlantModel
+{
+public:
+    GasPlantModel(const sGasPlantParameters &parameters = DEFAULT_PARAMETERS);
+    void setParameters(const sGasPlantParameters &parameters) { this->parameters = parameters; }
+    void reset(float o2Level, float co2Level, float pressure);
+    void step(float dt, bool isO2ValveOpen, bool isCo2ValveOpen, bool isAirValveOpen);
+
+    float getO2() const;
+    float getCo2() const;
+    float getPressure() const;
+    float getMeasuredO2() const { return this->measuredO2; }
+    float getMeasuredCo2() const { return this->measuredCo2; }
+    float getSuppliedO2Volume() const { return this->suppliedO2Volume; }
+    float getSuppliedCo2Volume() const { return this->suppliedCo2Volume; }
+    float getSuppliedAirVolume() const { return this->suppliedAirVolume; }
+
+    static const sGasPlantParameters DEFAULT_PARAMETERS;
+
+    static constexpr float V = 1.296;                     // Volume of the pressure chamber (L)
+    static constexpr float P_CHAMBER = 25 * 6895;         // Setpoint of the chamber, gauge (Pa)
+    static constexpr float P_SUPPLY = 30 * 6895;          // Pressure of the gas supplies, gauge (Pa)
+    static constexpr float ATMOSPHERIC_PRESSURE = 101325; // Pa
+
+private:
+    float getSupplyFlowFactor() const;
+    void addGas(float o2Volume, float co2Volume, float otherVolume);
+
+    sGasPlantParameters parameters;
+
+    // Gas in the chamber (L at the setpoint pressure)
+    float o2Volume;
+    float co2Volume;
+    float otherVolume; // N2 and the other gases of the air
+
+    // Gas taken from the supplies since the reset (L at the setpoint pressure)
+    float suppliedO2Volume;
+    float suppliedCo2Volume;
+    float suppliedAirVolume;
+
+    // Sensor responses, the first stage models the delay
+    float delayedO2;
+    float measuredO2;
+    float delayedCo2;
+    float measuredCo2;
+};
+
+#endif // GAS_PLANT_MODEL_H
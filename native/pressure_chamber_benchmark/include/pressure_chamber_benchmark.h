@@ -0,0 +1,68 @@
+#ifndef PRESSURE_CHAMBER_BENCHMARK_H
+#define PRESSURE_CHAMBER_BENCHMARK_H
+
+#include <Arduino.h>
+#include "gas_plant_model.h"
+
+/**
+ * @brief Scenario run by the pressure chamber benchmark.
+ */
+typedef struct
+{
+    const char *name;
+    float initialO2;        // Initial O2 concentration of the chamber (%)
+    float initialCo2;       // Initial CO2 concentration of the chamber (ppm)
+    float o2Ref;            // O2 reference of the controller (%)
+    float co2Ref;           // CO2 reference of the controller (ppm)
+    unsigned long duration; // Simulated time (ms)
+    float flowScale;        // Ratio between the real valve flows and the default ones of the model
+    float cellActivity;     // Ratio between the gas exchange of the cells and the default one of the model
+} sPressureChamberScenario;
+
+/**
+ * @brief Metrics of one scenario, computed on the real composition of the chamber.
+ */
+typedef struct
+{
+    bool isBandReached;
+    float timeToBand;       // First time both gases are in their band (s)
+    uint16_t bandExitCount; // Number of times a gas left its band after reaching it, shows the oscillations
+    float o2RmsError;       // RMS error of O2 once in the band (%)
+    float co2RmsError;      // RMS error of CO2 once in the band (ppm)
+    float o2Volume;         // O2 taken from the supply (L)
+    float co2Volume;        // CO2 taken from the supply (L)
+    float airVolume;        // Air taken from the supply (L)
+    uint16_t valveOpeningCount;
+    float maxPressure;      // Highest gauge pressure of the chamber (Pa)
+    double hostTime;        // Time taken by the host to run the scenario (s)
+} sPressureChamberBenchmarkResult;
+
+/**
+ * @class PressureChamberBenchmark
+ * @brief Runs the PressureChamberController in closed loop with the GasPlantModel on a simulated time.
+ *
+ * The observer, the dosing and the valve timing are the ones used by the firmware, they are only given the simulated
+ * time instead of the system clock. Changes of the correction factors or the dead zones can be compared before a real
+ * culture.
+ */
+class PressureChamberBenchmark
+{
+public:
+    sPressureChamberBenchmarkResult runScenario(const sPressureChamberScenario &scenario);
+
+    static const sPressureChamberScenario SCENARIOS[];
+    static const uint8_t SCENARIO_COUNT;
+    static constexpr float P_CHAMBER_MAX = GasPlantModel::P_CHAMBER + 2 * 6895; // Pa, same as the limit of the PressureChamberController, a scenario above it fails
+
+private:
+    GasPlantModel plant;
+
+    static constexpr unsigned long SIMULATION_STEP = 10;               // ms
+    static constexpr unsigned long OBSERVER_UPDATE_INTERVAL = 1000;    // ms, same as GAS_OBSERVER_UPDATE_INTERVAL
+    static constexpr unsigned long CONTROLLER_UPDATE_INTERVAL = 10000; // ms, same as PRESSURE_CHAMBER_CONTROLLER_UPDATE_INTERVAL
+    static constexpr float O2_BAND = 0.5f;                             // Accepted O2 error for the culture (%)
+    static constexpr float CO2_BAND = 1000.0f;                         // Accepted CO2 error for the culture (ppm)
+    static constexpr float MILLIS_TO_SECONDS = 1000.0f;
+};
+
+#endif // PRESSURE_CHAMBER_BENCHMARK_H
@@ -0,0 +1,146 @@
+#include "gas_plant_model.h"
+#include "gas_composition_observer.h"
+
+static constexpr float PERCENT = 100.0f;
+static constexpr float PPM = 1000000.0f;
+
+const sGasPlantParameters GasPlantModel::DEFAULT_PARAMETERS = {
+    0.058f,    // o2Flow (L/s)
+    0.154f,    // co2Flow (L/s)
+    0.0043f,   // airFlow (L/s)
+    0.0002f,   // leakRate (L/s), the chamber loses its volume in about 2 h
+    0.000005f, // o2Uptake (L/s)
+    0.000004f, // co2Production (L/s), respiratory quotient of 0.8
+    6.0f,      // o2SensorTimeConstant (s)
+    2.0f,      // o2SensorDelay (s)
+    20.0f,     // co2SensorTimeConstant (s)
+    5.0f,      // co2SensorDelay (s)
+};
+
+/**
+ * @brief Constructor of the gas model, starts filled with air at the setpoint pressure.
+ * @param parameters Parameters of the model.
+ */
+GasPlantModel::GasPlantModel(const sGasPlantParameters &parameters)
+    : parameters(parameters)
+{
+    reset(GasCompositionObserver::O2_IN_AIR, GasCompositionObserver::CO2_IN_AIR, P_CHAMBER);
+}
+
+/**
+ * @brief Set the initial state of the chamber, the sensors start at the true composition.
+ * @param o2Level O2 concentration (%).
+ * @param co2Level CO2 concentration (ppm).
+ * @param pressure Gauge pressure (Pa).
+ */
+void GasPlantModel::reset(float o2Level, float co2Level, float pressure)
+{
+    float totalVolume = V * (pressure + ATMOSPHERIC_PRESSURE) / (P_CHAMBER + ATMOSPHERIC_PRESSURE);
+    this->o2Volume = totalVolume * o2Level / PERCENT;
+    this->co2Volume = totalVolume * co2Level / PPM;
+    this->otherVolume = max(0.0f, totalVolume - this->o2Volume - this->co2Volume);
+    this->suppliedO2Volume = 0.0f;
+    this->suppliedCo2Volume = 0.0f;
+    this->suppliedAirVolume = 0.0f;
+
+    this->delayedO2 = this->measuredO2 = o2Level;
+    this->delayedCo2 = this->measuredCo2 = co2Level;
+}
+
+/**
+ * @brief Integrate the model (explicit Euler, dt must be small compared to the valve opening times).
+ * @param dt Time step (s).
+ * @param isO2ValveOpen State of the O2 valve during the step.
+ * @param isCo2ValveOpen State of the CO2 valve during the step.
+ * @param isAirValveOpen State of the air valve during the step.
+ */
+void GasPlantModel::step(float dt, bool isO2ValveOpen, bool isCo2ValveOpen, bool isAirValveOpen)
+{
+    float supplyFlowFactor = getSupplyFlowFactor();
+    if (isO2ValveOpen)
+    {
+        float addedO2Volume = this->parameters.o2Flow * supplyFlowFactor * dt;
+        this->suppliedO2Volume += addedO2Volume;
+        addGas(addedO2Volume, 0.0f, 0.0f);
+    }
+    if (isCo2ValveOpen)
+    {
+        float addedCo2Volume = this->parameters.co2Flow * supplyFlowFactor * dt;
+        this->suppliedCo2Volume += addedCo2Volume;
+        addGas(0.0f, addedCo2Volume, 0.0f);
+    }
+    if (isAirValveOpen)
+    {
+        float addedAirVolume = this->parameters.airFlow * supplyFlowFactor * dt;
+        this->suppliedAirVolume += addedAirVolume;
+        addGas(addedAirVolume * GasCompositionObserver::O2_IN_AIR / PERCENT, addedAirVolume * GasCompositionObserver::CO2_IN_AIR / PPM,
+               addedAirVolume * (1.0f - GasCompositionObserver::O2_IN_AIR / PERCENT - GasCompositionObserver::CO2_IN_AIR / PPM));
+    }
+
+    // The leak removes the mixture, the cells exchange O2 for CO2
+    float totalVolume = this->o2Volume + this->co2Volume + this->otherVolume;
+    float leakFraction = constrain(this->parameters.leakRate * max(0.0f, getPressure()) / P_CHAMBER * dt / totalVolume, 0.0f, 1.0f);
+    this->o2Volume -= this->o2Volume * leakFraction;
+    this->co2Volume -= this->co2Volume * leakFraction;
+    this->otherVolume -= this->otherVolume * leakFraction;
+    this->o2Volume = max(0.0f, this->o2Volume - this->parameters.o2Uptake * dt);
+    this->co2Volume += this->parameters.co2Production * dt;
+
+    float o2Level = getO2();
+    float co2Level = getCo2();
+    this->delayedO2 += (o2Level - this->delayedO2) * min(1.0f, dt / this->parameters.o2SensorDelay);
+    this->measuredO2 += (this->delayedO2 - this->measuredO2) * min(1.0f, dt / this->parameters.o2SensorTimeConstant);
+    this->delayedCo2 += (co2Level - this->delayedCo2) * min(1.0f, dt / this->parameters.co2SensorDelay);
+    this->measuredCo2 += (this->delayedCo2 - this->measuredCo2) * min(1.0f, dt / this->parameters.co2SensorTimeConstant);
+}
+
+/**
+ * @brief Get the true O2 concentration of the chamber.
+ * @return O2 concentration (%).
+ */
+float GasPlantModel::getO2() const
+{
+    float totalVolume = this->o2Volume + this->co2Volume + this->otherVolume;
+    return totalVolume > 0.0f ? this->o2Volume / totalVolume * PERCENT : 0.0f;
+}
+
+/**
+ * @brief Get the true CO2 concentration of the chamber.
+ * @return CO2 concentration (ppm).
+ */
+float GasPlantModel::getCo2() const
+{
+    float totalVolume = this->o2Volume + this->co2Volume + this->otherVolume;
+    return totalVolume > 0.0f ? this->co2Volume / totalVolume * PPM : 0.0f;
+}
+
+/**
+ * @brief Get the pressure of the chamber.
+ * @return Gauge pressure (Pa).
+ */
+float GasPlantModel::getPressure() const
+{
+    float totalVolume = this->o2Volume + this->co2Volume + this->otherVolume;
+    return (P_CHAMBER + ATMOSPHERIC_PRESSURE) * totalVolume / V - ATMOSPHERIC_PRESSURE;
+}
+
+/**
+ * @brief Ratio between the flow of a valve at the current pressure and its flow at the setpoint.
+ */
+float GasPlantModel::getSupplyFlowFactor() const
+{
+    return max(0.0f, (P_SUPPLY - getPressure()) / (P_SUPPLY - P_CHAMBER));
+}
+
+/**
+ * @brief Add gas to the chamber.
+ * @param o2Volume Volume of O2 added (L).
+ * @param co2Volume Volume of CO2 added (L).
+ * @param otherVolume Volume of the other gases added (L).
+ */
+void GasPlantModel::addGas(float o2Volume, float co2Volume, float otherVolume)
+{
+    this->o2Volume += o2Volume;
+    this->co2Volume += co2Volume;
+    this->otherVolume += otherVolume;
+}
@@ -0,0 +1,176 @@
+/*
+ * Runs the PressureChamberController of the firmware (observer, dosing and valve timing) in closed loop with the
+ * GasPlantModel and prints for each scenario as JSON the time to reach the O2 and CO2 bands, the oscillations, the
+ * RMS errors, the gas used and the highest pressure of the chamber. The run fails if a scenario takes the chamber above
+ * P_CHAMBER_MAX.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "pressure_chamber_benchmark.h"
+#include "pressure_chamber_controller.h"
+
+typedef std::chrono::steady_clock HostClock;
+
+static constexpr unsigned long HOUR = 3600000UL;
+
+/**
+ * @brief Scenarios of the benchmark.
+ */
+const sPressureChamberScenario PressureChamberBenchmark::SCENARIOS[] = {
+    // name, initial O2, initial CO2, O2 reference, CO2 reference, duration, flow scale, cell activity
+    // The leak is the only way out of the chamber (the controller never opens the safety valve), the CO2 reference can
+    // only be held while the cells produce less than the leak carries away: leakRate * co2Ref / co2Production, about
+    // 2.5 times the default activity at 50000 ppm. Above it the chamber sits at P_CHAMBER_MAX diluting with O2.
+    {"fill-from-air", 20.9f, 400.0f, 85.0f, 50000.0f, 4 * HOUR, 1.0f, 1.0f},
+    {"steady-culture", 85.0f, 50000.0f, 85.0f, 50000.0f, 4 * HOUR, 1.0f, 1.0f},
+    {"dense-culture", 85.0f, 50000.0f, 85.0f, 50000.0f, 4 * HOUR, 1.0f, 2.0f},
+    {"reference-change", 85.0f, 50000.0f, 80.0f, 60000.0f, 2 * HOUR, 1.0f, 1.0f},
+    {"slow-valves", 85.0f, 50000.0f, 85.0f, 50000.0f, 4 * HOUR, 0.5f, 1.0f},
+    {"fast-valves", 85.0f, 50000.0f, 85.0f, 50000.0f, 4 * HOUR, 2.0f, 1.0f}};
+const uint8_t PressureChamberBenchmark::SCENARIO_COUNT = sizeof(SCENARIOS) / sizeof(SCENARIOS[0]);
+
+/**
+ * @brief Run one scenario with a new controller.
+ * @param scenario The scenario to run.
+ * @return The metrics of the scenario.
+ */
+sPressureChamberBenchmarkResult PressureChamberBenchmark::runScenario(const sPressureChamberScenario &scenario)
+{
+    HostClock::time_point hostStart = HostClock::now();
+
+    sGasPlantParameters parameters = GasPlantModel::DEFAULT_PARAMETERS;
+    parameters.o2Flow *= scenario.flowScale;
+    parameters.co2Flow *= scenario.flowScale;
+    parameters.airFlow *= scenario.flowScale;
+    parameters.o2Uptake *= scenario.cellActivity;
+    parameters.co2Production *= scenario.cellActivity;
+    plant.setParameters(parameters);
+    plant.reset(scenario.initialO2, scenario.initialCo2, GasPlantModel::P_CHAMBER);
+
+    PressureChamberController controller;
+    controller.setReferenceLevel(O2, scenario.o2Ref);
+    controller.setReferenceLevel(CO2, scenario.co2Ref);
+    controller.setPressureChamberState(true);
+
+    sPressureChamberBenchmarkResult result = {};
+    unsigned long lastObserverTime = 0;
+    unsigned long lastControllerTime = 0;
+    bool wasInBand = false;
+    bool wasAnyValveOpen = false;
+    float o2SquaredErrorSum = 0.0f;
+    float co2SquaredErrorSum = 0.0f;
+    unsigned long inBandSampleCount = 0;
+    result.maxPressure = plant.getPressure();
+
+    for (unsigned long time = 0; time < scenario.duration; time += SIMULATION_STEP)
+    {
+        if (time - lastObserverTime >= OBSERVER_UPDATE_INTERVAL)
+        {
+            lastObserverTime = time;
+            controller.updateObserver(plant.getMeasuredO2(), true, plant.getMeasuredCo2(), true, time);
+        }
+
+        if (time - lastControllerTime >= CONTROLLER_UPDATE_INTERVAL && controller.isEstimationReady())
+        {
+            lastControllerTime = time;
+            controller.update(controller.getEstimatedLevel(O2), controller.getEstimatedLevel(CO2), plant.getPressure(), time);
+        }
+
+        bool isO2ValveOpen = controller.getValveState(O2, time);
+        bool isCo2ValveOpen = controller.getValveState(CO2, time);
+        bool isAirValveOpen = controller.getValveState(AIR, time);
+        bool isAnyValveOpen = isO2ValveOpen || isCo2ValveOpen || isAirValveOpen;
+        if (isAnyValveOpen && !wasAnyValveOpen)
+            result.valveOpeningCount++;
+        wasAnyValveOpen = isAnyValveOpen;
+
+        plant.step(SIMULATION_STEP / MILLIS_TO_SECONDS, isO2ValveOpen, isCo2ValveOpen, isAirValveOpen);
+
+        float o2Error = plant.getO2() - scenario.o2Ref;
+        float co2Error = plant.getCo2() - scenario.co2Ref;
+        bool isInBand = fabs(o2Error) <= O2_BAND && fabs(co2Error) <= CO2_BAND;
+        if (isInBand && !result.isBandReached)
+        {
+            result.isBandReached = true;
+            result.timeToBand = time / MILLIS_TO_SECONDS;
+        }
+        if (!isInBand && wasInBand)
+            result.bandExitCount++;
+        wasInBand = isInBand;
+
+        if (result.isBandReached)
+        {
+            o2SquaredErrorSum += o2Error * o2Error;
+            co2SquaredErrorSum += co2Error * co2Error;
+            inBandSampleCount++;
+        }
+        result.maxPressure = max(result.maxPressure, plant.getPressure());
+    }
+
+    if (inBandSampleCount > 0)
+    {
+        result.o2RmsError = sqrt(o2SquaredErrorSum / inBandSampleCount);
+        result.co2RmsError = sqrt(co2SquaredErrorSum / inBandSampleCount);
+    }
+    result.o2Volume = plant.getSuppliedO2Volume();
+    result.co2Volume = plant.getSuppliedCo2Volume();
+    result.airVolume = plant.getSuppliedAirVolume();
+    result.hostTime = std::chrono::duration<double>(HostClock::now() - hostStart).count();
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    const char *scenarioName = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "-s" && i + 1 < argc)
+            scenarioName = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [-s scenario]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    PressureChamberBenchmark benchmark;
+    printf("{\"scenarios\": [\n");
+    bool isFirst = true;
+    uint8_t overPressureCount = 0;
+    for (uint8_t i = 0; i < PressureChamberBenchmark::SCENARIO_COUNT; i++)
+    {
+        const sPressureChamberScenario &scenario = PressureChamberBenchmark::SCENARIOS[i];
+        if (scenarioName != nullptr && strcmp(scenarioName, scenario.name) != 0)
+            continue;
+        sPressureChamberBenchmarkResult result = benchmark.runScenario(scenario);
+        bool isOverPressure = result.maxPressure > PressureChamberBenchmark::P_CHAMBER_MAX;
+        if (isOverPressure)
+            overPressureCount++;
+        printf("%s    {\"scenario\": \"%s\", \"simulated_s\": %lu, \"band_reached\": %s, \"time_to_band_s\": %.0f, \"band_exits\": %u,\n",
+               isFirst ? "" : ",\n", scenario.name, scenario.duration / 1000, result.isBandReached ? "true" : "false",
+               result.timeToBand, result.bandExitCount);
+        printf("     \"o2_rms_error_pct\": %.3f, \"co2_rms_error_ppm\": %.0f, \"o2_used_l\": %.3f, \"co2_used_l\": %.3f, \"air_used_l\": %.3f,\n",
+               result.o2RmsError, result.co2RmsError, result.o2Volume, result.co2Volume, result.airVolume);
+        printf("     \"valve_openings\": %u, \"max_pressure_pa\": %.0f, \"over_pressure\": %s, \"host_s\": %.6f}",
+               result.valveOpeningCount, result.maxPressure, isOverPressure ? "true" : "false", result.hostTime);
+        isFirst = false;
+    }
+    printf("\n]}\n");
+    if (isFirst)
+    {
+        fprintf(stderr, "Unknown scenario %s\n", scenarioName);
+        return EXIT_FAILURE;
+    }
+    if (overPressureCount > 0)
+    {
+        fprintf(stderr, "%u scenario(s) above P_CHAMBER_MAX (%.0f Pa)\n", overPressureCount,
+                PressureChamberBenchmark::P_CHAMBER_MAX);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,64 @@
+#ifndef TEMPERATURE_BENCHMARK_H
+#define TEMPERATURE_BENCHMARK_H
+
+#include <Arduino.h>
+#include "thermal_plant_model.h"
+
+/**
+ * @brief Scenario run by the temperature benchmark.
+ */
+typedef struct
+{
+    const char *name;
+    float initialTemp;              // Initial air and culture liquid temperature (°C)
+    float ambientTemp;              // Room temperature (°C)
+    float referenceTemp;            // Reference of the controller (°C)
+    unsigned long duration;         // Simulated time (ms)
+    unsigned long disturbanceStart; // Start of the disturbance (ms), 0 = no disturbance
+    unsigned long disturbanceEnd;   // End of the disturbance (ms), 0 = until the end of the scenario
+    float disturbanceAmbientTemp;   // Room temperature during the disturbance (°C)
+    float disturbanceExtraLoss;     // Additional conductance to the room during the disturbance (W/K)
+} sTemperatureScenario;
+
+/**
+ * @brief Metrics of one scenario, computed on the real culture liquid temperature.
+ */
+typedef struct
+{
+    float settlingTime;     // Last time the liquid was outside of the settling band (s)
+    float overshoot;        // Highest liquid temperature above the reference (°C)
+    float steadyStateError; // Mean error (reference - liquid) over the end of the scenario (°C)
+    float heaterDuty;       // Mean SSR output over the scenario (%)
+    bool isSettled;         // The liquid stayed in the settling band over the end of the scenario
+    double hostTime;        // Time taken by the host to run the scenario (s)
+} sTemperatureBenchmarkResult;
+
+/**
+ * @class TemperatureBenchmark
+ * @brief Runs the TemperatureController and the SSR_Relay in closed loop with the ThermalPlantModel on a simulated time.
+ *
+ * The controller and the relay are the ones used by the firmware, they are only given the simulated time instead of the
+ * system clock. Hours of regulation are simulated in a few seconds, so a regression of the tuning shows up on the host
+ * without waiting for a real run.
+ */
+class TemperatureBenchmark
+{
+public:
+    TemperatureBenchmark(const sThermalPlantParameters &parameters = ThermalPlantModel::DEFAULT_PARAMETERS);
+    sTemperatureBenchmarkResult runScenario(const sTemperatureScenario &scenario);
+
+    static const sTemperatureScenario SCENARIOS[];
+    static const uint8_t SCENARIO_COUNT;
+
+private:
+    ThermalPlantModel plant;
+
+    static constexpr unsigned long RELAY_STEP = 10;                     // ms, CHECK_INTERVAL of the SSR_Relay
+    static constexpr uint8_t RELAY_STEPS_PER_PLANT_STEP = 10;           // The plant is integrated every 100 ms
+    static constexpr unsigned long CONTROLLER_UPDATE_INTERVAL = 1000;   // ms, same as TEMPERATURE_CONTROLLER_UPDATE_INTERVAL
+    static constexpr float SETTLING_BAND = 0.2f;                        // °C
+    static constexpr unsigned long STEADY_STATE_WINDOW = 30UL * 60000;  // ms, end of the scenario used for the steady-state error
+    static constexpr float MILLIS_TO_SECONDS = 1000.0f;
+};
+
+#endif // TEMPERATURE_BENCHMARK_H
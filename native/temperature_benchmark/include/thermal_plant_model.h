@@ -0,0 +1,56 @@
+#ifndef THERMAL_PLANT_MODEL_H
+#define THERMAL_PLANT_MODEL_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Parameters of the thermal model of the bioreactor.
+ */
+typedef struct
+{
+    float airHeatCapacity;         // Air, walls and heater block (J/K)
+    float liquidHeatCapacity;      // Culture liquid and culture chamber (J/K)
+    float heaterPower;             // Heater power when the SSR is ON (W)
+    float airToAmbientLoss;        // Conductance between the air and the room, fans OFF (W/K)
+    float fanLoss;                 // Conductance added by the cooling fans when they are ON (W/K)
+    float airToLiquidTransfer;     // Conductance between the air and the culture liquid (W/K)
+    float waterSensorTimeConstant; // Response time of the culture liquid temperature sensor (s)
+} sThermalPlantParameters;
+
+/**
+ * @class ThermalPlantModel
+ * @brief Two node thermal model of the bioreactor (air volume and culture liquid) heated by the SSR heater.
+ *
+ * C_air * dT_air/dt = P_heater - (G_ambient + G_fans) * (T_air - T_ambient) - G_liquid * (T_air - T_liquid)
+ * C_liquid * dT_liquid/dt = G_liquid * (T_air - T_liquid)
+ *
+ * Used to run the TemperatureController on a simulated time, the default parameters must be fitted on a real run.
+ */
+class ThermalPlantModel
+{
+public:
+    ThermalPlantModel(const sThermalPlantParameters &parameters = DEFAULT_PARAMETERS);
+    void reset(float airTemp, float liquidTemp, float ambientTemp);
+    void step(float dt, float heaterLevel);
+
+    void setAmbientTemperature(float ambientTemp) { this->ambientTemp = ambientTemp; }
+    void setFansState(bool isFanOn) { this->isFanOn = isFanOn; }
+    void setExtraLoss(float extraLoss) { this->extraLoss = extraLoss; }
+
+    float getAirTemperature() const { return this->airTemp; }
+    float getLiquidTemperature() const { return this->liquidTemp; }
+    float getMeasuredLiquidTemperature() const { return this->measuredLiquidTemp; }
+
+    static const sThermalPlantParameters DEFAULT_PARAMETERS;
+
+private:
+    sThermalPlantParameters parameters;
+    float airTemp;
+    float liquidTemp;
+    float measuredLiquidTemp;
+    float ambientTemp;
+    float extraLoss; // Additional conductance to the room, ex: door open (W/K)
+    bool isFanOn;
+};
+
+#endif // THERMAL_PLANT_MODEL_H
@@ -0,0 +1,196 @@
+/*
+ * Runs the TemperatureController and the SSR_Relay of the firmware in closed loop with the ThermalPlantModel and prints
+ * for each scenario as JSON the settling time, the overshoot, the steady-state error and the heater duty, measured on
+ * the real culture liquid temperature.
+ *
+ * The default parameters of the model are not fitted on a real run yet. With them the cold-start scenario does not
+ * settle: the integral of the air reference winds up during the heating, the liquid overshoots by 0.9°C and only
+ * re-enters the settling band after about 10 h, past the 6 h of the scenario. Its figures can compare two tunings of
+ * the controller but say nothing of the bioreactor; fitted parameters are given with -p until they replace the
+ * defaults.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "temperature_benchmark.h"
+#include "temperature_controller.h"
+#include "ssr_relay.h"
+
+typedef std::chrono::steady_clock HostClock;
+
+static constexpr unsigned long HOUR = 3600000UL;
+static constexpr unsigned long MINUTE = 60000UL;
+
+/**
+ * @brief Scenarios of the benchmark.
+ */
+const sTemperatureScenario TemperatureBenchmark::SCENARIOS[] = {
+    // name, initial, ambient, reference, duration, disturbance start, disturbance end, disturbance ambient, disturbance loss
+    // cold-start does not settle within its duration on the default parameters of the model (see the top of the file)
+    {"cold-start", 22.0f, 22.0f, 37.0f, 6 * HOUR, 0, 0, 22.0f, 0.0f},
+    {"setpoint-step", 37.0f, 22.0f, 38.0f, 3 * HOUR, 0, 0, 22.0f, 0.0f},
+    {"ambient-drop", 37.0f, 22.0f, 37.0f, 4 * HOUR, 1 * HOUR, 0, 16.0f, 0.0f},
+    {"door-open", 37.0f, 22.0f, 37.0f, 3 * HOUR, 1 * HOUR, 1 * HOUR + 5 * MINUTE, 22.0f, 10.0f}};
+const uint8_t TemperatureBenchmark::SCENARIO_COUNT = sizeof(SCENARIOS) / sizeof(SCENARIOS[0]);
+
+/**
+ * @brief Constructor of the benchmark.
+ * @param parameters Parameters of the thermal model.
+ */
+TemperatureBenchmark::TemperatureBenchmark(const sThermalPlantParameters &parameters)
+    : plant(parameters)
+{
+}
+
+/**
+ * @brief Run one scenario with a new controller and relay.
+ * @param scenario The scenario to run.
+ * @return The metrics of the scenario.
+ */
+sTemperatureBenchmarkResult TemperatureBenchmark::runScenario(const sTemperatureScenario &scenario)
+{
+    HostClock::time_point hostStart = HostClock::now();
+
+    TemperatureController controller;
+    SSR_Relay relay(SSR_Relay::NO_PIN);
+    controller.setReferenceTemperature(scenario.referenceTemp);
+
+    // A scenario starting at the reference starts from the equilibrium of the air and the liquid
+    plant.reset(scenario.initialTemp, scenario.initialTemp, scenario.ambientTemp);
+
+    sTemperatureBenchmarkResult result = {0.0f, 0.0f, 0.0f, 0.0f, false, 0.0};
+    unsigned long lastControllerTime = 0;
+    unsigned long heaterOnCount = 0;
+    unsigned long relayStepCount = 0;
+    unsigned long lastOutsideBandTime = 0;
+    float steadyStateErrorSum = 0.0f;
+    unsigned long steadyStateSampleCount = 0;
+    bool isDisturbanceActive = false;
+
+    for (unsigned long time = 0; time < scenario.duration; time += RELAY_STEP * RELAY_STEPS_PER_PLANT_STEP)
+    {
+        bool isDisturbed = scenario.disturbanceStart != 0 && time >= scenario.disturbanceStart &&
+                           (scenario.disturbanceEnd == 0 || time < scenario.disturbanceEnd);
+        if (isDisturbed != isDisturbanceActive)
+        {
+            isDisturbanceActive = isDisturbed;
+            plant.setAmbientTemperature(isDisturbed ? scenario.disturbanceAmbientTemp : scenario.ambientTemp);
+            plant.setExtraLoss(isDisturbed ? scenario.disturbanceExtraLoss : 0.0f);
+        }
+
+        if (time - lastControllerTime >= CONTROLLER_UPDATE_INTERVAL)
+        {
+            lastControllerTime = time;
+            controller.update(plant.getMeasuredLiquidTemperature(), plant.getAirTemperature(), time);
+            relay.setLevel(controller.getHeaterPower());
+        }
+
+        uint8_t heaterOnSteps = 0;
+        for (uint8_t i = 0; i < RELAY_STEPS_PER_PLANT_STEP; i++)
+        {
+            relay.update(time + i * RELAY_STEP);
+            if (relay.getOutputState())
+                heaterOnSteps++;
+        }
+        heaterOnCount += heaterOnSteps;
+        relayStepCount += RELAY_STEPS_PER_PLANT_STEP;
+        plant.step(RELAY_STEP * RELAY_STEPS_PER_PLANT_STEP / MILLIS_TO_SECONDS, (float)heaterOnSteps / RELAY_STEPS_PER_PLANT_STEP);
+
+        float liquidTemp = plant.getLiquidTemperature();
+        float error = scenario.referenceTemp - liquidTemp;
+        if (fabs(error) > SETTLING_BAND)
+            lastOutsideBandTime = time;
+        if (-error > result.overshoot)
+            result.overshoot = -error;
+        if (scenario.duration - time <= STEADY_STATE_WINDOW)
+        {
+            steadyStateErrorSum += error;
+            steadyStateSampleCount++;
+        }
+    }
+
+    result.settlingTime = lastOutsideBandTime / MILLIS_TO_SECONDS;
+    result.steadyStateError = steadyStateSampleCount > 0 ? steadyStateErrorSum / steadyStateSampleCount : 0.0f;
+    result.heaterDuty = relayStepCount > 0 ? 100.0f * heaterOnCount / relayStepCount : 0.0f;
+    result.isSettled = scenario.duration - lastOutsideBandTime > STEADY_STATE_WINDOW;
+    result.hostTime = std::chrono::duration<double>(HostClock::now() - hostStart).count();
+    return result;
+}
+
+/**
+ * @brief Set a parameter of the thermal model from a "name=value" argument.
+ * @return false if the name is unknown.
+ */
+static bool setParameter(sThermalPlantParameters &parameters, const char *argument)
+{
+    const char *separator = strchr(argument, '=');
+    if (separator == nullptr)
+        return false;
+    std::string name(argument, separator - argument);
+    float value = strtof(separator + 1, nullptr);
+    if (name == "airHeatCapacity")
+        parameters.airHeatCapacity = value;
+    else if (name == "liquidHeatCapacity")
+        parameters.liquidHeatCapacity = value;
+    else if (name == "heaterPower")
+        parameters.heaterPower = value;
+    else if (name == "airToAmbientLoss")
+        parameters.airToAmbientLoss = value;
+    else if (name == "fanLoss")
+        parameters.fanLoss = value;
+    else if (name == "airToLiquidTransfer")
+        parameters.airToLiquidTransfer = value;
+    else if (name == "waterSensorTimeConstant")
+        parameters.waterSensorTimeConstant = value;
+    else
+        return false;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    sThermalPlantParameters parameters = ThermalPlantModel::DEFAULT_PARAMETERS;
+    const char *scenarioName = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "-s" && i + 1 < argc)
+            scenarioName = argv[++i];
+        else if (argument == "-p" && i + 1 < argc && setParameter(parameters, argv[i + 1]))
+            i++;
+        else
+        {
+            fprintf(stderr, "Usage: %s [-s scenario] [-p parameter=value]...\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    TemperatureBenchmark benchmark(parameters);
+    printf("{\"parameters\": {\"airHeatCapacity\": %g, \"liquidHeatCapacity\": %g, \"heaterPower\": %g, \"airToAmbientLoss\": %g, "
+           "\"fanLoss\": %g, \"airToLiquidTransfer\": %g, \"waterSensorTimeConstant\": %g}, \"scenarios\": [\n",
+           parameters.airHeatCapacity, parameters.liquidHeatCapacity, parameters.heaterPower, parameters.airToAmbientLoss,
+           parameters.fanLoss, parameters.airToLiquidTransfer, parameters.waterSensorTimeConstant);
+    bool isFirst = true;
+    for (uint8_t i = 0; i < TemperatureBenchmark::SCENARIO_COUNT; i++)
+    {
+        const sTemperatureScenario &scenario = TemperatureBenchmark::SCENARIOS[i];
+        if (scenarioName != nullptr && strcmp(scenarioName, scenario.name) != 0)
+            continue;
+        sTemperatureBenchmarkResult result = benchmark.runScenario(scenario);
+        printf("%s    {\"scenario\": \"%s\", \"simulated_s\": %lu, \"settling_s\": %.0f, \"overshoot_c\": %.3f, "
+               "\"steady_state_error_c\": %.3f, \"heater_duty_pct\": %.1f, \"settled\": %s, \"host_s\": %.6f}",
+               isFirst ? "" : ",\n", scenario.name, scenario.duration / 1000, result.settlingTime, result.overshoot,
+               result.steadyStateError, result.heaterDuty, result.isSettled ? "true" : "false", result.hostTime);
+        isFirst = false;
+    }
+    printf("\n]}\n");
+    if (isFirst)
+    {
+        fprintf(stderr, "Unknown scenario %s\n", scenarioName);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
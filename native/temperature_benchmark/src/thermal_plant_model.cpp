@@ -0,0 +1,58 @@
+#include "thermal_plant_model.h"
+
+const sThermalPlantParameters ThermalPlantModel::DEFAULT_PARAMETERS = {
+    5000.0f, // airHeatCapacity (J/K)
+    4500.0f, // liquidHeatCapacity (J/K), about 1 L of medium
+    200.0f,  // heaterPower (W)
+    2.0f,    // airToAmbientLoss (W/K)
+    1.0f,    // fanLoss (W/K)
+    1.5f,    // airToLiquidTransfer (W/K)
+    30.0f,   // waterSensorTimeConstant (s)
+};
+
+/**
+ * @brief Constructor of the thermal model, starts at 22°C everywhere.
+ * @param parameters Parameters of the model.
+ */
+ThermalPlantModel::ThermalPlantModel(const sThermalPlantParameters &parameters)
+    : parameters(parameters),
+      airTemp(22.0f),
+      liquidTemp(22.0f),
+      measuredLiquidTemp(22.0f),
+      ambientTemp(22.0f),
+      extraLoss(0.0f),
+      isFanOn(true)
+{
+}
+
+/**
+ * @brief Set the initial state of the model.
+ * @param airTemp Initial air temperature (°C).
+ * @param liquidTemp Initial culture liquid temperature (°C).
+ * @param ambientTemp Room temperature (°C).
+ */
+void ThermalPlantModel::reset(float airTemp, float liquidTemp, float ambientTemp)
+{
+    this->airTemp = airTemp;
+    this->liquidTemp = liquidTemp;
+    this->measuredLiquidTemp = liquidTemp;
+    this->ambientTemp = ambientTemp;
+    this->extraLoss = 0.0f;
+}
+
+/**
+ * @brief Integrate the model (explicit Euler, dt must be small compared to the time constants).
+ * @param dt Time step (s).
+ * @param heaterLevel Fraction of the step during which the SSR output was ON (0-1).
+ */
+void ThermalPlantModel::step(float dt, float heaterLevel)
+{
+    float ambientLoss = this->parameters.airToAmbientLoss + this->extraLoss + (this->isFanOn ? this->parameters.fanLoss : 0.0f);
+    float heatToLiquid = this->parameters.airToLiquidTransfer * (this->airTemp - this->liquidTemp);
+    float heatToAmbient = ambientLoss * (this->airTemp - this->ambientTemp);
+    float heatFromHeater = heaterLevel * this->parameters.heaterPower;
+
+    this->airTemp += (heatFromHeater - heatToAmbient - heatToLiquid) * dt / this->parameters.airHeatCapacity;
+    this->liquidTemp += heatToLiquid * dt / this->parameters.liquidHeatCapacity;
+    this->measuredLiquidTemp += (this->liquidTemp - this->measuredLiquidTemp) * dt / this->parameters.waterSensorTimeConstant;
+}
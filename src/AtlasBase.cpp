@@ -16,7 +16,7 @@ eAtlasStatus AtlasBase::begin()
  */
 void AtlasBase::update()
 {
-    unsigned long now = millis();
+    unsigned long now = systemClock.getMillis();
 
     if ((now - _lastCommTime) > COMM_LOSS_TIMEOUT_MS && _lastCommTime != 0)
     {
@@ -25,12 +25,13 @@ void AtlasBase::update()
 
     requestMeasurement();
 
-    if (_state == ST_WAITING && now >= _nextPollDue)
+    if (_state == ST_WAITING && now - _lastPollTime >= _pollDelay)
     {
         if (now - _cmdSentAt > NB_MAX_CONVERSION_MS)
         {
             _state = ST_ERROR;
             _status = ATLAS_STATUS_TIMEOUT_EXCEEDED;
+            _stats.addTimeout();
         }
         else
         {
@@ -58,8 +59,11 @@ bool AtlasBase::requestMeasurement()
         return false;
     }
     _state = ST_WAITING;
-    _cmdSentAt = millis();
-    _nextPollDue = millis();
+    _cmdSentAt = systemClock.getMillis();
+    _cmdSentAtUs = systemClock.readTime();
+    _stats.addRequest();
+    _lastPollTime = _cmdSentAt;
+    _pollDelay = 0;
     return true;
 }
 
@@ -72,19 +76,47 @@ eAtlasStatus AtlasBase::pollOnce()
     char buf[RESPONSE_BUFFER_SIZE];
     memset(buf, 0, RESPONSE_BUFFER_SIZE);
 
-    _pWire->requestFrom(_i2cAddress, RESPONSE_BUFFER_SIZE);
+    // Status byte followed by the ASCII reply
+    uint8_t response[RESPONSE_BUFFER_SIZE];
+    size_t length = 0;
+    if (busRecorder.isReplaying())
+    {
+        length = busRecorder.replay(BUS_CHANNEL_ATLAS, _i2cAddress, response, RESPONSE_BUFFER_SIZE);
+    }
+    else
+    {
+        _pWire->requestFrom(_i2cAddress, RESPONSE_BUFFER_SIZE);
+        while (_pWire->available() && length < RESPONSE_BUFFER_SIZE)
+        {
+            response[length++] = _pWire->read();
+        }
+        if (length == 0)
+            _stats.addBusError(); // The read request was not acknowledged
+        else if (response[0] != PENDING_STATUS_BYTE)
+        {
+            // A pending reply is not recorded, the replay polls again until the recorded reply is due.
+            // Only the status byte and the reply up to its NUL terminator are parsed, the rest of the read is padding.
+            size_t recordedLength = 1;
+            while (response[0] == SUCCESS_STATUS_BYTE && recordedLength < length && response[recordedLength - 1] != '\0')
+                recordedLength++;
+            busRecorder.record(BUS_CHANNEL_ATLAS, _i2cAddress, response, recordedLength);
+        }
+    }
+    _stats.addBytesReceived(length);
 
-    if (!_pWire->available())
+    if (length == 0)
     {
-        _nextPollDue = millis() + NB_POLL_INTERVAL_MS;
+        _lastPollTime = systemClock.getMillis();
+        _pollDelay = NB_POLL_INTERVAL_MS;
         return _status;
     }
 
-    uint8_t statusByte = _pWire->read();
+    uint8_t statusByte = response[0];
     size_t i = 0;
-    while (_pWire->available() && i < RESPONSE_BUFFER_SIZE - 1)
+    while (i + 1 < length && i < RESPONSE_BUFFER_SIZE - 1)
     {
-        buf[i++] = (char)_pWire->read();
+        buf[i] = (char)response[i + 1];
+        i++;
     }
     buf[i] = '\0';
 
@@ -95,22 +127,28 @@ eAtlasStatus AtlasBase::pollOnce()
         {
             _lastValue = 0.0;
             _state = ST_ERROR;
+            _stats.addParseError();
             return _status = ATLAS_STATUS_PARSING_ERROR;
         }
+        _stats.addSuccess();
+        _stats.addLatency((uint32_t)(systemClock.readTime() - _cmdSentAtUs));
         _lastValue = val;
-        _lastCommTime = millis();
-        _lastReadyTime = millis();
+        _lastCommTime = systemClock.getMillis();
+        _lastReadyTime = _lastCommTime;
         _state = ST_IDLE;
         return _status = ATLAS_STATUS_OK;
     }
     else if (statusByte == PENDING_STATUS_BYTE || statusByte == FAILED_STATUS_BYTE)
     {
-        _nextPollDue = millis() + NB_POLL_INTERVAL_MS;
+        _stats.addRetry();
+        _lastPollTime = systemClock.getMillis();
+        _pollDelay = NB_POLL_INTERVAL_MS;
         return _status;
     }
     else
     {
         _state = ST_ERROR;
+        _stats.addDeviceError();
         return _status = ATLAS_STATUS_DEVICE_ERROR;
     }
 }
@@ -121,7 +159,7 @@ eAtlasStatus AtlasBase::pollOnce()
  */
 unsigned long AtlasBase::getAgeMs() const
 {
-    return _lastReadyTime == 0 ? (unsigned long)0xFFFFFFFF : millis() - _lastReadyTime;
+    return _lastReadyTime == 0 ? (unsigned long)0xFFFFFFFF : systemClock.getMillis() - _lastReadyTime;
 }
 
 /**
@@ -137,8 +175,8 @@ void AtlasBase::ClearI2CBuffer()
 
 /**
  * @brief Clean a response string from the Atlas device, extracting the numeric value.
- * @param buf The raw response string from the device.
- * @return float The cleaned number containing the numeric value.
+ * @param buf The raw response string from the device, without the status byte.
+ * @return float The cleaned number containing the numeric value, 0 if there is none.
  */
 float AtlasBase::cleanString(const char *buf)
 {
@@ -160,6 +198,13 @@ float AtlasBase::cleanString(const char *buf)
  */
 eAtlasStatus AtlasBase::writeI2C(const char *payload, size_t len, bool nullTerminate)
 {
+    // The replies come from the recorder, the device may not be there (native replay)
+    if (busRecorder.isReplaying())
+    {
+        _stats.addBytesSent(nullTerminate ? len + 1 : len);
+        return _status = ATLAS_STATUS_OK;
+    }
+
     _pWire->beginTransmission(_i2cAddress);
 
     for (size_t i = 0; i < len; ++i)
@@ -167,9 +212,13 @@ eAtlasStatus AtlasBase::writeI2C(const char *payload, size_t len, bool nullTermi
 
     if (nullTerminate)
         _pWire->write((uint8_t)0x00);
+    _stats.addBytesSent(nullTerminate ? len + 1 : len);
 
     if (_pWire->endTransmission() != 0)
+    {
+        _stats.addBusError();
         return _status = ATLAS_STATUS_FAILED_TO_SEND_REQUEST;
+    }
 
     return _status = ATLAS_STATUS_OK;
 }
\ No newline at end of file
@@ -110,9 +110,13 @@ eO2SensorStatus O2Sensor::writeData(uint8_t reg, uint8_t *data, uint8_t len)
     _pWire->write(reg);
     for (uint8_t i = 0; i < len; i++)
         _pWire->write(data[i]);
+    stats.addBytesSent(len + 1);
 
     if (_pWire->endTransmission() != 0)
+    {
+        stats.addBusError();
         return this->status = O2_SENSOR_STATUS_FAILED_TO_SEND_REQUEST;
+    }
 
     return this->status = O2_SENSOR_STATUS_OK;
 }
@@ -126,23 +130,48 @@ eO2SensorStatus O2Sensor::writeData(uint8_t reg, uint8_t *data, uint8_t len)
  */
 eO2SensorStatus O2Sensor::readData(uint8_t reg, uint8_t *data, uint8_t len)
 {
+    if (busRecorder.isReplaying())
+    {
+        if (busRecorder.replay(BUS_CHANNEL_O2_SENSOR, reg, data, len) != len)
+            return this->status = O2_SENSOR_STATUS_INVALID_RESPONSE;
+        stats.addRequest();
+        stats.addSuccess();
+        return this->status = O2_SENSOR_STATUS_OK;
+    }
+
     uint8_t i = 0;
+    uint64_t requestTime = systemClock.readTime();
     _pWire->beginTransmission(I2C_ADDRESS);
     _pWire->write(reg);
+    stats.addRequest();
+    stats.addBytesSent(1);
     if (_pWire->endTransmission() != 0)
+    {
+        stats.addBusError();
         return this->status = O2_SENSOR_STATUS_FAILED_TO_SEND_REQUEST;
+    }
 
     uint8_t bytesReceived = _pWire->requestFrom(I2C_ADDRESS, len);
+    stats.addBytesReceived(bytesReceived);
     if (bytesReceived != len)
+    {
+        stats.addBusError();
         return this->status = O2_SENSOR_STATUS_INVALID_RESPONSE;
+    }
 
-    unsigned long startTime = millis();
+    unsigned long startTime = systemClock.readMillis();
     while (_pWire->available())
     {
         data[i++] = _pWire->read();
-        if (millis() - startTime > 100)
+        if (systemClock.readMillis() - startTime > 100)
+        {
+            stats.addTimeout();
             return this->status = O2_SENSOR_STATUS_TIMEOUT_EXCEEDED;
+        }
     }
 
+    busRecorder.record(BUS_CHANNEL_O2_SENSOR, reg, data, len);
+    stats.addSuccess();
+    stats.addLatency((uint32_t)(systemClock.readTime() - requestTime));
     return this->status = O2_SENSOR_STATUS_OK;
 }
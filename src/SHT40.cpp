@@ -65,29 +65,52 @@ eSHT40Status SHT40::fetchData()
     if (!this->isInit)
         return SHT40_STATUS_NOT_INITIALISED;
 
-    this->i2cBus->beginTransmission(SHT40_ADDR);
-    this->i2cBus->write(SHT40_REQ_TEMP);
-    uint8_t ret = this->i2cBus->endTransmission();
-    if (ret != I2C_COMMUNICATION_SUCCESS)
-        return SHT40_STATUS_FAILED_TO_SEND_REQUEST;
+    memset(rxBuffer, 0, SHT40_RSP_SIZE);
+    uint64_t requestTime = systemClock.readTime();
+    if (busRecorder.isReplaying())
+    {
+        if (busRecorder.replay(BUS_CHANNEL_SHT40, SHT40_ADDR, rxBuffer, SHT40_RSP_SIZE) != SHT40_RSP_SIZE)
+            return SHT40_STATUS_WRONG_MSG_LENGTH;
+        this->stats.addRequest();
+    }
+    else
+    {
+        this->i2cBus->beginTransmission(SHT40_ADDR);
+        this->i2cBus->write(SHT40_REQ_TEMP);
+        uint8_t ret = this->i2cBus->endTransmission();
+        this->stats.addRequest();
+        this->stats.addBytesSent(1);
+        if (ret != I2C_COMMUNICATION_SUCCESS)
+        {
+            this->stats.addBusError();
+            return SHT40_STATUS_FAILED_TO_SEND_REQUEST;
+        }
 
-    delay(I2C_READ_DELAY);
+        delay(I2C_READ_DELAY);
 
-    size_t recv = this->i2cBus->requestFrom(SHT40_ADDR, SHT40_RSP_SIZE);
-    if (recv != SHT40_RSP_SIZE)
-        return SHT40_STATUS_WRONG_MSG_LENGTH;
+        size_t recv = this->i2cBus->requestFrom(SHT40_ADDR, SHT40_RSP_SIZE);
+        this->stats.addBytesReceived(recv);
+        if (recv != SHT40_RSP_SIZE)
+        {
+            this->stats.addBusError();
+            return SHT40_STATUS_WRONG_MSG_LENGTH;
+        }
 
-    // read msg
-    memset(rxBuffer, 0, SHT40_RSP_SIZE);
-    for (uint8_t i = 0; i < SHT40_RSP_SIZE; i++)
-    {
-        rxBuffer[i] = this->i2cBus->read();
+        // read msg
+        for (uint8_t i = 0; i < SHT40_RSP_SIZE; i++)
+        {
+            rxBuffer[i] = this->i2cBus->read();
+        }
+        busRecorder.record(BUS_CHANNEL_SHT40, SHT40_ADDR, rxBuffer, SHT40_RSP_SIZE);
     }
 
     // Check CRC
     if (rxBuffer[INDEX_CRC_TEMPERATURE] != crc8((&(rxBuffer[INDEX_TEMPERATURE])), RAW_TEMPERATURE_SIZE) ||
         rxBuffer[INDEX_CRC_HUMIDITY] != crc8((&(rxBuffer[INDEX_HUMIDITY])), RAW_HUMIDITY_SIZE))
+    {
+        this->stats.addCrcError();
         return SHT40_STATUS_INVALID_CRC;
+    }
 
     // Convert data
     float rawTemp = (((uint16_t)(rxBuffer[INDEX_TEMPERATURE])) << NB_BITS_IN_BYTE) + ((uint16_t)rxBuffer[INDEX_TEMPERATURE + 1]);
@@ -96,6 +119,8 @@ eSHT40Status SHT40::fetchData()
     this->temperature = -45 + 175 * rawTemp / 65535; // Calculation from datasheet
     this->humidity = -6 + 125 * rawHumidity / 65535; // Calculation from datasheet
 
+    this->stats.addSuccess();
+    this->stats.addLatency((uint32_t)(systemClock.readTime() - requestTime));
     return SHT40_STATUS_OK;
 }
 
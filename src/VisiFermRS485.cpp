@@ -13,11 +13,12 @@ VisiFermRS485::VisiFermRS485(uint8_t rxPin,
       _addr(deviceAddress),
       _pollState(POLL_IDLE),
       _status(VISIFERM_STATUS_NOT_INITIALISED),
+      _oxygen(0.0),
+      _temperature(0.0),
       _rxLen(0),
       _waitStartMs(0),
-      _lastReadTime(0),
-      _oxygen(0.0),
-      _temperature(0.0)
+      _requestStartUs(0),
+      _lastReadTime(0)
 {
 }
 
@@ -43,7 +44,7 @@ eVisiFermStatus VisiFermRS485::begin()
  */
 eVisiFermStatus VisiFermRS485::update()
 {
-    uint32_t now = millis();
+    unsigned long now = systemClock.getMillis();
 
     if (_pollState == POLL_WAIT_DO || _pollState == POLL_WAIT_TEMP)
     {
@@ -51,9 +52,13 @@ eVisiFermStatus VisiFermRS485::update()
         {
             // full frame in _rxBuf
             float parsedValue = 0.0;
+            eVisiFermStatus frameStatus = decodeFrame(_rxBuf, _rxLen, parsedValue);
 
-            if (parseData(_rxBuf, _rxLen, parsedValue))
+            if (frameStatus == VISIFERM_STATUS_OK)
             {
+                _stats.addSuccess();
+                _stats.addLatency((uint32_t)(systemClock.readTime() - _requestStartUs));
+
                 if (_pollState == POLL_WAIT_DO)
                 {
                     _oxygen = parsedValue;
@@ -68,6 +73,17 @@ eVisiFermStatus VisiFermRS485::update()
                 _status = VISIFERM_STATUS_OK;
                 _lastReadTime = now;
             }
+            else
+            {
+                // A bad frame ends the exchange with the timeout
+                _status = frameStatus;
+                if (frameStatus == VISIFERM_STATUS_CRC_ERROR)
+                    _stats.addCrcError();
+                else if (frameStatus == VISIFERM_STATUS_SENSOR_STATUS_ERROR)
+                    _stats.addDeviceError();
+                else
+                    _stats.addParseError();
+            }
 
             _rxLen = 0;
             return _status;
@@ -76,6 +92,10 @@ eVisiFermStatus VisiFermRS485::update()
         // timeout
         if (now - _waitStartMs > RESPONSE_TIMEOUT_MS)
         {
+            // The exchanges that failed on a bad frame were already counted
+            if (_status == VISIFERM_STATUS_WAITING_RESPONSE || _status == VISIFERM_STATUS_OK)
+                _stats.addTimeout();
+
             _pollState = POLL_IDLE;
             _rxLen = 0;
             _status = VISIFERM_STATUS_TIMEOUT;
@@ -103,7 +123,7 @@ void VisiFermRS485::sendReadDO()
     cleanSerialBuffer();
     sendReadRegisters(REG_PMC1, REG_BLOCK_LEN);
     _pollState = POLL_WAIT_DO;
-    _waitStartMs = millis();
+    _waitStartMs = systemClock.getMillis();
 }
 
 /**
@@ -114,19 +134,41 @@ void VisiFermRS485::sendReadTemp()
     cleanSerialBuffer();
     sendReadRegisters(REG_PMC6, REG_BLOCK_LEN);
     _pollState = POLL_WAIT_TEMP;
-    _waitStartMs = millis();
+    _waitStartMs = systemClock.getMillis();
 }
 
 /**
  * @brief Send a Modbus read request to the sensor.
  */
 void VisiFermRS485::sendReadRegisters(uint16_t reg, uint16_t count)
+{
+    uint8_t frame[MODBUS_READ_REGISTER_MSG_LEN];
+    encodeReadRegisters(_addr, reg, count, frame);
+
+    // drive RS485 TX
+    _serial.write(frame, MODBUS_READ_REGISTER_MSG_LEN);
+    _serial.flush();
+    _stats.addRequest();
+    _stats.addBytesSent(MODBUS_READ_REGISTER_MSG_LEN);
+    _requestStartUs = systemClock.readTime();
+
+    // prepare RX
+    _rxLen = 0;
+}
+
+/**
+ * @brief Build a Modbus read holding registers request.
+ * @param deviceAddress Modbus address of the sensor.
+ * @param reg First register, as numbered in the manual (1-based).
+ * @param count Number of registers.
+ * @param frame Output, MODBUS_READ_REGISTER_MSG_LEN bytes.
+ */
+void VisiFermRS485::encodeReadRegisters(uint8_t deviceAddress, uint16_t reg, uint16_t count, uint8_t *frame)
 {
     // Manual addresses start at 1. Modbus frame needs startAddr-1.
     uint16_t startAddr = reg - 1;
 
-    uint8_t frame[MODBUS_READ_REGISTER_MSG_LEN];
-    frame[0] = _addr;                                                        // device address
+    frame[0] = deviceAddress;                                                // device address
     frame[1] = MODBUS_FUNC_READ_HOLDING;                                     // function code 0x03
     frame[2] = (startAddr >> 8) & 0xFF;                                      // start address high
     frame[3] = (startAddr) & 0xFF;                                           // start address low
@@ -135,13 +177,6 @@ void VisiFermRS485::sendReadRegisters(uint16_t reg, uint16_t count)
     uint16_t crc = modbusCRC(frame, MODBUS_READ_REGISTER_MSG_LEN - CRC_LEN); // CRC over first 6 bytes
     frame[6] = crc & 0xFF;                                                   // CRC low
     frame[7] = (crc >> 8) & 0xFF;                                            // CRC high
-
-    // drive RS485 TX
-    _serial.write(frame, MODBUS_READ_REGISTER_MSG_LEN);
-    _serial.flush();
-
-    // prepare RX
-    _rxLen = 0;
 }
 
 /**
@@ -150,9 +185,19 @@ void VisiFermRS485::sendReadRegisters(uint16_t reg, uint16_t count)
  */
 bool VisiFermRS485::tryReadFrame()
 {
-    while (_serial.available() && _rxLen < sizeof(_rxBuf))
+    if (busRecorder.isReplaying())
     {
-        _rxBuf[_rxLen++] = _serial.read();
+        // A recorded frame is always complete
+        _rxLen = busRecorder.replay(BUS_CHANNEL_VISIFERM, _addr, _rxBuf, sizeof(_rxBuf));
+        _stats.addBytesReceived(_rxLen);
+    }
+    else
+    {
+        while (_serial.available() && _rxLen < sizeof(_rxBuf))
+        {
+            _rxBuf[_rxLen++] = _serial.read();
+            _stats.addBytesReceived(1);
+        }
     }
 
     if (_rxLen < MIN_MSG_LEN)
@@ -165,59 +210,47 @@ bool VisiFermRS485::tryReadFrame()
     if (_rxLen < expectedLen)
         return false;
 
-    // check CRC
-    uint16_t frameCRC = (_rxBuf[expectedLen - 1] << 8) | _rxBuf[expectedLen - CRC_LEN];
-    uint16_t calcCRC = modbusCRC(_rxBuf, expectedLen - CRC_LEN);
-    if (frameCRC != calcCRC)
-    {
-        _status = VISIFERM_STATUS_CRC_ERROR;
-        return true; // we have a frame, but bad
-    }
-
+    busRecorder.record(BUS_CHANNEL_VISIFERM, _addr, _rxBuf, _rxLen);
     return true;
 }
 
 /**
- * @brief Parsing logic for Primary Measurement Channel frames.
- * @return True if parsing was successful, false on error.
+ * @brief Check and decode a Primary Measurement Channel response, without any side effect.
+ * @param frame Bytes received, starting with the address.
+ * @param len Number of bytes, the bytes after the frame are ignored.
+ * @param outValue Measured value, only set when the frame is valid.
+ * @return VISIFERM_STATUS_OK, VISIFERM_STATUS_CRC_ERROR, VISIFERM_STATUS_BAD_FRAME (incomplete, not a read response)
+ * or VISIFERM_STATUS_SENSOR_STATUS_ERROR.
  */
-bool VisiFermRS485::parseData(const uint8_t *frame, uint16_t len, float &outValue)
+eVisiFermStatus VisiFermRS485::decodeFrame(const uint8_t *frame, uint16_t len, float &outValue)
 {
     if (len < MIN_MSG_LEN)
-    {
-        _status = VISIFERM_STATUS_BAD_FRAME;
-        return false;
-    }
-
-    if (frame[1] != MODBUS_FUNC_READ_HOLDING)
-    {
-        _status = VISIFERM_STATUS_BAD_FRAME;
-        return false;
-    }
+        return VISIFERM_STATUS_BAD_FRAME;
 
+    // [0]=addr, [1]=func, [2]=byteCount (should be 0x14 = 20), [3..] data, [end-2..end-1]=crc
     uint8_t byteCount = frame[2];
-    if (byteCount < DATA_LEN || len < (uint16_t)(byteCount + MIN_MSG_LEN))
-    {
-        _status = VISIFERM_STATUS_BAD_FRAME;
-        return false;
-    }
+    uint16_t expectedLen = byteCount + MIN_MSG_LEN;
+    if (len < expectedLen)
+        return VISIFERM_STATUS_BAD_FRAME;
 
-    const uint8_t *data = &frame[3]; // data block (expected 20 bytes)
+    uint16_t frameCRC = (frame[expectedLen - 1] << 8) | frame[expectedLen - CRC_LEN];
+    if (frameCRC != modbusCRC(frame, expectedLen - CRC_LEN))
+        return VISIFERM_STATUS_CRC_ERROR;
 
-    // Reg3/Reg4 = value (float, LSW first)
-    outValue = modbusToFloat(&data[4]);
+    if (frame[1] != MODBUS_FUNC_READ_HOLDING || byteCount < DATA_LEN)
+        return VISIFERM_STATUS_BAD_FRAME;
+
+    const uint8_t *data = &frame[3]; // data block (expected 20 bytes)
 
-    // Reg5/Reg6 = measurement status
+    // Reg5/Reg6 = measurement status, the sensor reports a warning/error in the measurement
     uint16_t statusLo = (uint16_t)data[8] << 8 | data[9];
     uint16_t statusHi = (uint16_t)data[10] << 8 | data[11];
     if (statusLo != 0 || statusHi != 0)
-    {
-        // sensor reports warning/error in measurement
-        _status = VISIFERM_STATUS_SENSOR_STATUS_ERROR;
-        return false;
-    }
+        return VISIFERM_STATUS_SENSOR_STATUS_ERROR;
 
-    return true;
+    // Reg3/Reg4 = value (float, LSW first)
+    outValue = modbusToFloat(&data[4]);
+    return VISIFERM_STATUS_OK;
 }
 
 /**
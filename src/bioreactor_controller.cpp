@@ -4,34 +4,69 @@
 SHT40 sht40(&Wire);
 GMP251 co2Sensor(RS485_RX_PIN, RS485_TX_PIN, RS485_DE_PIN, Serial1);
 O2Sensor o2Sensor;
-DriveTmc5041 driveStepper1(&SPI, SPI_CS_DRV_1_PIN);
-DriveTmc5041 driveStepper3(&SPI, SPI_CS_DRV_3_PIN);
-StepperMotor approvPump(&driveStepper1, MOTOR_1);
-StepperMotor cultureChamberPump2(&driveStepper1, MOTOR_2);
-StepperMotor cultureChamberPump1(&driveStepper3, MOTOR_1);
-StepperMotor circulationPump(&driveStepper3, MOTOR_2);
+PumpRegistry pumpRegistry(&SPI);
 SSR_Relay heater(HEATER_PIN);
 IOExpander ioExpander(&Wire);
 TemperatureController temperatureController;
 PressureChamberController pressureChamber;
+PhController phController;
+DoController doController;
 VisiFermRS485 dissolvedOxygenSensor(RS485_2_RX_PIN, RS485_2_TX_PIN, Serial2);
 AtlasPHSensor pHSensor(&Wire);
 AtlasTempSensor tempSensor(&Wire);
 LimitSwitch limitSwitch(LIMIT_SWITCH_PIN);
 LedI2C ledI2C(&Wire);
 Preferences bioreactorParameter;
+PressureSensor pressureSensor(PRESSURE_SENSOR_PIN);
+VisiFermSensorInput dissolvedOxygenInput("DO", dissolvedOxygenSensor);
+AtlasSensorInput pHInput("pH", pHSensor);
+AtlasSensorInput waterTemperatureInput("WaterTemp", tempSensor);
+Sht40SensorInput airInput("Air", sht40);
+Gmp251SensorInput co2Input("CO2", co2Sensor);
+O2SensorInput o2Input("O2", o2Sensor);
+PressureSensorInput pressureInput("Pressure", pressureSensor);
+SensorManager sensorManager;
+SafetyInterlock safetyInterlock(LIMIT_SWITCH_PIN, pumpRegistry.getPumps(), PUMP_COUNT, heater, ioExpander, pressureSensor);
+RecipeEngine recipeEngine;
+static_assert(RECIPE_PUMP_COUNT <= PUMP_COUNT, "The recipe steps set the first pumps");
 
 // Global variables
 eBioreactorState bioreactorState = eBioreactorState::TEST;
 unsigned long lastTemperatureControllerTime = 0;
 unsigned long lastPressureChamberControllerTime = 0;
 unsigned long lastPressureChamberControllerTimePrint = 0;
+unsigned long lastGasObserverTime = 0;
+unsigned long lastPhControllerTime = 0;
+unsigned long lastDoControllerTime = 0;
+int8_t phBasePumpIndex = NO_PUMP;
 unsigned long lastPrintTime = 0;
 unsigned long lastLEDUpdateTime = 0;
+uint8_t lastInterlockTrips = 0;
 uint8_t lastLEDState = 0;
-unsigned long lastMotorSetSpeedTime = 0;
 uint8_t testState = 0;
 unsigned long stateTimer;
+int8_t temperatureHeartbeat = NO_HEARTBEAT;
+int8_t gasHeartbeat = NO_HEARTBEAT;
+int8_t telemetryHeartbeat = NO_HEARTBEAT;
+unsigned long lastPhaseSaveTime = 0;
+unsigned long phaseDosingTimeout = 0;
+unsigned long firstTemperatureControlTime = 0;
+unsigned long firstGasControlTime = 0;
+bool isFirstControlCycleReported = false;
+bool isRecipeStepStarted = false;
+
+/**
+ * @brief Progress of the current state, kept in the RTC memory that is not cleared by a reset.
+ */
+typedef struct
+{
+    uint32_t magic;   // PHASE_RECORD_MAGIC when the record was written by this firmware
+    uint8_t state;    // eBioreactorState
+    uint32_t elapsed; // ms since the start of the state
+} sPhaseRecord;
+
+static constexpr uint32_t PHASE_RECORD_MAGIC = 0x50484153; // "PHAS"
+static RTC_NOINIT_ATTR sPhaseRecord phaseRecord;
 
 /**
  * @brief Call the "begin" of every objects in the bioreactor controller.
@@ -39,24 +74,43 @@ unsigned long stateTimer;
 void beginBioreactorController()
 {
     ioExpander.begin(); // Initialize the IO Expander first to ensure a short delay before turning the valves and fans off
+    heater.begin();
+
+    // The sensors are started first, their first measurements then run on each bus while the rest is initialized
+    pressureSensor.begin();
     sht40.begin();
     co2Sensor.begin();
     o2Sensor.begin();
     dissolvedOxygenSensor.begin();
     pHSensor.begin();
     tempSensor.begin();
-    heater.begin();
+
+    // Sensors polled by updateSensors()
+    sensorManager.addSensor(SENSOR_ID_DISSOLVED_OXYGEN, &dissolvedOxygenInput);
+    sensorManager.addSensor(SENSOR_ID_PH, &pHInput);
+    sensorManager.addSensor(SENSOR_ID_WATER_TEMPERATURE, &waterTemperatureInput);
+    sensorManager.addSensor(SENSOR_ID_AIR, &airInput);
+    sensorManager.addSensor(SENSOR_ID_CO2, &co2Input);
+    sensorManager.addSensor(SENSOR_ID_O2, &o2Input);
+    sensorManager.addSensor(SENSOR_ID_PRESSURE, &pressureInput);
+    sensorManager.begin(systemClock.getMillis());
+    sensorManager.update(systemClock.getMillis()); // Sends the first request on each bus
+
     limitSwitch.begin();
 
     // Pumps
     SPI.begin();
-    driveStepper1.begin();
-    driveStepper3.begin();
-    approvPump.begin();
-    circulationPump.begin();
-    cultureChamberPump1.begin();
-    cultureChamberPump2.begin();
+    pumpRegistry.begin();
     beginBioreactorPreferences();
+
+    // After the actuators it cuts
+    if (!safetyInterlock.begin())
+        Serial.println("> Safety interlock not started");
+
+    // Subsystems supervised by the watchdog, the sensors are registered by the sensor manager
+    temperatureHeartbeat = registerHeartbeat("Temperature", CONTROLLER_HEARTBEAT_DEADLINE);
+    gasHeartbeat = registerHeartbeat("Gas", CONTROLLER_HEARTBEAT_DEADLINE);
+    telemetryHeartbeat = registerHeartbeat("Telemetry", CONTROLLER_HEARTBEAT_DEADLINE);
 }
 
 /**
@@ -74,10 +128,126 @@ void setBioreactorState(uint8_t state_int)
 
     bioreactorState = state;
     bioreactorParameter.putShort("state", (int16_t)state);
-    stateTimer = millis();
+    bioreactorParameter.putULong("elapsed", 0);
+    stateTimer = systemClock.getMillis();
+    lastPhaseSaveTime = systemClock.getMillis();
+    startPhaseDosing(0);
+    isRecipeStepStarted = false;
+    if (state == eBioreactorState::RECIPE)
+    {
+        recipeEngine.start();
+        bioreactorParameter.putBytes("recipepos", &recipeEngine.getPosition(), sizeof(sRecipePosition));
+    }
     return;
 }
 
+/**
+ * @brief Restore the time elapsed in the saved state, so a reset does not restart a timed phase.
+ *
+ * The RTC memory holds the progress of the last loop but does not survive a power loss, the NVS holds the progress
+ * saved every PHASE_SAVE_INTERVAL. The most recent valid one is used.
+ */
+void restorePhaseProgress()
+{
+    unsigned long elapsed = bioreactorParameter.getULong("elapsed", 0);
+
+    esp_reset_reason_t reason = esp_reset_reason();
+    bool isPhaseRecordValid = reason != ESP_RST_POWERON && phaseRecord.magic == PHASE_RECORD_MAGIC &&
+                              phaseRecord.state == (uint8_t)bioreactorState && phaseRecord.elapsed >= elapsed;
+    if (isPhaseRecordValid)
+        elapsed = phaseRecord.elapsed;
+
+    stateTimer = systemClock.getMillis() - elapsed;
+    lastPhaseSaveTime = systemClock.getMillis();
+    Serial.println("> Restored State: " + String(static_cast<int>(bioreactorState)) + ", elapsed (s): " + String(elapsed / 1000));
+    startPhaseDosing(elapsed);
+
+    // In a recipe the elapsed time is the one of the current step
+    sRecipePosition position;
+    if (bioreactorState == eBioreactorState::RECIPE && bioreactorParameter.getBytesLength("recipepos") == sizeof(position))
+    {
+        bioreactorParameter.getBytes("recipepos", &position, sizeof(position));
+        if (!recipeEngine.restore(position))
+            stateTimer = systemClock.getMillis();
+    }
+}
+
+/**
+ * @brief Start the volume moved by the approv pump in the current state, if the state has one.
+ * @param elapsed Time already spent in the state (ms), the volume moved meanwhile at the nominal flow is deducted.
+ */
+void startPhaseDosing(unsigned long elapsed)
+{
+    float volume = 0.0;
+    float flow = 0.0;
+    switch (bioreactorState)
+    {
+    case eBioreactorState::APPROV:
+        volume = APPROV_VOLUME;
+        flow = APPROV_FLOW;
+        break;
+    case eBioreactorState::SAMPLING:
+        volume = SAMPLING_VOLUME;
+        flow = SAMPLING_FLOW;
+        break;
+    default:
+        // Also the volume of a recipe step, any pump
+        for (uint8_t i = 0; i < PUMP_COUNT; i++)
+        {
+            if (getPump(i)->isDispensing())
+                getPump(i)->stop();
+        }
+        return;
+    }
+
+    // After a reset the volume moved before is only known from the elapsed time
+    float duration = fabsf(volume) / flow * MINUTE;
+    float remainingRatio = max(0.0f, 1.0f - elapsed / duration);
+    phaseDosingTimeout = elapsed + (unsigned long)(duration * DOSING_TIMEOUT_FACTOR);
+    getPump(PUMP_ID_APPROV)->dispense(volume * remainingRatio, flow);
+}
+
+/**
+ * @brief Check if the volume of the current state is moved, or if it takes too long.
+ * @return true when the state can end.
+ */
+bool isPhaseDosingComplete()
+{
+    StepperMotor *approvPump = getPump(PUMP_ID_APPROV);
+    bool isComplete = approvPump->isDispenseComplete();
+    if (!isComplete && systemClock.getMillis() - stateTimer > phaseDosingTimeout)
+    {
+        Serial.println("> Dosing timeout, volume not reached");
+        isComplete = true;
+    }
+
+    if (isComplete)
+    {
+        float volume = 0.0;
+        approvPump->getDispensedVolume(volume);
+        Serial.println("> Dosed Volume (ml): " + String(volume));
+    }
+    return isComplete;
+}
+
+/**
+ * @brief Save the time elapsed in the current state. Must be called in the main loop.
+ */
+void updatePhaseProgress()
+{
+    unsigned long elapsed = systemClock.getMillis() - stateTimer;
+    phaseRecord.magic = PHASE_RECORD_MAGIC;
+    phaseRecord.state = (uint8_t)bioreactorState;
+    phaseRecord.elapsed = elapsed;
+
+    // The short and untimed phases (IDLE resets its timer every loop) are not written to the flash
+    if (systemClock.getMillis() - lastPhaseSaveTime > PHASE_SAVE_INTERVAL && elapsed > PHASE_SAVE_INTERVAL)
+    {
+        lastPhaseSaveTime = systemClock.getMillis();
+        bioreactorParameter.putULong("elapsed", elapsed);
+    }
+}
+
 /**
  * @brief Get all the culture parameter from memory
  */
@@ -97,9 +267,226 @@ void beginBioreactorPreferences()
     pressureChamber.setReferenceLevel(O2, dioxyg);
 
     // ph
+    phController.setReferencePh(ph);
+    phController.setNominalCo2Level(co2);
+    // A saved index may be a circuit pump, accepted by an older firmware
+    phBasePumpIndex = bioreactorParameter.getChar("phbasepump", NO_PUMP);
+    if (!isDosingPump(phBasePumpIndex))
+        phBasePumpIndex = NO_PUMP;
+    phController.setBaseEnabled(phBasePumpIndex != NO_PUMP);
     // oxy_dissous
+    doController.setO2Limits(bioreactorParameter.getFloat("doo2min", 21.0), bioreactorParameter.getFloat("doo2max", 95.0));
+    doController.setReferenceDo(oxyDissous);
+    doController.setNominalO2Level(dioxyg);
     bioreactorState = state;
     // pump
+    for (uint8_t i = 0; i < PUMP_COUNT; i++)
+        getPump(i)->getCalibration().load(bioreactorParameter, getPumpCalibrationKey(i).c_str());
+    recipeEngine.load(bioreactorParameter, "recipe");
+    restorePhaseProgress();
+}
+
+/**
+ * @brief Get a pump from its index in the commands.
+ * @param index ePumpId of the pump, 0: approv, 1: circulation, 2: culture chamber 1, 3: culture chamber 2
+ * @return The pump, nullptr if the index is not below PUMP_COUNT.
+ */
+StepperMotor *getPump(uint8_t index)
+{
+    return pumpRegistry.getPump(index);
+}
+
+/**
+ * @brief Get the preferences key of the flow calibration of a pump.
+ * @param index Index of the pump, see getPump().
+ */
+String getPumpCalibrationKey(uint8_t index)
+{
+    return "pumpcal" + String(index);
+}
+
+/**
+ * @brief End the current phase if a pump is occluded or runs dry. Must be called in the main loop.
+ *
+ * A pinched tube or an empty supply would otherwise run until the end of the phase without moving any liquid.
+ */
+void checkPumpEvents()
+{
+    for (uint8_t i = 0; i < PUMP_COUNT; i++)
+    {
+        StepperMotor *pump = getPump(i);
+        ePumpEvent event = pump->getEvent();
+        if (event == PUMP_EVENT_NONE)
+            continue;
+
+        pump->clearEvent();
+        String eventName = event == PUMP_EVENT_OCCLUSION ? "occlusion" : "dry run";
+        Serial.println("> Pump " + String(i) + " " + eventName + ", load: " + String(pump->getLoad()));
+        if (bioreactorState != eBioreactorState::IDLE)
+        {
+            setBioreactorState((uint8_t)eBioreactorState::IDLE);
+            Serial.println("> Phase stopped, Bioreactor State set to IDLE");
+        }
+    }
+}
+
+/**
+ * @brief Report the trips of the safety interlock and resume the pumps once the door is closed. Must be called in the
+ * main loop.
+ */
+void updateSafetyInterlock()
+{
+    static const char *const INTERLOCK_NAMES[INTERLOCK_MAX] = {"door open", "over temperature", "over pressure"};
+
+    uint8_t trips = safetyInterlock.getTrips();
+    for (uint8_t i = 0; i < INTERLOCK_MAX; i++)
+    {
+        uint8_t bit = 1 << i;
+        if ((trips & bit) && !(lastInterlockTrips & bit))
+        {
+            sInterlockStats stats = safetyInterlock.getStats((eInterlock)i);
+            Serial.println("> Interlock " + String(INTERLOCK_NAMES[i]) + " tripped, reaction (us): " + String(stats.lastLatency) + ", max (us): " + String(stats.maxLatency));
+        }
+        else if (!(trips & bit) && (lastInterlockTrips & bit))
+        {
+            Serial.println("> Interlock " + String(INTERLOCK_NAMES[i]) + " cleared");
+            if (i == INTERLOCK_DOOR_OPEN)
+            {
+                for (uint8_t j = 0; j < PUMP_COUNT; j++)
+                    getPump(j)->resume();
+            }
+        }
+    }
+    lastInterlockTrips = trips;
+}
+
+/**
+ * @brief Execute the current instruction of the uploaded recipe. Must be called in the main loop in the RECIPE state.
+ *
+ * stateTimer is the start of the current step, so a step resumes after a reset like a timed state.
+ */
+void updateRecipe()
+{
+    const sRecipeInstruction *instruction = recipeEngine.getInstruction();
+    if (instruction == nullptr)
+    {
+        Serial.println("> Recipe complete");
+        setBioreactorState((uint8_t)eBioreactorState::IDLE);
+        return;
+    }
+
+    // A loop or an end instruction takes one call, the position is saved at the next step
+    if (instruction->opcode != RECIPE_OP_STEP)
+    {
+        recipeEngine.next();
+        return;
+    }
+
+    if (!isRecipeStepStarted)
+        startRecipeStep(*instruction, systemClock.getMillis() - stateTimer);
+    applyRecipeStep(*instruction);
+
+    if (isRecipeStepComplete(*instruction))
+    {
+        recipeEngine.next();
+        saveRecipePosition();
+    }
+}
+
+/**
+ * @brief Start the volume of a step, if it has a volume exit.
+ * @param step The current step.
+ * @param elapsed Time already spent in the step (ms), the volume moved meanwhile at the nominal flow is deducted.
+ */
+void startRecipeStep(const sRecipeInstruction &step, unsigned long elapsed)
+{
+    isRecipeStepStarted = true;
+    Serial.println("> Recipe Step: " + String(recipeEngine.getPosition().programCounter));
+    if (step.exit != RECIPE_EXIT_VOLUME)
+        return;
+
+    float flow = fabsf(step.pumpSpeeds[step.exitSource]);
+    float duration = fabsf(step.threshold) / flow * MINUTE;
+    float remainingRatio = max(0.0f, 1.0f - elapsed / duration);
+    getPump(step.exitSource)->dispense(step.threshold * remainingRatio, flow);
+}
+
+/**
+ * @brief Set the actuators of a step.
+ * @param step The current step, the pump of a volume exit is left to its volume.
+ */
+void applyRecipeStep(const sRecipeInstruction &step)
+{
+    // The pumps after the ones of the recipe are stopped
+    float speeds[PUMP_COUNT] = {OFF};
+    for (uint8_t i = 0; i < RECIPE_PUMP_COUNT; i++)
+        speeds[i] = step.exit == RECIPE_EXIT_VOLUME && step.exitSource == i ? OFF : step.pumpSpeeds[i];
+
+    setFansState(RecipeEngine::isOutputOn(step, RECIPE_OUTPUT_HEATER_FAN), RecipeEngine::isOutputOn(step, RECIPE_OUTPUT_CIRCULATION_FAN),
+                 RecipeEngine::isOutputOn(step, RECIPE_OUTPUT_RIGHT_FAN), RecipeEngine::isOutputOn(step, RECIPE_OUTPUT_LEFT_FAN),
+                 RecipeEngine::isOutputOn(step, RECIPE_OUTPUT_PCB_FAN), RecipeEngine::isOutputOn(step, RECIPE_OUTPUT_LOW_VOLT_FAN),
+                 RecipeEngine::isOutputOn(step, RECIPE_OUTPUT_HIGH_VOLT_FAN));
+    pumpRegistry.setSpeeds(speeds, systemClock.getMillis());
+    setValvesState(RecipeEngine::isOutputOn(step, RECIPE_OUTPUT_SUPPLY_VALVE), RecipeEngine::isOutputOn(step, RECIPE_OUTPUT_CIRCULATION_VALVE),
+                   RecipeEngine::isOutputOn(step, RECIPE_OUTPUT_RETURN_VALVE));
+    setPressureChamberState(RecipeEngine::isOutputOn(step, RECIPE_OUTPUT_PRESSURE_CHAMBER));
+    setHeatersState(RecipeEngine::isOutputOn(step, RECIPE_OUTPUT_HEATER));
+}
+
+/**
+ * @brief Check the exit condition of a step, its duration is the timeout of the volume and sensor exits.
+ * @param step The current step.
+ * @return true when the step can end.
+ */
+bool isRecipeStepComplete(const sRecipeInstruction &step)
+{
+    bool isTimeout = systemClock.getMillis() - stateTimer >= step.duration * 1000UL;
+    bool isComplete = false;
+    switch (step.exit)
+    {
+    case RECIPE_EXIT_TIME:
+        return isTimeout;
+    case RECIPE_EXIT_VOLUME:
+    {
+        StepperMotor *pump = getPump(step.exitSource);
+        isComplete = pump->isDispenseComplete();
+        if (isComplete || isTimeout)
+        {
+            float volume = 0.0;
+            pump->getDispensedVolume(volume);
+            pump->stop();
+            Serial.println("> Dosed Volume (ml): " + String(volume));
+        }
+        break;
+    }
+    default:
+    {
+        // A sensor without a valid value does not end the step, the timeout does
+        eSensorId id = (eSensorId)step.exitSource;
+        if (sensorManager.getQuality(id, systemClock.getMillis()) == SENSOR_QUALITY_OK)
+        {
+            float value = sensorManager.getValue(id, step.exitIndex);
+            isComplete = step.exit == RECIPE_EXIT_SENSOR_ABOVE ? value > step.threshold : value < step.threshold;
+        }
+        break;
+    }
+    }
+
+    if (!isComplete && isTimeout)
+        Serial.println("> Recipe step timeout, exit condition not reached");
+    return isComplete || isTimeout;
+}
+
+/**
+ * @brief Save the position in the recipe and start the timer of the next step.
+ */
+void saveRecipePosition()
+{
+    bioreactorParameter.putBytes("recipepos", &recipeEngine.getPosition(), sizeof(sRecipePosition));
+    bioreactorParameter.putULong("elapsed", 0);
+    stateTimer = systemClock.getMillis();
+    lastPhaseSaveTime = systemClock.getMillis();
+    isRecipeStepStarted = false;
 }
 
 /**
@@ -144,6 +531,12 @@ void setValvesState(bool valveSupplyState, bool valveCirculationState, bool valv
  */
 void setPressureChamberValvesState(bool o2ValveState, bool co2ValveState, bool airValveState)
 {
+    if (safetyInterlock.isTripped(INTERLOCK_OVER_PRESSURE))
+    {
+        o2ValveState = false;
+        co2ValveState = false;
+        airValveState = false;
+    }
     ioExpander.setEfuse(EFUSE_VALVE_O2_INDEX, o2ValveState);
     ioExpander.setEfuse(EFUSE_VALVE_CO2_INDEX, co2ValveState);
     ioExpander.setEfuse(EFUSE_VALVE_AIR_INDEX, airValveState);
@@ -154,22 +547,17 @@ void setPressureChamberValvesState(bool o2ValveState, bool co2ValveState, bool a
  *
  * Speed is in float ml/min and +/- for direction
  *
- * @param approvPumpSpeed           Speed of the approv pump
- * @param circulationPumpSpeed           Speed of the sensor pump
- * @param cultureChamberPump1Speed  Speed of the culture chamber pump 1
- * @param cultureChamberPump2Speed  Speed of the culture chamber pump 2
+ * @param speeds Speed of the pumps to run, by ID (ex: {{PUMP_ID_CIRCULATION, 150.0}}), the other pumps are stopped
  */
-void setPumpsSpeed(float approvPumpSpeed, float circulationPumpSpeed, float cultureChamberPump1Speed, float cultureChamberPump2Speed)
+void setPumpsSpeed(std::initializer_list<sPumpSpeed> speeds)
 {
-    if (millis() - lastMotorSetSpeedTime > MOTOR_SET_SPEED_MSG_INTERVAL)
+    float pumpSpeeds[PUMP_COUNT] = {OFF};
+    for (const sPumpSpeed &speed : speeds)
     {
-        approvPump.setSpeed(approvPumpSpeed);
-        circulationPump.setSpeed(circulationPumpSpeed);
-        cultureChamberPump1.setSpeed(cultureChamberPump1Speed);
-        cultureChamberPump2.setSpeed(cultureChamberPump2Speed);
-
-        lastMotorSetSpeedTime = millis();
+        if (speed.id < PUMP_COUNT)
+            pumpSpeeds[speed.id] = speed.speed;
     }
+    pumpRegistry.setSpeeds(pumpSpeeds, systemClock.getMillis());
 }
 
 /**
@@ -179,7 +567,7 @@ void setPumpsSpeed(float approvPumpSpeed, float circulationPumpSpeed, float cult
  */
 void setHeatersState(bool heaterState)
 {
-    if (heaterState)
+    if (heaterState && !safetyInterlock.isTripped(INTERLOCK_OVER_TEMPERATURE))
         heater.setLevel(temperatureController.getHeaterPower());
     else
         heater.setLevel(OFF);
@@ -201,14 +589,23 @@ void updateTemperatureController()
 {
     heater.update();
 
-    if (millis() - lastTemperatureControllerTime > TEMPERATURE_CONTROLLER_UPDATE_INTERVAL)
+    if (systemClock.getMillis() - lastTemperatureControllerTime > TEMPERATURE_CONTROLLER_UPDATE_INTERVAL)
     {
-        lastTemperatureControllerTime = millis();
-        float airTemperature = 0;
-        sht40.getData(&airTemperature);
-        float waterTemperature = tempSensor.getTemperatureC();
+        lastTemperatureControllerTime = systemClock.getMillis();
+        float airTemperature = sensorManager.getValue(SENSOR_ID_AIR, 0);
+        float waterTemperature = sensorManager.getValue(SENSOR_ID_WATER_TEMPERATURE);
+        feedHeartbeat(temperatureHeartbeat);
+
+        // Wait for the first measurements, a NAN would stay in the integral terms
+        if (isnan(airTemperature) || isnan(waterTemperature))
+            return;
 
+        safetyInterlock.setTemperatures(waterTemperature, airTemperature);
         temperatureController.update(waterTemperature, airTemperature);
+        if (firstTemperatureControlTime == 0 &&
+            sensorManager.getQuality(SENSOR_ID_AIR, systemClock.getMillis()) == SENSOR_QUALITY_OK &&
+            sensorManager.getQuality(SENSOR_ID_WATER_TEMPERATURE, systemClock.getMillis()) == SENSOR_QUALITY_OK)
+            firstTemperatureControlTime = systemClock.getMillis();
     }
 }
 
@@ -217,30 +614,101 @@ void updateTemperatureController()
  */
 void updatePressureChamberController()
 {
-    if (millis() - lastPressureChamberControllerTime > PRESSURE_CHAMBER_CONTROLLER_UPDATE_INTERVAL)
+    // The observer follows the chamber composition between the slow sensor responses
+    if (systemClock.getMillis() - lastGasObserverTime > GAS_OBSERVER_UPDATE_INTERVAL)
+    {
+        lastGasObserverTime = systemClock.getMillis();
+        bool isO2New = sensorManager.hasNewSample(SENSOR_ID_O2);
+        bool isCo2New = sensorManager.hasNewSample(SENSOR_ID_CO2);
+        sSensorSample o2Sample = sensorManager.readSample(SENSOR_ID_O2, systemClock.getMillis());
+        sSensorSample co2Sample = sensorManager.readSample(SENSOR_ID_CO2, systemClock.getMillis());
+
+        pressureChamber.updateObserver(o2Sample.values[0], isO2New, co2Sample.values[0], isCo2New);
+        feedHeartbeat(gasHeartbeat);
+    }
+
+    if (systemClock.getMillis() - lastPressureChamberControllerTime > PRESSURE_CHAMBER_CONTROLLER_UPDATE_INTERVAL && pressureChamber.isEstimationReady())
     {
-        lastPressureChamberControllerTime = millis();
-        float o2Concentration = o2Sensor.getO2();
-        float co2Concentration = co2Sensor.getCO2();
-        float pressure = 25 * 6895; // 7.5 psi to Pa // TODO: get this value from the sensor
+        lastPressureChamberControllerTime = systemClock.getMillis();
+        float o2Concentration = pressureChamber.getEstimatedLevel(O2);
+        float co2Concentration = pressureChamber.getEstimatedLevel(CO2);
+        float pressure = (sensorManager.getQuality(SENSOR_ID_PRESSURE, systemClock.getMillis()) == SENSOR_QUALITY_OK) ? sensorManager.getValue(SENSOR_ID_PRESSURE) : NAN;
+        if (!isnan(pressure))
+            co2Sensor.setPressureCompensation((pressure + ATMOSPHERIC_PRESSURE) * PA_TO_HPA);
 
         pressureChamber.update(o2Concentration, co2Concentration, pressure);
+        if (firstGasControlTime == 0 && !isnan(pressure))
+            firstGasControlTime = systemClock.getMillis();
     }
 
     // // DEBUG: Print every second the O2 and CO2 concentration and the time since last update
-    // if (millis() - lastPressureChamberControllerTimePrint > 1000)
+    // if (systemClock.getMillis() - lastPressureChamberControllerTimePrint > 1000)
     // {
-    //     lastPressureChamberControllerTimePrint = millis();
+    //     lastPressureChamberControllerTimePrint = systemClock.getMillis();
     //     Serial.println(">o2Concentration: " + String(o2Sensor.getO2()));
     //     Serial.println(">co2Concentration: " + String(co2Sensor.getCO2()));
-    //     Serial.println(">Time since controller update: " + String(millis() - lastPressureChamberControllerTime));
+    //     Serial.println(">Time since controller update: " + String(systemClock.getMillis() - lastPressureChamberControllerTime));
     // }
 
     setPressureChamberValvesState(pressureChamber.getValveState(O2),
                                   pressureChamber.getValveState(CO2),
                                   pressureChamber.getValveState(AIR));
+}
+
+/**
+ * @brief Update the pH controller, it trims the CO2 reference of the pressure chamber. Must be called in the main loop.
+ */
+void updatePhController()
+{
+    if (systemClock.getMillis() - lastPhControllerTime <= PH_CONTROLLER_UPDATE_INTERVAL)
+        return;
+    lastPhControllerTime = systemClock.getMillis();
+
+    // The CO2 only acts on the pH while the chamber is regulated, the next culture starts from the nominal level
+    if (!pressureChamber.getPressureChamberState())
+    {
+        phController.reset();
+        pressureChamber.setReferenceLevel(CO2, phController.getCo2Level());
+        return;
+    }
+
+    if (!phController.update(pHSensor.getLastValue(), pHSensor.getAgeMs()))
+        return;
+    pressureChamber.setReferenceLevel(CO2, phController.getCo2Level());
+
+    float baseVolume = phController.getBasePulseVolume();
+    StepperMotor *basePump = phBasePumpIndex != NO_PUMP ? getPump(phBasePumpIndex) : nullptr;
+    if (baseVolume > 0.0 && basePump != nullptr && !basePump->isDispensing())
+    {
+        basePump->dispense(baseVolume, PH_BASE_PULSE_FLOW);
+        Serial.println("> Base Pulse (ml): " + String(baseVolume));
+    }
+}
+
+/**
+ * @brief Update the dissolved oxygen controller, it sets the O2 reference of the pressure chamber. Must be called in
+ * the main loop.
+ */
+void updateDoController()
+{
+    if (systemClock.getMillis() - lastDoControllerTime <= DO_CONTROLLER_UPDATE_INTERVAL)
+        return;
+    lastDoControllerTime = systemClock.getMillis();
+
+    // The O2 only reaches the medium while the chamber is regulated, the next culture starts from the nominal level
+    if (!pressureChamber.getPressureChamberState())
+    {
+        doController.reset();
+        pressureChamber.setReferenceLevel(O2, doController.getO2Level());
+        return;
+    }
 
-    co2Sensor.update();
+    if (sensorManager.getQuality(SENSOR_ID_DISSOLVED_OXYGEN, systemClock.getMillis()) != SENSOR_QUALITY_OK)
+        return;
+    float doLevel = sensorManager.getValue(SENSOR_ID_DISSOLVED_OXYGEN, 0);
+    unsigned long sampleAge = sensorManager.getSensor(SENSOR_ID_DISSOLVED_OXYGEN)->getAgeMs(systemClock.getMillis());
+    if (doController.update(doLevel, sampleAge))
+        pressureChamber.setReferenceLevel(O2, doController.getO2Level());
 }
 
 /**
@@ -250,27 +718,43 @@ void updatePressureChamberController()
  */
 void printBioreactorStateToSerial()
 {
-    if (millis() - lastPrintTime > PRINT_UPDATE_INTERVAL)
+    if (systemClock.getMillis() - lastPrintTime > PRINT_UPDATE_INTERVAL)
     {
+        sSensorSnapshot snapshot;
+        sensorManager.getSnapshot(snapshot, systemClock.getMillis());
+
         Serial.println("> Bioreactor State: " + String(static_cast<int>(bioreactorState)));
-        Serial.println("> DO Sensor (%sat): " + String(dissolvedOxygenSensor.getOxygen()));
-        Serial.println("> pH Sensor (pH): " + String(pHSensor.getPH()));
-        Serial.println("> Water Temperature (°C): " + String(tempSensor.getTemperatureC()));
-        Serial.println("> Air Temperature (°C): " + String(sht40.getLastTemperature()));
-        Serial.println("> Air Humidity (%RH): " + String(sht40.getLastHumidity()));
+        Serial.println("> DO Sensor (%sat): " + String(snapshot.samples[SENSOR_ID_DISSOLVED_OXYGEN].values[0]));
+        Serial.println("> pH Sensor (pH): " + String(snapshot.samples[SENSOR_ID_PH].values[0]));
+        Serial.println("> Water Temperature (°C): " + String(snapshot.samples[SENSOR_ID_WATER_TEMPERATURE].values[0]));
+        Serial.println("> Air Temperature (°C): " + String(snapshot.samples[SENSOR_ID_AIR].values[0]));
+        Serial.println("> Air Humidity (%RH): " + String(snapshot.samples[SENSOR_ID_AIR].values[1]));
         Serial.println("> Heater Power (%): " + String(temperatureController.getHeaterPower()));
-        Serial.println("> CO2 Concentration (ppm): " + String(co2Sensor.getCO2()));
-        Serial.println("> O2 Concentration (%): " + String(o2Sensor.getO2()));
+        Serial.println("> CO2 Concentration (ppm): " + String(snapshot.samples[SENSOR_ID_CO2].values[0]));
+        Serial.println("> O2 Concentration (%): " + String(snapshot.samples[SENSOR_ID_O2].values[0]));
+        Serial.println("> CO2 Estimation (ppm): " + String(pressureChamber.getEstimatedLevel(CO2)));
+        Serial.println("> O2 Estimation (%): " + String(pressureChamber.getEstimatedLevel(O2)));
+        Serial.println("> CO2 Reference From pH (ppm): " + String(phController.getCo2Level()));
+        Serial.println("> O2 Reference From DO (%): " + String(doController.getO2Level()));
+        Serial.println("> Chamber Pressure (Pa): " + String(snapshot.samples[SENSOR_ID_PRESSURE].values[0]));
         Serial.println("> O2 status: " + String(o2Sensor.getStatus()));
         Serial.println("> PH status: " + String(pHSensor.getStatus()));
         Serial.println("> Temperature culture status: " + String(tempSensor.getStatus()));
         Serial.println("> CO2 status: " + String(co2Sensor.getStatus()));
         Serial.println("> DO status: " + String(dissolvedOxygenSensor.getStatus()));
+        Serial.println("> Pressure status: " + String(pressureSensor.getStatus()));
+        if (!isFirstControlCycleReported && firstTemperatureControlTime != 0 && firstGasControlTime != 0)
+        {
+            // Time since the reset, both controllers ran with valid measurements
+            isFirstControlCycleReported = true;
+            Serial.println("> Time To First Control Cycle (ms): " + String(max(firstTemperatureControlTime, firstGasControlTime)));
+        }
 
         /* Add more prints here*/
 
         Serial.println("");
-        lastPrintTime = millis();
+        lastPrintTime = systemClock.getMillis();
+        feedHeartbeat(telemetryHeartbeat);
     }
 }
 
@@ -279,9 +763,7 @@ void printBioreactorStateToSerial()
  */
 void updateSensors()
 {
-    dissolvedOxygenSensor.update();
-    pHSensor.update();
-    tempSensor.update();
+    sensorManager.update(systemClock.getMillis());
 }
 
 /**
@@ -294,11 +776,15 @@ void updateLEDState()
     bool isDoorOpen = limitSwitch.getDoorState();
     eLedState ledState = isDoorOpen ? LED_STATE_DOOR_OPEN : LED_STATE_IDLE;
 
+    // The door has its own color, the other trips are errors
+    if (safetyInterlock.getTrips() & ~(1 << INTERLOCK_DOOR_OPEN))
+        ledState = LED_STATE_ERROR;
+
     // Update the LED at each change for fast response and at every LED_UPDATE_INTERVAL to ensure periodic updates
-    if (ledState != lastLEDState || (millis() - lastLEDUpdateTime) > LED_UPDATE_INTERVAL)
+    if (ledState != lastLEDState || (systemClock.getMillis() - lastLEDUpdateTime) > LED_UPDATE_INTERVAL)
     {
         lastLEDState = ledState;
         ledI2C.sendState(ledState);
-        lastLEDUpdateTime = millis();
+        lastLEDUpdateTime = systemClock.getMillis();
     }
 }
@@ -0,0 +1,257 @@
+#include "bus_recorder.h"
+
+BusRecorder busRecorder;
+
+/**
+ * @brief Constructor of the recorder, starts idle with an empty buffer.
+ */
+BusRecorder::BusRecorder()
+    : mode(BUS_RECORDER_IDLE),
+      head(0),
+      tail(0),
+      usedBytes(0),
+      recordCount(0),
+      droppedCount(0),
+      replayStartTime(0),
+      firstTimestamp(0),
+      lastTimestamp(0),
+      firstPendingOffset(0)
+{
+}
+
+/**
+ * @brief Clear the buffer and start recording the bus traffic.
+ */
+void BusRecorder::startCapture()
+{
+    clear();
+    this->mode = BUS_RECORDER_CAPTURING;
+}
+
+/**
+ * @brief Start feeding the recorded traffic to the drivers, from the oldest record.
+ * @return False if there is nothing to replay.
+ */
+bool BusRecorder::startReplay()
+{
+    if (this->recordCount == 0)
+        return false;
+
+    // Records can be replayed again
+    for (uint32_t offset = 0; offset < this->usedBytes; offset += getRecordSize(offset))
+    {
+        this->buffer[(this->tail + offset + CHANNEL_INDEX) % BUFFER_SIZE] &= ~REPLAYED_FLAG;
+        this->lastTimestamp = readTimestamp(offset);
+    }
+
+    this->firstTimestamp = readTimestamp(0);
+    this->firstPendingOffset = 0;
+    this->replayStartTime = systemClock.getMillis();
+    this->mode = BUS_RECORDER_REPLAYING;
+    return true;
+}
+
+/**
+ * @brief Stop the capture or the replay, the records are kept.
+ */
+void BusRecorder::stop()
+{
+    this->mode = BUS_RECORDER_IDLE;
+}
+
+/**
+ * @brief Remove all the records.
+ */
+void BusRecorder::clear()
+{
+    this->mode = BUS_RECORDER_IDLE;
+    this->head = 0;
+    this->tail = 0;
+    this->usedBytes = 0;
+    this->recordCount = 0;
+    this->droppedCount = 0;
+}
+
+/**
+ * @brief Ends the replay once every record was replayed. Must be called in the main loop.
+ */
+void BusRecorder::update()
+{
+    if (this->mode != BUS_RECORDER_REPLAYING)
+        return;
+
+    // Records of a driver that is not called anymore must not keep the replay running
+    if (this->firstPendingOffset >= this->usedBytes ||
+        systemClock.getMillis() - this->replayStartTime > this->lastTimestamp - this->firstTimestamp + REPLAY_END_TIMEOUT)
+    {
+        this->mode = BUS_RECORDER_IDLE;
+        Serial.println("Bus replay finished");
+    }
+}
+
+/**
+ * @brief Record data received on a bus. Does nothing if the capture is not running.
+ * @param channel The bus and driver that received the data.
+ * @param tag Identifies the device or the request when a channel has several (address, register...).
+ * @param data The raw bytes received.
+ * @param length The number of bytes, truncated to MAX_DATA_LENGTH.
+ */
+void BusRecorder::record(eBusChannel channel, uint8_t tag, const uint8_t *data, uint16_t length)
+{
+    if (this->mode != BUS_RECORDER_CAPTURING)
+        return;
+
+    if (length > MAX_DATA_LENGTH)
+        length = MAX_DATA_LENGTH;
+    appendRecord(systemClock.getMillis(), channel, tag, data, length);
+}
+
+/**
+ * @brief Get the next recorded data of a channel, once its time is reached in the replay.
+ * @param channel The bus and driver asking for data.
+ * @param tag Identifies the device or the request, must match the one given to record().
+ * @param data Output buffer for the recorded bytes.
+ * @param maxLength Size of the output buffer.
+ * @return The number of bytes copied, 0 if there is nothing to replay yet.
+ */
+uint16_t BusRecorder::replay(eBusChannel channel, uint8_t tag, uint8_t *data, uint16_t maxLength)
+{
+    if (this->mode != BUS_RECORDER_REPLAYING)
+        return 0;
+
+    uint32_t replayTime = systemClock.getMillis() - this->replayStartTime;
+    for (uint32_t offset = this->firstPendingOffset; offset < this->usedBytes; offset += getRecordSize(offset))
+    {
+        // The records are in chronological order, stop at the first one in the future
+        if (readTimestamp(offset) - this->firstTimestamp > replayTime)
+            break;
+
+        if (readByte(offset + CHANNEL_INDEX) != channel || readByte(offset + TAG_INDEX) != tag)
+            continue;
+
+        this->buffer[(this->tail + offset + CHANNEL_INDEX) % BUFFER_SIZE] |= REPLAYED_FLAG;
+        uint16_t length = min((uint16_t)readByte(offset + LENGTH_INDEX), maxLength);
+        for (uint16_t i = 0; i < length; i++)
+            data[i] = readByte(offset + HEADER_SIZE + i);
+
+        while (this->firstPendingOffset < this->usedBytes && (readByte(this->firstPendingOffset + CHANNEL_INDEX) & REPLAYED_FLAG))
+            this->firstPendingOffset += getRecordSize(this->firstPendingOffset);
+        return length;
+    }
+    return 0;
+}
+
+/**
+ * @brief Count the records already given to the drivers since the start of the replay.
+ * @return The number of replayed records, the others were not asked for by any driver (yet).
+ */
+uint16_t BusRecorder::getReplayedCount() const
+{
+    uint16_t count = 0;
+    for (uint32_t offset = 0; offset < this->usedBytes; offset += getRecordSize(offset))
+    {
+        if (readByte(offset + CHANNEL_INDEX) & REPLAYED_FLAG)
+            count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Print every record as a "REC=" line of hexadecimal bytes, the lines can be given back to load().
+ * @param output Where to print the records (ex: Serial).
+ */
+void BusRecorder::dump(Print &output) const
+{
+    char hex[3];
+    for (uint32_t offset = 0; offset < this->usedBytes; offset += getRecordSize(offset))
+    {
+        output.print("REC=");
+        uint32_t size = getRecordSize(offset);
+        for (uint32_t i = 0; i < size; i++)
+        {
+            uint8_t value = readByte(offset + i);
+            if (i == CHANNEL_INDEX)
+                value &= ~REPLAYED_FLAG;
+            snprintf(hex, sizeof(hex), "%02X", value);
+            output.print(hex);
+        }
+        output.println();
+    }
+    output.println("Bus records: " + String(this->recordCount) + ", dropped: " + String(this->droppedCount));
+}
+
+/**
+ * @brief Append one record printed by dump().
+ * @param line The hexadecimal bytes of the record, without the "REC=" prefix.
+ * @return False if the record is malformed or if the recorder is not idle.
+ */
+bool BusRecorder::load(const String &line)
+{
+    String hex = line;
+    hex.trim(); // The dump lines end with "\r\n"
+    if (this->mode != BUS_RECORDER_IDLE || hex.length() < HEADER_SIZE * 2 || hex.length() % 2 != 0)
+        return false;
+
+    uint8_t record[HEADER_SIZE + MAX_DATA_LENGTH];
+    uint16_t size = hex.length() / 2;
+    if (size > sizeof(record))
+        return false;
+
+    for (uint16_t i = 0; i < size; i++)
+    {
+        char byteString[3] = {hex[2 * i], hex[2 * i + 1], '\0'};
+        char *end = nullptr;
+        record[i] = strtoul(byteString, &end, 16);
+        if (end != &byteString[2])
+            return false;
+    }
+
+    if (record[LENGTH_INDEX] != size - HEADER_SIZE || record[CHANNEL_INDEX] >= BUS_CHANNEL_MAX)
+        return false;
+
+    uint32_t timestamp = record[0] | (record[1] << 8) | (record[2] << 16) | ((uint32_t)record[3] << 24);
+    appendRecord(timestamp, record[CHANNEL_INDEX], record[TAG_INDEX], &record[HEADER_SIZE], record[LENGTH_INDEX]);
+    return true;
+}
+
+/**
+ * @brief Write a record at the head of the ring buffer, dropping the oldest records if needed.
+ */
+void BusRecorder::appendRecord(uint32_t timestamp, uint8_t channel, uint8_t tag, const uint8_t *data, uint8_t length)
+{
+    uint32_t size = HEADER_SIZE + length;
+    while (this->usedBytes + size > BUFFER_SIZE)
+        dropOldestRecord();
+
+    uint8_t header[HEADER_SIZE] = {(uint8_t)timestamp, (uint8_t)(timestamp >> 8), (uint8_t)(timestamp >> 16), (uint8_t)(timestamp >> 24),
+                                   channel, tag, length};
+    for (uint8_t i = 0; i < HEADER_SIZE; i++)
+        this->buffer[(this->head + i) % BUFFER_SIZE] = header[i];
+    for (uint16_t i = 0; i < length; i++)
+        this->buffer[(this->head + HEADER_SIZE + i) % BUFFER_SIZE] = data[i];
+
+    this->head = (this->head + size) % BUFFER_SIZE;
+    this->usedBytes += size;
+    this->recordCount++;
+}
+
+/**
+ * @brief Remove the oldest record of the ring buffer.
+ */
+void BusRecorder::dropOldestRecord()
+{
+    uint32_t size = getRecordSize(0);
+    this->tail = (this->tail + size) % BUFFER_SIZE;
+    this->usedBytes -= size;
+    this->recordCount--;
+    this->droppedCount++;
+}
+
+/**
+ * @brief Read the timestamp of a record.
+ * @param offset Offset of the record from the tail.
+ */
+uint32_t BusRecorder::readTimestamp(uint32_t offset) const
+{
+    return readByte(offset) | (readByte(offset + 1) << 8) | (readByte(offset + 2) << 16) | ((uint32_t)readByte(offset + 3) << 24);
+}
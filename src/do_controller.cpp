@@ -0,0 +1,98 @@
+#include "do_controller.h"
+
+/**
+ * @brief Constructor to initialize the control loop parameters.
+ */
+DoController::DoController()
+    : doRef(100.0f),
+      nominalO2Level(85.0f),
+      o2Level(85.0f),
+      minO2Level(MIN_O2_LEVEL),
+      maxO2Level(MAX_O2_LEVEL),
+      integralTerm(0.0f),
+      lastSampleTime(0),
+      prevTime(0),
+      isStarted(false)
+{
+}
+
+/**
+ * @brief Updates the O2 level with the latest DO measurement.
+ * @param doLevel Measured dissolved oxygen (%sat).
+ * @param sampleAge Age of the measurement (ms).
+ * @return True if the measurement was used.
+ */
+bool DoController::update(float doLevel, unsigned long sampleAge)
+{
+    return update(doLevel, sampleAge, systemClock.getMillis());
+}
+
+/**
+ * @brief Updates the O2 level with the latest DO measurement at a given time.
+ * @param doLevel Measured dissolved oxygen (%sat).
+ * @param sampleAge Age of the measurement (ms).
+ * @param currentTime Time of the update (ms), allows to run the controller on a simulated time.
+ * @return True if the measurement was used, false if it is stale, invalid or already used.
+ */
+bool DoController::update(float doLevel, unsigned long sampleAge, unsigned long currentTime)
+{
+    unsigned long sampleTime = currentTime - sampleAge;
+    if (isnan(doLevel) || sampleAge > MAX_SAMPLE_AGE || sampleTime == this->lastSampleTime)
+        return false;
+    this->lastSampleTime = sampleTime;
+
+    // The first update only starts the integration time
+    bool isFirstUpdate = !this->isStarted;
+    float dt = (float)(currentTime - this->prevTime) / MILLIS_TO_SECONDS;
+    this->prevTime = currentTime;
+    this->isStarted = true;
+
+    // A positive error (not enough oxygen) needs more O2
+    float error = this->doRef - doLevel;
+    bool isSaturatedHigh = this->o2Level >= this->maxO2Level && error > 0.0f;
+    bool isSaturatedLow = this->o2Level <= this->minO2Level && error < 0.0f;
+    if (!isFirstUpdate && fabsf(error) > DO_DEAD_BAND && !isSaturatedHigh && !isSaturatedLow)
+        this->integralTerm += KI * error * dt;
+
+    // The integral alone never holds the reference beyond the limits
+    this->integralTerm = constrain(this->integralTerm, this->minO2Level - this->nominalO2Level, this->maxO2Level - this->nominalO2Level);
+    this->o2Level = constrain(this->nominalO2Level + KP * error + this->integralTerm, this->minO2Level, this->maxO2Level);
+    return true;
+}
+
+/**
+ * @brief Go back to the nominal O2 level, for a new culture.
+ */
+void DoController::reset()
+{
+    this->integralTerm = 0.0f;
+    this->isStarted = false;
+    this->o2Level = constrain(this->nominalO2Level, this->minO2Level, this->maxO2Level);
+}
+
+/**
+ * @brief Set the O2 level set by the user, the correction is kept.
+ * @param o2Level O2 level (%).
+ */
+void DoController::setNominalO2Level(float o2Level)
+{
+    this->nominalO2Level = o2Level;
+    this->o2Level = constrain(o2Level + this->integralTerm, this->minO2Level, this->maxO2Level);
+}
+
+/**
+ * @brief Set the range of the O2 reference.
+ * @param minLevel Lowest O2 reference (%).
+ * @param maxLevel Highest O2 reference (%).
+ * @return False if the range is invalid, the limits are then unchanged.
+ */
+bool DoController::setO2Limits(float minLevel, float maxLevel)
+{
+    if (isnan(minLevel) || isnan(maxLevel) || minLevel < 0.0f || maxLevel > 100.0f || minLevel >= maxLevel)
+        return false;
+
+    this->minO2Level = minLevel;
+    this->maxO2Level = maxLevel;
+    this->o2Level = constrain(this->o2Level, minLevel, maxLevel);
+    return true;
+}
@@ -0,0 +1,64 @@
+#include "driver_stats.h"
+
+/**
+ * @brief Constructor of the counters, all at zero.
+ */
+DriverStats::DriverStats()
+{
+    reset();
+}
+
+/**
+ * @brief Set all the counters back to zero.
+ */
+void DriverStats::reset()
+{
+    memset(&this->stats, 0, sizeof(this->stats));
+    this->stats.minLatency = UINT32_MAX;
+}
+
+/**
+ * @brief Add the response latency of a successful exchange.
+ * @param latency Time from the request to the valid response (µs).
+ */
+void DriverStats::addLatency(uint32_t latency)
+{
+    if (latency < this->stats.minLatency)
+        this->stats.minLatency = latency;
+    if (latency > this->stats.maxLatency)
+        this->stats.maxLatency = latency;
+    this->stats.totalLatency += latency;
+    this->stats.latencyCount++;
+}
+
+/**
+ * @brief Get the average response latency.
+ * @return Average latency (µs), 0 if no latency was measured.
+ */
+uint32_t DriverStats::getAverageLatency() const
+{
+    if (this->stats.latencyCount == 0)
+        return 0;
+    return this->stats.totalLatency / this->stats.latencyCount;
+}
+
+/**
+ * @brief Print the counters as comma separated values, in the order:
+ * requests,successes,timeouts,busErrors,crcErrors,parseErrors,deviceErrors,retries,minLatency,avgLatency,maxLatency,bytesSent,bytesReceived
+ * @param output Where to print the counters (ex: Serial).
+ */
+void DriverStats::print(Print &output) const
+{
+    uint32_t minLatency = this->stats.latencyCount == 0 ? 0 : this->stats.minLatency;
+    uint32_t counters[] = {this->stats.requests, this->stats.successes, this->stats.timeouts, this->stats.busErrors,
+                           this->stats.crcErrors, this->stats.parseErrors, this->stats.deviceErrors, this->stats.retries,
+                           minLatency, getAverageLatency(), this->stats.maxLatency,
+                           this->stats.bytesSent, this->stats.bytesReceived};
+    uint8_t counterCount = sizeof(counters) / sizeof(counters[0]);
+    for (uint8_t i = 0; i < counterCount; i++)
+    {
+        output.print(counters[i]);
+        if (i + 1 < counterCount)
+            output.print(',');
+    }
+}
@@ -1,4 +1,4 @@
-#include "Example.h"
+#include "example.h"
 
 /**
  * @brief Constructor to initialize the Example class
@@ -0,0 +1,146 @@
+#include "gas_composition_observer.h"
+
+/**
+ * @brief Constructor to initialize the observer. The estimation starts at the first sensor sample.
+ */
+GasCompositionObserver::GasCompositionObserver()
+    : o2({0.0f, 0.0f, {{0.0f, 0.0f}, {0.0f, 0.0f}}}),
+      co2({0.0f, 0.0f, {{0.0f, 0.0f}, {0.0f, 0.0f}}}),
+      isO2Initialized(false),
+      isCo2Initialized(false)
+{
+}
+
+/**
+ * @brief Prediction step of the observer. Must be called periodically, even when no valve was opened.
+ * @param dt Time elapsed since the last prediction (s).
+ * @param addedO2Volume Volume of O2 added to the chamber since the last prediction (L).
+ * @param addedCo2Volume Volume of CO2 added to the chamber since the last prediction (L).
+ * @param addedAirVolume Volume of air added to the chamber since the last prediction (L).
+ */
+void GasCompositionObserver::predict(float dt, float addedO2Volume, float addedCo2Volume, float addedAirVolume)
+{
+    if (dt <= 0.0f)
+        return;
+
+    float addedVolume = addedO2Volume + addedCo2Volume + addedAirVolume;
+
+    if (this->isO2Initialized)
+    {
+        float addedO2 = O2_IN_O2_TANK * addedO2Volume + O2_IN_AIR * addedAirVolume;
+        predictGas(this->o2, dt, addedVolume, addedO2, O2_SENSOR_TIME_CONSTANT, O2_PROCESS_NOISE);
+    }
+
+    if (this->isCo2Initialized)
+    {
+        float addedCo2 = CO2_IN_CO2_TANK * addedCo2Volume + CO2_IN_AIR * addedAirVolume;
+        predictGas(this->co2, dt, addedVolume, addedCo2, CO2_SENSOR_TIME_CONSTANT, CO2_PROCESS_NOISE);
+    }
+}
+
+/**
+ * @brief Correction step of the observer with a new O2 sensor sample.
+ * @param o2Concentration The O2 concentration read by the sensor (%).
+ */
+void GasCompositionObserver::correctO2(float o2Concentration)
+{
+    if (!this->isO2Initialized)
+    {
+        initGas(this->o2, o2Concentration, O2_MEASUREMENT_NOISE);
+        this->isO2Initialized = true;
+        return;
+    }
+
+    correctGas(this->o2, o2Concentration, O2_MEASUREMENT_NOISE);
+}
+
+/**
+ * @brief Correction step of the observer with a new CO2 sensor sample.
+ * @param co2Concentration The CO2 concentration read by the sensor (ppm).
+ */
+void GasCompositionObserver::correctCo2(float co2Concentration)
+{
+    if (!this->isCo2Initialized)
+    {
+        initGas(this->co2, co2Concentration, CO2_MEASUREMENT_NOISE);
+        this->isCo2Initialized = true;
+        return;
+    }
+
+    correctGas(this->co2, co2Concentration, CO2_MEASUREMENT_NOISE);
+}
+
+/**
+ * @brief Propagate the estimation of one gas.
+ *
+ * The gas added to the chamber is mixed with the gas already present: c = (c * V + addedGas) / (V + addedVolume).
+ * The sensor then follows the chamber concentration with a first order response: m += k * (c - m), k = 1 - exp(-dt / tau).
+ *
+ * @param gas The estimation to propagate.
+ * @param dt Time elapsed since the last prediction (s).
+ * @param addedVolume Total volume of gas added to the chamber (L).
+ * @param addedGas Quantity of this gas added to the chamber (concentration unit * L).
+ * @param sensorTimeConstant Time constant of the sensor response (s).
+ * @param processNoise Variance added to the chamber concentration per second.
+ */
+void GasCompositionObserver::predictGas(sGasEstimate &gas, float dt, float addedVolume, float addedGas, float sensorTimeConstant, float processNoise)
+{
+    float a = V / (V + addedVolume);
+    float k = 1.0f - expf(-dt / sensorTimeConstant);
+
+    gas.chamberLevel = a * gas.chamberLevel + addedGas / (V + addedVolume);
+    gas.sensorLevel += k * (gas.chamberLevel - gas.sensorLevel);
+
+    // P = F * P * F^T + Q with F = [[a, 0], [k * a, 1 - k]]
+    float f[2][2] = {{a, 0.0f}, {k * a, 1.0f - k}};
+    float fp[2][2];
+    for (uint8_t i = 0; i < 2; i++)
+        for (uint8_t j = 0; j < 2; j++)
+            fp[i][j] = f[i][0] * gas.p[0][j] + f[i][1] * gas.p[1][j];
+
+    for (uint8_t i = 0; i < 2; i++)
+        for (uint8_t j = 0; j < 2; j++)
+            gas.p[i][j] = fp[i][0] * f[j][0] + fp[i][1] * f[j][1];
+
+    gas.p[0][0] += processNoise * dt;
+}
+
+/**
+ * @brief Correct the estimation of one gas with a sensor sample (the sensor measures the lagged concentration).
+ * @param gas The estimation to correct.
+ * @param measurement The sensor sample.
+ * @param measurementNoise Variance of the sensor sample.
+ */
+void GasCompositionObserver::correctGas(sGasEstimate &gas, float measurement, float measurementNoise)
+{
+    // H = [0, 1]
+    float s = gas.p[1][1] + measurementNoise;
+    float k0 = gas.p[0][1] / s;
+    float k1 = gas.p[1][1] / s;
+    float innovation = measurement - gas.sensorLevel;
+
+    gas.chamberLevel += k0 * innovation;
+    gas.sensorLevel += k1 * innovation;
+
+    // P = (I - K * H) * P, row 1 of P is only modified last
+    gas.p[0][0] -= k0 * gas.p[1][0];
+    gas.p[0][1] -= k0 * gas.p[1][1];
+    gas.p[1][0] -= k1 * gas.p[1][0];
+    gas.p[1][1] -= k1 * gas.p[1][1];
+}
+
+/**
+ * @brief Initialize the estimation of one gas with its first sensor sample, assuming the chamber is at equilibrium.
+ * @param gas The estimation to initialize.
+ * @param measurement The first sensor sample.
+ * @param measurementNoise Variance of the sensor sample.
+ */
+void GasCompositionObserver::initGas(sGasEstimate &gas, float measurement, float measurementNoise)
+{
+    gas.chamberLevel = measurement;
+    gas.sensorLevel = measurement;
+    gas.p[0][0] = measurementNoise;
+    gas.p[0][1] = measurementNoise;
+    gas.p[1][0] = measurementNoise;
+    gas.p[1][1] = measurementNoise;
+}
@@ -0,0 +1,218 @@
+#include "gas_dosing_optimizer.h"
+#include "gas_composition_observer.h"
+
+constexpr double GasDosingOptimizer::GAS_COST[DOSING_VALVE_COUNT];
+
+/**
+ * @brief Composition of each gas supply (rows: O2 in %, CO2 in ppm; columns: O2, CO2 and air valves).
+ */
+static constexpr double SUPPLY_LEVEL[MIXTURE_GAS_COUNT][DOSING_VALVE_COUNT] = {
+    {GasCompositionObserver::O2_IN_O2_TANK, 0.0, GasCompositionObserver::O2_IN_AIR},
+    {0.0, GasCompositionObserver::CO2_IN_CO2_TANK, GasCompositionObserver::CO2_IN_AIR}};
+
+/**
+ * @brief Computes the volume of gas to add with each valve.
+ * @param problem The dosing problem to solve.
+ * @param volumes Output volumes to add with the O2, CO2 and air valves (L).
+ */
+void GasDosingOptimizer::solve(const sGasDosingProblem &problem, float volumes[DOSING_VALVE_COUNT]) const
+{
+    for (uint8_t i = 0; i < DOSING_VALVE_COUNT; i++)
+        volumes[i] = 0.0f;
+
+    // Linear form of the mixture model, each row is weighted by the tolerance of the gas
+    double a[MIXTURE_GAS_COUNT][DOSING_VALVE_COUNT];
+    double b[MIXTURE_GAS_COUNT];
+    for (uint8_t gas = 0; gas < MIXTURE_GAS_COUNT; gas++)
+    {
+        double weight = 1.0 / problem.tolerance[gas];
+        for (uint8_t valve = 0; valve < DOSING_VALVE_COUNT; valve++)
+            a[gas][valve] = (SUPPLY_LEVEL[gas][valve] - problem.reference[gas]) * weight;
+        b[gas] = (problem.reference[gas] - problem.level[gas]) * V * weight;
+    }
+
+    // Try every combination of active constraints and keep the feasible solution with the lowest cost.
+    // Adding nothing is always feasible and is the fallback.
+    double bestVolumes[DOSING_VALVE_COUNT] = {0.0, 0.0, 0.0};
+    double bestCost = cost(a, b, bestVolumes);
+
+    eBound bounds[DOSING_VALVE_COUNT];
+    for (uint8_t combination = 0; combination < eBound_MAX * eBound_MAX * eBound_MAX; combination++)
+    {
+        uint8_t code = combination;
+        for (uint8_t valve = 0; valve < DOSING_VALVE_COUNT; valve++)
+        {
+            bounds[valve] = static_cast<eBound>(code % eBound_MAX);
+            code /= eBound_MAX;
+        }
+
+        for (uint8_t isBudgetActive = 0; isBudgetActive < 2; isBudgetActive++)
+        {
+            double candidate[DOSING_VALVE_COUNT];
+            if (!solveActiveSet(a, b, problem, bounds, isBudgetActive, candidate))
+                continue;
+
+            double candidateCost = cost(a, b, candidate);
+            if (candidateCost < bestCost)
+            {
+                bestCost = candidateCost;
+                memcpy(bestVolumes, candidate, sizeof(bestVolumes));
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < DOSING_VALVE_COUNT; i++)
+        volumes[i] = static_cast<float>(bestVolumes[i]);
+}
+
+/**
+ * @brief Solves the problem for one combination of active constraints (KKT conditions).
+ * @param a Weighted mixture matrix.
+ * @param b Weighted mixture target.
+ * @param problem The dosing problem (bounds and budget).
+ * @param bounds The bound fixing each valve volume, or BOUND_FREE.
+ * @param isBudgetActive True if the total volume must be equal to the budget.
+ * @param volumes Output volumes.
+ * @return True if the solution exists and respects all the constraints.
+ */
+bool GasDosingOptimizer::solveActiveSet(const double a[MIXTURE_GAS_COUNT][DOSING_VALVE_COUNT], const double b[MIXTURE_GAS_COUNT],
+                                        const sGasDosingProblem &problem, const eBound bounds[DOSING_VALVE_COUNT], bool isBudgetActive,
+                                        double volumes[DOSING_VALVE_COUNT]) const
+{
+    uint8_t freeValves[DOSING_VALVE_COUNT];
+    uint8_t freeCount = 0;
+    double fixedVolume = 0.0;
+    for (uint8_t valve = 0; valve < DOSING_VALVE_COUNT; valve++)
+    {
+        volumes[valve] = (bounds[valve] == BOUND_UPPER) ? problem.maxVolume[valve] : 0.0;
+        fixedVolume += volumes[valve];
+        if (bounds[valve] == BOUND_FREE)
+            freeValves[freeCount++] = valve;
+    }
+
+    if (freeCount == 0 && isBudgetActive)
+        return false;
+
+    if (freeCount > 0)
+    {
+        // Target left for the free valves once the fixed ones are applied
+        double residual[MIXTURE_GAS_COUNT];
+        for (uint8_t gas = 0; gas < MIXTURE_GAS_COUNT; gas++)
+        {
+            residual[gas] = b[gas];
+            for (uint8_t valve = 0; valve < DOSING_VALVE_COUNT; valve++)
+                residual[gas] -= a[gas][valve] * volumes[valve];
+        }
+
+        // [A^T A + cost, 1; 1^T, 0] [v; mu] = [A^T residual; budget - fixed]
+        double m[DOSING_VALVE_COUNT + 1][DOSING_VALVE_COUNT + 2] = {};
+        uint8_t n = freeCount + (isBudgetActive ? 1 : 0);
+        for (uint8_t i = 0; i < freeCount; i++)
+        {
+            for (uint8_t j = 0; j < freeCount; j++)
+            {
+                for (uint8_t gas = 0; gas < MIXTURE_GAS_COUNT; gas++)
+                    m[i][j] += a[gas][freeValves[i]] * a[gas][freeValves[j]];
+            }
+            m[i][i] += GAS_COST[freeValves[i]];
+
+            for (uint8_t gas = 0; gas < MIXTURE_GAS_COUNT; gas++)
+                m[i][n] += a[gas][freeValves[i]] * residual[gas];
+
+            if (isBudgetActive)
+            {
+                m[i][freeCount] = 1.0;
+                m[freeCount][i] = 1.0;
+            }
+        }
+        if (isBudgetActive)
+            m[freeCount][n] = problem.volumeBudget - fixedVolume;
+
+        double x[DOSING_VALVE_COUNT + 1];
+        if (!solveLinearSystem(m, n, x))
+            return false;
+
+        for (uint8_t i = 0; i < freeCount; i++)
+            volumes[freeValves[i]] = x[i];
+    }
+
+    double totalVolume = 0.0;
+    for (uint8_t valve = 0; valve < DOSING_VALVE_COUNT; valve++)
+    {
+        if (volumes[valve] < -FEASIBILITY_TOLERANCE || volumes[valve] > problem.maxVolume[valve] + FEASIBILITY_TOLERANCE)
+            return false;
+        volumes[valve] = constrain(volumes[valve], 0.0, (double)problem.maxVolume[valve]);
+        totalVolume += volumes[valve];
+    }
+
+    return totalVolume <= problem.volumeBudget + FEASIBILITY_TOLERANCE;
+}
+
+/**
+ * @brief Cost of a solution: weighted squared error left after dosing plus the cost of the gas used.
+ */
+double GasDosingOptimizer::cost(const double a[MIXTURE_GAS_COUNT][DOSING_VALVE_COUNT], const double b[MIXTURE_GAS_COUNT],
+                                const double volumes[DOSING_VALVE_COUNT]) const
+{
+    double total = 0.0;
+    for (uint8_t gas = 0; gas < MIXTURE_GAS_COUNT; gas++)
+    {
+        double error = -b[gas];
+        for (uint8_t valve = 0; valve < DOSING_VALVE_COUNT; valve++)
+            error += a[gas][valve] * volumes[valve];
+        total += error * error;
+    }
+
+    for (uint8_t valve = 0; valve < DOSING_VALVE_COUNT; valve++)
+        total += GAS_COST[valve] * volumes[valve] * volumes[valve];
+
+    return total;
+}
+
+/**
+ * @brief Solves a small linear system with Gaussian elimination and partial pivoting.
+ * @param m Augmented matrix of the system, the right hand side is in column n.
+ * @param n Size of the system.
+ * @param x Output solution.
+ * @return False if the system is singular.
+ */
+bool GasDosingOptimizer::solveLinearSystem(double m[][DOSING_VALVE_COUNT + 2], uint8_t n, double x[])
+{
+    for (uint8_t col = 0; col < n; col++)
+    {
+        uint8_t pivot = col;
+        for (uint8_t row = col + 1; row < n; row++)
+        {
+            if (fabs(m[row][col]) > fabs(m[pivot][col]))
+                pivot = row;
+        }
+        if (fabs(m[pivot][col]) < PIVOT_TOLERANCE)
+            return false;
+
+        if (pivot != col)
+        {
+            for (uint8_t k = 0; k <= n; k++)
+            {
+                double tmp = m[col][k];
+                m[col][k] = m[pivot][k];
+                m[pivot][k] = tmp;
+            }
+        }
+
+        for (uint8_t row = col + 1; row < n; row++)
+        {
+            double factor = m[row][col] / m[col][col];
+            for (uint8_t k = col; k <= n; k++)
+                m[row][k] -= factor * m[col][k];
+        }
+    }
+
+    for (int8_t row = n - 1; row >= 0; row--)
+    {
+        double sum = m[row][n];
+        for (uint8_t k = row + 1; k < n; k++)
+            sum -= m[row][k] * x[k];
+        x[row] = sum / m[row][row];
+    }
+    return true;
+}
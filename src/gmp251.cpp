@@ -8,7 +8,8 @@
  * @param serial The HardwareSerial object for communication.
  */
 GMP251::GMP251(uint8_t rxPin, uint8_t txPin, uint8_t dePin, HardwareSerial &serial)
-    : _rxPin(rxPin), _txPin(txPin), _dePin(dePin), _serial(serial), co2(0), lastReadTime(0), status(GMP_251_STATUS_NOT_INITIALISED) {}
+    : _serial(serial), _rxPin(rxPin), _txPin(txPin), _dePin(dePin), lastReadTime(0), lastSampleTime(0), status(GMP_251_STATUS_NOT_INITIALISED), co2(0),
+      compensationPressure(0), isCompensationPending(false), requestTime(0) {}
 
 /**
  * @brief Initializes RS-485 communication and forces serial mode.
@@ -24,9 +25,10 @@ eGMP251Status GMP251::begin()
 
 eGMP251Status GMP251::update()
 {
-    if (millis() - this->lastReadTime >= READ_INTERVAL_MS)
+    unsigned long now = systemClock.getMillis();
+    if (now - this->lastReadTime >= READ_INTERVAL_MS)
     {
-        this->lastReadTime = millis();
+        this->lastReadTime = now;
 
         if (this->status == GMP_251_STATUS_NOT_INITIALISED || this->status == GMP_251_STATUS_PARSING_FAILED)
         {
@@ -47,7 +49,8 @@ void GMP251::forceSerialMode()
     // Verify connection
     // The send is done after the read to remove the need for a delay between the two.
     String response = readResponse();
-    sendCommand("send");
+    requestMeasurement();
+    this->stats.addRetry();
 
     if (response.isEmpty())
         this->status = GMP_251_STATUS_NOT_INITIALISED;
@@ -66,6 +69,7 @@ void GMP251::sendCarriageReturns()
         _serial.print("\r");
     }
     _serial.flush();
+    this->stats.addBytesSent(NUM_CARRIAGE_RETURNS);
     digitalWrite(_dePin, LOW); // Switch to RX mode
 }
 
@@ -80,6 +84,17 @@ void GMP251::sendCommand(const String &command)
     _serial.print(command + "\r");
     _serial.flush();
     digitalWrite(_dePin, LOW);
+    this->stats.addBytesSent(command.length() + 1);
+}
+
+/**
+ * @brief Sends a measurement request, the response is read at the next update.
+ */
+void GMP251::requestMeasurement()
+{
+    sendCommand("send");
+    this->requestTime = systemClock.readTime();
+    this->stats.addRequest();
 }
 
 /**
@@ -88,11 +103,25 @@ void GMP251::sendCommand(const String &command)
 String GMP251::readResponse()
 {
     String response = "";
+    if (busRecorder.isReplaying())
+    {
+        uint8_t recorded[BusRecorder::MAX_DATA_LENGTH];
+        uint16_t length = busRecorder.replay(BUS_CHANNEL_GMP251, 0, recorded, sizeof(recorded));
+        for (uint16_t i = 0; i < length; i++)
+            response += (char)recorded[i];
+        this->stats.addBytesReceived(length);
+        return response;
+    }
+
     while (_serial.available())
     {
         char c = _serial.read();
         response += c;
     }
+
+    this->stats.addBytesReceived(response.length());
+    if (!response.isEmpty())
+        busRecorder.record(BUS_CHANNEL_GMP251, 0, (const uint8_t *)response.c_str(), response.length());
     return response;
 }
 
@@ -102,21 +131,56 @@ String GMP251::readResponse()
 eGMP251Status GMP251::parseCO2()
 {
     String response = readResponse();
-    sendCommand("send"); // Request CO₂ data
+    uint32_t latency = (uint32_t)(systemClock.readTime() - this->requestTime);
+    if (this->isCompensationPending)
+    {
+        // Sent between two measurements so the reply does not mix with the CO₂ data
+        this->isCompensationPending = false;
+        sendCommand("env xpres " + String(this->compensationPressure));
+    }
+    requestMeasurement(); // Request CO₂ data
+
+    float value = 0;
+    this->status = parseResponse(response, value);
+    if (this->status != GMP_251_STATUS_OK)
+    {
+        if (response.isEmpty())
+            this->stats.addTimeout();
+        else
+            this->stats.addParseError();
+        return this->status;
+    }
 
+    this->co2 = value;
+    this->lastSampleTime = systemClock.getMillis();
+    this->stats.addSuccess();
+    this->stats.addLatency(latency); // Bounded by the update interval, the response is only read at the next update
+    return this->status;
+}
+
+/**
+ * @brief Extract the CO₂ concentration from a response to "send", without any side effect.
+ * @param response The text received, ex: "CO2=    412.3 ppm\r\n".
+ * @param co2 Output, CO₂ concentration in ppm, only set on success.
+ * @return GMP_251_STATUS_OK, GMP_251_STATUS_PARSING_FAILED if there is no "CO2=...ppm" field or
+ * GMP_251_STATUS_PARSING_NOT_A_NUMBER if the sensor printed stars (measurement not ready).
+ */
+eGMP251Status GMP251::parseResponse(const String &response, float &co2)
+{
     int start = response.indexOf("CO2=");
     int end = response.indexOf("ppm", start);
 
     if (start == -1 || end == -1)
-        return this->status = GMP_251_STATUS_PARSING_FAILED;
+        return GMP_251_STATUS_PARSING_FAILED;
 
     String co2Value = response.substring(start + CO2_STRING_LENGTH, end);
 
-    if (!isDigit(co2Value[co2Value.length() - 2]))
-        return this->status = GMP_251_STATUS_PARSING_NOT_A_NUMBER;
+    // The value is followed by a space
+    if (co2Value.length() < 2 || !isDigit(co2Value[co2Value.length() - 2]))
+        return GMP_251_STATUS_PARSING_NOT_A_NUMBER;
 
-    this->co2 = co2Value.toFloat();
-    return this->status = GMP_251_STATUS_OK;
+    co2 = co2Value.toFloat();
+    return GMP_251_STATUS_OK;
 }
 
 /**
@@ -174,6 +238,20 @@ void GMP251::calibratePressure(float pressure)
     sendCommand("env xpres " + String(pressure));
 }
 
+/**
+ * @brief Updates the pressure used by the sensor compensation without blocking the measurements.
+ * @param pressure The absolute pressure of the measured gas in hPa.
+ * @note The value is sent before the next measurement request, only if it changed significantly.
+ */
+void GMP251::setPressureCompensation(float pressure)
+{
+    if (fabsf(pressure - this->compensationPressure) < COMPENSATION_PRESSURE_THRESHOLD)
+        return;
+
+    this->compensationPressure = pressure;
+    this->isCompensationPending = true;
+}
+
 /**
  * @brief Calibrates the oxygen sensor.
  * @param oxygen The reference oxygen concentration in %.
@@ -6,7 +6,8 @@
  * @param pWire Pointer to the I²C interface (SDA/SCL)
  */
 IOExpander::IOExpander(TwoWire *pWire)
-    : _pWire(pWire)
+    : _pWire(pWire),
+      _lock(nullptr)
 {
 }
 
@@ -38,6 +39,8 @@ bool IOExpander::writeBytes(uint8_t reg, const uint8_t *data, size_t len) const
 bool IOExpander::begin()
 {
     _pWire->begin();
+    if (_lock == nullptr)
+        _lock = xSemaphoreCreateMutex();
 
     uint8_t cfg[IOE_PORT_BYTES] = {CONFIG_OUTPUT_MODE, CONFIG_OUTPUT_MODE, CONFIG_OUTPUT_MODE};
     // Configure all 24 IOs as outputs (default after power-on is inputs)
@@ -73,14 +76,53 @@ void IOExpander::setEfuse(uint8_t channel, bool outputState)
     uint8_t port = channel / 8;
     uint8_t bit  = channel % 8;
 
-    if (outputState)
+    if (_lock != nullptr)
+        xSemaphoreTake(_lock, portMAX_DELAY);
+
+    if (outputState && !(_inhibited[port] & (1U << bit)))
     {
         _outputs[port] |= static_cast<uint8_t>(1U << bit);   // ON -> bit = 1
     }
     else
     {
-        _outputs[port] &= static_cast<uint8_t>(~(1U << bit)); // OFF -> bit = 0
+        _outputs[port] &= static_cast<uint8_t>(~(1U << bit)); // OFF or inhibited -> bit = 0
     }
 
     writeBytes(IOE_REG_OUTPUT, _outputs, IOE_PORT_BYTES);
+
+    if (_lock != nullptr)
+        xSemaphoreGive(_lock);
+}
+
+/**
+ * @brief Latch an output off, or release it. The output stays off after the release until setEfuse() turns it on.
+ * @param channel Output index (0–23).
+ * @param isInhibited True to cut the output at once and keep it off.
+ */
+void IOExpander::setInhibited(uint8_t channel, bool isInhibited)
+{
+    if (channel >= OUTPUT_COUNT)
+    {
+        return;
+    }
+
+    uint8_t port = channel / 8;
+    uint8_t bit  = channel % 8;
+
+    if (_lock != nullptr)
+        xSemaphoreTake(_lock, portMAX_DELAY);
+
+    if (isInhibited)
+    {
+        _inhibited[port] |= static_cast<uint8_t>(1U << bit);
+        _outputs[port] &= static_cast<uint8_t>(~(1U << bit));
+        writeBytes(IOE_REG_OUTPUT, _outputs, IOE_PORT_BYTES);
+    }
+    else
+    {
+        _inhibited[port] &= static_cast<uint8_t>(~(1U << bit));
+    }
+
+    if (_lock != nullptr)
+        xSemaphoreGive(_lock);
 }
@@ -2,47 +2,50 @@
 
 void setup()
 {
+    systemClock.tick();
     Serial.begin(SERIAL_BAUDRATE);
     Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN);
     Serial.println("Hello, World!");
+    reportLastReset(Serial);
 
-    beginBioreactorController();
-    stateTimer = millis();
+    beginBioreactorController(); // Restores the state and its elapsed time
     initWatchDog();
 }
 
 void loop()
 {
+    systemClock.tick(); // The time of this loop, read by all the stages
+    beginLoopStage(LOOP_STAGE_STATE_MACHINE);
     switch (bioreactorState)
     {
     case eBioreactorState::IDLE:
         setFansState(OFF, OFF, OFF, OFF, OFF, OFF, OFF);
-        setPumpsSpeed(OFF, OFF, OFF, OFF);
+        setPumpsSpeed({});
         setValvesState(CLOSE, CLOSE, CLOSE);
         setPressureChamberValvesState(OFF, OFF, OFF);
         setHeatersState(OFF);
-        stateTimer = millis();
+        stateTimer = systemClock.getMillis();
         // switch when user command received
         break;
     case eBioreactorState::APPROV:
         // start when user send command
         setFansState(OFF, OFF, ON, ON, ON, ON, ON);
-        setPumpsSpeed(220.0, OFF, OFF, OFF);
+        setPumpsSpeed({}); // The approv pump moves APPROV_VOLUME, started by setBioreactorState()
         setValvesState(OPEN, CLOSE, CLOSE);
         setPressureChamberState(OFF);
         setHeatersState(OFF);
 
-        // switch after 5 min to PREPARE
-        if (millis() - stateTimer > 5 * MINUTE)
+        // switch to PREPARE once the volume is supplied
+        if (isPhaseDosingComplete())
         {
             setBioreactorState((uint8_t)eBioreactorState::PREPARE);
-            stateTimer = millis();
+            stateTimer = systemClock.getMillis();
         }
         break;
     case eBioreactorState::PREPARE:
         // start when approv is finished
         setFansState(ON, ON, ON, ON, ON, ON, ON);
-        setPumpsSpeed(OFF, 150.0, OFF, OFF);
+        setPumpsSpeed({{PUMP_ID_CIRCULATION, 150.0}});
         setValvesState(CLOSE, CLOSE, CLOSE);
         setPressureChamberState(ON);
         setHeatersState(ON);
@@ -51,7 +54,7 @@ void loop()
     case eBioreactorState::RUN:
         // start when user sent command
         setFansState(ON, ON, ON, ON, ON, ON, ON);
-        setPumpsSpeed(OFF, 110.0, 50.0, 50.0);
+        setPumpsSpeed({{PUMP_ID_CIRCULATION, 110.0}, {PUMP_ID_CULTURE_CHAMBER_1, 50.0}, {PUMP_ID_CULTURE_CHAMBER_2, 50.0}});
         setValvesState(CLOSE, OPEN, CLOSE);
         setPressureChamberState(ON);
         setHeatersState(ON);
@@ -60,182 +63,200 @@ void loop()
     case eBioreactorState::CELL_RETURN:
         // start when user send command (from IDLE after culture is finished)
         setFansState(OFF, ON, ON, ON, ON, ON, ON);
-        setPumpsSpeed(-200.0, -200.0, -50.0, -50.0);
+        setPumpsSpeed({{PUMP_ID_APPROV, -200.0}, {PUMP_ID_CIRCULATION, -200.0}, {PUMP_ID_CULTURE_CHAMBER_1, -50.0}, {PUMP_ID_CULTURE_CHAMBER_2, -50.0}});
         setValvesState(OPEN, OPEN, CLOSE);
         setPressureChamberState(OFF);
         setHeatersState(OFF);
 
         // switch after 10 min to IDLE
-        if (millis() - stateTimer > 5 * MINUTE)
+        if (systemClock.getMillis() - stateTimer > 5 * MINUTE)
         {
             setBioreactorState((uint8_t)eBioreactorState::IDLE);
-            stateTimer = millis();
+            stateTimer = systemClock.getMillis();
         }
         break;
     case eBioreactorState::CLEANING_APPROV:
         // start when user send command (from IDLE after growth liquid returned)
         setFansState(OFF, OFF, ON, ON, ON, ON, ON);
-        setPumpsSpeed(220.0, OFF, OFF, OFF);
+        setPumpsSpeed({{PUMP_ID_APPROV, 220.0}});
         setValvesState(OPEN, CLOSE, CLOSE);
         setPressureChamberState(OFF);
         setHeatersState(OFF);
 
         // switch after 5 min to CLEANING_CIRCULATION
-        if (millis() - stateTimer > 5 * MINUTE)
+        if (systemClock.getMillis() - stateTimer > 5 * MINUTE)
         {
             setBioreactorState((uint8_t)eBioreactorState::CLEANING_CIRCULATION);
-            stateTimer = millis();
+            stateTimer = systemClock.getMillis();
         }
         break;
     case eBioreactorState::CLEANING_CIRCULATION:
         // start after cleaning liquid is approvisioned
         setFansState(OFF, OFF, ON, ON, ON, ON, ON);
-        setPumpsSpeed(OFF, 150.0, 50.0, 50.0);
+        setPumpsSpeed({{PUMP_ID_CIRCULATION, 150.0}, {PUMP_ID_CULTURE_CHAMBER_1, 50.0}, {PUMP_ID_CULTURE_CHAMBER_2, 50.0}});
         setValvesState(CLOSE, OPEN, CLOSE);
         setPressureChamberState(OFF);
         setHeatersState(OFF);
 
         // switch after 10 min to CLEANING_RETURN
-        if (millis() - stateTimer > 15 * MINUTE)
+        if (systemClock.getMillis() - stateTimer > 15 * MINUTE)
         {
             setBioreactorState((uint8_t)eBioreactorState::CLEANING_RETURN);
-            stateTimer = millis();
+            stateTimer = systemClock.getMillis();
         }
         break;
     case eBioreactorState::CLEANING_RETURN:
         setFansState(OFF, OFF, ON, ON, ON, ON, ON);
-        setPumpsSpeed(-220.0, -220.0, -50.0, -50.0);
+        setPumpsSpeed({{PUMP_ID_APPROV, -220.0}, {PUMP_ID_CIRCULATION, -220.0}, {PUMP_ID_CULTURE_CHAMBER_1, -50.0}, {PUMP_ID_CULTURE_CHAMBER_2, -50.0}});
         setValvesState(CLOSE, OPEN, OPEN);
         setPressureChamberState(OFF);
         setHeatersState(OFF);
 
         // switch after 10 min to RINSING_LIQUID_APPROV
-        if (millis() - stateTimer > 5 * MINUTE)
+        if (systemClock.getMillis() - stateTimer > 5 * MINUTE)
         {
             setBioreactorState((uint8_t)eBioreactorState::IDLE);
-            stateTimer = millis();
+            stateTimer = systemClock.getMillis();
         }
         break;
     case eBioreactorState::RINSING_APPROV:
         setFansState(OFF, OFF, ON, ON, ON, ON, ON);
-        setPumpsSpeed(220.0, OFF, OFF, OFF);
+        setPumpsSpeed({{PUMP_ID_APPROV, 220.0}});
         setValvesState(OPEN, CLOSE, CLOSE);
         setPressureChamberState(OFF);
         setHeatersState(OFF);
 
         // switch after 5 min to RINSING_CIRCULATION
-        if (millis() - stateTimer > 5 * MINUTE)
+        if (systemClock.getMillis() - stateTimer > 5 * MINUTE)
         {
             setBioreactorState((uint8_t)eBioreactorState::RINSING_CIRCULATION);
-            stateTimer = millis();
+            stateTimer = systemClock.getMillis();
         }
         break;
     case eBioreactorState::RINSING_CIRCULATION:
         // start after rinsing liquid is approvisioned
         setFansState(OFF, OFF, ON, ON, ON, ON, ON);
-        setPumpsSpeed(OFF, 150.0, 50.0, 50.0);
+        setPumpsSpeed({{PUMP_ID_CIRCULATION, 150.0}, {PUMP_ID_CULTURE_CHAMBER_1, 50.0}, {PUMP_ID_CULTURE_CHAMBER_2, 50.0}});
         setValvesState(CLOSE, OPEN, CLOSE);
         setPressureChamberState(OFF);
         setHeatersState(OFF);
 
         // switch after 10 min to RINSING_RETURN
-        if (millis() - stateTimer > 15 * MINUTE)
+        if (systemClock.getMillis() - stateTimer > 15 * MINUTE)
         {
             setBioreactorState((uint8_t)eBioreactorState::RINSING_RETURN);
-            stateTimer = millis();
+            stateTimer = systemClock.getMillis();
         }
         break;
     case eBioreactorState::RINSING_RETURN:
         // start after rinsing liquid is finished
         setFansState(OFF, OFF, ON, ON, ON, ON, ON);
-        setPumpsSpeed(-200.0, -125.0, -50.0, -50.0);
+        setPumpsSpeed({{PUMP_ID_APPROV, -200.0}, {PUMP_ID_CIRCULATION, -125.0}, {PUMP_ID_CULTURE_CHAMBER_1, -50.0}, {PUMP_ID_CULTURE_CHAMBER_2, -50.0}});
         setValvesState(CLOSE, OPEN, OPEN);
         setPressureChamberState(OFF);
         setHeatersState(OFF);
 
         // switch after 2 min to OPEN_VALVES
-        if (millis() - stateTimer > 2 * MINUTE)
+        if (systemClock.getMillis() - stateTimer > 2 * MINUTE)
         {
             setBioreactorState((uint8_t)eBioreactorState::OPEN_VALVES);
-            stateTimer = millis();
+            stateTimer = systemClock.getMillis();
         }
         break;
     case eBioreactorState::RETURN_START:
         // start after rinsing liquid is finished
         setFansState(OFF, OFF, ON, ON, ON, ON, ON);
-        setPumpsSpeed(-200.0, -140.0, CLOSE, CLOSE);
+        setPumpsSpeed({{PUMP_ID_APPROV, -200.0}, {PUMP_ID_CIRCULATION, -140.0}});
         setValvesState(CLOSE, CLOSE, OPEN);
         setPressureChamberState(OFF);
         setHeatersState(OFF);
 
         // switch after 10 min to IDLE
-        if (millis() - stateTimer > 3 * MINUTE)
+        if (systemClock.getMillis() - stateTimer > 3 * MINUTE)
         {
             setBioreactorState((uint8_t)eBioreactorState::IDLE);
-            stateTimer = millis();
+            stateTimer = systemClock.getMillis();
         }
         break;
     case eBioreactorState::REDUCE_OVERFLOW: // reduce a bit the quantity of liquid in the sensor vial
         // start after rinsing liquid is finished
         setFansState(OFF, OFF, ON, ON, ON, ON, ON);
-        setPumpsSpeed(OFF, -100.0, 0.0, 0.0);
+        setPumpsSpeed({{PUMP_ID_CIRCULATION, -100.0}});
         setValvesState(OPEN, OPEN, CLOSE);
         setPressureChamberState(OFF);
         setHeatersState(OFF);
 
         // switch after 10 min to IDLE
-        if (millis() - stateTimer > 1 * MINUTE)
+        if (systemClock.getMillis() - stateTimer > 1 * MINUTE)
         {
             setBioreactorState((uint8_t)eBioreactorState::IDLE);
-            stateTimer = millis();
+            stateTimer = systemClock.getMillis();
         }
         break;
     case eBioreactorState::TEST: // For the fluidic and heating system test
         setFansState(ON, ON, ON, ON, ON, ON, ON);
-        setPumpsSpeed(OFF, OFF, OFF, OFF);
+        setPumpsSpeed({});
         setValvesState(OPEN, OPEN, OPEN);
         setPressureChamberState(ON);
         setHeatersState(OFF);
         break;
     case eBioreactorState::OPEN_VALVES: // For the fluidic and heating system test
         setFansState(OFF, OFF, OFF, OFF, OFF, OFF, OFF);
-        setPumpsSpeed(OFF, OFF, OFF, OFF);
+        setPumpsSpeed({});
         setValvesState(OPEN, OPEN, OPEN);
         setPressureChamberState(OFF);
         setHeatersState(OFF);
         break;
     case eBioreactorState::SAMPLING:
         setFansState(OFF, OFF, OFF, OFF, OFF, OFF, OFF);
-        setPumpsSpeed(-80.0, OFF, OFF, OFF);
+        setPumpsSpeed({}); // The approv pump moves SAMPLING_VOLUME, started by setBioreactorState()
         setValvesState(OPEN, CLOSE, CLOSE);
         setPressureChamberState(OFF);
         setHeatersState(OFF);
 
-        if (millis() - stateTimer > 0.75 * MINUTE)
+        if (isPhaseDosingComplete())
         {
             setBioreactorState((uint8_t)eBioreactorState::RUN);
-            stateTimer = millis();
+            stateTimer = systemClock.getMillis();
         }
         break;
     case eBioreactorState::HEATING:
         setFansState(OFF, OFF, OFF, OFF, OFF, OFF, OFF);
-        setPumpsSpeed(OFF, OFF, OFF, OFF);
+        setPumpsSpeed({});
         setValvesState(CLOSE, CLOSE, CLOSE);
         setPressureChamberState(OFF);
         setHeatersState(ON);
         break;
+    case eBioreactorState::RECIPE:
+        // The actuators and the exit of each step come from the uploaded recipe, IDLE at its end
+        updateRecipe();
+        break;
     default:
         /* code */
         break;
     }
+    updatePhaseProgress();
+    checkPumpEvents();
+    updateSafetyInterlock();
 
+    beginLoopStage(LOOP_STAGE_SENSORS);
     updateSensors();
+    beginLoopStage(LOOP_STAGE_TELEMETRY);
     printBioreactorStateToSerial();
+    beginLoopStage(LOOP_STAGE_TEMPERATURE);
     updateTemperatureController();
+    beginLoopStage(LOOP_STAGE_GAS);
+    updatePhController();
+    updateDoController();
     updatePressureChamberController();
+    beginLoopStage(LOOP_STAGE_LED);
     updateLEDState();
+    beginLoopStage(LOOP_STAGE_COMMANDS);
     receiveSerialCommand();
+    beginLoopStage(LOOP_STAGE_RECORDER);
+    busRecorder.update();
     // updateBioreactorState(); // To be implemented when communication with the GUI will be available
     serialReader(); // This is used for DEBUG only
-    kickWatchDog();
+    endLoopStage();
+    updateWatchDog();
 }
@@ -0,0 +1,92 @@
+#include "ph_controller.h"
+
+/**
+ * @brief Constructor to initialize the control loop parameters.
+ */
+PhController::PhController()
+    : phRef(7.0f),
+      nominalCo2Level(50000.0f),
+      co2Level(50000.0f),
+      isBaseEnabled(false),
+      basePulseVolume(0.0f),
+      lastSampleTime(0),
+      lastBasePulseTime(0),
+      isBasePulseDone(false)
+{
+}
+
+/**
+ * @brief Updates the CO2 level with the latest pH measurement.
+ * @param ph Measured pH.
+ * @param sampleAge Age of the measurement (ms).
+ * @return True if the measurement was used.
+ */
+bool PhController::update(float ph, unsigned long sampleAge)
+{
+    return update(ph, sampleAge, systemClock.getMillis());
+}
+
+/**
+ * @brief Updates the CO2 level with the latest pH measurement at a given time.
+ * @param ph Measured pH.
+ * @param sampleAge Age of the measurement (ms).
+ * @param currentTime Time of the update (ms), allows to run the controller on a simulated time.
+ * @return True if the measurement was used, false if it is stale, invalid or already used.
+ */
+bool PhController::update(float ph, unsigned long sampleAge, unsigned long currentTime)
+{
+    unsigned long sampleTime = currentTime - sampleAge;
+    if (isnan(ph) || sampleAge > MAX_SAMPLE_AGE || sampleTime == this->lastSampleTime)
+        return false;
+    this->lastSampleTime = sampleTime;
+
+    // A positive error (too basic) needs more CO2
+    float error = ph - this->phRef;
+    if (fabsf(error) <= PH_DEAD_BAND)
+        return true;
+
+    float ratio = constrain(powf(10.0f, CO2_GAIN * error), 1.0f / MAX_CO2_RATIO_STEP, MAX_CO2_RATIO_STEP);
+    this->co2Level = constrain(this->co2Level * ratio, MIN_CO2_LEVEL, MAX_CO2_LEVEL);
+
+    // The CO2 cannot lower the acidity more
+    bool isBaseNeeded = error < -BASE_DEAD_BAND && this->co2Level <= MIN_CO2_LEVEL;
+    bool isPulseAllowed = !this->isBasePulseDone || currentTime - this->lastBasePulseTime >= BASE_PULSE_INTERVAL;
+    if (this->isBaseEnabled && isBaseNeeded && isPulseAllowed)
+    {
+        this->basePulseVolume = BASE_PULSE_VOLUME;
+        this->lastBasePulseTime = currentTime;
+        this->isBasePulseDone = true;
+    }
+    return true;
+}
+
+/**
+ * @brief Go back to the nominal CO2 level, for a new culture.
+ */
+void PhController::reset()
+{
+    this->co2Level = constrain(this->nominalCo2Level, MIN_CO2_LEVEL, MAX_CO2_LEVEL);
+    this->basePulseVolume = 0.0f;
+    this->isBasePulseDone = false;
+}
+
+/**
+ * @brief Set the CO2 level set by the user, the trim starts again from it.
+ * @param co2Level CO2 level (ppm).
+ */
+void PhController::setNominalCo2Level(float co2Level)
+{
+    this->nominalCo2Level = co2Level;
+    this->co2Level = constrain(co2Level, MIN_CO2_LEVEL, MAX_CO2_LEVEL);
+}
+
+/**
+ * @brief Take the requested base pulse.
+ * @return Volume of base to add (ml), 0 if no pulse is requested.
+ */
+float PhController::getBasePulseVolume()
+{
+    float volume = this->basePulseVolume;
+    this->basePulseVolume = 0.0f;
+    return volume;
+}
@@ -4,30 +4,47 @@
  * @brief Constructor to initialize the control loop parameters.
  */
 PressureChamberController::PressureChamberController()
-    : co2MinRef(CO2_REF - CO2_DEAD_ZONE),
-      co2MaxRef(CO2_REF + CO2_DEAD_ZONE),
-      co2Ref(CO2_REF),
+    : pressureChamberState(false),
+      timeBeforeClosingO2Valve(0),
+      timeBeforeClosingCO2Valve(0),
+      timeBeforeClosingAirValve(0),
+      valveOpeningTime(0),
+      lastObserverUpdateTime(0),
       o2MinRef(O2_REF - O2_DEAD_ZONE),
       o2MaxRef(O2_REF + O2_DEAD_ZONE),
+      co2MinRef(CO2_REF - CO2_DEAD_ZONE),
+      co2MaxRef(CO2_REF + CO2_DEAD_ZONE),
+      co2Ref(CO2_REF),
       o2Ref(O2_REF),
       o2ValveState(false),
       co2ValveState(false),
       airValveState(false),
-      safetyValveState(false),
-      pressureChamberState(false),
-      timeBeforeClosingO2Valve(0),
-      timeBeforeClosingCO2Valve(0),
-      timeBeforeClosingAirValve(0)
+      safetyValveState(false)
 {
 }
 
 /**
- * @brief Calculates the time the valve should remain open based on the concentrations of gases and the pressure.
+ * @brief Calculates the time the valves should remain open based on the concentrations of gases and the pressure.
  * @param o2Concentration The concentration of O2 in the chamber in %.
  * @param co2Concentration The concentration of CO2 in the chamber in ppm.
- * @param pressure The pressure in the chamber in Pa.
+ * @param pressure The gauge pressure in the chamber in Pa, NAN if the pressure sensor is not available.
+ *
+ * @note The O2, CO2 and air valves are computed together by the GasDosingOptimizer because every gas added
+ * dilutes the others and raises the pressure of the chamber.
  */
 void PressureChamberController::update(float o2Concentration, float co2Concentration, float pressure)
+{
+    update(o2Concentration, co2Concentration, pressure, systemClock.getMillis());
+}
+
+/**
+ * @brief Calculates the time the valves should remain open, starting at a given time.
+ * @param o2Concentration The concentration of O2 in the chamber in %.
+ * @param co2Concentration The concentration of CO2 in the chamber in ppm.
+ * @param pressure The gauge pressure in the chamber in Pa, NAN if the pressure sensor is not available.
+ * @param currentTime Time at which the valves open (ms), allows to run the controller on a simulated time.
+ */
+void PressureChamberController::update(float o2Concentration, float co2Concentration, float pressure, unsigned long currentTime)
 {
     if (!this->pressureChamberState)
         return;
@@ -36,106 +53,193 @@ void PressureChamberController::update(float o2Concentration, float co2Concentra
     float co2ValveTime = 0;
     float airValveTime = 0;
 
-    float o2Error = o2Concentration - this->o2Ref;
-    float co2Error = co2Concentration - this->co2Ref;
+    // Without the sensor, assume the chamber is at its setpoint
+    bool isPressureKnown = !isnan(pressure);
+    if (!isPressureKnown)
+        pressure = P_CHAMBER;
 
-    // --- O₂ Control Logic ---
-    if (o2Error > 0)
-    {
-        float effectiveO2Error = o2Error / o2Concentration;
-        airValveTime = calculateTimeBeforeClosingValve(AIR, effectiveO2Error) * CORRECTION_FACTOR_O2_REDUCTION;
-    }
-    else if (o2Error < 0)
-    {
-        float correctionFactor = (-o2Error < SMALL_O2_ERROR_THRESHOLD)
-                                     ? CORRECTION_FACTOR_O2_SMALL
-                                     : CORRECTION_FACTOR_O2;
+    bool isO2InDeadZone = (o2Concentration >= this->o2MinRef) && (o2Concentration <= this->o2MaxRef);
+    bool isCo2InDeadZone = (co2Concentration >= this->co2MinRef) && (co2Concentration <= this->co2MaxRef);
 
-        o2ValveTime = calculateTimeBeforeClosingValve(O2, -o2Error) * correctionFactor;
-    }
-
-    // --- CO₂ Control Logic ---
-    if (co2Error > 0)
+    // --- O₂ and CO₂ Control Logic ---
+    if (!isO2InDeadZone || !isCo2InDeadZone)
     {
-        float effectiveCO2Error = co2Error / co2Concentration;
-        float airValveTimeFromCo2 = calculateTimeBeforeClosingValve(AIR, effectiveCO2Error) * CORRECTION_FACTOR_CO2_REDUCTION;
-        airValveTime = max(airValveTime, airValveTimeFromCo2);
-    }
-    else if (co2Error < 0)
-    {
-        float correctionFactor = (-co2Error < SMALL_CO2_ERROR_THRESHOLD)
-                                     ? CORRECTION_FACTOR_CO2_SMALL
-                                     : CORRECTION_FACTOR_CO2;
+        sGasDosingProblem problem;
+        problem.level[O2] = o2Concentration;
+        problem.level[CO2] = co2Concentration;
+        problem.reference[O2] = this->o2Ref;
+        problem.reference[CO2] = this->co2Ref;
+        problem.tolerance[O2] = O2_DEAD_ZONE;
+        problem.tolerance[CO2] = CO2_DEAD_ZONE;
+        for (uint8_t valve = O2; valve < DOSING_VALVE_COUNT; valve++)
+            problem.maxVolume[valve] = getEffectiveFlowRate(static_cast<eValves>(valve)) * MAX_VALVE_OPEN_TIME / SECONDS_TO_MILLIS;
+
+        // The gas added raises the pressure of the chamber: dP / P = dV / V, with P absolute
+        problem.volumeBudget = max(0.0f, V * (P_CHAMBER_MAX - pressure) / (pressure + ATMOSPHERIC_PRESSURE));
 
-        // Serial.println(">CO2 Error: " + String(co2Error));
-        // Serial.println(">CO2 Error Correction Factor: " + String(correctionFactor));
+        float volumes[DOSING_VALVE_COUNT];
+        this->dosingOptimizer.solve(problem, volumes);
 
-        co2ValveTime = calculateTimeBeforeClosingValve(CO2, -co2Error) * correctionFactor;
+        o2ValveTime = volumes[O2] / getEffectiveFlowRate(O2) * SECONDS_TO_MILLIS;   // Time in milliseconds (t=V/Q)
+        co2ValveTime = volumes[CO2] / getEffectiveFlowRate(CO2) * SECONDS_TO_MILLIS; // Time in milliseconds (t=V/Q)
+        airValveTime = volumes[AIR] / getEffectiveFlowRate(AIR) * SECONDS_TO_MILLIS; // Time in milliseconds (t=V/Q)
     }
 
     // --- Pressure Control Logic ---
-    if (pressure < P_CHAMBER_MIN)
+    if (isPressureKnown && pressure < P_CHAMBER_MIN && airValveTime < AIR_VALVE_OPEN_TIME)
     {
-        float airValveTimeFromPressure = millis() + AIR_VALVE_OPEN_TIME;
-        airValveTime = max(airValveTime, airValveTimeFromPressure);
+        airValveTime = AIR_VALVE_OPEN_TIME;
     }
 
     // Apply the calculated times
-    this->timeBeforeClosingO2Valve = millis() + static_cast<unsigned long>(o2ValveTime);
-    this->timeBeforeClosingCO2Valve = millis() + static_cast<unsigned long>(co2ValveTime);
-    this->timeBeforeClosingAirValve = millis() + static_cast<unsigned long>(airValveTime);
-
-    // --- DEBUG OUTPUT ---
-    // float printTimeBeforeClosingO2Valve = (timeBeforeClosingO2Valve - millis());
-    // if (printTimeBeforeClosingO2Valve > 999999999)
-    //     printTimeBeforeClosingO2Valve = 0;
-    // float printTimeBeforeClosingCO2Valve = (timeBeforeClosingCO2Valve - millis());
-    // if (printTimeBeforeClosingCO2Valve > 999999999)
-    //     printTimeBeforeClosingCO2Valve = 0;
-    // float printTimeBeforeClosingAirValve = (timeBeforeClosingAirValve - millis());
-    // if (printTimeBeforeClosingAirValve > 999999999)
-    //     printTimeBeforeClosingAirValve = 0;
-    // Serial.println(">O2 Opening Time: " + String(printTimeBeforeClosingO2Valve));
-    // Serial.println(">CO2 Opening Time: " + String(printTimeBeforeClosingCO2Valve));
-    // Serial.println(">Air Opening Time: " + String(printTimeBeforeClosingAirValve));
+    this->valveOpeningTime = currentTime;
+    this->timeBeforeClosingO2Valve = this->valveOpeningTime + static_cast<unsigned long>(o2ValveTime);
+    this->timeBeforeClosingCO2Valve = this->valveOpeningTime + static_cast<unsigned long>(co2ValveTime);
+    this->timeBeforeClosingAirValve = this->valveOpeningTime + static_cast<unsigned long>(airValveTime);
 }
 
 /**
- * @brief Calculates the time before closing the valve based on the error.
- * @param Valve The valve to be closed.
- * @param error The error value.
- * @return The time before closing the valve in milliseconds.
- * @note This function makes a few simplifications that must be tested :
- * - The flow rate is assumed to be constant even if opening the valve will increase the pressure in the chamber.
- * - The equation assumes that no gas is lost when new gas is added to the chamber, wich is false.
- *   Because we will have multiple adjustment in a row, I assume that the error will disapear after a few iterations.
+ * @brief Calculates the flow rate through a valve when it is open (Poiseuille's law).
+ * @param Valve The valve to get the flow rate of.
+ * @return The flow rate in liters per second, 0 for an unknown valve.
  */
-float PressureChamberController::calculateTimeBeforeClosingValve(eValves Valve, float error)
+float PressureChamberController::getValveFlowRate(eValves Valve) const
 {
-    float timeBeforeClosing = 0;
-    float q = 0.0f;           // Flow rate in liters per second
-    float volumeToAdd = 0.0f; // Volume to add in liters
+    float mu = 0.0f; // Viscosity of the gas
     switch (Valve)
     {
     case O2:
-        q = (PI * pow(R, 4)) / (8 * MU_O2 * L) * (P_APPROV - P_CHAMBER); // Flow rate equation for O2 (Poiseuille's law)
-        volumeToAdd = error * PERCENT_TO_LITERS;                         // Volume to add in liters
-        timeBeforeClosing = volumeToAdd / q * SECONDS_TO_MILLIS;         // Time in milliseconds (t=V/Q)
+        mu = MU_O2;
         break;
     case CO2:
-        q = (PI * pow(R, 4)) / (8 * MU_CO2 * L) * (P_APPROV - P_CHAMBER); // Flow rate equation for CO2 (Poiseuille's law)
-        volumeToAdd = error * PPM_TO_LITERS;                              // Volume to add in liters
-        timeBeforeClosing = volumeToAdd / q * SECONDS_TO_MILLIS;          // Time in milliseconds (t=V/Q)
+        mu = MU_CO2;
         break;
     case AIR:
-        q = (PI * pow(R, 4)) / (8 * MU_AIR * L) * (P_APPROV - P_CHAMBER); // Flow rate equation for air (Poiseuille's law)
-        volumeToAdd = error * PERCENT_TO_LITERS;                          // Volume to add in liters
-        timeBeforeClosing = volumeToAdd / q * SECONDS_TO_MILLIS;          // Time in milliseconds (t=V/Q)
+        mu = MU_AIR;
         break;
     default:
+        return 0.0f;
+    }
+    return (PI * pow(R, 4)) / (8 * mu * L) * (P_APPROV - P_CHAMBER);
+}
+
+/**
+ * @brief Calculates the flow rate really added to the chamber through a valve when it is open.
+ * @param Valve The valve to get the flow rate of.
+ * @return The flow rate in liters per second, 0 for an unknown valve.
+ *
+ * @note The flow model makes a few simplifications that must be tested, the correction factors are tuned
+ * empirically to match the flow really added to the chamber:
+ * - The flow rate is assumed to be constant even if opening the valve will increase the pressure in the chamber.
+ * - The restriction of the valves is not part of the model.
+ */
+float PressureChamberController::getEffectiveFlowRate(eValves Valve) const
+{
+    switch (Valve)
+    {
+    case O2:
+        return getValveFlowRate(O2) / CORRECTION_FACTOR_O2;
+    case CO2:
+        return getValveFlowRate(CO2) / CORRECTION_FACTOR_CO2;
+    case AIR:
+        return getValveFlowRate(AIR) / CORRECTION_FACTOR_AIR;
+    default:
+        return 0.0f;
+    }
+}
+
+/**
+ * @brief Calculates how long a valve was open during a time window.
+ * @param Valve The valve to check.
+ * @param from Start of the time window (ms).
+ * @param to End of the time window (ms).
+ * @return The time the valve was open during the window in milliseconds.
+ */
+unsigned long PressureChamberController::getValveOpenTime(eValves Valve, unsigned long from, unsigned long to) const
+{
+    unsigned long timeBeforeClosing = 0;
+    switch (Valve)
+    {
+    case O2:
+        timeBeforeClosing = this->timeBeforeClosingO2Valve;
+        break;
+    case CO2:
+        timeBeforeClosing = this->timeBeforeClosingCO2Valve;
         break;
+    case AIR:
+        timeBeforeClosing = this->timeBeforeClosingAirValve;
+        break;
+    default:
+        return 0;
+    }
+
+    // Work with offsets from the valve opening so the computation is safe when the time wraps around
+    long openDuration = static_cast<long>(timeBeforeClosing - this->valveOpeningTime);
+    long start = constrain(static_cast<long>(from - this->valveOpeningTime), 0L, openDuration);
+    long end = constrain(static_cast<long>(to - this->valveOpeningTime), 0L, openDuration);
+    return static_cast<unsigned long>(end - start);
+}
+
+/**
+ * @brief Updates the estimation of the chamber composition. Must be called periodically (about every second).
+ * @param o2Concentration The concentration of O2 read by the sensor in %.
+ * @param isO2New True if o2Concentration is a new valid sample.
+ * @param co2Concentration The concentration of CO2 read by the sensor in ppm.
+ * @param isCo2New True if co2Concentration is a new valid sample.
+ */
+void PressureChamberController::updateObserver(float o2Concentration, bool isO2New, float co2Concentration, bool isCo2New)
+{
+    updateObserver(o2Concentration, isO2New, co2Concentration, isCo2New, systemClock.getMillis());
+}
+
+/**
+ * @brief Updates the estimation of the chamber composition at a given time.
+ * @param o2Concentration The concentration of O2 read by the sensor in %.
+ * @param isO2New True if o2Concentration is a new valid sample.
+ * @param co2Concentration The concentration of CO2 read by the sensor in ppm.
+ * @param isCo2New True if co2Concentration is a new valid sample.
+ * @param currentTime Time of the samples (ms), allows to run the observer on a simulated time.
+ */
+void PressureChamberController::updateObserver(float o2Concentration, bool isO2New, float co2Concentration, bool isCo2New, unsigned long currentTime)
+{
+    float dt = static_cast<float>(currentTime - this->lastObserverUpdateTime) / SECONDS_TO_MILLIS;
+
+    float addedO2Volume = 0.0f;
+    float addedCo2Volume = 0.0f;
+    float addedAirVolume = 0.0f;
+    if (this->pressureChamberState)
+    {
+        unsigned long from = this->lastObserverUpdateTime;
+        addedO2Volume = getEffectiveFlowRate(O2) * getValveOpenTime(O2, from, currentTime) / SECONDS_TO_MILLIS;
+        addedCo2Volume = getEffectiveFlowRate(CO2) * getValveOpenTime(CO2, from, currentTime) / SECONDS_TO_MILLIS;
+        addedAirVolume = getEffectiveFlowRate(AIR) * getValveOpenTime(AIR, from, currentTime) / SECONDS_TO_MILLIS;
+    }
+    this->lastObserverUpdateTime = currentTime;
+
+    this->observer.predict(dt, addedO2Volume, addedCo2Volume, addedAirVolume);
+
+    if (isO2New)
+        this->observer.correctO2(o2Concentration);
+    if (isCo2New)
+        this->observer.correctCo2(co2Concentration);
+}
+
+/**
+ * @brief Returns the estimated concentration of a gas in the chamber.
+ * @param Valve The gas to get (O2 or CO2).
+ * @return The estimated concentration (% for O2, ppm for CO2), 0 for any other valve.
+ */
+float PressureChamberController::getEstimatedLevel(eValves Valve) const
+{
+    switch (Valve)
+    {
+    case O2:
+        return this->observer.getO2();
+    case CO2:
+        return this->observer.getCo2();
+    default:
+        return 0.0f;
     }
-    return timeBeforeClosing;
 }
 
 /**
@@ -144,24 +248,39 @@ float PressureChamberController::calculateTimeBeforeClosingValve(eValves Valve,
  * @return The state of the valve (true for open, false for closed).
  */
 bool PressureChamberController::getValveState(eValves Valve) const
+{
+    return getValveState(Valve, systemClock.getMillis());
+}
+
+/**
+ * @brief Returns the state of the specified valve at a given time.
+ * @param Valve The valve to check.
+ * @param currentTime Time at which the state is checked (ms), allows to run the controller on a simulated time.
+ * @return The state of the valve (true for open, false for closed).
+ */
+bool PressureChamberController::getValveState(eValves Valve, unsigned long currentTime) const
 {
     if (!this->pressureChamberState)
         return false;
 
+    unsigned long timeBeforeClosing = 0;
     switch (Valve)
     {
     case O2:
-        return (timeBeforeClosingO2Valve > millis()) ? true : false;
+        timeBeforeClosing = this->timeBeforeClosingO2Valve;
+        break;
     case CO2:
-        // bool status = (co2Sensor.getStatus() == eGMP251Status::GMP_251_STATUS_OK) || (co2Sensor.getStatus() == eGMP251Status::GMP_251_STATUS_INITIALIZED);
-        return ((timeBeforeClosingCO2Valve > millis())) ? true : false;
+        timeBeforeClosing = this->timeBeforeClosingCO2Valve;
+        break;
     case AIR:
-        return (timeBeforeClosingAirValve > millis()) ? true : false;
-    case SAFETY:
-        return false;
-    default:
+        timeBeforeClosing = this->timeBeforeClosingAirValve;
+        break;
+    default: // SAFETY is never opened by the controller
         return false;
     }
+
+    // Compare offsets from the valve opening, the closing time may have wrapped around
+    return currentTime - this->valveOpeningTime < timeBeforeClosing - this->valveOpeningTime;
 }
 
 /**
@@ -0,0 +1,214 @@
+#include "pressure_sensor.h"
+
+/**
+ * @brief Calibration curve of the transducer: voltage at the ADC pin (after the 2/3 divider) to gauge pressure.
+ * The points must be sorted by increasing voltage, the curve is linear between the points.
+ */
+const sPressureCalibrationPoint PressureSensor::CALIBRATION_CURVE[] = {
+    {333.0f, 0.0f},        // 0.5 V at the transducer, 0 psi
+    {3000.0f, 50 * 6895}}; // 4.5 V at the transducer, 50 psi
+const uint8_t PressureSensor::CALIBRATION_POINT_COUNT = sizeof(CALIBRATION_CURVE) / sizeof(CALIBRATION_CURVE[0]);
+
+/**
+ * @brief Constructor for the pressure sensor.
+ * @param pin The ADC1 pin connected to the transducer.
+ */
+PressureSensor::PressureSensor(uint8_t pin)
+    : _pin(pin),
+      _channel(0),
+      _status(PRESSURE_SENSOR_STATUS_NOT_INITIALISED),
+      _taskHandle(nullptr),
+      _rawSum(0),
+      _rawCount(0),
+      _filteredPressure(0.0f),
+      _isFilterInitialized(false),
+      _lock(portMUX_INITIALIZER_UNLOCKED),
+      _pressure(0.0f),
+      _lastSampleTime(0)
+{
+}
+
+/**
+ * @brief Configure the ADC in continuous mode and start the acquisition task.
+ * @return Status of the initialization.
+ */
+ePressureSensorStatus PressureSensor::begin()
+{
+    int8_t channel = digitalPinToAnalogChannel(_pin);
+    if (channel < 0 || channel >= ADC1_CHANNEL_COUNT)
+        return _status = PRESSURE_SENSOR_STATUS_INVALID_PIN;
+    _channel = channel;
+
+    esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, ADC_DEFAULT_VREF, &_adcCharacteristics);
+
+    adc_digi_init_config_t dmaConfig = {};
+    dmaConfig.max_store_buf_size = ADC_BUFFER_SIZE;
+    dmaConfig.conv_num_each_intr = ADC_FRAME_SIZE;
+    dmaConfig.adc1_chan_mask = BIT(_channel);
+    dmaConfig.adc2_chan_mask = 0;
+    if (adc_digi_initialize(&dmaConfig) != ESP_OK)
+        return _status = PRESSURE_SENSOR_STATUS_ADC_INIT_FAILED;
+
+    adc_digi_pattern_config_t pattern = {};
+    pattern.atten = ADC_ATTEN_DB_11;
+    pattern.channel = _channel;
+    pattern.unit = 0; // ADC1
+    pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+    adc_digi_configuration_t adcConfig = {};
+    adcConfig.conv_limit_en = true;
+    adcConfig.conv_limit_num = ADC_CONVERSION_LIMIT;
+    adcConfig.pattern_num = 1;
+    adcConfig.adc_pattern = &pattern;
+    adcConfig.sample_freq_hz = ADC_SAMPLE_FREQUENCY;
+    adcConfig.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    adcConfig.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+    if (adc_digi_controller_configure(&adcConfig) != ESP_OK)
+        return _status = PRESSURE_SENSOR_STATUS_ADC_INIT_FAILED;
+
+    if (adc_digi_start() != ESP_OK)
+        return _status = PRESSURE_SENSOR_STATUS_ADC_INIT_FAILED;
+
+    if (xTaskCreatePinnedToCore(taskEntry, "pressureSensor", TASK_STACK_SIZE, this, TASK_PRIORITY, &_taskHandle, TASK_CORE) != pdPASS)
+    {
+        adc_digi_stop();
+        return _status = PRESSURE_SENSOR_STATUS_TASK_CREATION_FAILED;
+    }
+
+    return _status;
+}
+
+/**
+ * @brief Get the last filtered pressure.
+ * @return Gauge pressure of the chamber (Pa).
+ */
+float PressureSensor::getPressure() const
+{
+    portENTER_CRITICAL(&_lock);
+    float pressure = _pressure;
+    portEXIT_CRITICAL(&_lock);
+    return pressure;
+}
+
+/**
+ * @brief Get the age of the last published pressure.
+ * @return unsigned long Age in milliseconds.
+ */
+unsigned long PressureSensor::getAgeMs() const
+{
+    portENTER_CRITICAL(&_lock);
+    unsigned long lastSampleTime = _lastSampleTime;
+    portEXIT_CRITICAL(&_lock);
+    return lastSampleTime == 0 ? (unsigned long)0xFFFFFFFF : systemClock.readMillis() - lastSampleTime;
+}
+
+/**
+ * @brief Get the time of the last published pressure.
+ * @return unsigned long Time of the publication (ms, SystemClock::readMillis()), 0 if no pressure was published yet.
+ */
+unsigned long PressureSensor::getLastSampleTime() const
+{
+    portENTER_CRITICAL(&_lock);
+    unsigned long lastSampleTime = _lastSampleTime;
+    portEXIT_CRITICAL(&_lock);
+    return lastSampleTime;
+}
+
+/**
+ * @brief FreeRTOS entry point of the acquisition task.
+ */
+void PressureSensor::taskEntry(void *pvParameters)
+{
+    static_cast<PressureSensor *>(pvParameters)->run();
+}
+
+/**
+ * @brief Acquisition task: read the DMA frames and decimate them.
+ */
+void PressureSensor::run()
+{
+    uint8_t frame[ADC_FRAME_SIZE];
+
+    for (;;)
+    {
+        uint32_t length = 0;
+        esp_err_t ret = adc_digi_read_bytes(frame, ADC_FRAME_SIZE, &length, ADC_READ_TIMEOUT_MS);
+        _stats.addRequest();
+        if (ret == ESP_ERR_TIMEOUT)
+        {
+            _stats.addTimeout();
+            continue;
+        }
+        if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) // INVALID_STATE: the driver buffer overflowed, the data read is still valid
+        {
+            _stats.addBusError();
+            continue;
+        }
+        _stats.addBytesReceived(length);
+
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES)
+        {
+            const adc_digi_output_data_t *sample = reinterpret_cast<const adc_digi_output_data_t *>(&frame[i]);
+            if (sample->type1.channel != _channel)
+                continue;
+
+            _rawSum += sample->type1.data;
+            if (++_rawCount >= OVERSAMPLING_COUNT)
+            {
+                publish(static_cast<float>(_rawSum) / _rawCount);
+                _rawSum = 0;
+                _rawCount = 0;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Convert a decimated ADC value to a pressure, filter it and publish it.
+ * @param averageRaw The average of the raw ADC samples.
+ */
+void PressureSensor::publish(float averageRaw)
+{
+    float voltage = esp_adc_cal_raw_to_voltage(static_cast<uint32_t>(averageRaw + 0.5f), &_adcCharacteristics);
+
+    if (voltage < CALIBRATION_CURVE[0].voltage - OUT_OF_RANGE_MARGIN ||
+        voltage > CALIBRATION_CURVE[CALIBRATION_POINT_COUNT - 1].voltage + OUT_OF_RANGE_MARGIN)
+    {
+        // The transducer is disconnected or faulty, stop publishing so the age of the value grows
+        _status = PRESSURE_SENSOR_STATUS_OUT_OF_RANGE;
+        _stats.addDeviceError();
+        _isFilterInitialized = false;
+        return;
+    }
+
+    float pressure = voltageToPressure(voltage);
+    if (!_isFilterInitialized)
+    {
+        _filteredPressure = pressure;
+        _isFilterInitialized = true;
+    }
+    _filteredPressure += FILTER_ALPHA * (pressure - _filteredPressure);
+
+    portENTER_CRITICAL(&_lock);
+    _pressure = _filteredPressure;
+    _lastSampleTime = systemClock.readMillis();
+    portEXIT_CRITICAL(&_lock);
+    _status = PRESSURE_SENSOR_STATUS_OK;
+    _stats.addSuccess();
+}
+
+/**
+ * @brief Apply the calibration curve (linear interpolation, extrapolated from the first and last segments).
+ * @param voltage Voltage at the ADC pin (mV).
+ * @return Gauge pressure (Pa).
+ */
+float PressureSensor::voltageToPressure(float voltage) const
+{
+    uint8_t segment = 0;
+    while (segment < CALIBRATION_POINT_COUNT - 2 && voltage > CALIBRATION_CURVE[segment + 1].voltage)
+        segment++;
+
+    const sPressureCalibrationPoint &low = CALIBRATION_CURVE[segment];
+    const sPressureCalibrationPoint &high = CALIBRATION_CURVE[segment + 1];
+    return low.pressure + (voltage - low.voltage) * (high.pressure - low.pressure) / (high.voltage - low.voltage);
+}
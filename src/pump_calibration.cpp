@@ -0,0 +1,169 @@
+#include "pump_calibration.h"
+
+/**
+ * @brief Constructor of an empty calibration, the flows are not corrected.
+ */
+PumpCalibration::PumpCalibration()
+{
+    clear();
+}
+
+/**
+ * @brief Add a calibration point, replaces the point at the same commanded flow.
+ * @param commandedFlow Flow set to the pump during the measure (ml/min), its sign gives the direction.
+ * @param measuredFlow Flow measured (ml/min), positive.
+ * @return True if the point is added, false if invalid or if the direction has PUMP_CALIBRATION_MAX_POINTS.
+ */
+bool PumpCalibration::addPoint(float commandedFlow, float measuredFlow)
+{
+    if (commandedFlow == 0.0 || measuredFlow <= 0.0 || isnan(commandedFlow) || isnan(measuredFlow))
+        return false;
+
+    ePumpDirection direction = commandedFlow > 0.0 ? PUMP_DIRECTION_FORWARD : PUMP_DIRECTION_REVERSE;
+    commandedFlow = fabsf(commandedFlow);
+    uint8_t &count = this->table.pointCounts[direction];
+    sPumpCalibrationPoint *points = this->table.points[direction];
+
+    uint8_t index = 0;
+    while (index < count && points[index].commanded < commandedFlow - 0.5f)
+        index++;
+
+    bool isReplaced = index < count && fabsf(points[index].commanded - commandedFlow) <= 0.5f;
+    if (!isReplaced)
+    {
+        if (count >= PUMP_CALIBRATION_MAX_POINTS)
+            return false;
+        for (uint8_t i = count; i > index; i--)
+            points[i] = points[i - 1];
+        count++;
+    }
+    points[index].commanded = commandedFlow;
+    points[index].measured = measuredFlow;
+
+    buildLut(direction);
+    return true;
+}
+
+/**
+ * @brief Remove all the calibration points.
+ */
+void PumpCalibration::clear()
+{
+    memset(&this->table, 0, sizeof(this->table));
+    for (uint8_t direction = 0; direction < PUMP_DIRECTION_MAX; direction++)
+        buildLut((ePumpDirection)direction);
+}
+
+/**
+ * @brief Get the flow to command to the pump to get a flow.
+ * @param flow Wanted flow (ml/min), + or -.
+ * @return Flow to command (ml/min), same sign.
+ */
+float PumpCalibration::getCommandedFlow(float flow) const
+{
+    ePumpDirection direction = flow < 0.0 ? PUMP_DIRECTION_REVERSE : PUMP_DIRECTION_FORWARD;
+    const float *entries = this->lut[direction];
+    float position = fabsf(flow) / LUT_STEP;
+
+    uint8_t index = position >= LUT_SIZE - 1 ? LUT_SIZE - 2 : (uint8_t)position;
+    float commanded = entries[index] + (position - index) * (entries[index + 1] - entries[index]);
+    return flow < 0.0 ? -commanded : commanded;
+}
+
+/**
+ * @brief Load the calibration points saved by save().
+ * @param preferences Opened preferences.
+ * @param key Key of the pump.
+ * @return True if a valid calibration was found, else the flows are not corrected.
+ */
+bool PumpCalibration::load(Preferences &preferences, const char *key)
+{
+    clear();
+    if (preferences.getBytesLength(key) != sizeof(this->table))
+        return false;
+
+    sPumpCalibrationTable saved;
+    preferences.getBytes(key, &saved, sizeof(saved));
+    for (uint8_t direction = 0; direction < PUMP_DIRECTION_MAX; direction++)
+    {
+        if (saved.pointCounts[direction] > PUMP_CALIBRATION_MAX_POINTS)
+            return false;
+    }
+
+    this->table = saved;
+    for (uint8_t direction = 0; direction < PUMP_DIRECTION_MAX; direction++)
+        buildLut((ePumpDirection)direction);
+    return true;
+}
+
+/**
+ * @brief Save the calibration points.
+ * @param preferences Opened preferences.
+ * @param key Key of the pump.
+ */
+void PumpCalibration::save(Preferences &preferences, const char *key) const
+{
+    preferences.putBytes(key, &this->table, sizeof(this->table));
+}
+
+/**
+ * @brief Print the calibration points as "F,commanded:measured,...;R,commanded:measured,...".
+ * @param output Where to print the points (ex: Serial).
+ */
+void PumpCalibration::print(Print &output) const
+{
+    for (uint8_t direction = 0; direction < PUMP_DIRECTION_MAX; direction++)
+    {
+        if (direction > 0)
+            output.print(';');
+        output.print(direction == PUMP_DIRECTION_FORWARD ? 'F' : 'R');
+        for (uint8_t i = 0; i < this->table.pointCounts[direction]; i++)
+        {
+            output.print(',');
+            output.print(this->table.points[direction][i].commanded);
+            output.print(':');
+            output.print(this->table.points[direction][i].measured);
+        }
+    }
+}
+
+/**
+ * @brief Compute the lookup table of a direction from its calibration points.
+ * @param direction Direction to compute.
+ */
+void PumpCalibration::buildLut(ePumpDirection direction)
+{
+    for (uint8_t i = 0; i < LUT_SIZE; i++)
+        this->lut[direction][i] = invert(direction, i * LUT_STEP);
+}
+
+/**
+ * @brief Find the commanded flow giving a measured flow, by linear interpolation between the points.
+ *
+ * The origin is an implicit point, the last segment is extended above the last point.
+ *
+ * @param direction Direction of the points.
+ * @param flow Wanted flow (ml/min), positive.
+ * @return Flow to command (ml/min), positive.
+ */
+float PumpCalibration::invert(ePumpDirection direction, float flow) const
+{
+    uint8_t count = this->table.pointCounts[direction];
+    const sPumpCalibrationPoint *points = this->table.points[direction];
+    if (count == 0)
+        return flow;
+
+    sPumpCalibrationPoint previous = {0.0, 0.0};
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (flow <= points[i].measured || i == count - 1)
+        {
+            float measuredRange = points[i].measured - previous.measured;
+            if (measuredRange <= 0.0)
+                return points[i].commanded;
+            return previous.commanded + (flow - previous.measured) * (points[i].commanded - previous.commanded) / measuredRange;
+        }
+        previous = points[i];
+    }
+    return flow;
+}
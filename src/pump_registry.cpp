@@ -0,0 +1,97 @@
+#include "pump_registry.h"
+
+/**
+ * @brief Construct the drives and the pumps of the board tables.
+ * @param spi SPI bus of the drives.
+ */
+PumpRegistry::PumpRegistry(SPIClass *spi)
+    : lastRefreshTime(0),
+      lastWriteCount(0)
+{
+    for (uint8_t i = 0; i < DRIVE_COUNT; i++)
+        this->drives[i] = DriveTmc5041(spi, DRIVE_TABLE[i].csPin);
+    for (uint8_t i = 0; i < PUMP_COUNT; i++)
+    {
+        this->pumps[i] = StepperMotor(&this->drives[PUMP_TABLE[i].drive], PUMP_TABLE[i].motor);
+        this->pumpHandles[i] = &this->pumps[i];
+    }
+}
+
+/**
+ * @brief Initialise the drives then the pumps. The SPI bus must be started before.
+ */
+void PumpRegistry::begin()
+{
+    for (uint8_t i = 0; i < DRIVE_COUNT; i++)
+        this->drives[i].begin();
+    for (uint8_t i = 0; i < PUMP_COUNT; i++)
+    {
+        this->pumps[i].begin();
+        this->pumps[i].setAcceleration(PUMP_TABLE[i].acceleration);
+    }
+}
+
+/**
+ * @brief Get a pump from its ID.
+ * @param id ePumpId of the pump.
+ * @return The pump, nullptr if the ID is not below PUMP_COUNT.
+ */
+StepperMotor *PumpRegistry::getPump(uint8_t id)
+{
+    if (id >= PUMP_COUNT)
+        return nullptr;
+    return &this->pumps[id];
+}
+
+/**
+ * @brief Set the speed of every pump, the pumps moving a volume keep it until it is complete.
+ * @param speeds PUMP_COUNT speeds (ml/min), in the order of ePumpId.
+ * @param currentTime Time of the call (ms).
+ */
+void PumpRegistry::setSpeeds(const float *speeds, unsigned long currentTime)
+{
+    bool isRefreshDue = currentTime - this->lastRefreshTime > REFRESH_INTERVAL;
+    if (isRefreshDue)
+        this->lastRefreshTime = currentTime;
+
+    sTmcDatagram datagrams[DRIVE_COUNT][MAX_DRIVE_DATAGRAMS];
+    uint8_t driveCounts[DRIVE_COUNT] = {0};
+    uint8_t pumpOffsets[PUMP_COUNT] = {0};
+    uint8_t pumpCounts[PUMP_COUNT] = {0};
+
+    // The drives stay locked from the preparation to the responses, the safety interlock cannot halt a pump in between
+    for (uint8_t i = 0; i < DRIVE_COUNT; i++)
+        this->drives[i].lock();
+
+    // A volume in progress is only checked at the refresh, its speed is applied once it is complete
+    this->lastWriteCount = 0;
+    for (uint8_t i = 0; i < PUMP_COUNT; i++)
+    {
+        StepperMotor &pump = this->pumps[i];
+        bool isChanged = !pump.isDispensing() && speeds[i] != pump.getSpeed();
+        if (!isChanged && !(isRefreshDue && pump.isRefreshNeeded()))
+            continue;
+
+        uint8_t drive = PUMP_TABLE[i].drive;
+        pumpOffsets[i] = driveCounts[drive];
+        pump.prepareSpeed(speeds[i], &datagrams[drive][driveCounts[drive]], pumpCounts[i]);
+        driveCounts[drive] += pumpCounts[i];
+        if (pumpCounts[i] > 0)
+            this->lastWriteCount++;
+    }
+
+    for (uint8_t i = 0; i < DRIVE_COUNT; i++)
+    {
+        if (driveCounts[i] > 0)
+            this->drives[i].transfer(datagrams[i], driveCounts[i]);
+    }
+
+    for (uint8_t i = 0; i < PUMP_COUNT; i++)
+    {
+        if (pumpCounts[i] > 0)
+            this->pumps[i].completeSpeed(&datagrams[PUMP_TABLE[i].drive][pumpOffsets[i]], pumpCounts[i]);
+    }
+
+    for (uint8_t i = DRIVE_COUNT; i > 0; i--)
+        this->drives[i - 1].unlock();
+}
@@ -0,0 +1,289 @@
+#include "recipe_engine.h"
+
+/**
+ * @brief Constructor of an empty recipe, it ends at once.
+ */
+RecipeEngine::RecipeEngine()
+    : instructionCount(0), uploadCount(0)
+{
+    memset(this->program, 0, sizeof(this->program));
+    memset(this->instructions, 0, sizeof(this->instructions));
+    memset(&this->position, 0, sizeof(this->position));
+}
+
+/**
+ * @brief Start a new upload, the instructions added before are dropped. The current recipe is kept until
+ * commitUpload().
+ */
+void RecipeEngine::beginUpload()
+{
+    this->uploadCount = 0;
+}
+
+/**
+ * @brief Add the next instruction of the upload.
+ * @param line The RECIPE_INSTRUCTION_SIZE hexadecimal bytes of the instruction, without the "RECIPE=" prefix.
+ * @return False if the line is malformed or if the upload has RECIPE_MAX_INSTRUCTIONS.
+ */
+bool RecipeEngine::addInstruction(const String &line)
+{
+    String hex = line;
+    hex.trim(); // The printed lines end with "\r\n"
+    if (hex.length() != RECIPE_INSTRUCTION_SIZE * 2 || this->uploadCount >= RECIPE_MAX_INSTRUCTIONS)
+        return false;
+
+    uint8_t bytes[RECIPE_INSTRUCTION_SIZE];
+    for (uint8_t i = 0; i < RECIPE_INSTRUCTION_SIZE; i++)
+    {
+        char byteString[3] = {hex[2 * i], hex[2 * i + 1], '\0'};
+        char *end = nullptr;
+        bytes[i] = strtoul(byteString, &end, 16);
+        if (end != &byteString[2])
+            return false;
+    }
+
+    memcpy(&this->upload[this->uploadCount * RECIPE_INSTRUCTION_SIZE], bytes, RECIPE_INSTRUCTION_SIZE);
+    this->uploadCount++;
+    return true;
+}
+
+/**
+ * @brief Replace the recipe by the uploaded instructions if they are valid. The position is reset.
+ * @param invalidIndex Output index of the first invalid instruction, the instruction count if the upload is empty.
+ * @return False if the upload is not a valid recipe, the current recipe is then kept.
+ */
+bool RecipeEngine::commitUpload(uint8_t &invalidIndex)
+{
+    if (!validate(this->upload, this->uploadCount, invalidIndex))
+        return false;
+
+    memcpy(this->program, this->upload, this->uploadCount * RECIPE_INSTRUCTION_SIZE);
+    this->instructionCount = this->uploadCount;
+    for (uint8_t i = 0; i < this->instructionCount; i++)
+        decode(&this->program[i * RECIPE_INSTRUCTION_SIZE], this->instructions[i]);
+    start();
+    return true;
+}
+
+/**
+ * @brief Load the saved recipe.
+ * @param preferences Opened preferences.
+ * @param key Key of the recipe.
+ * @return False if there is no valid saved recipe, the recipe is then empty.
+ */
+bool RecipeEngine::load(Preferences &preferences, const char *key)
+{
+    this->instructionCount = 0;
+    start();
+
+    size_t size = preferences.getBytesLength(key);
+    if (size == 0 || size % RECIPE_INSTRUCTION_SIZE != 0 || size > sizeof(this->upload))
+        return false;
+
+    preferences.getBytes(key, this->upload, size);
+    this->uploadCount = size / RECIPE_INSTRUCTION_SIZE;
+    uint8_t invalidIndex = 0;
+    return commitUpload(invalidIndex);
+}
+
+/**
+ * @brief Save the recipe.
+ * @param preferences Opened preferences.
+ * @param key Key of the recipe.
+ */
+void RecipeEngine::save(Preferences &preferences, const char *key) const
+{
+    preferences.putBytes(key, this->program, this->instructionCount * RECIPE_INSTRUCTION_SIZE);
+}
+
+/**
+ * @brief Print every instruction as a "RECIPE=" line of hexadecimal bytes, the lines can be uploaded again.
+ * @param output Where to print the recipe (ex: Serial).
+ */
+void RecipeEngine::print(Print &output) const
+{
+    char hex[3];
+    for (uint8_t i = 0; i < this->instructionCount; i++)
+    {
+        output.print("RECIPE=");
+        for (uint8_t j = 0; j < RECIPE_INSTRUCTION_SIZE; j++)
+        {
+            snprintf(hex, sizeof(hex), "%02X", this->program[i * RECIPE_INSTRUCTION_SIZE + j]);
+            output.print(hex);
+        }
+        output.println();
+    }
+    output.println("Recipe instructions: " + String(this->instructionCount));
+}
+
+/**
+ * @brief Go back to the first instruction of the recipe.
+ */
+void RecipeEngine::start()
+{
+    memset(&this->position, 0, sizeof(this->position));
+}
+
+/**
+ * @brief Get the instruction to execute.
+ * @return The instruction, nullptr once the recipe ended.
+ */
+const sRecipeInstruction *RecipeEngine::getInstruction() const
+{
+    if (this->position.programCounter >= this->instructionCount)
+        return nullptr;
+    return &this->instructions[this->position.programCounter];
+}
+
+/**
+ * @brief Execute the end of the current instruction: a step ended, a loop jumps back or goes on, the recipe ends.
+ */
+void RecipeEngine::next()
+{
+    const sRecipeInstruction *instruction = getInstruction();
+    if (instruction == nullptr)
+        return;
+
+    uint8_t &programCounter = this->position.programCounter;
+    switch (instruction->opcode)
+    {
+    case RECIPE_OP_LOOP:
+    {
+        // The count is reset once the loop is done, so an outer loop runs it again
+        uint8_t &loopCount = this->position.loopCounts[programCounter];
+        if (loopCount < instruction->loopCount)
+        {
+            loopCount++;
+            programCounter = instruction->loopTarget;
+        }
+        else
+        {
+            loopCount = 0;
+            programCounter++;
+        }
+        break;
+    }
+    case RECIPE_OP_END:
+        programCounter = this->instructionCount;
+        break;
+    default:
+        programCounter++;
+        break;
+    }
+}
+
+/**
+ * @brief Resume the recipe at a saved position.
+ * @param position Position given by getPosition().
+ * @return False if the position does not fit the recipe, the recipe then starts from the first instruction.
+ */
+bool RecipeEngine::restore(const sRecipePosition &position)
+{
+    bool isValid = position.programCounter <= this->instructionCount;
+    for (uint8_t i = 0; i < RECIPE_MAX_INSTRUCTIONS && isValid; i++)
+    {
+        uint8_t maxCount = i < this->instructionCount && this->instructions[i].opcode == RECIPE_OP_LOOP ? this->instructions[i].loopCount : 0;
+        isValid = position.loopCounts[i] <= maxCount;
+    }
+
+    if (!isValid)
+    {
+        start();
+        return false;
+    }
+    this->position = position;
+    return true;
+}
+
+/**
+ * @brief Decode a little endian instruction.
+ * @param bytes The RECIPE_INSTRUCTION_SIZE bytes of the instruction.
+ * @param instruction Output instruction.
+ */
+void RecipeEngine::decode(const uint8_t *bytes, sRecipeInstruction &instruction)
+{
+    memset(&instruction, 0, sizeof(instruction));
+    instruction.opcode = bytes[0];
+    switch (instruction.opcode)
+    {
+    case RECIPE_OP_STEP:
+        instruction.outputs = bytes[1] | (bytes[2] << 8);
+        instruction.exit = bytes[3];
+        instruction.exitSource = bytes[4];
+        instruction.exitIndex = bytes[5];
+        instruction.duration = bytes[6] | (bytes[7] << 8);
+        for (uint8_t i = 0; i < RECIPE_PUMP_COUNT; i++)
+            instruction.pumpSpeeds[i] = (int16_t)(bytes[8 + 2 * i] | (bytes[9 + 2 * i] << 8));
+        memcpy(&instruction.threshold, &bytes[16], sizeof(instruction.threshold)); // The ESP32 is little endian
+        break;
+    case RECIPE_OP_LOOP:
+        instruction.loopTarget = bytes[1];
+        instruction.loopCount = bytes[2];
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Check that encoded instructions make a recipe that can be run and that ends.
+ * @param program The encoded instructions.
+ * @param count Number of instructions.
+ * @param invalidIndex Output index of the first invalid instruction, count if there is no instruction.
+ * @return True if the recipe is valid.
+ */
+bool RecipeEngine::validate(const uint8_t *program, uint8_t count, uint8_t &invalidIndex)
+{
+    invalidIndex = count;
+    if (count == 0 || count > RECIPE_MAX_INSTRUCTIONS)
+        return false;
+
+    sRecipeInstruction decoded[RECIPE_MAX_INSTRUCTIONS];
+    for (uint8_t i = 0; i < count; i++)
+        decode(&program[i * RECIPE_INSTRUCTION_SIZE], decoded[i]);
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (!isValidInstruction(decoded, i))
+        {
+            invalidIndex = i;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Check one decoded instruction of a recipe.
+ * @param instructions The decoded recipe.
+ * @param index Index of the instruction to check.
+ * @return True if the instruction is valid.
+ */
+bool RecipeEngine::isValidInstruction(const sRecipeInstruction *instructions, uint8_t index)
+{
+    const sRecipeInstruction &instruction = instructions[index];
+    switch (instruction.opcode)
+    {
+    case RECIPE_OP_STEP:
+        if (instruction.exit >= RECIPE_EXIT_MAX || instruction.outputs >= (1 << RECIPE_OUTPUT_MAX) || instruction.duration == 0)
+            return false;
+        for (uint8_t i = 0; i < RECIPE_PUMP_COUNT; i++)
+        {
+            if (abs(instruction.pumpSpeeds[i]) > RECIPE_MAX_FLOW)
+                return false;
+        }
+        if (instruction.exit == RECIPE_EXIT_VOLUME)
+            return instruction.exitSource < RECIPE_PUMP_COUNT && instruction.pumpSpeeds[instruction.exitSource] != 0 &&
+                   instruction.threshold != 0.0 && isfinite(instruction.threshold);
+        if (instruction.exit == RECIPE_EXIT_SENSOR_ABOVE || instruction.exit == RECIPE_EXIT_SENSOR_BELOW)
+            return instruction.exitSource < SENSOR_ID_MAX && instruction.exitIndex < SENSOR_MAX_VALUES && isfinite(instruction.threshold);
+        return true;
+    case RECIPE_OP_LOOP:
+        // Backward to a step only, each pass then takes at least one bounded step
+        return instruction.loopTarget < index && instructions[instruction.loopTarget].opcode == RECIPE_OP_STEP && instruction.loopCount > 0;
+    case RECIPE_OP_END:
+        return true;
+    default:
+        return false;
+    }
+}
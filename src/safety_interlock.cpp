@@ -0,0 +1,204 @@
+#include "safety_interlock.h"
+
+SafetyInterlock *SafetyInterlock::instance = nullptr;
+
+/**
+ * @brief Constructor of the interlock, nothing is supervised before begin().
+ * @param doorPin Limit switch of the door, LOW when closed.
+ * @param pumps Pumps halted when the door is open.
+ * @param pumpCount Number of pumps.
+ * @param heater Heater turned off on over temperature.
+ * @param ioExpander IO expander of the gas valves closed on over pressure.
+ * @param pressureSensor Pressure of the pressure chamber.
+ */
+SafetyInterlock::SafetyInterlock(uint8_t doorPin, StepperMotor *const *pumps, uint8_t pumpCount, SSR_Relay &heater,
+                                 IOExpander &ioExpander, PressureSensor &pressureSensor)
+    : doorPin(doorPin),
+      pumps(pumps),
+      pumpCount(pumpCount),
+      heater(heater),
+      ioExpander(ioExpander),
+      pressureSensor(pressureSensor),
+      taskHandle(nullptr),
+      trips(0),
+      lastDoorOpenTime(0),
+      lock(portMUX_INITIALIZER_UNLOCKED),
+      isDoorEdgePending(false),
+      doorEdgeTime(0),
+      waterTemperature(NAN),
+      airTemperature(NAN)
+{
+    memset(this->stats, 0, sizeof(this->stats));
+}
+
+/**
+ * @brief Start the supervision task and the door interrupt. The actuators must be initialized before.
+ * @return True if the task is started.
+ */
+bool SafetyInterlock::begin()
+{
+    instance = this;
+    pinMode(this->doorPin, INPUT_PULLUP);
+    if (xTaskCreatePinnedToCore(taskEntry, "interlock", TASK_STACK_SIZE, this, TASK_PRIORITY, &this->taskHandle, TASK_CORE) != pdPASS)
+        return false;
+
+    attachInterrupt(this->doorPin, doorInterrupt, CHANGE);
+    return true;
+}
+
+/**
+ * @brief Give the last measured temperatures, NAN if not available.
+ * @param waterTemperature Temperature of the culture medium (°C).
+ * @param airTemperature Temperature of the air around the culture chamber (°C).
+ */
+void SafetyInterlock::setTemperatures(float waterTemperature, float airTemperature)
+{
+    portENTER_CRITICAL(&this->lock);
+    this->waterTemperature = waterTemperature;
+    this->airTemperature = airTemperature;
+    portEXIT_CRITICAL(&this->lock);
+}
+
+/**
+ * @brief Get the trips of an interlock.
+ * @param interlock Interlock to get.
+ */
+sInterlockStats SafetyInterlock::getStats(eInterlock interlock) const
+{
+    portENTER_CRITICAL(&this->lock);
+    sInterlockStats interlockStats = this->stats[interlock];
+    portEXIT_CRITICAL(&this->lock);
+    return interlockStats;
+}
+
+/**
+ * @brief FreeRTOS entry point of the supervision task.
+ */
+void SafetyInterlock::taskEntry(void *pvParameters)
+{
+    static_cast<SafetyInterlock *>(pvParameters)->run();
+}
+
+/**
+ * @brief Door switch interrupt, wakes the task up at once.
+ */
+void IRAM_ATTR SafetyInterlock::doorInterrupt()
+{
+    portENTER_CRITICAL_ISR(&instance->lock);
+    instance->isDoorEdgePending = true;
+    instance->doorEdgeTime = micros(); // The system clock is not in IRAM, the latencies stay on micros()
+    portEXIT_CRITICAL_ISR(&instance->lock);
+
+    BaseType_t isHigherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(instance->taskHandle, &isHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(isHigherPriorityTaskWoken);
+}
+
+/**
+ * @brief Supervision task: evaluate the rules.
+ */
+void SafetyInterlock::run()
+{
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CHECK_INTERVAL));
+        uint32_t now = micros();
+
+        portENTER_CRITICAL(&this->lock);
+        bool isDoorEdge = this->isDoorEdgePending;
+        uint32_t doorDetectionTime = isDoorEdge ? this->doorEdgeTime : now;
+        this->isDoorEdgePending = false;
+        float water = this->waterTemperature;
+        float air = this->airTemperature;
+        portEXIT_CRITICAL(&this->lock);
+
+        // A single open read may be a glitch of the switch, it must still be open a moment later
+        bool isDoorOpen = digitalRead(this->doorPin) != LOW;
+        if (isDoorOpen && !isTripped(INTERLOCK_DOOR_OPEN))
+        {
+            delayMicroseconds(DOOR_CONFIRM_TIME);
+            isDoorOpen = digitalRead(this->doorPin) != LOW;
+        }
+        if (isDoorOpen)
+            this->lastDoorOpenTime = systemClock.readMillis();
+        bool isDoorClosedLongEnough = !isDoorOpen && systemClock.readMillis() - this->lastDoorOpenTime >= DOOR_DEBOUNCE_TIME;
+        update(INTERLOCK_DOOR_OPEN, isDoorOpen, isDoorClosedLongEnough, doorDetectionTime);
+
+        // The comparisons with NAN are false, a missing temperature neither trips nor clears
+        bool isOverTemperature = water > MAX_WATER_TEMPERATURE || air > MAX_AIR_TEMPERATURE;
+        bool isTemperatureBack = water < MAX_WATER_TEMPERATURE - TEMPERATURE_HYSTERESIS &&
+                                 air < MAX_AIR_TEMPERATURE - TEMPERATURE_HYSTERESIS;
+        update(INTERLOCK_OVER_TEMPERATURE, isOverTemperature, isTemperatureBack, now);
+
+        float pressure = this->pressureSensor.getAgeMs() < PRESSURE_MAX_AGE ? this->pressureSensor.getPressure() : NAN;
+        update(INTERLOCK_OVER_PRESSURE, pressure > MAX_PRESSURE, pressure < MAX_PRESSURE - PRESSURE_HYSTERESIS, now);
+    }
+}
+
+/**
+ * @brief Trip or clear an interlock.
+ * @param interlock Interlock to update.
+ * @param isTripCondition True if the limit is crossed.
+ * @param isClearCondition True if the trip can be cleared.
+ * @param detectionTime micros() when the crossing was detected, for the reaction latency.
+ */
+void SafetyInterlock::update(eInterlock interlock, bool isTripCondition, bool isClearCondition, uint32_t detectionTime)
+{
+    uint8_t bit = 1 << interlock;
+    if (!isTripped(interlock) && isTripCondition)
+    {
+        this->trips |= bit;
+        cutoff(interlock);
+
+        uint32_t latency = micros() - detectionTime;
+        portENTER_CRITICAL(&this->lock);
+        sInterlockStats &interlockStats = this->stats[interlock];
+        interlockStats.tripCount++;
+        interlockStats.lastLatency = latency;
+        if (latency > interlockStats.maxLatency)
+            interlockStats.maxLatency = latency;
+        portEXIT_CRITICAL(&this->lock);
+    }
+    else if (isTripped(interlock) && isClearCondition)
+    {
+        this->trips &= ~bit;
+        if (interlock == INTERLOCK_OVER_TEMPERATURE)
+            this->heater.setInhibited(false);
+        else if (interlock == INTERLOCK_OVER_PRESSURE)
+            setGasValvesInhibited(false);
+    }
+}
+
+/**
+ * @brief Cut the actuators of an interlock.
+ * @param interlock Interlock tripped.
+ */
+void SafetyInterlock::cutoff(eInterlock interlock)
+{
+    switch (interlock)
+    {
+    case INTERLOCK_DOOR_OPEN:
+        for (uint8_t i = 0; i < this->pumpCount; i++)
+            this->pumps[i]->halt();
+        break;
+    case INTERLOCK_OVER_TEMPERATURE:
+        this->heater.setInhibited(true); // Latched in the relay, the main loop cannot turn it on again
+        break;
+    case INTERLOCK_OVER_PRESSURE:
+        setGasValvesInhibited(true); // Latched in the IO expander, the main loop cannot open them again
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Latch the gas valves closed, or release them.
+ * @param isInhibited True to close the valves and keep them closed.
+ */
+void SafetyInterlock::setGasValvesInhibited(bool isInhibited)
+{
+    this->ioExpander.setInhibited(EFUSE_VALVE_O2_INDEX, isInhibited);
+    this->ioExpander.setInhibited(EFUSE_VALVE_CO2_INDEX, isInhibited);
+    this->ioExpander.setInhibited(EFUSE_VALVE_AIR_INDEX, isInhibited);
+}
@@ -0,0 +1,94 @@
+#include "sensor.h"
+
+/**
+ * @brief Constructor of a sensor without sample.
+ * @param name Name printed in the diagnostics.
+ * @param bus Bus used by the driver, the manager polls one sensor per bus at a time.
+ * @param period Time between two polls (ms).
+ * @param maxAge Age after which the last sample is considered stale (ms).
+ */
+Sensor::Sensor(const char *name, eSensorBus bus, unsigned long period, unsigned long maxAge)
+    : name(name), bus(bus), period(period), maxAge(maxAge), isNewSample(false)
+{
+    memset(&this->sample, 0, sizeof(this->sample));
+    this->sample.quality = SENSOR_QUALITY_NO_DATA;
+}
+
+/**
+ * @brief Advance the driver and keep its latest sample.
+ * @param currentTime Time of the poll (ms).
+ * @return True if a new sample was received.
+ */
+bool Sensor::poll(unsigned long currentTime)
+{
+    sSensorSample newSample = {};
+    newSample.timestamp = currentTime;
+    if (!pollDriver(currentTime, newSample))
+        return false;
+
+    this->sample = newSample;
+    this->isNewSample = true;
+    return true;
+}
+
+/**
+ * @brief Get the latest sample and mark it as read, hasNewSample() returns false until the next sample.
+ * @param currentTime Time used to evaluate the quality of the sample (ms).
+ */
+sSensorSample Sensor::readSample(unsigned long currentTime)
+{
+    this->isNewSample = false;
+    return getSample(currentTime);
+}
+
+/**
+ * @brief Get the latest sample without marking it as read.
+ * @param currentTime Time used to evaluate the quality of the sample (ms).
+ */
+sSensorSample Sensor::getSample(unsigned long currentTime) const
+{
+    sSensorSample currentSample = this->sample;
+    currentSample.quality = getQuality(currentTime);
+    return currentSample;
+}
+
+/**
+ * @brief Get a value of the latest sample.
+ * @param index Index of the value, see the sensor implementation for the order.
+ * @return The value, NAN if the sensor has no such value.
+ */
+float Sensor::getValue(uint8_t index) const
+{
+    if (index >= this->sample.valueCount)
+        return NAN;
+    return this->sample.values[index];
+}
+
+/**
+ * @brief Get the age of the latest sample.
+ * @param currentTime Time of the call (ms).
+ * @return Age in milliseconds, 0xFFFFFFFF if there was no sample yet.
+ */
+unsigned long Sensor::getAgeMs(unsigned long currentTime) const
+{
+    return this->sample.valueCount == 0 ? (unsigned long)0xFFFFFFFF : currentTime - this->sample.timestamp;
+}
+
+/**
+ * @brief Get the quality of the latest sample, the errors of the driver take precedence over the age of the sample.
+ * @param currentTime Time of the call (ms).
+ */
+eSensorQuality Sensor::getQuality(unsigned long currentTime) const
+{
+    eSensorQuality driverQuality = getDriverQuality();
+    if (driverQuality != SENSOR_QUALITY_OK)
+        return driverQuality;
+
+    if (this->sample.valueCount == 0)
+        return SENSOR_QUALITY_NO_DATA;
+
+    if (currentTime - this->sample.timestamp > this->maxAge)
+        return SENSOR_QUALITY_STALE;
+
+    return SENSOR_QUALITY_OK;
+}
@@ -0,0 +1,204 @@
+#include "sensor_inputs.h"
+
+/**
+ * @brief Advance the non-blocking measurement cycle of the EZO circuit.
+ */
+bool AtlasSensorInput::pollDriver(unsigned long, sSensorSample &newSample)
+{
+    this->atlas.update();
+
+    unsigned long sampleTime = this->atlas.getLastSampleTime();
+    if (sampleTime == 0 || sampleTime == this->lastSampleTime)
+        return false;
+
+    this->lastSampleTime = sampleTime;
+    newSample.values[0] = this->atlas.getLastValue();
+    newSample.valueCount = 1;
+    newSample.timestamp = sampleTime;
+    return true;
+}
+
+eSensorQuality AtlasSensorInput::getDriverQuality() const
+{
+    switch (this->atlas.getStatus())
+    {
+    case ATLAS_STATUS_NOT_INITIALISED:
+        return SENSOR_QUALITY_NO_DATA;
+    case ATLAS_STATUS_FAILED_TO_SEND_REQUEST:
+    case ATLAS_STATUS_TIMEOUT_EXCEEDED:
+        return SENSOR_QUALITY_COMM_ERROR;
+    case ATLAS_STATUS_PARSING_ERROR:
+    case ATLAS_STATUS_DEVICE_ERROR:
+        return SENSOR_QUALITY_DATA_ERROR;
+    default:
+        return SENSOR_QUALITY_OK;
+    }
+}
+
+/**
+ * @brief Advance the Modbus polling of the VisiFerm.
+ */
+bool VisiFermSensorInput::pollDriver(unsigned long, sSensorSample &newSample)
+{
+    this->visiFerm.update();
+
+    unsigned long sampleTime = this->visiFerm.getLastReadMs();
+    if (sampleTime == 0 || sampleTime == this->lastSampleTime)
+        return false;
+
+    this->lastSampleTime = sampleTime;
+    newSample.values[0] = this->visiFerm.getOxygen();
+    newSample.values[1] = this->visiFerm.getTemperature();
+    newSample.valueCount = 2;
+    newSample.timestamp = sampleTime;
+    return true;
+}
+
+eSensorQuality VisiFermSensorInput::getDriverQuality() const
+{
+    switch (this->visiFerm.getStatus())
+    {
+    case VISIFERM_STATUS_NOT_INITIALISED:
+        return SENSOR_QUALITY_NO_DATA;
+    case VISIFERM_STATUS_TIMEOUT:
+    case VISIFERM_STATUS_CRC_ERROR:
+    case VISIFERM_STATUS_BAD_FRAME:
+        return SENSOR_QUALITY_COMM_ERROR;
+    case VISIFERM_STATUS_SENSOR_STATUS_ERROR:
+        return SENSOR_QUALITY_DATA_ERROR;
+    default:
+        return SENSOR_QUALITY_OK;
+    }
+}
+
+/**
+ * @brief Send the next request to the GMP251 and parse the previous response, the driver limits the request rate.
+ */
+bool Gmp251SensorInput::pollDriver(unsigned long, sSensorSample &newSample)
+{
+    this->gmp251.update();
+
+    unsigned long sampleTime = this->gmp251.getLastSampleTime();
+    if (this->gmp251.getStatus() != GMP_251_STATUS_OK || sampleTime == this->lastSampleTime)
+        return false;
+
+    this->lastSampleTime = sampleTime;
+    newSample.values[0] = this->gmp251.getCO2();
+    newSample.valueCount = 1;
+    newSample.timestamp = sampleTime;
+    return true;
+}
+
+eSensorQuality Gmp251SensorInput::getDriverQuality() const
+{
+    switch (this->gmp251.getStatus())
+    {
+    case GMP_251_STATUS_NOT_INITIALISED:
+        return SENSOR_QUALITY_NO_DATA;
+    case GMP_251_STATUS_FAILED_TO_SEND_REQUEST:
+        return SENSOR_QUALITY_COMM_ERROR;
+    case GMP_251_STATUS_PARSING_FAILED:
+    case GMP_251_STATUS_PARSING_NOT_A_NUMBER:
+        return SENSOR_QUALITY_DATA_ERROR;
+    default:
+        return SENSOR_QUALITY_OK;
+    }
+}
+
+/**
+ * @brief Read the O2 concentration, blocks for the I2C transaction.
+ */
+bool O2SensorInput::pollDriver(unsigned long, sSensorSample &newSample)
+{
+    float o2Concentration = this->o2Sensor.getO2();
+    if (this->o2Sensor.getStatus() != O2_SENSOR_STATUS_OK)
+        return false;
+
+    newSample.values[0] = o2Concentration;
+    newSample.valueCount = 1;
+    return true;
+}
+
+eSensorQuality O2SensorInput::getDriverQuality() const
+{
+    switch (this->o2Sensor.getStatus())
+    {
+    case O2_SENSOR_STATUS_NOT_INITIALIZED:
+        return SENSOR_QUALITY_NO_DATA;
+    case O2_SENSOR_STATUS_FAILED_TO_SEND_REQUEST:
+    case O2_SENSOR_STATUS_TIMEOUT_EXCEEDED:
+        return SENSOR_QUALITY_COMM_ERROR;
+    case O2_SENSOR_STATUS_INVALID_RESPONSE:
+        return SENSOR_QUALITY_DATA_ERROR;
+    default:
+        return SENSOR_QUALITY_OK;
+    }
+}
+
+/**
+ * @brief Read the air temperature and humidity, blocks for 10 ms.
+ */
+bool Sht40SensorInput::pollDriver(unsigned long, sSensorSample &newSample)
+{
+    float temperature = 0;
+    float humidity = 0;
+    this->status = this->sht40.getData(&temperature, &humidity);
+    if (this->status != SHT40_STATUS_OK)
+        return false;
+
+    newSample.values[0] = temperature;
+    newSample.values[1] = humidity;
+    newSample.valueCount = 2;
+    return true;
+}
+
+eSensorQuality Sht40SensorInput::getDriverQuality() const
+{
+    switch (this->status)
+    {
+    case SHT40_STATUS_NOT_INITIALISED:
+        return SENSOR_QUALITY_NO_DATA;
+    case SHT40_STATUS_INVALID_I2C_BUS:
+    case SHT40_STATUS_FAILED_TO_SEND_REQUEST:
+        return SENSOR_QUALITY_COMM_ERROR;
+    case SHT40_STATUS_INVALID_CRC:
+    case SHT40_STATUS_WRONG_MSG_LENGTH:
+        return SENSOR_QUALITY_DATA_ERROR;
+    default:
+        return SENSOR_QUALITY_OK;
+    }
+}
+
+/**
+ * @brief Copy the last pressure published by the acquisition task.
+ */
+bool PressureSensorInput::pollDriver(unsigned long currentTime, sSensorSample &newSample)
+{
+    unsigned long sampleTime = this->pressureSensor.getLastSampleTime();
+    if (sampleTime == 0 || sampleTime == this->lastSampleTime)
+        return false;
+
+    this->lastSampleTime = sampleTime;
+    newSample.values[0] = this->pressureSensor.getPressure();
+    newSample.valueCount = 1;
+    // The task may have published after the tick of this loop, the sample is not dated in the future
+    newSample.timestamp = (long)(sampleTime - currentTime) > 0 ? currentTime : sampleTime;
+    return true;
+}
+
+eSensorQuality PressureSensorInput::getDriverQuality() const
+{
+    switch (this->pressureSensor.getStatus())
+    {
+    case PRESSURE_SENSOR_STATUS_NOT_INITIALISED:
+        return SENSOR_QUALITY_NO_DATA;
+    case PRESSURE_SENSOR_STATUS_INVALID_PIN:
+    case PRESSURE_SENSOR_STATUS_ADC_INIT_FAILED:
+    case PRESSURE_SENSOR_STATUS_TASK_CREATION_FAILED:
+        return SENSOR_QUALITY_COMM_ERROR;
+    case PRESSURE_SENSOR_STATUS_OUT_OF_RANGE:
+        return SENSOR_QUALITY_DATA_ERROR;
+    default:
+        return SENSOR_QUALITY_OK;
+    }
+}
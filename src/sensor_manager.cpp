@@ -0,0 +1,212 @@
+#include "sensor_manager.h"
+
+static const char *const BUS_NAMES[SENSOR_BUS_MAX] = {"I2C", "RS485_1", "RS485_2", "ADC"};
+
+/**
+ * @brief Constructor of the manager, without sensors.
+ */
+SensorManager::SensorManager()
+{
+    for (uint8_t i = 0; i < SENSOR_ID_MAX; i++)
+    {
+        this->sensors[i] = nullptr;
+        this->nextPollTimes[i] = 0;
+        this->heartbeats[i] = NO_HEARTBEAT;
+    }
+}
+
+/**
+ * @brief Register a sensor, must be called before begin().
+ * @param id Identifier used by the consumers to read the sensor.
+ * @param sensor The sensor, it must stay valid while the manager is used.
+ * @return False if the identifier is invalid or already used.
+ */
+bool SensorManager::addSensor(eSensorId id, Sensor *sensor)
+{
+    if (id >= SENSOR_ID_MAX || sensor == nullptr || this->sensors[id] != nullptr)
+        return false;
+
+    this->sensors[id] = sensor;
+    return true;
+}
+
+/**
+ * @brief Schedule the first poll of each sensor, staggered per bus, and register their heartbeats.
+ * @param currentTime Current time (ms).
+ */
+void SensorManager::begin(unsigned long currentTime)
+{
+    uint8_t busSensorCount[SENSOR_BUS_MAX] = {};
+    for (uint8_t i = 0; i < SENSOR_ID_MAX; i++)
+    {
+        if (this->sensors[i] == nullptr)
+            continue;
+
+        eSensorBus bus = this->sensors[i]->getBus();
+        this->nextPollTimes[i] = currentTime + busSensorCount[bus] * STAGGER_INTERVAL;
+        busSensorCount[bus]++;
+        this->heartbeats[i] = registerHeartbeat(this->sensors[i]->getName(), HEARTBEAT_DEADLINE);
+    }
+}
+
+/**
+ * @brief Poll the sensors that are due, at most one per bus. Must be called in the main loop.
+ * @param currentTime Current time (ms).
+ */
+void SensorManager::update(unsigned long currentTime)
+{
+    for (uint8_t bus = 0; bus < SENSOR_BUS_MAX; bus++)
+    {
+        int8_t mostLateSensor = -1;
+        unsigned long mostLateDelay = 0;
+        for (uint8_t i = 0; i < SENSOR_ID_MAX; i++)
+        {
+            if (this->sensors[i] == nullptr || this->sensors[i]->getBus() != bus)
+                continue;
+
+            // Wrap-safe "currentTime >= nextPollTime"
+            unsigned long lateness = currentTime - this->nextPollTimes[i];
+            if ((long)lateness < 0)
+                continue;
+
+            if (mostLateSensor < 0 || lateness > mostLateDelay)
+            {
+                mostLateSensor = i;
+                mostLateDelay = lateness;
+            }
+        }
+
+        if (mostLateSensor < 0)
+            continue;
+
+        Sensor *sensor = this->sensors[mostLateSensor];
+        if (sensor->poll(currentTime) || sensor->getDriverQuality() != SENSOR_QUALITY_OK)
+            feedHeartbeat(this->heartbeats[mostLateSensor]);
+
+        // Keep the phase of the sensor, unless it missed a whole period
+        unsigned long period = sensor->getPeriod();
+        this->nextPollTimes[mostLateSensor] = mostLateDelay >= period ? currentTime + period : this->nextPollTimes[mostLateSensor] + period;
+    }
+}
+
+/**
+ * @brief Get a registered sensor.
+ * @return The sensor, nullptr if none is registered with this identifier.
+ */
+Sensor *SensorManager::getSensor(eSensorId id) const
+{
+    if (id >= SENSOR_ID_MAX)
+        return nullptr;
+    return this->sensors[id];
+}
+
+/**
+ * @brief Check if a sensor has a sample that was not read with readSample().
+ */
+bool SensorManager::hasNewSample(eSensorId id) const
+{
+    Sensor *sensor = getSensor(id);
+    return sensor != nullptr && sensor->hasNewSample();
+}
+
+/**
+ * @brief Get the latest sample of a sensor and mark it as read.
+ * @param id The sensor.
+ * @param currentTime Time used to evaluate the quality of the sample (ms).
+ */
+sSensorSample SensorManager::readSample(eSensorId id, unsigned long currentTime)
+{
+    Sensor *sensor = getSensor(id);
+    if (sensor == nullptr)
+    {
+        sSensorSample sample = {};
+        sample.quality = SENSOR_QUALITY_NO_DATA;
+        return sample;
+    }
+    return sensor->readSample(currentTime);
+}
+
+/**
+ * @brief Get a value of the latest sample of a sensor, see eSensorId for the values of each sensor.
+ * @return The value, NAN if the sensor has no such value.
+ */
+float SensorManager::getValue(eSensorId id, uint8_t index) const
+{
+    Sensor *sensor = getSensor(id);
+    return sensor == nullptr ? NAN : sensor->getValue(index);
+}
+
+/**
+ * @brief Get the quality of the latest sample of a sensor.
+ * @param id The sensor.
+ * @param currentTime Time used to evaluate the age of the sample (ms).
+ */
+eSensorQuality SensorManager::getQuality(eSensorId id, unsigned long currentTime) const
+{
+    Sensor *sensor = getSensor(id);
+    return sensor == nullptr ? SENSOR_QUALITY_NO_DATA : sensor->getQuality(currentTime);
+}
+
+/**
+ * @brief Copy the latest samples of all the sensors, without marking them as read.
+ * @param snapshot Output samples, indexed by eSensorId.
+ * @param currentTime Time used to evaluate the quality of the samples (ms).
+ */
+void SensorManager::getSnapshot(sSensorSnapshot &snapshot, unsigned long currentTime) const
+{
+    snapshot.time = currentTime;
+    for (uint8_t i = 0; i < SENSOR_ID_MAX; i++)
+    {
+        if (this->sensors[i] == nullptr)
+        {
+            memset(&snapshot.samples[i], 0, sizeof(sSensorSample));
+            snapshot.samples[i].quality = SENSOR_QUALITY_NO_DATA;
+            continue;
+        }
+        snapshot.samples[i] = this->sensors[i]->getSample(currentTime);
+    }
+}
+
+/**
+ * @brief Print the counters of all the drivers and the traffic of each bus, in one line:
+ * DIAG=<time>;<sensor>,<quality>,<driver counters>;...;<bus>,<bytes sent>,<bytes received>;...
+ * See DriverStats::print() for the order of the driver counters.
+ * @param output Where to print the diagnostics (ex: Serial).
+ * @param currentTime Time used to evaluate the quality of the samples (ms).
+ */
+void SensorManager::printDiagnostics(Print &output, unsigned long currentTime) const
+{
+    uint32_t busBytesSent[SENSOR_BUS_MAX] = {};
+    uint32_t busBytesReceived[SENSOR_BUS_MAX] = {};
+
+    output.print("DIAG=");
+    output.print(currentTime);
+    for (uint8_t i = 0; i < SENSOR_ID_MAX; i++)
+    {
+        if (this->sensors[i] == nullptr)
+            continue;
+
+        const DriverStats &stats = this->sensors[i]->getDriverStats();
+        output.print(';');
+        output.print(this->sensors[i]->getName());
+        output.print(',');
+        output.print(this->sensors[i]->getQuality(currentTime));
+        output.print(',');
+        stats.print(output);
+
+        eSensorBus bus = this->sensors[i]->getBus();
+        busBytesSent[bus] += stats.get().bytesSent;
+        busBytesReceived[bus] += stats.get().bytesReceived;
+    }
+
+    for (uint8_t bus = 0; bus < SENSOR_BUS_MAX; bus++)
+    {
+        output.print(';');
+        output.print(BUS_NAMES[bus]);
+        output.print(',');
+        output.print(busBytesSent[bus]);
+        output.print(',');
+        output.print(busBytesReceived[bus]);
+    }
+    output.println();
+}
@@ -1,10 +1,38 @@
 #include "serialReader.h"
 
+/**
+ * @brief Get the next command to execute.
+ * @param rx Output command, without the line ending.
+ * @return True if there is a command to execute.
+ * @note During a bus replay, the commands received during the capture are executed again.
+ */
+static bool readSerialCommand(String &rx)
+{
+    char recorded[BusRecorder::MAX_DATA_LENGTH + 1];
+    uint16_t length = busRecorder.replay(BUS_CHANNEL_COMMAND, 0, (uint8_t *)recorded, BusRecorder::MAX_DATA_LENGTH);
+    if (length > 0)
+    {
+        recorded[length] = '\0';
+        rx = recorded;
+        return true;
+    }
+
+    if (!Serial.available())
+        return false;
+
+    rx = Serial.readStringUntil('\n');
+
+    // The recorder commands are not part of the incident
+    if (!rx.startsWith("REC-") && !rx.startsWith("REC="))
+        busRecorder.record(BUS_CHANNEL_COMMAND, 0, (const uint8_t *)rx.c_str(), rx.length());
+    return true;
+}
+
 void receiveSerialCommand()
 {
-    if (Serial.available())
+    String rx;
+    if (readSerialCommand(rx))
     {
-        String rx = Serial.readStringUntil('\n');
 
         uint8_t rx_buff[sizeof(float) * 6];
         if (rx == "STATE=APPROV")
@@ -92,18 +120,28 @@ void receiveSerialCommand()
             setBioreactorState((uint8_t)eBioreactorState::HEATING);
             Serial.println("Bioreactor State set to HEATING");
         }
-        if (sscanf(rx.c_str(), "STATE=%d", (uint8_t *)rx_buff))
+        if (rx == "STATE=RECIPE")
         {
-            eBioreactorState state = (eBioreactorState) * ((uint8_t *)rx_buff);
-            if (state >= eBioreactorState::MAX_STATE)
+            if (recipeEngine.getInstructionCount() == 0)
             {
+                Serial.println("No recipe saved");
                 return;
             }
-            setBioreactorState((uint8_t)state);
+            setBioreactorState((uint8_t)eBioreactorState::RECIPE);
+            Serial.println("Bioreactor State set to RECIPE");
+        }
+        int stateNumber = 0;
+        if (sscanf(rx.c_str(), "STATE=%d", &stateNumber) == 1)
+        {
+            if (stateNumber < 0 || stateNumber >= (int)eBioreactorState::MAX_STATE)
+            {
+                return;
+            }
+            setBioreactorState((uint8_t)stateNumber);
             Serial.print("Bioreactor State set to: ");
-            Serial.println(static_cast<int>(state));
+            Serial.println(stateNumber);
         }
-        if (sscanf(rx.c_str(), "TEMP=%f", (float *)rx_buff))
+        if (sscanf(rx.c_str(), "TEMP=%f", (float *)rx_buff) == 1)
         {
             float temp = *((float *)rx_buff);
             temperatureController.setReferenceTemperature(temp);
@@ -111,36 +149,67 @@ void receiveSerialCommand()
             Serial.print("Temperature Reference updated to: ");
             Serial.println(temp);
         }
-        if (sscanf(rx.c_str(), "PH=%f", (float *)rx_buff))
+        if (sscanf(rx.c_str(), "PH=%f", (float *)rx_buff) == 1)
         {
             float ph = *((float *)rx_buff);
             bioreactorParameter.putFloat("ph", ph);
+            phController.setReferencePh(ph);
             Serial.print("pH Reference updated to: ");
             Serial.println(ph);
         }
-        if (sscanf(rx.c_str(), "DO=%f", (float *)rx_buff))
+        if (sscanf(rx.c_str(), "DO=%f", (float *)rx_buff) == 1)
         {
             float oxy_percent = *((float *)rx_buff);
             bioreactorParameter.putFloat("do", oxy_percent);
+            doController.setReferenceDo(oxy_percent);
             Serial.print("Dissolved Oxygen Reference updated to: ");
             Serial.println(oxy_percent);
         }
-        if (sscanf(rx.c_str(), "CO2=%f", (float *)rx_buff))
+        if (rx.startsWith("DO-O2-LIMITS="))
+        {
+            float minLevel = NAN;
+            float maxLevel = NAN;
+            if (sscanf(rx.c_str(), "DO-O2-LIMITS=%f,%f", &minLevel, &maxLevel) != 2 || !doController.setO2Limits(minLevel, maxLevel))
+            {
+                Serial.println("Invalid O2 limits, expected DO-O2-LIMITS=<min %>,<max %>");
+                return;
+            }
+            bioreactorParameter.putFloat("doo2min", minLevel);
+            bioreactorParameter.putFloat("doo2max", maxLevel);
+            Serial.println("O2 reference limits updated to: " + String(minLevel) + " - " + String(maxLevel));
+        }
+        if (sscanf(rx.c_str(), "CO2=%f", (float *)rx_buff) == 1)
         {
             float CO2_PPM = *((float *)rx_buff);
             bioreactorParameter.putFloat("CO2", CO2_PPM);
-            pressureChamber.setReferenceLevel(CO2, CO2_PPM);
+            phController.setNominalCo2Level(CO2_PPM);
+            pressureChamber.setReferenceLevel(CO2, phController.getCo2Level());
             Serial.print("CO2 Reference Level updated to: ");
             Serial.println(CO2_PPM);
         }
-        if (sscanf(rx.c_str(), "O2=%f", (float *)rx_buff))
+        if (sscanf(rx.c_str(), "O2=%f", (float *)rx_buff) == 1)
         {
             float O2_PPM = *((float *)rx_buff);
             bioreactorParameter.putFloat("O2", O2_PPM);
-            pressureChamber.setReferenceLevel(O2, O2_PPM);
+            doController.setNominalO2Level(O2_PPM);
+            pressureChamber.setReferenceLevel(O2, doController.getO2Level());
             Serial.print("O2 Reference Level updated to: ");
             Serial.println(O2_PPM);
         }
+        if (rx.startsWith("PH-BASE-PUMP="))
+        {
+            // -1 when no pump is connected to a base bottle
+            int pumpIndex = rx.substring(13).toInt();
+            if (pumpIndex != NO_PUMP && !isDosingPump(pumpIndex))
+            {
+                Serial.println("Invalid base pump, must be a dosing pump or -1");
+                return;
+            }
+            phBasePumpIndex = pumpIndex;
+            phController.setBaseEnabled(pumpIndex != NO_PUMP);
+            bioreactorParameter.putChar("phbasepump", phBasePumpIndex);
+            Serial.println("pH base pump set to: " + String(pumpIndex));
+        }
         if (sscanf(rx.c_str(), "PUMP-SPEED=%f,%f,%f,%f", &(((float *)rx_buff)[0]), &(((float *)rx_buff)[1]), &(((float *)rx_buff)[2]), &(((float *)rx_buff)[3])))
         {
             // uint8_t i = 0;
@@ -167,6 +236,90 @@ void receiveSerialCommand()
             pHSensor.calibrateSinglePoint(eCalibrationValues::CAL_PH_10);
             Serial.println("pH Sensor calibrated at pH 10");
         }
+        if (rx.startsWith("CALIB-PUMP-RUN="))
+        {
+            // Runs an uncalibrated volume, weigh it and send CALIB-PUMP= with the same pump and flow
+            int pumpIndex = 0;
+            float flow = 0.0;
+            StepperMotor *pump = nullptr;
+            if (sscanf(rx.c_str(), "CALIB-PUMP-RUN=%d,%f", &pumpIndex, &flow) == 2 && pumpIndex >= 0)
+                pump = getPump(pumpIndex);
+            if (bioreactorState != eBioreactorState::IDLE || pump == nullptr || flow == 0.0)
+            {
+                Serial.println("Pump calibration run only available in IDLE state, with a pump index and a flow");
+                return;
+            }
+            pump->dispense(flow * PUMP_CALIBRATION_RUN_TIME, fabsf(flow), false);
+            Serial.println("Pump " + String(pumpIndex) + " calibration run started");
+        }
+        if (rx.startsWith("CALIB-PUMP="))
+        {
+            int pumpIndex = 0;
+            float flow = 0.0;
+            float mass = 0.0;
+            StepperMotor *pump = nullptr;
+            if (sscanf(rx.c_str(), "CALIB-PUMP=%d,%f,%f", &pumpIndex, &flow, &mass) == 3 && pumpIndex >= 0)
+                pump = getPump(pumpIndex);
+            float measuredFlow = mass / MEDIUM_DENSITY / PUMP_CALIBRATION_RUN_TIME;
+            if (pump == nullptr || !pump->getCalibration().addPoint(flow, measuredFlow))
+            {
+                Serial.println("Invalid pump calibration point");
+                return;
+            }
+            pump->getCalibration().save(bioreactorParameter, getPumpCalibrationKey(pumpIndex).c_str());
+            Serial.println("Pump " + String(pumpIndex) + " calibrated, measured flow (ml/min): " + String(measuredFlow));
+        }
+        if (rx.startsWith("CALIB-PUMP-CLEAR="))
+        {
+            int pumpIndex = rx.substring(17).toInt();
+            StepperMotor *pump = pumpIndex >= 0 ? getPump(pumpIndex) : nullptr;
+            if (pump != nullptr)
+            {
+                pump->getCalibration().clear();
+                bioreactorParameter.remove(getPumpCalibrationKey(pumpIndex).c_str());
+                Serial.println("Pump " + String(pumpIndex) + " calibration cleared");
+            }
+        }
+        if (rx == "CALIB-PUMP?")
+        {
+            for (uint8_t i = 0; i < PUMP_COUNT; i++)
+            {
+                Serial.print("CALIB-PUMP=" + String(i) + ";");
+                getPump(i)->getCalibration().print(Serial);
+                Serial.println();
+            }
+        }
+        if (rx == "RECIPE-BEGIN")
+        {
+            recipeEngine.beginUpload();
+            Serial.println("Recipe upload started");
+        }
+        if (rx.startsWith("RECIPE="))
+        {
+            if (!recipeEngine.addInstruction(rx.substring(7)))
+                Serial.println("Invalid recipe instruction or recipe full");
+        }
+        if (rx == "RECIPE-SAVE")
+        {
+            // The running recipe is not replaced, its saved position would not match
+            if (bioreactorState == eBioreactorState::RECIPE)
+            {
+                Serial.println("Recipe not saved while a recipe is running");
+                return;
+            }
+            uint8_t invalidIndex = 0;
+            if (!recipeEngine.commitUpload(invalidIndex))
+            {
+                Serial.println("Invalid recipe at instruction " + String(invalidIndex) + ", previous recipe kept");
+                return;
+            }
+            recipeEngine.save(bioreactorParameter, "recipe");
+            Serial.println("Recipe saved (" + String(recipeEngine.getInstructionCount()) + " instructions)");
+        }
+        if (rx == "RECIPE?")
+        {
+            recipeEngine.print(Serial);
+        }
         if (rx == "CALIB-DO=0")
         {
             // do calib
@@ -175,5 +328,54 @@ void receiveSerialCommand()
         {
             // do calib
         }
+        if (rx == "DIAG?")
+        {
+            sensorManager.printDiagnostics(Serial, systemClock.getMillis());
+            Serial.print("DRV=" + String(systemClock.getMillis()));
+            for (uint8_t i = 0; i < DRIVE_COUNT; i++)
+            {
+                const DriveTmc5041 &drive = pumpRegistry.getDrive(i);
+                Serial.print(";" + String(DRIVE_TABLE[i].name) + "," + String(drive.getSpiStatus()) + ",");
+                drive.getStats().print(Serial);
+            }
+            Serial.println();
+        }
+        if (rx == "REC-START")
+        {
+            busRecorder.startCapture();
+            Serial.println("Bus capture started");
+        }
+        if (rx == "REC-STOP")
+        {
+            busRecorder.stop();
+            Serial.println("Bus recorder stopped");
+        }
+        if (rx == "REC-CLEAR")
+        {
+            busRecorder.clear();
+            Serial.println("Bus records cleared");
+        }
+        if (rx == "REC-DUMP")
+        {
+            busRecorder.dump(Serial);
+        }
+        if (rx.startsWith("REC="))
+        {
+            if (!busRecorder.load(rx.substring(4)))
+                Serial.println("Invalid bus record or recorder not stopped");
+        }
+        if (rx == "REC-REPLAY")
+        {
+            // The replayed commands drive the bioreactor like during the capture, start from a known state
+            if (bioreactorState != eBioreactorState::IDLE)
+            {
+                Serial.println("Bus replay only available in IDLE state");
+                return;
+            }
+            if (busRecorder.startReplay())
+                Serial.println("Bus replay started (" + String(busRecorder.getRecordCount()) + " records)");
+            else
+                Serial.println("No bus records to replay");
+        }
     }
 }
\ No newline at end of file
@@ -1,16 +1,21 @@
-#include "SSR_Relay.h"
+#include "ssr_relay.h"
 
 /**
  * @brief Constructor to initialize the relay control pin.
  * @param pin The control pin for the SSR relay.
  */
-SSR_Relay::SSR_Relay(uint8_t pin) : pin(pin), lastCheckTime(0) {}
+SSR_Relay::SSR_Relay(uint8_t pin)
+    : lastCheckTime(0), levelPWM(0), pin(pin), currentPWMIndex(0), isOutputOn(false), isInhibited(false),
+      lock(portMUX_INITIALIZER_UNLOCKED) {}
 
 /**
  * @brief Initialise SSR relay pin and set default state.
  */
 void SSR_Relay::begin()
 {
+    if (this->pin == NO_PIN)
+        return;
+
     pinMode(this->pin, OUTPUT);
     digitalWrite(this->pin, LOW);
 }
@@ -30,6 +35,31 @@ void SSR_Relay::setLevel(uint8_t level)
 void SSR_Relay::off()
 {
     this->setLevel(0);
+
+    // Cut the output at once instead of at the next PWM step
+    portENTER_CRITICAL(&this->lock);
+    this->isOutputOn = false;
+    if (this->pin != NO_PIN)
+        digitalWrite(pin, LOW);
+    portEXIT_CRITICAL(&this->lock);
+}
+
+/**
+ * @brief Latch the output off, or release it. The level set meanwhile is applied from the next PWM step after the
+ * release.
+ * @param isInhibited True to cut the output at once and keep it off.
+ */
+void SSR_Relay::setInhibited(bool isInhibited)
+{
+    portENTER_CRITICAL(&this->lock);
+    this->isInhibited = isInhibited;
+    if (isInhibited)
+    {
+        this->isOutputOn = false;
+        if (this->pin != NO_PIN)
+            digitalWrite(pin, LOW);
+    }
+    portEXIT_CRITICAL(&this->lock);
 }
 
 /**
@@ -37,14 +67,23 @@ void SSR_Relay::off()
  */
 void SSR_Relay::update()
 {
-    unsigned long currentTime = millis();
+    update(systemClock.getMillis());
+}
 
+/**
+ * @brief Manage the relay PWM at a given time.
+ * @param currentTime Current time (ms), allows to run the relay on a simulated time.
+ */
+void SSR_Relay::update(unsigned long currentTime)
+{
     if (currentTime - lastCheckTime >= CHECK_INTERVAL)
     {
-        if (currentPWMIndex < levelPWM)
-            digitalWrite(pin, HIGH);
-        else
-            digitalWrite(pin, LOW);
+        // The inhibit is checked with the pin write, so a cut cannot land between the two
+        portENTER_CRITICAL(&this->lock);
+        this->isOutputOn = !this->isInhibited && currentPWMIndex < levelPWM;
+        if (this->pin != NO_PIN)
+            digitalWrite(pin, this->isOutputOn ? HIGH : LOW);
+        portEXIT_CRITICAL(&this->lock);
 
         currentPWMIndex++;
         lastCheckTime = currentTime;
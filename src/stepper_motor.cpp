@@ -4,8 +4,26 @@ const uint8_t StepperMotor::MOTOR_DRV_IHOLD_IRUN_ADDR[MOTOR_NAME_MAX] = {0x30, 0
 const uint8_t StepperMotor::MOTOR_DRV_AMAX_ADDR[MOTOR_NAME_MAX] = {0x26, 0x46};
 const uint8_t StepperMotor::MOTOR_DRV_SET_SPEED_ADDR[MOTOR_NAME_MAX] = {0x27, 0x47};
 const uint8_t StepperMotor::MOTOR_DRV_SET_MODE_ADDR[MOTOR_NAME_MAX] = {0x20, 0x40};
+const uint8_t StepperMotor::MOTOR_DRV_VACTUAL_ADDR[MOTOR_NAME_MAX] = {0x22, 0x42};
+const uint8_t StepperMotor::MOTOR_DRV_XACTUAL_ADDR[MOTOR_NAME_MAX] = {0x21, 0x41};
+const uint8_t StepperMotor::MOTOR_DRV_XTARGET_ADDR[MOTOR_NAME_MAX] = {0x2D, 0x4D};
+const uint8_t StepperMotor::MOTOR_DRV_VSTART_ADDR[MOTOR_NAME_MAX] = {0x23, 0x43};
+const uint8_t StepperMotor::MOTOR_DRV_A1_ADDR[MOTOR_NAME_MAX] = {0x24, 0x44};
+const uint8_t StepperMotor::MOTOR_DRV_V1_ADDR[MOTOR_NAME_MAX] = {0x25, 0x45};
+const uint8_t StepperMotor::MOTOR_DRV_DMAX_ADDR[MOTOR_NAME_MAX] = {0x28, 0x48};
+const uint8_t StepperMotor::MOTOR_DRV_D1_ADDR[MOTOR_NAME_MAX] = {0x2A, 0x4A};
+const uint8_t StepperMotor::MOTOR_DRV_VSTOP_ADDR[MOTOR_NAME_MAX] = {0x2B, 0x4B};
+const uint8_t StepperMotor::MOTOR_DRV_DRV_STATUS_ADDR[MOTOR_NAME_MAX] = {0x6F, 0x7F};
 const uint8_t StepperMotor::SET_SPEED_CONFIG_MSG_ADDR_LIST[MOTOR_NAME_MAX][CONFIG_MSG_SIZE] = {{0x6C, 0x30, 0x2C, 0x10, 0x32, 0x31, 0x26}, {0x7C, 0x50, 0x4C, 0x18, 0x52, 0x51, 0x46}};
-const uint32_t StepperMotor::SET_SPEED_CONFIG_MSG_DATA_LIST[CONFIG_MSG_SIZE] = {0x010100C5, RUNNING_TORQUE * 2, 0x00002710, 0x003501C8, 0x00061A80, 0x00007530, 0x00001388};
+const uint32_t StepperMotor::SET_SPEED_CONFIG_MSG_DATA_LIST[CONFIG_MSG_SIZE] = {0x010100C5, RUNNING_TORQUE * 2, 0x00002710, 0x003501C8, 0x00061A80, 0x00007530, DEFAULT_AMAX};
+
+/**
+ * @brief Construct a StepperMotor object without drive, to be replaced by one with a drive before begin()
+ */
+StepperMotor::StepperMotor()
+    : StepperMotor(nullptr, MOTOR_1)
+{
+}
 
 /**
  * @brief Construct a new StepperMotor object
@@ -16,7 +34,22 @@ const uint32_t StepperMotor::SET_SPEED_CONFIG_MSG_DATA_LIST[CONFIG_MSG_SIZE] = {
 StepperMotor::StepperMotor(DriveTmc5041 *drive_handle, eMotorName motorName)
     : _drive_handle(drive_handle),
       _motorName(motorName),
-      _isInit(false)
+      _isInit(false),
+      _amax(DEFAULT_AMAX),
+      _speed(0.0),
+      _isDispensing(false),
+      _dispenseTarget(0),
+      _dispenseRatio(1.0),
+      _dispenseVmax(0),
+      _isHalted(false),
+      _isTorqueHeld(false),
+      _lastLoadSampleTime(0),
+      _load(0),
+      _loadBaseline(0.0),
+      _baselineCount(0),
+      _abnormalCount(0),
+      _abnormalEvent(PUMP_EVENT_NONE),
+      _event(PUMP_EVENT_NONE)
 {
 }
 
@@ -33,10 +66,7 @@ eMotorStatus StepperMotor::begin()
         return MOTOR_STATUS_INCORRECT_VARIABLE;
 
     // Motor specific configuration
-    for (uint8_t i = 0; i < CONFIG_MSG_SIZE; i++)
-    {
-        _drive_handle->tmc_write(SET_SPEED_CONFIG_MSG_ADDR_LIST[_motorName][i], SET_SPEED_CONFIG_MSG_DATA_LIST[i]);
-    }
+    _drive_handle->writeRegisters(SET_SPEED_CONFIG_MSG_ADDR_LIST[_motorName], SET_SPEED_CONFIG_MSG_DATA_LIST, CONFIG_MSG_SIZE);
 
     _isInit = true;
     return MOTOR_STATUS_OK;
@@ -45,35 +75,256 @@ eMotorStatus StepperMotor::begin()
 /**
  * @brief Set the motor speed in ml/min
  *
- * @param speed speed in ml/min (+ is clockwise, - is counterclockwise)
+ * The TMC5041 ramp generator reaches the new speed at the acceleration set by setAcceleration(), a change of
+ * direction decelerates to zero first. When the speed is zero the current is kept until the motor has stopped,
+ * then released at the next call. The load of the motor is read in the same transaction every LOAD_SAMPLE_INTERVAL.
+ *
+ * @param speed speed in ml/min (+ is clockwise, - is counterclockwise), corrected by the flow calibration
  * @return eMotorStatus MOTOR_STATUS_OK if no problem occured else return error code
  */
 eMotorStatus StepperMotor::setSpeed(float speed)
 {
+    sTmcDatagram datagrams[MAX_SPEED_DATAGRAMS];
+    uint8_t count = 0;
+    lockDrive();
+    eMotorStatus status = prepareSpeed(speed, datagrams, count);
+    if (status == MOTOR_STATUS_OK && count > 0)
+    {
+        _drive_handle->transfer(datagrams, count);
+        completeSpeed(datagrams, count);
+    }
+    unlockDrive();
+    return status;
+}
+
+/**
+ * @brief First half of setSpeed(), gives the datagrams to send instead of sending them, so the speeds of several
+ * motors of a drive can be sent in one transaction
+ *
+ * @param speed speed in ml/min (+ is clockwise, - is counterclockwise), corrected by the flow calibration
+ * @param datagrams where to write the datagrams, MAX_SPEED_DATAGRAMS at most
+ * @param count where to store the number of datagrams to send, 0 if there is nothing to send (halted)
+ * @return eMotorStatus MOTOR_STATUS_OK if no problem occured else return error code
+ * @note The datagrams must be given to completeSpeed() once exchanged, the drive must stay locked from prepareSpeed() to
+ * completeSpeed() so the safety interlock cannot halt the motor in between
+ */
+eMotorStatus StepperMotor::prepareSpeed(float speed, sTmcDatagram *datagrams, uint8_t &count)
+{
+    count = 0;
     if (!_isInit)
         return MOTOR_STATUS_NOT_INITIALISED;
+    if (_isDispensing && !isDispenseComplete())
+        return MOTOR_STATUS_BUSY;
 
     eMotorMode direction = MOTOR_MODE_SPEED_CONTROL_COUNTERCLOCKWISE;
     uint32_t torque = RUNNING_TORQUE;
     if (speed == 0.0)
     {
-        torque = 0;
+        // The status of the last exchange tells if the ramp down is over, the motor would freewheel before
+        if (_speed == 0.0 && isVelocityReached())
+            torque = 0;
     }
     else if (speed < 0.0)
     {
         direction = MOTOR_MODE_SPEED_CONTROL_CLOCKWISE;
-        speed = fabsf(speed);
     }
+    if (speed != _speed)
+        resetLoadBaseline();
+    _speed = speed;
+
+    // Applied by resume()
+    if (_isHalted)
+        return MOTOR_STATUS_OK;
+
+    float commandedSpeed = fabsf(_calibration.getCommandedFlow(speed));
+    const sTmcDatagram speedDatagrams[MAX_SPEED_DATAGRAMS] = {
+        {(uint8_t)(MOTOR_DRV_IHOLD_IRUN_ADDR[_motorName] | DriveTmc5041::TMC_WRITE_BIT), torque, 0},
+        {(uint8_t)(MOTOR_DRV_AMAX_ADDR[_motorName] | DriveTmc5041::TMC_WRITE_BIT), _amax, 0},
+        {(uint8_t)(MOTOR_DRV_SET_SPEED_ADDR[_motorName] | DriveTmc5041::TMC_WRITE_BIT), uint32_t(commandedSpeed * ML_PER_MIN_TO_REG), 0},
+        {(uint8_t)(MOTOR_DRV_SET_MODE_ADDR[_motorName] | DriveTmc5041::TMC_WRITE_BIT), (uint32_t)direction, 0},
+        {MOTOR_DRV_DRV_STATUS_ADDR[_motorName], 0, 0},
+        {MOTOR_DRV_DRV_STATUS_ADDR[_motorName], 0, 0}, // Clocks out the DRV_STATUS response
+    };
+
+    bool isLoadSampled = speed != 0.0 && isLoadSampleDue();
+    count = isLoadSampled ? MAX_SPEED_DATAGRAMS : SET_SPEED_MSG_SIZE;
+    memcpy(datagrams, speedDatagrams, count * sizeof(sTmcDatagram));
+    _isTorqueHeld = torque != 0;
+    return MOTOR_STATUS_OK;
+}
+
+/**
+ * @brief Second half of setSpeed(), reads the responses of the datagrams given by prepareSpeed()
+ *
+ * @param datagrams the datagrams once exchanged with the drive
+ * @param count number of datagrams given by prepareSpeed()
+ */
+void StepperMotor::completeSpeed(const sTmcDatagram *datagrams, uint8_t count)
+{
+    if (count == MAX_SPEED_DATAGRAMS)
+        updateLoad(datagrams[MAX_SPEED_DATAGRAMS - 1].data);
+}
+
+/**
+ * @brief Check if the motor has to be written again at the same speed: to release the current once stopped, to
+ * sample the load while running or to check the end of a volume
+ *
+ * @return true if setSpeed() with the same speed would do something
+ */
+bool StepperMotor::isRefreshNeeded() const
+{
+    if (!_isInit || _isHalted)
+        return false;
+    if (_isDispensing)
+        return true;
+    return _speed == 0.0 ? _isTorqueHeld : isLoadSampleDue();
+}
+
+/**
+ * @brief Set the acceleration of the speed changes, used from the next setSpeed()
+ *
+ * @param acceleration acceleration in ml/min per second, clamped to the fastest ramp of the driver
+ * @return eMotorStatus MOTOR_STATUS_OK if no problem occured else return error code
+ */
+eMotorStatus StepperMotor::setAcceleration(float acceleration)
+{
+    if (acceleration <= 0.0)
+        return MOTOR_STATUS_INCORRECT_VARIABLE;
+
+    float amax = acceleration * ML_PER_MIN_PER_S_TO_AMAX;
+    _amax = amax > MAX_AMAX ? MAX_AMAX : max((uint32_t)amax, (uint32_t)1);
+    return MOTOR_STATUS_OK;
+}
+
+/**
+ * @brief Read the speed of the motor during the ramp
+ *
+ * @param speed where to store the actual speed in ml/min (+ is clockwise, - is counterclockwise)
+ * @return eMotorStatus MOTOR_STATUS_OK if no problem occured else return error code
+ * @note The speed is not corrected by the flow calibration
+ */
+eMotorStatus StepperMotor::getActualSpeed(float &speed)
+{
+    if (!_isInit)
+        return MOTOR_STATUS_NOT_INITIALISED;
+
+    uint32_t vactual = 0;
+    eMotorStatus status = _drive_handle->readRegisters(&MOTOR_DRV_VACTUAL_ADDR[_motorName], &vactual, 1);
+    if (status != MOTOR_STATUS_OK)
+        return status;
+
+    // VACTUAL is a signed 24 bit value, positive in the clockwise mode
+    int32_t velocity = (int32_t)(vactual << 8) >> 8;
+    speed = -velocity * REG_TO_ML_PER_MIN;
+    return MOTOR_STATUS_OK;
+}
+
+/**
+ * @brief Move a volume with the positioning mode of the TMC5041, setSpeed() is refused until it is complete
+ *
+ * The ramp uses the acceleration of setAcceleration() for the start and the stop. The position counter is reset, so
+ * the volume moved is known from XACTUAL.
+ *
+ * @param volume volume in ml (+ in the same direction as a + speed)
+ * @param flow maximum speed in ml/min
+ * @param isCalibrated false to ignore the flow calibration, to measure a new calibration point
+ * @return eMotorStatus MOTOR_STATUS_OK if no problem occured else return error code
+ */
+eMotorStatus StepperMotor::dispense(float volume, float flow, bool isCalibrated)
+{
+    if (!_isInit)
+        return MOTOR_STATUS_NOT_INITIALISED;
+    if (flow <= 0.0)
+        return MOTOR_STATUS_INCORRECT_VARIABLE;
+
+    // The volume per step changes with the flow like the flow per step
+    float commandedFlow = flow;
+    if (isCalibrated)
+        commandedFlow = fabsf(_calibration.getCommandedFlow(volume < 0.0 ? -flow : flow));
+    _dispenseRatio = commandedFlow / flow;
+
+    // A + speed runs the counterclockwise mode, toward the negative positions
+    _dispenseTarget = -(int32_t)(volume * _dispenseRatio * ML_TO_MICROSTEP);
+
+    // D1 must not be 0 in positioning mode, even with V1 = 0 (no A1 and D1 phases). XTARGET is written before the
+    // mode so the motor does not move toward the previous target
+    const uint8_t addresses[DISPENSE_MSG_SIZE] = {MOTOR_DRV_IHOLD_IRUN_ADDR[_motorName], MOTOR_DRV_XACTUAL_ADDR[_motorName],
+                                                  MOTOR_DRV_VSTART_ADDR[_motorName], MOTOR_DRV_A1_ADDR[_motorName],
+                                                  MOTOR_DRV_V1_ADDR[_motorName], MOTOR_DRV_AMAX_ADDR[_motorName],
+                                                  MOTOR_DRV_DMAX_ADDR[_motorName], MOTOR_DRV_D1_ADDR[_motorName],
+                                                  MOTOR_DRV_VSTOP_ADDR[_motorName], MOTOR_DRV_SET_SPEED_ADDR[_motorName],
+                                                  MOTOR_DRV_XTARGET_ADDR[_motorName], MOTOR_DRV_SET_MODE_ADDR[_motorName]};
+    const uint32_t data[DISPENSE_MSG_SIZE] = {RUNNING_TORQUE, 0, 0, _amax, 0, _amax, _amax, _amax, POSITION_VSTOP,
+                                              uint32_t(commandedFlow * ML_PER_MIN_TO_REG), (uint32_t)_dispenseTarget, MOTOR_MODE_POSITION_CONTROL};
+    lockDrive();
+    eMotorStatus status = _drive_handle->writeRegisters(addresses, data, DISPENSE_MSG_SIZE);
+    if (status == MOTOR_STATUS_OK)
+    {
+        // The volume starts at resume()
+        _dispenseVmax = data[9];
+        if (_isHalted)
+            writeHalt();
+
+        _isDispensing = true;
+        _isTorqueHeld = true;
+        _speed = 0.0; // The motor is stopped when the volume is reached
+        resetLoadBaseline();
+    }
+    unlockDrive();
+    return status;
+}
+
+/**
+ * @brief Check if the volume of dispense() is reached, reads the position of the motor
+ *
+ * @return true if the volume is reached or if no volume is in progress
+ */
+bool StepperMotor::isDispenseComplete()
+{
+    if (!_isDispensing)
+        return true;
+
+    // The load is read in the same transaction as the position
+    const uint8_t addresses[2] = {MOTOR_DRV_XACTUAL_ADDR[_motorName], MOTOR_DRV_DRV_STATUS_ADDR[_motorName]};
+    uint32_t values[2] = {0, 0};
+    bool isLoadSampled = isLoadSampleDue();
+    lockDrive();
+    if (_drive_handle->readRegisters(addresses, values, isLoadSampled ? 2 : 1) == MOTOR_STATUS_OK)
+    {
+        if (isLoadSampled)
+            updateLoad(values[1]);
+
+        uint32_t xactual = values[0];
+        if ((int32_t)xactual == _dispenseTarget)
+            _isDispensing = false;
+    }
+    unlockDrive();
+    return !_isDispensing;
+}
 
-    _drive_handle->tmc_write(MOTOR_DRV_IHOLD_IRUN_ADDR[_motorName], torque);
-    _drive_handle->tmc_write(MOTOR_DRV_SET_SPEED_ADDR[_motorName], uint32_t(speed * ML_PER_MIN_TO_REG));
-    _drive_handle->tmc_write(MOTOR_DRV_SET_MODE_ADDR[_motorName], direction);
+/**
+ * @brief Read the volume moved since the start of the last dispense()
+ *
+ * @param volume where to store the volume in ml (+ in the same direction as a + speed)
+ * @return eMotorStatus MOTOR_STATUS_OK if no problem occured else return error code
+ * @note Only valid until the next setSpeed(), the position keeps counting in velocity mode
+ */
+eMotorStatus StepperMotor::getDispensedVolume(float &volume)
+{
+    if (!_isInit)
+        return MOTOR_STATUS_NOT_INITIALISED;
+
+    uint32_t xactual = 0;
+    eMotorStatus status = _drive_handle->readRegisters(&MOTOR_DRV_XACTUAL_ADDR[_motorName], &xactual, 1);
+    if (status != MOTOR_STATUS_OK)
+        return status;
 
+    volume = -(int32_t)xactual / ML_TO_MICROSTEP / _dispenseRatio;
     return MOTOR_STATUS_OK;
 }
 
 /**
- * @brief Set motor speed to zero and make the motor be a freewheel
+ * @brief Ramp the motor speed down to zero, the motor becomes a freewheel once stopped. Cancels a dispense().
  *
  * @return eMotorStatus MOTOR_STATUS_OK if no problem occured else return error code
  */
@@ -82,7 +333,169 @@ eMotorStatus StepperMotor::stop()
     if (!_isInit)
         return MOTOR_STATUS_NOT_INITIALISED;
 
+    lockDrive();
+    _isDispensing = false;
     this->setSpeed(0);
+    unlockDrive();
 
     return MOTOR_STATUS_OK;
 }
+
+/**
+ * @brief Driver error of this motor, from the status returned by the last SPI exchange of its drive
+ *
+ * @return true if the drive reported an error (overtemperature, short to ground or undervoltage)
+ */
+bool StepperMotor::hasDriverError() const
+{
+    uint8_t errorBit = _motorName == MOTOR_1 ? TMC_SPI_STATUS_DRIVER_ERROR_1 : TMC_SPI_STATUS_DRIVER_ERROR_2;
+    return _drive_handle && (_drive_handle->getSpiStatus() & errorBit);
+}
+
+/**
+ * @brief Speed of this motor reached, from the status returned by the last SPI exchange of its drive
+ *
+ * @return true if the motor runs at the set speed
+ */
+bool StepperMotor::isVelocityReached() const
+{
+    uint8_t velocityBit = _motorName == MOTOR_1 ? TMC_SPI_STATUS_VELOCITY_REACHED_1 : TMC_SPI_STATUS_VELOCITY_REACHED_2;
+    return _drive_handle && (_drive_handle->getSpiStatus() & velocityBit);
+}
+
+/**
+ * @brief Stop the motor at once without ramp and without current, until resume()
+ *
+ * Can be called from another task than the one commanding the motor: it takes the drive lock, so it waits for an
+ * exchange in progress and no exchange started before the halt is sent after it. The speed and the volumes set
+ * meanwhile are kept for resume().
+ */
+void StepperMotor::halt()
+{
+    lockDrive();
+    _isHalted = true;
+    if (_isInit)
+        writeHalt();
+    unlockDrive();
+}
+
+/**
+ * @brief Restore the speed or the volume in progress after halt()
+ *
+ * @return eMotorStatus MOTOR_STATUS_OK if no problem occured else return error code
+ */
+eMotorStatus StepperMotor::resume()
+{
+    if (!_isInit)
+        return MOTOR_STATUS_NOT_INITIALISED;
+
+    lockDrive();
+    _isHalted = false;
+    resetLoadBaseline();
+    eMotorStatus status = MOTOR_STATUS_OK;
+    if (!_isDispensing)
+    {
+        status = setSpeed(_speed);
+    }
+    else
+    {
+        const uint8_t addresses[2] = {MOTOR_DRV_IHOLD_IRUN_ADDR[_motorName], MOTOR_DRV_SET_SPEED_ADDR[_motorName]};
+        const uint32_t data[2] = {RUNNING_TORQUE, _dispenseVmax};
+        status = _drive_handle->writeRegisters(addresses, data, 2);
+    }
+    unlockDrive();
+    return status;
+}
+
+/**
+ * @brief Take the drive of the motor, shared with the other motor of the drive and with the safety interlock task
+ */
+void StepperMotor::lockDrive()
+{
+    if (_drive_handle)
+        _drive_handle->lock();
+}
+
+/**
+ * @brief Release the drive taken by lockDrive()
+ */
+void StepperMotor::unlockDrive()
+{
+    if (_drive_handle)
+        _drive_handle->unlock();
+}
+
+/**
+ * @brief Write no current and no speed to the drive
+ */
+void StepperMotor::writeHalt()
+{
+    const uint8_t addresses[2] = {MOTOR_DRV_IHOLD_IRUN_ADDR[_motorName], MOTOR_DRV_SET_SPEED_ADDR[_motorName]};
+    const uint32_t data[2] = {0, 0};
+    _drive_handle->writeRegisters(addresses, data, 2);
+}
+
+/**
+ * @brief Clear the occlusion or dry run event, the detection restarts with a new baseline
+ */
+void StepperMotor::clearEvent()
+{
+    _event = PUMP_EVENT_NONE;
+    resetLoadBaseline();
+}
+
+/**
+ * @brief Check if the load must be read with the next exchange
+ */
+bool StepperMotor::isLoadSampleDue() const
+{
+    return systemClock.getMillis() - _lastLoadSampleTime >= LOAD_SAMPLE_INTERVAL;
+}
+
+/**
+ * @brief Restart the learning of the load baseline, the load depends on the speed
+ */
+void StepperMotor::resetLoadBaseline()
+{
+    _loadBaseline = 0.0;
+    _baselineCount = 0;
+    _abnormalCount = 0;
+}
+
+/**
+ * @brief Compare the load of the motor to its baseline at the current speed
+ *
+ * The baseline is learned from the first BASELINE_SAMPLES once the motor has reached its speed. A load sample far
+ * from it, or a stall, during EVENT_SAMPLES consecutive samples latches an event.
+ *
+ * @param drvStatus DRV_STATUS register of this motor
+ */
+void StepperMotor::updateLoad(uint32_t drvStatus)
+{
+    _lastLoadSampleTime = systemClock.getMillis();
+    _load = drvStatus & SG_RESULT_MASK;
+
+    // The load is only comparable at constant speed
+    if (!isVelocityReached())
+        return;
+
+    if (_baselineCount < BASELINE_SAMPLES)
+    {
+        _loadBaseline += (_load - _loadBaseline) / ++_baselineCount;
+        return;
+    }
+    if (_loadBaseline < MIN_BASELINE)
+        return;
+
+    ePumpEvent event = PUMP_EVENT_NONE;
+    if ((drvStatus & STALL_GUARD_BIT) || _load < _loadBaseline * OCCLUSION_LOAD_RATIO)
+        event = PUMP_EVENT_OCCLUSION;
+    else if (_load > _loadBaseline * DRY_RUN_LOAD_RATIO)
+        event = PUMP_EVENT_DRY_RUN;
+
+    if (event == PUMP_EVENT_NONE || event != _abnormalEvent)
+        _abnormalCount = 0;
+    _abnormalEvent = event;
+    if (event != PUMP_EVENT_NONE && ++_abnormalCount >= EVENT_SAMPLES && _event == PUMP_EVENT_NONE)
+        _event = event;
+}
@@ -0,0 +1,23 @@
+#include "system_clock.h"
+
+SystemClock systemClock;
+
+/**
+ * @brief Replace the source of the time, sampled at the next tick.
+ * @param source Function giving the time (µs), nullptr restores esp_timer_get_time().
+ */
+void SystemClock::setSource(TimeSource source)
+{
+    this->source = source != nullptr ? source : readEspTimer;
+}
+
+/**
+ * @brief Sample the time for the loop starting. A source going back in time (swapped) holds the time until it
+ * catches up, the time never decreases.
+ */
+void SystemClock::tick()
+{
+    uint64_t now = this->source();
+    if (now > this->time)
+        this->time = now;
+}
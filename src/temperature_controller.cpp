@@ -4,10 +4,13 @@
  * @brief Constructor to initialize the control loop parameters.
  */
 TemperatureController::TemperatureController()
-    : integralError(0.0f),
+    : tempRef(37.0f),
+      integralError(0.0f),
       prevError(0.0f),
-      pwmHeater(0),
-      tempRef(37.0f)
+      prevTime(0),
+      isStarted(false),
+      integralErrorAir(0.0f),
+      pwmHeater(0)
 {
 }
 
@@ -19,10 +22,21 @@ TemperatureController::TemperatureController()
  * @note This function needs to be called at 1 Hz.
  */
 void TemperatureController::update(float waterTemp, float airTemp)
+{
+    update(waterTemp, airTemp, systemClock.getMillis());
+}
+
+/**
+ * @brief Updates the control loop with the latest temperature measurements at a given time.
+ * @param waterTemp   Current water temperature (°C).
+ * @param airTemp     Current air temperature (°C).
+ * @param currentTime Time of the measurements (ms), allows to run the controller on a simulated time.
+ */
+void TemperatureController::update(float waterTemp, float airTemp, unsigned long currentTime)
 {
     // --- Compute Target Air Temperature ---
-    unsigned long currentTime = millis();
-    float dt = (float)(currentTime - prevTime) / MILLIS_TO_SECONDS;
+    // The first update only starts the integration time
+    float dt = this->isStarted ? (float)(currentTime - prevTime) / MILLIS_TO_SECONDS : 0.0f;
     float error = (tempRef - waterTemp);
     this->integralErrorAir += error * dt;
 
@@ -34,10 +48,11 @@ void TemperatureController::update(float waterTemp, float airTemp)
 
     // --- PID Control for the Heater ---
     error = targetAirTemp - airTemp;
-    float derivative = (error - prevError) / dt;
+    float derivative = dt > 0.0f ? (error - prevError) / dt : 0.0f;
     this->integralError += error * dt;
     this->prevError = error;
     this->prevTime = currentTime;
+    this->isStarted = true;
 
     float heaterControl = KP_FAN * error + KI_FAN * integralError + KD_FAN * derivative;
     this->pwmHeater = constrain(heaterControl, 0, 100);
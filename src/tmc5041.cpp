@@ -1,5 +1,13 @@
 #include "tmc5041.h"
 
+/**
+ * @brief Construct a DriveTmc5041 object without SPI, to be replaced by one with SPI before begin()
+ */
+DriveTmc5041::DriveTmc5041()
+    : DriveTmc5041(nullptr, 0)
+{
+}
+
 /**
  * @brief Construct a new DriveTmc5041 object
  *
@@ -9,7 +17,10 @@
 DriveTmc5041::DriveTmc5041(SPIClass *spi_handle, uint8_t cs)
     : _spi(spi_handle),
       _cs(cs),
-      _isInit(false)
+      _csMask(0),
+      _isInit(false),
+      _spiStatus(0),
+      _lock(nullptr)
 {
 }
 
@@ -22,8 +33,11 @@ eMotorStatus DriveTmc5041::begin()
 {
   pinMode(_cs, OUTPUT);
   digitalWrite(_cs, HIGH);
+  _csMask = _cs < 32 ? (1UL << _cs) : (1UL << (_cs - 32));
   if (!_spi)
     return MOTOR_STATUS_NULL_VARIABLE;
+  if (_lock == nullptr)
+    _lock = xSemaphoreCreateRecursiveMutex();
 
   // send global drive config
   tmc_write(0x00, (uint32_t)0x08);
@@ -40,13 +54,7 @@ eMotorStatus DriveTmc5041::begin()
  */
 void DriveTmc5041::tmc_write(uint8_t address, uint32_t data)
 {
-  digitalWrite(_cs, LOW);
-  _spi->transfer(address | 0b10000000); // Write bit
-  _spi->transfer((data >> 24) & 0xFF);
-  _spi->transfer((data >> 16) & 0xFF);
-  _spi->transfer((data >> 8) & 0xFF);
-  _spi->transfer(data & 0xFF);
-  digitalWrite(_cs, HIGH);
+  writeRegisters(&address, &data, 1);
 }
 
 /**
@@ -58,11 +66,148 @@ void DriveTmc5041::tmc_write(uint8_t address, uint32_t data)
 uint32_t DriveTmc5041::tmc_read(uint8_t address)
 {
   uint32_t value = 0;
-  digitalWrite(_cs, LOW);
-  _spi->transfer(address & 0x7F);
-
-  for (int i = 0; i < 4; i++)
-    value = (value << 8) | SPI.transfer(0x00);
-  digitalWrite(_cs, HIGH);
+  readRegisters(&address, &value, 1);
   return value;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Write several registers in one SPI transaction
+ *
+ * @param addresses Registers to write
+ * @param data Values to write, one per register
+ * @param count Number of registers, at most MAX_BATCH_SIZE
+ * @return eMotorStatus MOTOR_STATUS_OK if no problem occured else return error code
+ */
+eMotorStatus DriveTmc5041::writeRegisters(const uint8_t *addresses, const uint32_t *data, uint8_t count)
+{
+  if (!_spi || !addresses || !data)
+    return MOTOR_STATUS_NULL_VARIABLE;
+  if (count > MAX_BATCH_SIZE)
+    return MOTOR_STATUS_INCORRECT_VARIABLE;
+
+  sTmcDatagram datagrams[MAX_BATCH_SIZE];
+  for (uint8_t i = 0; i < count; i++)
+  {
+    datagrams[i].address = addresses[i] | TMC_WRITE_BIT;
+    datagrams[i].data = data[i];
+  }
+  transfer(datagrams, count);
+  return MOTOR_STATUS_OK;
+}
+
+/**
+ * @brief Read several registers in one SPI transaction
+ *
+ * The driver answers a read request in the next datagram, so one more datagram than registers is sent.
+ *
+ * @param addresses Registers to read
+ * @param data Where to store the values, one per register
+ * @param count Number of registers, at most MAX_BATCH_SIZE
+ * @return eMotorStatus MOTOR_STATUS_OK if no problem occured else return error code
+ */
+eMotorStatus DriveTmc5041::readRegisters(const uint8_t *addresses, uint32_t *data, uint8_t count)
+{
+  if (!_spi || !addresses || !data)
+    return MOTOR_STATUS_NULL_VARIABLE;
+  if (count == 0 || count > MAX_BATCH_SIZE)
+    return MOTOR_STATUS_INCORRECT_VARIABLE;
+
+  sTmcDatagram datagrams[MAX_BATCH_SIZE + 1];
+  for (uint8_t i = 0; i < count; i++)
+  {
+    datagrams[i].address = addresses[i] & ~TMC_WRITE_BIT;
+    datagrams[i].data = 0;
+  }
+  datagrams[count] = datagrams[count - 1]; // Only clocks out the last response
+  transfer(datagrams, count + 1);
+
+  for (uint8_t i = 0; i < count; i++)
+    data[i] = datagrams[i + 1].data;
+  return MOTOR_STATUS_OK;
+}
+
+/**
+ * @brief Send datagrams in one SPI transaction, CS rises between each of them
+ *
+ * Each datagram goes through the SPI FIFO at once, the CS pin is toggled through the GPIO set and clear registers.
+ *
+ * @param datagrams Datagrams to send, their data and status are replaced by the responses
+ * @param count Number of datagrams
+ */
+void DriveTmc5041::transfer(sTmcDatagram *datagrams, uint8_t count)
+{
+  if (!_spi || count == 0)
+    return;
+
+  lock();
+  uint64_t startTime = systemClock.readTime();
+  _spi->beginTransaction(SPISettings(SPI_CLOCK, MSBFIRST, SPI_MODE3));
+  for (uint8_t i = 0; i < count; i++)
+  {
+    uint32_t data = datagrams[i].data;
+    uint8_t txBuffer[DATAGRAM_SIZE] = {datagrams[i].address, (uint8_t)(data >> 24), (uint8_t)(data >> 16), (uint8_t)(data >> 8), (uint8_t)data};
+    uint8_t rxBuffer[DATAGRAM_SIZE];
+
+    if (i > 0)
+      delayMicroseconds(CS_HIGH_TIME);
+    csLow();
+    _spi->transferBytes(txBuffer, rxBuffer, DATAGRAM_SIZE);
+    csHigh();
+
+    datagrams[i].status = rxBuffer[0];
+    datagrams[i].data = ((uint32_t)rxBuffer[1] << 24) | ((uint32_t)rxBuffer[2] << 16) | ((uint32_t)rxBuffer[3] << 8) | rxBuffer[4];
+    if (rxBuffer[0] & (TMC_SPI_STATUS_DRIVER_ERROR_1 | TMC_SPI_STATUS_DRIVER_ERROR_2))
+      _stats.addDeviceError();
+  }
+  _spi->endTransaction();
+
+  _spiStatus = datagrams[count - 1].status;
+  _stats.addRequest();
+  _stats.addSuccess();
+  _stats.addBytesSent(count * DATAGRAM_SIZE);
+  _stats.addBytesReceived(count * DATAGRAM_SIZE);
+  _stats.addLatency((uint32_t)(systemClock.readTime() - startTime));
+  unlock();
+}
+
+/**
+ * @brief Take the drive for a sequence of transfers, the motor state read before them stays valid until unlock()
+ *
+ * Recursive, transfer() takes it too. Does nothing before begin().
+ */
+void DriveTmc5041::lock()
+{
+  if (_lock != nullptr)
+    xSemaphoreTakeRecursive(_lock, portMAX_DELAY);
+}
+
+/**
+ * @brief Release the drive taken by lock()
+ */
+void DriveTmc5041::unlock()
+{
+  if (_lock != nullptr)
+    xSemaphoreGiveRecursive(_lock);
+}
+
+/**
+ * @brief Select the driver, faster than digitalWrite()
+ */
+void DriveTmc5041::csLow()
+{
+  if (_cs < 32)
+    GPIO.out_w1tc = _csMask;
+  else
+    GPIO.out1_w1tc.val = _csMask;
+}
+
+/**
+ * @brief Release the driver, faster than digitalWrite()
+ */
+void DriveTmc5041::csHigh()
+{
+  if (_cs < 32)
+    GPIO.out_w1ts = _csMask;
+  else
+    GPIO.out1_w1ts.val = _csMask;
+}
@@ -1,16 +1,184 @@
 #include "watchdog.h"
 
+/**
+ * @brief Subsystem supervised by the watchdog, it must be fed before its deadline.
+ */
+typedef struct
+{
+    const char *name;
+    unsigned long deadline; // ms
+    unsigned long lastBeat; // ms, read live and not at the tick, a stalled stage must count
+} sHeartbeat;
+
+static constexpr uint32_t RECORD_MAGIC = 0x57444F47; // "WDOG"
+static const char *const LOOP_STAGE_NAMES[LOOP_STAGE_MAX] = {"state machine", "sensors", "telemetry", "temperature", "gas", "LED", "commands", "recorder"};
+
+static sHeartbeat heartbeats[MAX_HEARTBEATS];
+static uint8_t heartbeatCount = 0;
+static uint64_t stageStartTime = 0; // us
+static void (*loopStageHook)(eLoopStage stage) = nullptr;
+static RTC_NOINIT_ATTR sWatchdogRecord watchdogRecord;
+
 /**
  * @brief Initialise the watchdog must be done at the end of setup for it not to reset during the setup
  *
+ * @note reportLastReset() must be called before, the record of the previous run is cleared here.
  */
 void initWatchDog()
 {
+    memset(&watchdogRecord, 0, sizeof(watchdogRecord));
+    watchdogRecord.magic = RECORD_MAGIC;
+    watchdogRecord.stalledHeartbeat = NO_HEARTBEAT;
+    watchdogRecord.currentStage = LOOP_STAGE_MAX;
+
+    // The heartbeats registered during the setup start from now
+    for (uint8_t i = 0; i < heartbeatCount; i++)
+        heartbeats[i].lastBeat = systemClock.readMillis();
+
     esp_task_wdt_init(WATCHDOG_TIMER, true); // Enable panic (reset)
     esp_task_wdt_add(NULL);                  // Add current thread (loopTask)
 }
 
+/**
+ * @brief Feed the watchdog and all the heartbeats without checking them.
+ *
+ * Only for the operations that block the main loop on purpose (benchmarks), the subsystems cannot be fed meanwhile.
+ */
 void kickWatchDog()
 {
+    for (uint8_t i = 0; i < heartbeatCount; i++)
+        heartbeats[i].lastBeat = systemClock.readMillis();
     esp_task_wdt_reset();
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Feed the watchdog only if every heartbeat is healthy. Must be called at the end of the main loop.
+ *
+ * A stalled subsystem is saved in the RTC memory, the watchdog then resets the board after WATCHDOG_TIMER.
+ */
+void updateWatchDog()
+{
+    unsigned long now = systemClock.readMillis();
+    watchdogRecord.uptime = now;
+
+    int8_t stalledHeartbeat = NO_HEARTBEAT;
+    for (uint8_t i = 0; i < heartbeatCount; i++)
+    {
+        if (now - heartbeats[i].lastBeat > heartbeats[i].deadline)
+        {
+            stalledHeartbeat = i;
+            break;
+        }
+    }
+
+    if (stalledHeartbeat == NO_HEARTBEAT)
+    {
+        watchdogRecord.stalledHeartbeat = NO_HEARTBEAT;
+        esp_task_wdt_reset();
+        return;
+    }
+
+    const sHeartbeat &heartbeat = heartbeats[stalledHeartbeat];
+    if (watchdogRecord.stalledHeartbeat != stalledHeartbeat)
+    {
+        watchdogRecord.stalledHeartbeat = stalledHeartbeat;
+        strncpy(watchdogRecord.stalledName, heartbeat.name, HEARTBEAT_NAME_SIZE - 1);
+        watchdogRecord.stalledName[HEARTBEAT_NAME_SIZE - 1] = '\0';
+        Serial.println("Watchdog: " + String(heartbeat.name) + " stalled, reset in " + String(WATCHDOG_TIMER) + " s");
+    }
+    watchdogRecord.stalledFor = now - heartbeat.lastBeat;
+}
+
+/**
+ * @brief Add a subsystem to supervise.
+ * @param name Name reported after a reset, truncated to HEARTBEAT_NAME_SIZE - 1 characters.
+ * @param deadline Maximum time between two feeds (ms).
+ * @return The heartbeat to give to feedHeartbeat(), NO_HEARTBEAT if there are already MAX_HEARTBEATS.
+ */
+int8_t registerHeartbeat(const char *name, unsigned long deadline)
+{
+    if (heartbeatCount >= MAX_HEARTBEATS)
+        return NO_HEARTBEAT;
+
+    heartbeats[heartbeatCount].name = name;
+    heartbeats[heartbeatCount].deadline = deadline;
+    heartbeats[heartbeatCount].lastBeat = systemClock.readMillis();
+    return heartbeatCount++;
+}
+
+/**
+ * @brief Signal that a subsystem is making progress.
+ * @param heartbeat The heartbeat returned by registerHeartbeat().
+ */
+void feedHeartbeat(int8_t heartbeat)
+{
+    if (heartbeat < 0 || heartbeat >= heartbeatCount)
+        return;
+    heartbeats[heartbeat].lastBeat = systemClock.readMillis();
+}
+
+/**
+ * @brief Mark the start of a stage of the main loop, ends the previous one.
+ * @param stage The stage starting.
+ */
+void beginLoopStage(eLoopStage stage)
+{
+    endLoopStage();
+    watchdogRecord.currentStage = stage;
+    stageStartTime = systemClock.readTime();
+    if (loopStageHook != nullptr)
+        loopStageHook(stage);
+}
+
+/**
+ * @brief Mark the end of the stage in progress and save its duration.
+ */
+void endLoopStage()
+{
+    uint8_t stage = watchdogRecord.currentStage;
+    if (stage >= LOOP_STAGE_MAX)
+        return;
+
+    uint32_t duration = (uint32_t)(systemClock.readTime() - stageStartTime);
+    watchdogRecord.lastStageDurations[stage] = duration;
+    if (duration > watchdogRecord.maxStageDurations[stage])
+        watchdogRecord.maxStageDurations[stage] = duration;
+    watchdogRecord.currentStage = LOOP_STAGE_MAX;
+    if (loopStageHook != nullptr)
+        loopStageHook(LOOP_STAGE_MAX);
+}
+
+/**
+ * @brief Be told of every stage change of the main loop, used by the native benchmarks to time the stages on the host.
+ * @param hook Called with the stage starting, LOOP_STAGE_MAX when a stage ends. nullptr to remove it.
+ */
+void setLoopStageHook(void (*hook)(eLoopStage stage))
+{
+    loopStageHook = hook;
+}
+
+/**
+ * @brief Print the reason of the last reset and, after a watchdog reset, what stalled.
+ * @param output Where to print the report (ex: Serial).
+ */
+void reportLastReset(Print &output)
+{
+    esp_reset_reason_t reason = esp_reset_reason();
+    output.println("> Reset Reason: " + String(reason));
+
+    // The RTC memory holds random data after a power on
+    if (reason == ESP_RST_POWERON || reason == ESP_RST_BROWNOUT || watchdogRecord.magic != RECORD_MAGIC)
+        return;
+
+    output.println("> Uptime Before Reset (ms): " + String(watchdogRecord.uptime));
+    if (watchdogRecord.stalledHeartbeat != NO_HEARTBEAT)
+    {
+        watchdogRecord.stalledName[HEARTBEAT_NAME_SIZE - 1] = '\0';
+        output.println("> Stalled Subsystem: " + String(watchdogRecord.stalledName) + " (" + String(watchdogRecord.stalledFor) + " ms without heartbeat)");
+    }
+    if (watchdogRecord.currentStage < LOOP_STAGE_MAX)
+        output.println("> Stage In Progress: " + String(LOOP_STAGE_NAMES[watchdogRecord.currentStage]));
+
+    for (uint8_t i = 0; i < LOOP_STAGE_MAX; i++)
+        output.println("> Stage " + String(LOOP_STAGE_NAMES[i]) + " (us): last " + String(watchdogRecord.lastStageDurations[i]) + ", max " + String(watchdogRecord.maxStageDurations[i]));
+}
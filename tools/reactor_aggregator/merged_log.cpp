@@ -0,0 +1,257 @@
+#include "merged_log.h"
+
+#include <cstring>
+
+/**
+ * @brief Constructor, the log is written once opened.
+ * @param path Path of the CSV file.
+ * @param names Names of the reactors, prefix of their columns.
+ * @param labels Labels of each reactor, as interned by its TelemetryParser.
+ * @param period Time between two rows (us).
+ * @param latency Time waited after the end of a period before writing it (us).
+ */
+MergedLog::MergedLog(const std::string &path, const std::vector<std::string> &names,
+                     const std::vector<const std::vector<std::string> *> &labels, uint64_t period, uint64_t latency)
+    : path(path),
+      names(names),
+      labels(labels),
+      period(period),
+      latency(latency),
+      startTime(0),
+      startUnixTime(0),
+      file(nullptr),
+      segment(0),
+      isHeaderWritten(false),
+      columnCounts(names.size(), 0),
+      nextRow(0),
+      blockRows(names.size(), nullptr),
+      rowCount(0),
+      lateBlockCount(0)
+{
+    this->rows.resize(PENDING_ROWS);
+    for (size_t i = 0; i < PENDING_ROWS; i++)
+    {
+        this->rows[i].index = i;
+        this->rows[i].isUsed = false;
+        this->rows[i].cells.resize(names.size() * TelemetryParser::MAX_FIELDS);
+    }
+    this->buffer.reserve(2 * BUFFER_FLUSH_SIZE);
+}
+
+MergedLog::~MergedLog()
+{
+    close();
+}
+
+/**
+ * @brief Create the log file.
+ * @param startTime Monotonic time of the start of the first period (us).
+ * @param startUnixTime Wall clock time at startTime (ms), written in the time column.
+ * @return False if the file cannot be created.
+ */
+bool MergedLog::open(uint64_t startTime, uint64_t startUnixTime)
+{
+    this->startTime = startTime;
+    this->startUnixTime = startUnixTime;
+    this->segment = 0;
+    return openSegment();
+}
+
+/**
+ * @brief Start a telemetry block of a reactor, its values go to the period of the given time.
+ * @param reactor Index of the reactor.
+ * @param time Monotonic time of the first line of the block (us).
+ */
+void MergedLog::beginBlock(size_t reactor, uint64_t time)
+{
+    uint64_t index = (time - this->startTime) / this->period;
+    if (time < this->startTime || index < this->nextRow)
+    {
+        // The period was already written
+        this->blockRows[reactor] = nullptr;
+        this->lateBlockCount++;
+        return;
+    }
+
+    // The loop was late to write the previous periods
+    while (index >= this->nextRow + PENDING_ROWS)
+        writeRow(this->rows[this->nextRow % PENDING_ROWS]);
+
+    sRow &row = this->rows[index % PENDING_ROWS];
+    row.isUsed = true;
+    this->blockRows[reactor] = &row;
+}
+
+/**
+ * @brief Set a value of the block in progress of a reactor.
+ * @param reactor Index of the reactor.
+ * @param field Index of the label given by the TelemetryParser.
+ * @param value Value as printed by the firmware.
+ */
+void MergedLog::setValue(size_t reactor, uint8_t field, std::string_view value)
+{
+    sRow *row = this->blockRows[reactor];
+    if (row == nullptr || field >= TelemetryParser::MAX_FIELDS)
+        return;
+
+    sCell *cell = getCell(*row, reactor, field);
+    cell->length = value.size() < sizeof(cell->text) ? value.size() : sizeof(cell->text);
+    memcpy(cell->text, value.data(), cell->length);
+}
+
+/**
+ * @brief Write the periods that ended more than the latency ago.
+ * @param time Current monotonic time (us).
+ */
+void MergedLog::update(uint64_t time)
+{
+    if (this->file == nullptr)
+        return;
+
+    bool isWritten = false;
+    while (this->startTime + (this->nextRow + 1) * this->period + this->latency <= time)
+    {
+        isWritten |= this->rows[this->nextRow % PENDING_ROWS].isUsed;
+        writeRow(this->rows[this->nextRow % PENDING_ROWS]);
+    }
+    if (isWritten)
+        flushBuffer();
+}
+
+/**
+ * @brief Write the periods in progress and close the file.
+ */
+void MergedLog::close()
+{
+    if (this->file == nullptr)
+        return;
+
+    for (size_t i = 0; i < PENDING_ROWS; i++)
+        writeRow(this->rows[this->nextRow % PENDING_ROWS]);
+    flushBuffer();
+    fclose(this->file);
+    this->file = nullptr;
+}
+
+/**
+ * @brief Write a period to the buffer and reuse its row for the period PENDING_ROWS later.
+ * @param row Row of the next period to write.
+ */
+void MergedLog::writeRow(sRow &row)
+{
+    if (row.isUsed && this->file != nullptr)
+    {
+        if (!this->isHeaderWritten || isSchemaChanged())
+        {
+            if (this->isHeaderWritten)
+            {
+                flushBuffer();
+                fclose(this->file);
+                this->segment++;
+                openSegment();
+            }
+            writeHeader();
+        }
+
+        char number[24];
+        snprintf(number, sizeof(number), "%llu", (unsigned long long)(this->startUnixTime + row.index * this->period / 1000));
+        this->buffer.append(number);
+        for (size_t reactor = 0; reactor < this->names.size(); reactor++)
+        {
+            for (size_t field = 0; field < this->columnCounts[reactor]; field++)
+            {
+                sCell *cell = getCell(row, reactor, field);
+                this->buffer.push_back(',');
+                this->buffer.append(cell->text, cell->length);
+                cell->length = 0;
+            }
+        }
+        this->buffer.push_back('\n');
+        this->rowCount++;
+        if (this->buffer.size() >= BUFFER_FLUSH_SIZE)
+            flushBuffer();
+    }
+
+    // A block still in progress in this period loses its last values
+    for (size_t reactor = 0; reactor < this->names.size(); reactor++)
+    {
+        if (this->blockRows[reactor] == &row)
+            this->blockRows[reactor] = nullptr;
+    }
+    row.index += PENDING_ROWS;
+    row.isUsed = false;
+    this->nextRow++;
+}
+
+/**
+ * @brief Check if a reactor has labels that are not in the header.
+ */
+bool MergedLog::isSchemaChanged() const
+{
+    for (size_t reactor = 0; reactor < this->names.size(); reactor++)
+    {
+        if (this->labels[reactor]->size() > this->columnCounts[reactor])
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Create the file of the current segment.
+ * @return False if the file cannot be created.
+ */
+bool MergedLog::openSegment()
+{
+    std::string segmentPath = this->segment == 0 ? this->path : this->path + "." + std::to_string(this->segment);
+    this->file = fopen(segmentPath.c_str(), "w");
+    if (this->file == nullptr)
+        perror(segmentPath.c_str());
+    return this->file != nullptr;
+}
+
+/**
+ * @brief Write the header with the labels known now, they are the columns of the segment.
+ */
+void MergedLog::writeHeader()
+{
+    this->buffer.append("time_ms");
+    for (size_t reactor = 0; reactor < this->names.size(); reactor++)
+    {
+        this->columnCounts[reactor] = this->labels[reactor]->size();
+        for (const std::string &label : *this->labels[reactor])
+        {
+            std::string column = this->names[reactor] + "." + label;
+            if (column.find_first_of(",\"") == std::string::npos)
+            {
+                this->buffer.push_back(',');
+                this->buffer.append(column);
+                continue;
+            }
+
+            // Quoted CSV field
+            this->buffer.append(",\"");
+            for (char c : column)
+            {
+                if (c == '"')
+                    this->buffer.push_back('"');
+                this->buffer.push_back(c);
+            }
+            this->buffer.push_back('"');
+        }
+    }
+    this->buffer.push_back('\n');
+    this->isHeaderWritten = true;
+}
+
+/**
+ * @brief Write the buffered rows to the file.
+ */
+void MergedLog::flushBuffer()
+{
+    if (this->file != nullptr && !this->buffer.empty())
+    {
+        fwrite(this->buffer.data(), 1, this->buffer.size(), this->file);
+        fflush(this->file);
+    }
+    this->buffer.clear();
+}
@@ -0,0 +1,90 @@
+#ifndef MERGED_LOG_H
+#define MERGED_LOG_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "telemetry_parser.h"
+
+/**
+ * @class MergedLog
+ * @brief CSV log of all the reactors on a common time grid, one row per period and one column per reactor field.
+ *
+ * A telemetry block goes to the period in which its first line was received. A period is written once it ended
+ * more than the latency ago, so the blocks of all the reactors for this period have arrived. A field without a
+ * block in the period is left empty, a period without any block is not written. The values are kept as printed by
+ * the firmware, they are not converted.
+ *
+ * The columns are the labels known when the first row is written. A label appearing later (ex: after a reset of
+ * a reactor) starts a new segment of the log, "<path>.1", "<path>.2"..., with the new header.
+ */
+class MergedLog
+{
+public:
+    MergedLog(const std::string &path, const std::vector<std::string> &names,
+              const std::vector<const std::vector<std::string> *> &labels, uint64_t period, uint64_t latency);
+    ~MergedLog();
+
+    bool open(uint64_t startTime, uint64_t startUnixTime);
+    void beginBlock(size_t reactor, uint64_t time);
+    void setValue(size_t reactor, uint8_t field, std::string_view value);
+    void update(uint64_t time);
+    void close();
+
+    uint32_t getRowCount() const { return this->rowCount; }
+    uint32_t getLateBlockCount() const { return this->lateBlockCount; }
+    uint32_t getSegment() const { return this->segment; }
+
+private:
+    /**
+     * @brief Value of a field as printed by the firmware, a longer value is truncated.
+     */
+    typedef struct
+    {
+        char text[15];
+        uint8_t length; // 0 when there was no value in the period
+    } sCell;
+
+    /**
+     * @brief Period not written yet.
+     */
+    typedef struct
+    {
+        uint64_t index; // Period since the start of the log
+        bool isUsed;    // A block was received in the period
+        std::vector<sCell> cells;
+    } sRow;
+
+    sCell *getCell(sRow &row, size_t reactor, uint8_t field) { return &row.cells[reactor * TelemetryParser::MAX_FIELDS + field]; }
+    void writeRow(sRow &row);
+    bool isSchemaChanged() const;
+    bool openSegment();
+    void writeHeader();
+    void flushBuffer();
+
+    std::string path;
+    std::vector<std::string> names;
+    std::vector<const std::vector<std::string> *> labels;
+    uint64_t period;  // us
+    uint64_t latency; // us
+    uint64_t startTime;
+    uint64_t startUnixTime; // ms
+
+    FILE *file;
+    uint32_t segment;
+    bool isHeaderWritten;
+    std::vector<size_t> columnCounts; // Fields of each reactor in the header
+    std::vector<sRow> rows;           // Ring of the periods not written, by index % PENDING_ROWS
+    uint64_t nextRow;                 // Index of the next period to write
+    std::vector<sRow *> blockRows;    // Period of the block in progress of each reactor, nullptr if it is dropped
+    std::string buffer;
+    uint32_t rowCount;
+    uint32_t lateBlockCount;
+
+    static constexpr size_t PENDING_ROWS = 8;          // Periods kept in memory, more than latency / period
+    static constexpr size_t BUFFER_FLUSH_SIZE = 32768; // Bytes of rows written at once
+};
+
+#endif // MERGED_LOG_H
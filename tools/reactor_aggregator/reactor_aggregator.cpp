@@ -0,0 +1,320 @@
+/**
+ * Host daemon collecting the telemetry of several bioreactors.
+ *
+ * Usage: reactor_aggregator [-o log.csv] [-p period_ms] [-l latency_ms] [-b baudrate] [name=]device...
+ *
+ * - The telemetry blocks of printBioreactorStateToSerial() are merged in one time aligned CSV log (MergedLog).
+ * - The other lines of the reactors (command responses, messages) are printed as "name| line".
+ * - Each line of the standard input is a command: "name:COMMAND" for one reactor, "*:COMMAND" or "COMMAND" for
+ *   all of them. "!stats" prints the counters of the reactors and the CPU time used.
+ *
+ * A single thread polls all the ports. The lines are parsed in the receive buffers and the values are only copied
+ * into the log, so dozens of reactors at the firmware telemetry rate take a small part of one core. A port that
+ * fails (reactor unplugged or reset) is opened again every REOPEN_INTERVAL.
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <poll.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+#include "merged_log.h"
+#include "serial_port.h"
+#include "telemetry_parser.h"
+
+static constexpr uint32_t DEFAULT_BAUDRATE = 115200; // SERIAL_BAUDRATE of the firmware
+static constexpr uint64_t DEFAULT_PERIOD = 1000;     // ms, PRINT_UPDATE_INTERVAL of the firmware
+static constexpr uint64_t DEFAULT_LATENCY = 500;     // ms after the end of a period before writing it
+static constexpr int POLL_TIMEOUT = 100;             // ms, the log is written at least at this rate
+static constexpr uint64_t REOPEN_INTERVAL = 2000000; // us between two attempts to open a closed port
+
+/**
+ * @brief A reactor and the state of its telemetry.
+ */
+typedef struct
+{
+    SerialPort port;
+    LineReader reader;
+    TelemetryParser parser;
+    uint64_t lastOpenTime; // us, last attempt to open the port
+    uint32_t lineCount;
+    uint32_t blockCount;
+} sReactor;
+
+static volatile sig_atomic_t isStopping = 0;
+
+static void stop(int)
+{
+    isStopping = 1;
+}
+
+/**
+ * @brief Get the time of a clock in microseconds.
+ */
+static uint64_t getTime(clockid_t clock)
+{
+    timespec now;
+    clock_gettime(clock, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * @brief Handle a line received from a reactor.
+ * @param reactors All the reactors.
+ * @param index Index of the reactor.
+ * @param line Line without the line ending.
+ * @param time Monotonic time of the reception (us).
+ * @param log Merged log of the telemetry.
+ * @param console Output buffer of the lines printed on the standard output.
+ */
+static void handleLine(std::vector<sReactor> &reactors, size_t index, std::string_view line, uint64_t time,
+                       MergedLog &log, std::string &console)
+{
+    sReactor &reactor = reactors[index];
+    reactor.lineCount++;
+
+    bool wasInBlock = reactor.parser.isInBlock();
+    uint8_t field = 0;
+    std::string_view value;
+    switch (reactor.parser.parse(line, field, value))
+    {
+    case TELEMETRY_LINE_FIELD:
+        if (!wasInBlock)
+            log.beginBlock(index, time);
+        log.setValue(index, field, value);
+        break;
+    case TELEMETRY_LINE_END:
+        reactor.blockCount++;
+        break;
+    default:
+        if (!line.empty())
+        {
+            console.append(reactor.port.getName());
+            console.append("| ");
+            console.append(line);
+            console.push_back('\n');
+        }
+        break;
+    }
+}
+
+/**
+ * @brief Print the counters of the reactors and of the log.
+ */
+static void printStats(const std::vector<sReactor> &reactors, const MergedLog &log, std::string &console)
+{
+    char text[160];
+    for (const sReactor &reactor : reactors)
+    {
+        snprintf(text, sizeof(text), "stats| %s: %s, %u lines, %u blocks, %u overflows\n", reactor.port.getName().c_str(),
+                 reactor.port.isOpen() ? "open" : "closed", reactor.lineCount, reactor.blockCount,
+                 reactor.reader.getOverflowCount());
+        console.append(text);
+    }
+
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double cpuTime = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    snprintf(text, sizeof(text), "stats| log: %u rows, %u late blocks, segment %u, CPU time %.3f s\n",
+             log.getRowCount(), log.getLateBlockCount(), log.getSegment(), cpuTime);
+    console.append(text);
+}
+
+/**
+ * @brief Send a command typed on the standard input to its reactors.
+ * @param reactors All the reactors.
+ * @param line "name:COMMAND", "*:COMMAND" or "COMMAND".
+ * @param log Merged log, for the statistics.
+ * @param console Output buffer of the lines printed on the standard output.
+ */
+static void dispatchCommand(std::vector<sReactor> &reactors, std::string_view line, const MergedLog &log,
+                            std::string &console)
+{
+    if (line.empty())
+        return;
+    if (line == "!stats")
+    {
+        printStats(reactors, log, console);
+        return;
+    }
+
+    // The text before ':' is a target only if it is "*" or the name of a reactor
+    std::string_view target = "*";
+    std::string_view command = line;
+    size_t separator = line.find(':');
+    if (separator != std::string_view::npos)
+    {
+        std::string_view name = line.substr(0, separator);
+        for (const sReactor &reactor : reactors)
+        {
+            if (name == "*" || name == reactor.port.getName())
+            {
+                target = name;
+                command = line.substr(separator + 1);
+                break;
+            }
+        }
+    }
+
+    for (sReactor &reactor : reactors)
+    {
+        if (target != "*" && target != reactor.port.getName())
+            continue;
+        if (!reactor.port.queueCommand(command))
+            fprintf(stderr, "%s: command not sent, the port is closed or busy\n", reactor.port.getName().c_str());
+    }
+}
+
+/**
+ * @brief Print the usage of the program.
+ */
+static void printUsage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [-o log.csv] [-p period_ms] [-l latency_ms] [-b baudrate] [name=]device...\n", program);
+}
+
+int main(int argc, char **argv)
+{
+    std::string logPath = "reactors.csv";
+    uint64_t period = DEFAULT_PERIOD;
+    uint64_t latency = DEFAULT_LATENCY;
+    uint32_t baudrate = DEFAULT_BAUDRATE;
+    std::vector<std::string> names;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (argument == "-o" && hasValue)
+            logPath = argv[++i];
+        else if (argument == "-p" && hasValue)
+            period = strtoull(argv[++i], nullptr, 10);
+        else if (argument == "-l" && hasValue)
+            latency = strtoull(argv[++i], nullptr, 10);
+        else if (argument == "-b" && hasValue)
+            baudrate = strtoul(argv[++i], nullptr, 10);
+        else if (argument[0] == '-')
+        {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        else
+        {
+            // The name defaults to the device file name
+            size_t separator = argument.find('=');
+            std::string path = separator == std::string::npos ? argument : argument.substr(separator + 1);
+            std::string name = separator == std::string::npos ? path.substr(path.rfind('/') + 1) : argument.substr(0, separator);
+            names.push_back(name);
+            paths.push_back(path);
+        }
+    }
+    if (paths.empty() || period == 0)
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // The log keeps pointers to the labels of the parsers, the vector is not resized after
+    std::vector<sReactor> reactors;
+    reactors.reserve(paths.size());
+    std::vector<const std::vector<std::string> *> labels;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        reactors.push_back(sReactor{SerialPort(names[i], paths[i], baudrate), LineReader(), TelemetryParser(), 0, 0, 0});
+        labels.push_back(&reactors.back().parser.getLabels());
+    }
+
+    MergedLog log(logPath, names, labels, period * 1000, latency * 1000);
+    if (!log.open(getTime(CLOCK_MONOTONIC), getTime(CLOCK_REALTIME) / 1000))
+        return EXIT_FAILURE;
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    signal(SIGPIPE, SIG_IGN);
+
+    LineReader commandReader;
+    bool isCommandInputOpen = true;
+    std::string console;
+    std::vector<pollfd> fds;
+    std::vector<size_t> fdReactors; // Reactor of each entry of fds after the standard input
+
+    while (!isStopping)
+    {
+        uint64_t now = getTime(CLOCK_MONOTONIC);
+        fds.clear();
+        fdReactors.clear();
+        fds.push_back(pollfd{isCommandInputOpen ? STDIN_FILENO : -1, POLLIN, 0});
+        for (size_t i = 0; i < reactors.size(); i++)
+        {
+            sReactor &reactor = reactors[i];
+            if (!reactor.port.isOpen() && now - reactor.lastOpenTime >= REOPEN_INTERVAL)
+            {
+                reactor.lastOpenTime = now;
+                if (reactor.port.open())
+                    fprintf(stderr, "%s: connected to %s\n", reactor.port.getName().c_str(), reactor.port.getPath().c_str());
+            }
+            if (reactor.port.isOpen())
+            {
+                short events = POLLIN | (reactor.port.hasPendingOutput() ? POLLOUT : 0);
+                fds.push_back(pollfd{reactor.port.getFd(), events, 0});
+                fdReactors.push_back(i);
+            }
+        }
+
+        if (poll(fds.data(), fds.size(), POLL_TIMEOUT) < 0 && errno != EINTR)
+        {
+            perror("poll");
+            break;
+        }
+
+        // All the lines of a wake-up share the same time, the log period is much longer than a wake-up
+        now = getTime(CLOCK_MONOTONIC);
+        if (fds[0].revents != 0)
+        {
+            std::string_view line;
+            isCommandInputOpen = commandReader.read(STDIN_FILENO) >= 0;
+            while (commandReader.nextLine(line))
+                dispatchCommand(reactors, line, log, console);
+        }
+
+        for (size_t i = 1; i < fds.size(); i++)
+        {
+            sReactor &reactor = reactors[fdReactors[i - 1]];
+            bool isFailed = false;
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+            {
+                std::string_view line;
+                isFailed = reactor.reader.read(reactor.port.getFd()) < 0;
+                while (reactor.reader.nextLine(line))
+                    handleLine(reactors, fdReactors[i - 1], line, now, log, console);
+            }
+            if (fds[i].revents & POLLOUT)
+                isFailed |= !reactor.port.writeOutput();
+
+            if (isFailed)
+            {
+                fprintf(stderr, "%s: disconnected\n", reactor.port.getName().c_str());
+                reactor.port.close();
+                reactor.reader.clear();
+                reactor.parser.endBlock();
+            }
+        }
+
+        log.update(now);
+        if (!console.empty())
+        {
+            fwrite(console.data(), 1, console.size(), stdout);
+            fflush(stdout);
+            console.clear();
+        }
+    }
+
+    log.close();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,268 @@
+/**
+ * Stand-in for bioreactors, to run the aggregator without the hardware.
+ *
+ * Usage: reactor_emulator [-n count] [-i interval_ms]
+ *
+ * Each reactor is a pseudo-terminal printing the telemetry blocks of printBioreactorStateToSerial() every interval
+ * and answering the STATE= commands like the firmware. The devices are printed as "name=device" lines, ready to be
+ * given to the aggregator:
+ *
+ *   ./reactor_emulator -n 32 > devices.txt &
+ *   ./reactor_aggregator -o reactors.csv $(cat devices.txt)
+ *
+ * A short interval (ex: 10 ms) loads the aggregator much more than real reactors.
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <poll.h>
+#include <random>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+#include "telemetry_parser.h"
+
+static constexpr uint64_t DEFAULT_INTERVAL = 1000; // ms, PRINT_UPDATE_INTERVAL of the firmware
+static constexpr size_t DEFAULT_COUNT = 4;
+
+/**
+ * @brief Telemetry field printed by the firmware, with a nominal value and the amplitude of its noise.
+ */
+typedef struct
+{
+    const char *label;
+    float nominal;
+    float noise;
+    bool isInteger; // Status codes, printed without decimals
+} sEmulatedField;
+
+static const sEmulatedField FIELDS[] = {
+    {"DO Sensor (%sat)", 40.0f, 2.0f, false},
+    {"pH Sensor (pH)", 7.2f, 0.05f, false},
+    {"Water Temperature (°C)", 37.0f, 0.1f, false},
+    {"Air Temperature (°C)", 36.5f, 0.3f, false},
+    {"Air Humidity (%RH)", 60.0f, 2.0f, false},
+    {"Heater Power (%)", 35.0f, 10.0f, false},
+    {"CO2 Concentration (ppm)", 50000.0f, 500.0f, false},
+    {"O2 Concentration (%)", 21.0f, 0.2f, false},
+    {"CO2 Estimation (ppm)", 50000.0f, 200.0f, false},
+    {"O2 Estimation (%)", 21.0f, 0.1f, false},
+    {"CO2 Reference From pH (ppm)", 50000.0f, 0.0f, false},
+    {"O2 Reference From DO (%)", 21.0f, 0.0f, false},
+    {"Chamber Pressure (Pa)", 20000.0f, 100.0f, false},
+    {"O2 status", 0.0f, 0.0f, true},
+    {"PH status", 1.0f, 0.0f, true},
+    {"Temperature culture status", 1.0f, 0.0f, true},
+    {"CO2 status", 0.0f, 0.0f, true},
+    {"DO status", 0.0f, 0.0f, true},
+    {"Pressure status", 0.0f, 0.0f, true},
+};
+
+// In the order of eBioreactorState: STATE= argument and name printed by the firmware
+static const char *const STATE_COMMANDS[] = {
+    "IDLE", "APPROV", "PREPARE", "RUN", "CELL-RETURN", "CLEANING-APPROV", "CLEANING-CIRCULATION", "CLEANING-RETURN",
+    "RINSING-APPROV", "RINSING-CIRCUL", "RINSING-RETURN", "REDUCE-OVERFLOW", "RETURN-START", "TEST", "OPEN-VALVES",
+    "SAMPLING", "HEATING", "RECIPE"};
+static const char *const STATE_NAMES[] = {
+    "IDLE", "APPROV", "PREPARE", "RUN", "CELL_RETURN", "CLEANING_APPROV", "CLEANING_CIRCULATION", "CLEANING_RETURN",
+    "RINSING_APPROV", "RINSING_CIRCULATION", "RINSING_RETURN", "REDUCE_OVERFLOW", "RETURN_START", "TEST", "OPEN_VALVES",
+    "SAMPLING", "HEATING", "RECIPE"};
+static constexpr size_t STATE_COUNT = sizeof(STATE_COMMANDS) / sizeof(STATE_COMMANDS[0]);
+
+/**
+ * @brief An emulated reactor.
+ */
+typedef struct
+{
+    int master;            // Side of the emulator
+    int slave;             // Kept open so the pseudo-terminal stays usable while the aggregator reconnects
+    LineReader reader;     // Commands
+    uint64_t nextPrintTime; // us
+    uint8_t state;         // eBioreactorState
+    bool isFirstBlock;     // The first block after a reset reports the time to the first control cycle
+    uint32_t droppedCount; // Blocks not written because the aggregator did not read
+} sEmulatedReactor;
+
+static volatile sig_atomic_t isStopping = 0;
+
+static void stop(int)
+{
+    isStopping = 1;
+}
+
+/**
+ * @brief Get the monotonic time in microseconds.
+ */
+static uint64_t getTime()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * @brief Create the pseudo-terminal of a reactor.
+ * @param reactor Output reactor.
+ * @param path Output path of the device to give to the aggregator.
+ * @return False if the pseudo-terminal cannot be created.
+ */
+static bool openReactor(sEmulatedReactor &reactor, std::string &path)
+{
+    reactor.master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (reactor.master < 0 || grantpt(reactor.master) != 0 || unlockpt(reactor.master) != 0)
+        return false;
+    path = ptsname(reactor.master);
+    reactor.slave = open(path.c_str(), O_RDWR | O_NOCTTY);
+    if (reactor.slave < 0)
+        return false;
+
+    // No echo nor line editing, like a serial port
+    termios settings;
+    tcgetattr(reactor.slave, &settings);
+    cfmakeraw(&settings);
+    tcsetattr(reactor.slave, TCSANOW, &settings);
+    fcntl(reactor.master, F_SETFL, fcntl(reactor.master, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+/**
+ * @brief Answer a command like receiveSerialCommand().
+ * @param reactor Emulated reactor.
+ * @param command Command without the line ending.
+ * @param output Output buffer of the response.
+ */
+static void handleCommand(sEmulatedReactor &reactor, std::string_view command, std::string &output)
+{
+    static constexpr std::string_view STATE_PREFIX = "STATE=";
+    if (command.substr(0, STATE_PREFIX.size()) != STATE_PREFIX)
+        return;
+
+    std::string_view argument = command.substr(STATE_PREFIX.size());
+    for (size_t i = 0; i < STATE_COUNT; i++)
+    {
+        if (argument == STATE_COMMANDS[i])
+        {
+            reactor.state = i;
+            output.append("Bioreactor State set to ");
+            output.append(STATE_NAMES[i]);
+            output.append("\r\n");
+        }
+    }
+}
+
+/**
+ * @brief Append a telemetry block like printBioreactorStateToSerial().
+ */
+static void appendTelemetry(sEmulatedReactor &reactor, std::mt19937 &generator, std::string &output)
+{
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    char line[96];
+    snprintf(line, sizeof(line), "> Bioreactor State: %u\r\n", reactor.state);
+    output.append(line);
+    for (const sEmulatedField &field : FIELDS)
+    {
+        float value = field.nominal + field.noise * noise(generator);
+        if (field.isInteger)
+            snprintf(line, sizeof(line), "> %s: %d\r\n", field.label, (int)value);
+        else
+            snprintf(line, sizeof(line), "> %s: %.2f\r\n", field.label, value); // String(float) has 2 decimals
+        output.append(line);
+    }
+    if (reactor.isFirstBlock)
+    {
+        reactor.isFirstBlock = false;
+        output.append("> Time To First Control Cycle (ms): 4210\r\n");
+    }
+    output.append("\r\n");
+}
+
+int main(int argc, char **argv)
+{
+    size_t count = DEFAULT_COUNT;
+    uint64_t interval = DEFAULT_INTERVAL;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "-n" && i + 1 < argc)
+            count = strtoul(argv[++i], nullptr, 10);
+        else if (argument == "-i" && i + 1 < argc)
+            interval = strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            fprintf(stderr, "Usage: %s [-n count] [-i interval_ms]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (count == 0 || interval == 0)
+        return EXIT_FAILURE;
+
+    std::vector<sEmulatedReactor> reactors(count);
+    uint64_t now = getTime();
+    for (size_t i = 0; i < count; i++)
+    {
+        std::string path;
+        if (!openReactor(reactors[i], path))
+        {
+            perror("pseudo-terminal");
+            return EXIT_FAILURE;
+        }
+        // The reactors do not print at the same time
+        reactors[i].nextPrintTime = now + interval * 1000 * i / count;
+        reactors[i].state = 0;
+        reactors[i].isFirstBlock = true;
+        reactors[i].droppedCount = 0;
+        printf("reactor%zu=%s\n", i + 1, path.c_str());
+    }
+    fflush(stdout);
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+
+    std::mt19937 generator(1);
+    std::vector<pollfd> fds(count);
+    std::string output;
+    while (!isStopping)
+    {
+        for (size_t i = 0; i < count; i++)
+            fds[i] = pollfd{reactors[i].master, POLLIN, 0};
+        poll(fds.data(), fds.size(), 1);
+
+        now = getTime();
+        for (size_t i = 0; i < count; i++)
+        {
+            sEmulatedReactor &reactor = reactors[i];
+            output.clear();
+            if (fds[i].revents & POLLIN)
+            {
+                std::string_view command;
+                reactor.reader.read(reactor.master);
+                while (reactor.reader.nextLine(command))
+                    handleCommand(reactor, command, output);
+            }
+            if (now >= reactor.nextPrintTime)
+            {
+                reactor.nextPrintTime += interval * 1000;
+                appendTelemetry(reactor, generator, output);
+            }
+
+            // Like a full UART buffer, what the aggregator does not take is lost
+            if (!output.empty() && write(reactor.master, output.data(), output.size()) != (ssize_t)output.size())
+                reactor.droppedCount++;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (reactors[i].droppedCount > 0)
+            fprintf(stderr, "reactor%zu: %u writes dropped\n", i + 1, reactors[i].droppedCount);
+        close(reactors[i].slave);
+        close(reactors[i].master);
+    }
+    return EXIT_SUCCESS;
+}
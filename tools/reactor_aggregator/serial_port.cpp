@@ -0,0 +1,126 @@
+#include "serial_port.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+/**
+ * @brief Get the termios speed of a baudrate.
+ * @return The speed, B0 if the baudrate is not supported.
+ */
+static speed_t getSpeed(uint32_t baudrate)
+{
+    switch (baudrate)
+    {
+    case 9600:
+        return B9600;
+    case 19200:
+        return B19200;
+    case 38400:
+        return B38400;
+    case 57600:
+        return B57600;
+    case 115200:
+        return B115200;
+    case 230400:
+        return B230400;
+    default:
+        return B0;
+    }
+}
+
+/**
+ * @brief Constructor, the port is opened by open().
+ * @param name Name of the reactor, used in the log and to address the commands.
+ * @param path Path of the serial device.
+ * @param baudrate Baudrate of the firmware (SERIAL_BAUDRATE).
+ */
+SerialPort::SerialPort(const std::string &name, const std::string &path, uint32_t baudrate)
+    : name(name), path(path), baudrate(baudrate), fd(-1)
+{
+}
+
+SerialPort::~SerialPort()
+{
+    close();
+}
+
+/**
+ * @brief Open the port in raw mode.
+ * @return False if the device cannot be opened or configured.
+ */
+bool SerialPort::open()
+{
+    close();
+    speed_t speed = getSpeed(this->baudrate);
+    if (speed == B0)
+    {
+        fprintf(stderr, "%s: unsupported baudrate %u\n", this->name.c_str(), this->baudrate);
+        return false;
+    }
+
+    this->fd = ::open(this->path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (this->fd < 0)
+        return false;
+
+    termios settings;
+    if (tcgetattr(this->fd, &settings) != 0)
+    {
+        close();
+        return false;
+    }
+    cfmakeraw(&settings);
+    cfsetispeed(&settings, speed);
+    cfsetospeed(&settings, speed);
+    settings.c_cflag |= CLOCAL | CREAD;
+    settings.c_cflag &= ~HUPCL; // Closing the port does not reset the ESP32 through DTR
+    if (tcsetattr(this->fd, TCSANOW, &settings) != 0)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Close the port, the commands not written are dropped.
+ */
+void SerialPort::close()
+{
+    if (this->fd >= 0)
+        ::close(this->fd);
+    this->fd = -1;
+    this->output.clear();
+}
+
+/**
+ * @brief Queue a command for the reactor, the line ending is added.
+ * @param command Command as typed on the serial monitor (ex: "STATE=RUN").
+ * @return False if the port is closed or if too many commands are waiting.
+ */
+bool SerialPort::queueCommand(std::string_view command)
+{
+    if (!isOpen() || this->output.size() + command.size() + 1 > MAX_OUTPUT_SIZE)
+        return false;
+    this->output.append(command);
+    this->output.push_back('\n');
+    return true;
+}
+
+/**
+ * @brief Write the queued commands the port can take now.
+ * @return False if the port failed.
+ */
+bool SerialPort::writeOutput()
+{
+    if (!isOpen() || this->output.empty())
+        return isOpen();
+
+    ssize_t count = ::write(this->fd, this->output.data(), this->output.size());
+    if (count < 0)
+        return errno == EAGAIN || errno == EINTR;
+    this->output.erase(0, count);
+    return true;
+}
@@ -0,0 +1,41 @@
+#ifndef SERIAL_PORT_H
+#define SERIAL_PORT_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @class SerialPort
+ * @brief Non-blocking raw serial port of a reactor (USB serial adapter or pseudo-terminal).
+ *
+ * The commands are queued and written when the port can take them, so a slow reactor does not block the others.
+ */
+class SerialPort
+{
+public:
+    SerialPort(const std::string &name, const std::string &path, uint32_t baudrate);
+    ~SerialPort();
+
+    bool open();
+    void close();
+    bool isOpen() const { return this->fd >= 0; }
+    int getFd() const { return this->fd; }
+    const std::string &getName() const { return this->name; }
+    const std::string &getPath() const { return this->path; }
+
+    bool queueCommand(std::string_view command);
+    bool hasPendingOutput() const { return !this->output.empty(); }
+    bool writeOutput();
+
+private:
+    std::string name;
+    std::string path;
+    uint32_t baudrate;
+    int fd;
+    std::string output; // Commands not written yet
+
+    static constexpr size_t MAX_OUTPUT_SIZE = 4096; // Bytes of commands waiting for a reactor not reading
+};
+
+#endif // SERIAL_PORT_H
@@ -0,0 +1,160 @@
+#include "telemetry_parser.h"
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+/**
+ * @brief Constructor of an empty buffer.
+ */
+LineReader::LineReader()
+    : start(0), length(0), isDiscarding(false), overflowCount(0)
+{
+}
+
+/**
+ * @brief Read the available bytes of a port. The lines returned before are not valid anymore.
+ * @param fd Non-blocking file descriptor of the port.
+ * @return Number of bytes read, 0 if there is none, -1 if the port failed or closed.
+ */
+long LineReader::read(int fd)
+{
+    // Keep the unfinished line at the start of the buffer
+    if (this->start > 0)
+    {
+        memmove(this->buffer, this->buffer + this->start, this->length - this->start);
+        this->length -= this->start;
+        this->start = 0;
+    }
+    if (this->length == sizeof(this->buffer))
+    {
+        this->length = 0;
+        this->isDiscarding = true;
+        this->overflowCount++;
+    }
+
+    ssize_t count = ::read(fd, this->buffer + this->length, sizeof(this->buffer) - this->length);
+    if (count < 0)
+        return errno == EAGAIN || errno == EINTR ? 0 : -1;
+    if (count == 0)
+        return -1;
+    this->length += count;
+    return count;
+}
+
+/**
+ * @brief Get the next complete line of the buffer.
+ * @param line Output line, without the line ending.
+ * @return False if there is no complete line left.
+ */
+bool LineReader::nextLine(std::string_view &line)
+{
+    while (this->start < this->length)
+    {
+        const char *begin = this->buffer + this->start;
+        const char *end = static_cast<const char *>(memchr(begin, '\n', this->length - this->start));
+        if (end == nullptr)
+            return false;
+
+        this->start = end - this->buffer + 1;
+        if (this->isDiscarding)
+        {
+            // End of the line that overflowed the buffer
+            this->isDiscarding = false;
+            continue;
+        }
+
+        size_t lineLength = end - begin;
+        if (lineLength > 0 && begin[lineLength - 1] == '\r')
+            lineLength--;
+        line = std::string_view(begin, lineLength);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Drop the received bytes, when the port is closed.
+ */
+void LineReader::clear()
+{
+    this->start = 0;
+    this->length = 0;
+    this->isDiscarding = false;
+}
+
+/**
+ * @brief Constructor of a parser without known labels.
+ */
+TelemetryParser::TelemetryParser()
+    : expectedField(0), isBlockStarted(false)
+{
+    this->labels.reserve(MAX_FIELDS);
+}
+
+/**
+ * @brief Parse a line of the reactor.
+ * @param line Line without the line ending.
+ * @param field Output index of the label in getLabels(), for a field line.
+ * @param value Output value as printed by the firmware, for a field line.
+ * @return Kind of line.
+ */
+eTelemetryLine TelemetryParser::parse(std::string_view line, uint8_t &field, std::string_view &value)
+{
+    if (line.empty())
+    {
+        if (!this->isBlockStarted)
+            return TELEMETRY_LINE_OTHER;
+        endBlock();
+        return TELEMETRY_LINE_END;
+    }
+
+    size_t separator = line.rfind(": ");
+    if (line.size() < 2 || line[0] != '>' || line[1] != ' ' || separator == std::string_view::npos)
+        return TELEMETRY_LINE_OTHER;
+
+    if (!findField(line.substr(2, separator - 2), field))
+        return TELEMETRY_LINE_OTHER;
+    value = line.substr(separator + 2);
+    this->isBlockStarted = true;
+    this->expectedField = field + 1;
+    return TELEMETRY_LINE_FIELD;
+}
+
+/**
+ * @brief End the block in progress, when its empty line is lost (ex: the port was closed).
+ */
+void TelemetryParser::endBlock()
+{
+    this->isBlockStarted = false;
+    this->expectedField = 0;
+}
+
+/**
+ * @brief Find the index of a label, interning it the first time.
+ * @param label Label of the field, with its unit.
+ * @param field Output index of the label.
+ * @return False if the label is new and MAX_FIELDS labels are known.
+ */
+bool TelemetryParser::findField(std::string_view label, uint8_t &field)
+{
+    if (this->expectedField < this->labels.size() && this->labels[this->expectedField] == label)
+    {
+        field = this->expectedField;
+        return true;
+    }
+    for (size_t i = 0; i < this->labels.size(); i++)
+    {
+        if (this->labels[i] == label)
+        {
+            field = i;
+            return true;
+        }
+    }
+
+    if (this->labels.size() >= MAX_FIELDS)
+        return false;
+    field = this->labels.size();
+    this->labels.emplace_back(label);
+    return true;
+}
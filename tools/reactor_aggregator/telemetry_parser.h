@@ -0,0 +1,69 @@
+#ifndef TELEMETRY_PARSER_H
+#define TELEMETRY_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class LineReader
+ * @brief Receive buffer of a port, split in lines without copying them.
+ *
+ * The lines are views on the buffer, valid until the next read(). A line longer than the buffer is dropped.
+ */
+class LineReader
+{
+public:
+    LineReader();
+    long read(int fd);
+    bool nextLine(std::string_view &line);
+    void clear();
+    uint32_t getOverflowCount() const { return this->overflowCount; }
+
+private:
+    char buffer[4096];
+    size_t start;  // First byte not returned by nextLine()
+    size_t length; // End of the received bytes
+    bool isDiscarding;
+    uint32_t overflowCount;
+};
+
+typedef enum
+{
+    TELEMETRY_LINE_FIELD = 0, // "> Label (unit): value"
+    TELEMETRY_LINE_END,       // Empty line ending a telemetry block
+    TELEMETRY_LINE_OTHER,     // Response to a command or message of the firmware
+
+    TELEMETRY_LINE_MAX
+} eTelemetryLine;
+
+/**
+ * @class TelemetryParser
+ * @brief Parser of the telemetry printed by printBioreactorStateToSerial() on one reactor.
+ *
+ * A block is a list of "> Label (unit): value" lines ended by an empty line. The labels are interned once, then
+ * a field is found by comparing the label with the field expected after the previous one, the firmware printing
+ * them in the same order at each block. The parser does not allocate once the labels are known.
+ */
+class TelemetryParser
+{
+public:
+    TelemetryParser();
+    eTelemetryLine parse(std::string_view line, uint8_t &field, std::string_view &value);
+    void endBlock();
+    bool isInBlock() const { return this->isBlockStarted; }
+    const std::vector<std::string> &getLabels() const { return this->labels; }
+
+    static constexpr uint8_t MAX_FIELDS = 64;
+
+private:
+    bool findField(std::string_view label, uint8_t &field);
+
+    std::vector<std::string> labels;
+    uint8_t expectedField; // Field following the previous line
+    bool isBlockStarted;
+};
+
+#endif // TELEMETRY_PARSER_H